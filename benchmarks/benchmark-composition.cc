@@ -0,0 +1,172 @@
+// Composition benchmarks with synthetic(in-memory) subLayer graphs.
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "ubench.h"
+
+#include "asset-resolution.hh"
+#include "composition.hh"
+#include "prim-types.hh"
+
+using namespace tinyusdz;
+
+namespace {
+
+using MemoryAssets = std::map<std::string, std::string>;
+
+int MemResolve(const char *asset_name,
+               const std::vector<std::string> &search_paths,
+               std::string *resolved_asset_name, std::string *err,
+               void *userdata) {
+  (void)search_paths;
+  (void)err;
+  const MemoryAssets *assets = reinterpret_cast<const MemoryAssets *>(userdata);
+  if (!assets->count(asset_name)) {
+    return -1;
+  }
+  (*resolved_asset_name) = asset_name;
+  return 0;
+}
+
+int MemSize(const char *resolved_asset_name, uint64_t *nbytes,
+            std::string *err, void *userdata) {
+  (void)err;
+  const MemoryAssets *assets = reinterpret_cast<const MemoryAssets *>(userdata);
+  if (!assets->count(resolved_asset_name)) {
+    return -1;
+  }
+  (*nbytes) = assets->at(resolved_asset_name).size();
+  return 0;
+}
+
+int MemRead(const char *resolved_asset_name, uint64_t req_nbytes,
+            uint8_t *out_buf, uint64_t *nbytes, std::string *err,
+            void *userdata) {
+  (void)err;
+  const MemoryAssets *assets = reinterpret_cast<const MemoryAssets *>(userdata);
+  if (!assets->count(resolved_asset_name)) {
+    return -1;
+  }
+  const std::string &s = assets->at(resolved_asset_name);
+  if (req_nbytes < s.size()) {
+    return -1;
+  }
+  memcpy(out_buf, s.data(), s.size());
+  (*nbytes) = s.size();
+  return 0;
+}
+
+std::string LayerName(uint32_t idx) {
+  return "layer" + std::to_string(idx) + ".usda";
+}
+
+std::string MakeLayer(uint32_t idx, const std::vector<uint32_t> &sublayers) {
+  std::string s = "#usda 1.0\n";
+  if (!sublayers.empty()) {
+    s += "(\n  subLayers = [";
+    for (size_t i = 0; i < sublayers.size(); i++) {
+      if (i > 0) {
+        s += ", ";
+      }
+      s += "@" + LayerName(sublayers[i]) + "@";
+    }
+    s += "]\n)\n";
+  }
+  s += "def Xform \"prim" + std::to_string(idx) + "\"\n{\n}\n";
+  return s;
+}
+
+// subLayer graph + resolver. Layers are parsed once and kept in LayerCache, so
+// benchmarks measure the traversal of the subLayer graph.
+struct SublayerGraph {
+  MemoryAssets assets;
+  AssetResolutionResolver resolver;
+  LayerCache cache{/* validate_content */ false};
+  Layer root;
+
+  void setup() {
+    AssetResolutionHandler handler;
+    handler.resolve_fun = MemResolve;
+    handler.size_fun = MemSize;
+    handler.read_fun = MemRead;
+    handler.userdata = &assets;
+    resolver.register_asset_resolution_handler("usda", handler);
+
+    root.metas().subLayers.resize(1);
+    root.metas().subLayers[0].assetPath = value::AssetPath(LayerName(0));
+  }
+
+  bool compose() {
+    SublayersCompositionOptions options;
+    options.layer_cache = &cache;
+
+    Layer dst;
+    std::string warn, err;
+    return CompositeSublayers(resolver, root, &dst, &warn, &err, options);
+  }
+};
+
+// layer0 -> layer1 -> ... -> layer(n-1)
+std::unique_ptr<SublayerGraph> MakeDeepGraph(uint32_t n) {
+  std::unique_ptr<SublayerGraph> g(new SublayerGraph());
+  for (uint32_t i = 0; i < n; i++) {
+    std::vector<uint32_t> sublayers;
+    if ((i + 1) < n) {
+      sublayers.push_back(i + 1);
+    }
+    g->assets[LayerName(i)] = MakeLayer(i, sublayers);
+  }
+  g->setup();
+  return g;
+}
+
+// Complete tree with `fanout` subLayers per layer.
+std::unique_ptr<SublayerGraph> MakeWideGraph(uint32_t fanout,
+                                             uint32_t depth) {
+  std::unique_ptr<SublayerGraph> g(new SublayerGraph());
+
+  uint32_t num_layers = 0;
+  uint32_t level_size = 1;
+  for (uint32_t d = 0; d <= depth; d++) {
+    num_layers += level_size;
+    level_size *= fanout;
+  }
+
+  for (uint32_t i = 0; i < num_layers; i++) {
+    std::vector<uint32_t> sublayers;
+    for (uint32_t k = 1; k <= fanout; k++) {
+      uint32_t child = i * fanout + k;
+      if (child < num_layers) {
+        sublayers.push_back(child);
+      }
+    }
+    g->assets[LayerName(i)] = MakeLayer(i, sublayers);
+  }
+  g->setup();
+  return g;
+}
+
+}  // namespace
+
+UBENCH(composition, sublayers_deep_64)
+{
+  static std::unique_ptr<SublayerGraph> g = MakeDeepGraph(64);
+  bool ret = g->compose();
+  UBENCH_DO_NOTHING(&ret);
+}
+
+UBENCH(composition, sublayers_deep_512)
+{
+  static std::unique_ptr<SublayerGraph> g = MakeDeepGraph(512);
+  bool ret = g->compose();
+  UBENCH_DO_NOTHING(&ret);
+}
+
+UBENCH(composition, sublayers_wide_8x3)
+{
+  static std::unique_ptr<SublayerGraph> g = MakeWideGraph(8, 3);
+  bool ret = g->compose();
+  UBENCH_DO_NOTHING(&ret);
+}
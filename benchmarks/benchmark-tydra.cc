@@ -0,0 +1,228 @@
+// Tydra benchmarks with synthetic(in-memory) Stages.
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "ubench.h"
+
+#include "stage.hh"
+#include "tinyusdz.hh"
+#include "tydra/render-data.hh"
+
+using namespace tinyusdz;
+
+namespace {
+
+// CAD-style mesh: `n` convex and concave n-gons(`nverts` vertices each).
+std::string MakeNgonMeshUSDA(size_t n, uint32_t nverts) {
+  std::string counts, indices, points;
+
+  const float kPi = 3.141592653589793f;
+  for (size_t i = 0; i < n; i++) {
+    const float cx = float(i % 256) * 3.0f;
+    const float cy = float(i / 256) * 3.0f;
+    const bool concave = (i % 2) == 1;
+
+    counts += (i ? ", " : "") + std::to_string(nverts);
+    for (uint32_t k = 0; k < nverts; k++) {
+      const float t = 2.0f * kPi * float(k) / float(nverts);
+      // Star-shaped polygon for concave faces.
+      const float r = (concave && (k % 2)) ? 0.5f : 1.0f;
+      points += ((i + k) ? ", (" : "(") + std::to_string(cx + r * std::cos(t)) +
+                ", " + std::to_string(cy + r * std::sin(t)) + ", 0)";
+      indices += ((i + k) ? ", " : "") + std::to_string(i * nverts + k);
+    }
+  }
+
+  std::string s = "#usda 1.0\n";
+  s += "def Mesh \"ngons\"\n{\n";
+  s += "  int[] faceVertexCounts = [" + counts + "]\n";
+  s += "  int[] faceVertexIndices = [" + indices + "]\n";
+  s += "  point3f[] points = [" + points + "]\n";
+  s += "}\n";
+  return s;
+}
+
+std::unique_ptr<Stage> LoadNgonStage(size_t n, uint32_t nverts) {
+  std::unique_ptr<Stage> stage(new Stage());
+  const std::string usda = MakeNgonMeshUSDA(n, nverts);
+  std::string warn, err;
+  LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                     usda.size(), "", stage.get(), &warn, &err);
+  return stage;
+}
+
+bool ConvertStage(const Stage &stage, uint32_t num_threads) {
+  tydra::MeshConverterConfig mesh_config;
+  mesh_config.num_threads = num_threads;
+
+  tydra::RenderSceneConverter converter;
+  converter.set_mesh_config(mesh_config);
+
+  tydra::RenderScene scene;
+  return converter.ConvertToRenderScene(stage, &scene);
+}
+
+}  // namespace
+
+UBENCH(tydra, triangulate_ngon12_64k)
+{
+  static std::unique_ptr<Stage> stage = LoadNgonStage(64 * 1024, 12);
+  bool ret = ConvertStage(*stage, 1);
+  UBENCH_DO_NOTHING(&ret);
+}
+
+UBENCH(tydra, triangulate_ngon12_64k_mt)
+{
+  static std::unique_ptr<Stage> stage = LoadNgonStage(64 * 1024, 12);
+  bool ret = ConvertStage(*stage, 0);
+  UBENCH_DO_NOTHING(&ret);
+}
+
+namespace {
+
+// Indexed, triangulated grid of `n` x `n` quads.
+std::unique_ptr<tydra::RenderMesh> MakeGridMesh(uint32_t n) {
+  std::unique_ptr<tydra::RenderMesh> mesh(new tydra::RenderMesh());
+  for (uint32_t y = 0; y <= n; y++) {
+    for (uint32_t x = 0; x <= n; x++) {
+      mesh->points.push_back({float(x), float(y), 0.0f});
+    }
+  }
+  for (uint32_t y = 0; y < n; y++) {
+    for (uint32_t x = 0; x < n; x++) {
+      const uint32_t i0 = y * (n + 1) + x;
+      const uint32_t tris[6] = {i0, i0 + 1, i0 + n + 2, i0, i0 + n + 2,
+                                i0 + n + 1};
+      mesh->faceVertexIndices.insert(mesh->faceVertexIndices.end(), tris,
+                                     tris + 6);
+      mesh->faceVertexCounts.push_back(3);
+      mesh->faceVertexCounts.push_back(3);
+    }
+  }
+  mesh->is_indexed = true;
+  return mesh;
+}
+
+}  // namespace
+
+UBENCH(tydra, meshlets_grid_512)
+{
+  static std::unique_ptr<tydra::RenderMesh> mesh = MakeGridMesh(512);
+  bool ret = tydra::BuildMeshlets(*mesh, 64, 124);
+  UBENCH_DO_NOTHING(&ret);
+}
+
+UBENCH(tydra, vertex_cache_grid_512)
+{
+  static std::unique_ptr<tydra::RenderMesh> src = MakeGridMesh(512);
+  tydra::RenderMesh mesh = *src;
+  bool ret = tydra::OptimizeVertexCache(mesh);
+  UBENCH_DO_NOTHING(&ret);
+}
+
+namespace {
+
+// Vegetation-style scene: PointInstancer with `n` instances of a quad.
+std::unique_ptr<Stage> LoadPointInstancerStage(size_t n) {
+  std::string indices, positions, orientations, scales;
+  for (size_t i = 0; i < n; i++) {
+    const std::string sep = i ? ", " : "";
+    indices += sep + "0";
+    positions += sep + "(" + std::to_string(i % 1024) + ", 0, " +
+                 std::to_string(i / 1024) + ")";
+    orientations += sep + "(0.9238795, 0, 0.38268343, 0)";
+    scales += sep + "(1, " + std::to_string(1 + (i % 3)) + ", 1)";
+  }
+
+  std::string s = "#usda 1.0\n";
+  s += "def PointInstancer \"trees\"\n{\n";
+  s += "  rel prototypes = [</trees/protos/tree>]\n";
+  s += "  int[] protoIndices = [" + indices + "]\n";
+  s += "  point3f[] positions = [" + positions + "]\n";
+  s += "  quath[] orientations = [" + orientations + "]\n";
+  s += "  float3[] scales = [" + scales + "]\n";
+  s += "  def Scope \"protos\"\n  {\n";
+  s += "    def Mesh \"tree\"\n    {\n";
+  s += "      int[] faceVertexCounts = [4]\n";
+  s += "      int[] faceVertexIndices = [0, 1, 2, 3]\n";
+  s += "      point3f[] points = [(0, 0, 0), (1, 0, 0), (1, 1, 0), (0, 1, 0)]\n";
+  s += "    }\n  }\n}\n";
+
+  std::unique_ptr<Stage> stage(new Stage());
+  std::string warn, err;
+  LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(s.data()), s.size(), "",
+                     stage.get(), &warn, &err);
+  return stage;
+}
+
+}  // namespace
+
+UBENCH(tydra, point_instancer_256k)
+{
+  static std::unique_ptr<Stage> stage = LoadPointInstancerStage(256 * 1024);
+  bool ret = ConvertStage(*stage, 1);
+  UBENCH_DO_NOTHING(&ret);
+}
+
+namespace {
+
+// Layout-style scene: `n` Meshes of 32x32 quads.
+std::unique_ptr<Stage> LoadLayoutStage(size_t n) {
+  const uint32_t kRes = 32;
+
+  std::string counts, indices, points;
+  for (uint32_t y = 0; y < kRes; y++) {
+    for (uint32_t x = 0; x < kRes; x++) {
+      const uint32_t v = y * (kRes + 1) + x;
+      const std::string sep = (x + y) ? ", " : "";
+      counts += sep + "4";
+      indices += sep + std::to_string(v) + ", " + std::to_string(v + 1) +
+                 ", " + std::to_string(v + kRes + 2) + ", " +
+                 std::to_string(v + kRes + 1);
+    }
+  }
+  for (uint32_t y = 0; y <= kRes; y++) {
+    for (uint32_t x = 0; x <= kRes; x++) {
+      points += std::string((x + y) ? ", (" : "(") + std::to_string(x) +
+                ", " + std::to_string(y) + ", 0)";
+    }
+  }
+
+  std::string s = "#usda 1.0\n";
+  for (size_t i = 0; i < n; i++) {
+    s += "def Mesh \"m" + std::to_string(i) + "\"\n{\n";
+    s += "  int[] faceVertexCounts = [" + counts + "]\n";
+    s += "  int[] faceVertexIndices = [" + indices + "]\n";
+    s += "  point3f[] points = [" + points + "]\n";
+    s += "}\n";
+  }
+
+  std::unique_ptr<Stage> stage(new Stage());
+  std::string warn, err;
+  LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(s.data()), s.size(), "",
+                     stage.get(), &warn, &err);
+  return stage;
+}
+
+}  // namespace
+
+UBENCH(tydra, layout_full_256_meshes)
+{
+  static std::unique_ptr<Stage> stage = LoadLayoutStage(256);
+  bool ret = ConvertStage(*stage, 1);
+  UBENCH_DO_NOTHING(&ret);
+}
+
+// Re-convert one edited Mesh of the layout scene.
+UBENCH(tydra, layout_update_1_of_256_meshes)
+{
+  static std::unique_ptr<Stage> stage = LoadLayoutStage(256);
+  static tydra::RenderSceneConverter converter;
+  static tydra::RenderScene scene;
+  static bool converted = converter.ConvertToRenderScene(*stage, &scene);
+
+  bool ret = converted && converter.UpdateRenderScene(
+                              *stage, {Path("/m0", "")}, &scene);
+  UBENCH_DO_NOTHING(&ret);
+}
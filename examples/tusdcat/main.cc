@@ -178,10 +178,17 @@ int main(int argc, char **argv) {
     // - [ ] Specializes
     //
 
+    // Share loaded assets among composition passes.
+    tinyusdz::LayerCache layer_cache(/* validate_content */ false);
+
     tinyusdz::Layer src_layer = root_layer;
     if (comp_features.subLayers) {
+      tinyusdz::SublayersCompositionOptions sublayers_options;
+      sublayers_options.layer_cache = &layer_cache;
+      sublayers_options.num_threads = 0;  // Use all cores.
+
       tinyusdz::Layer composited_layer;
-      if (!tinyusdz::CompositeSublayers(resolver, src_layer, &composited_layer, &warn, &err)) {
+      if (!tinyusdz::CompositeSublayers(resolver, src_layer, &composited_layer, &warn, &err, sublayers_options)) {
         std::cerr << "Failed to composite subLayers: " << err << "\n";
         return -1;
       }
@@ -206,8 +213,12 @@ int main(int argc, char **argv) {
         } else {
           all_resolved = false;
 
+          tinyusdz::ReferencesCompositionOptions references_options;
+          references_options.layer_cache = &layer_cache;
+          references_options.num_threads = 0;  // Use all cores.
+
           tinyusdz::Layer composited_layer;
-          if (!tinyusdz::CompositeReferences(resolver, src_layer, &composited_layer, &warn, &err)) {
+          if (!tinyusdz::CompositeReferences(resolver, src_layer, &composited_layer, &warn, &err, references_options)) {
             std::cerr << "Failed to composite `references`: " << err << "\n";
             return -1;
           }
@@ -230,8 +241,12 @@ int main(int argc, char **argv) {
           all_resolved = false;
         }
 
+        tinyusdz::PayloadCompositionOptions payload_options;
+        payload_options.layer_cache = &layer_cache;
+        payload_options.num_threads = 0;  // Use all cores.
+
         tinyusdz::Layer composited_layer;
-        if (!tinyusdz::CompositePayload(resolver, src_layer, &composited_layer, &warn, &err)) {
+        if (!tinyusdz::CompositePayload(resolver, src_layer, &composited_layer, &warn, &err, payload_options)) {
           std::cerr << "Failed to composite `payload`: " << err << "\n";
           return -1;
         }
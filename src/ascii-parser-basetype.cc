@@ -1085,8 +1085,9 @@ bool AsciiParser::ReadBasicType(uint32_t *value) {
 #else
   // use jsteemann/atoi
   int retcode = 0;
-  auto result = jsteemann::atoi<uint32_t>(
-      ss.str().c_str(), ss.str().c_str() + ss.str().size(), retcode);
+  const std::string str = ss.str();
+  auto result = jsteemann::atoi<uint32_t>(str.c_str(),
+                                          str.c_str() + str.size(), retcode);
   DCOUT("sz = " << ss.str().size());
   DCOUT("ss = " << ss.str() << ", retcode = " << retcode
                 << ", result = " << result);
@@ -1114,7 +1115,6 @@ bool AsciiParser::ReadBasicType(int64_t *value) {
 
   // head character
   bool has_sign = false;
-  bool negative = false;
   {
     char sc;
     if (!Char1(&sc)) {
@@ -1124,10 +1124,8 @@ bool AsciiParser::ReadBasicType(int64_t *value) {
 
     // sign or [0-9]
     if (sc == '+') {
-      negative = false;
       has_sign = true;
     } else if (sc == '-') {
-      negative = true;
       has_sign = true;
     } else if ((sc >= '0') && (sc <= '9')) {
       // ok
@@ -1140,11 +1138,6 @@ bool AsciiParser::ReadBasicType(int64_t *value) {
     ss << sc;
   }
 
-  if (negative) {
-    PushError("Unsigned value expected but got '-' sign.");
-    return false;
-  }
-
   while (!Eof()) {
     char c;
     if (!Char1(&c)) {
@@ -1175,14 +1168,14 @@ bool AsciiParser::ReadBasicType(int64_t *value) {
   // TODO(syoyo): Use ryu parse.
 #if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
   try {
-    (*value) = std::stoull(ss.str());
+    (*value) = std::stoll(ss.str());
   } catch (const std::invalid_argument &e) {
     (void)e;
-    PushError("Not an 64bit unsigned integer literal.\n");
+    PushError("Not an 64bit integer literal.\n");
     return false;
   } catch (const std::out_of_range &e) {
     (void)e;
-    PushError("64bit unsigned integer value out of range.\n");
+    PushError("64bit integer value out of range.\n");
     return false;
   }
 
@@ -1190,8 +1183,9 @@ bool AsciiParser::ReadBasicType(int64_t *value) {
 #else
   // use jsteemann/atoi
   int retcode;
-  auto result = jsteemann::atoi<int64_t>(
-      ss.str().c_str(), ss.str().c_str() + ss.str().size(), retcode);
+  const std::string str = ss.str();
+  auto result = jsteemann::atoi<int64_t>(str.c_str(),
+                                         str.c_str() + str.size(), retcode);
   if (retcode == jsteemann::SUCCESS) {
     (*value) = result;
     return true;
@@ -1294,8 +1288,9 @@ bool AsciiParser::ReadBasicType(uint64_t *value) {
 #else
   // use jsteemann/atoi
   int retcode;
-  auto result = jsteemann::atoi<uint64_t>(
-      ss.str().c_str(), ss.str().c_str() + ss.str().size(), retcode);
+  const std::string str = ss.str();
+  auto result = jsteemann::atoi<uint64_t>(str.c_str(),
+                                          str.c_str() + str.size(), retcode);
   if (retcode == jsteemann::SUCCESS) {
     (*value) = result;
     return true;
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: Apache 2.0
 // Copyright 2022 - Present, Light Transport Entertainment, Inc.
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -26,8 +27,154 @@ std::string AssetResolutionResolver::search_paths_str() const {
   return str;
 }
 
+#if defined(TINYUSDZ_ENABLE_THREAD)
+#define RESOLVER_LOCK() std::lock_guard<std::mutex> lock(_mutex)
+#else
+#define RESOLVER_LOCK()
+#endif
+
+void AssetResolutionResolver::set_search_paths(
+    const std::vector<std::string> &paths) {
+  // TODO: Validate input paths.
+  std::vector<std::string> dedup_paths;
+  for (const auto &path : paths) {
+    if (std::find(dedup_paths.begin(), dedup_paths.end(), path) ==
+        dedup_paths.end()) {
+      dedup_paths.push_back(path);
+    }
+  }
+
+  RESOLVER_LOCK();
+
+  _search_paths = std::move(dedup_paths);
+  _search_paths_generation++;
+  _cached_resolved_paths.clear();
+}
+
+void AssetResolutionResolver::add_seartch_path(const std::string &path) {
+  RESOLVER_LOCK();
+
+  if (std::find(_search_paths.begin(), _search_paths.end(), path) !=
+      _search_paths.end()) {
+    return;
+  }
+
+  _search_paths.push_back(path);
+  _search_paths_generation++;
+
+  // Resolved paths are still valid since a new path is searched last, but
+  // "not found" results may be found now.
+  for (auto it = _cached_resolved_paths.begin();
+       it != _cached_resolved_paths.end();) {
+    if (it->second.empty()) {
+      it = _cached_resolved_paths.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::vector<std::string> AssetResolutionResolver::get_search_paths_copy()
+    const {
+  RESOLVER_LOCK();
+
+  return _search_paths;
+}
+
+void AssetResolutionResolver::set_resolve_cache_enabled(bool enabled) {
+  RESOLVER_LOCK();
+
+  _resolve_cache_enabled = enabled;
+  if (!enabled) {
+    _cached_resolved_paths.clear();
+  }
+}
+
+void AssetResolutionResolver::clear_resolve_cache() {
+  RESOLVER_LOCK();
+
+  _cached_resolved_paths.clear();
+}
+
+void AssetResolutionResolver::invalidate_resolve_cache(
+    const std::string &assetPath) {
+  RESOLVER_LOCK();
+
+  _cached_resolved_paths.erase(assetPath);
+}
+
+AssetResolutionStats AssetResolutionResolver::stats() const {
+  RESOLVER_LOCK();
+
+  return _stats;
+}
+
+void AssetResolutionResolver::reset_stats() {
+  RESOLVER_LOCK();
+
+  _stats = AssetResolutionStats();
+}
+
+std::string AssetResolutionResolver::resolve_file(
+    const std::string &assetPath) const {
+  std::vector<std::string> search_paths;
+  uint64_t generation{0};
+
+  {
+    RESOLVER_LOCK();
+
+    _stats.resolve_calls++;
+
+    if (_resolve_cache_enabled) {
+      const auto it = _cached_resolved_paths.find(assetPath);
+      if (it != _cached_resolved_paths.end()) {
+        _stats.cache_hits++;
+        if (it->second.empty()) {
+          _stats.negative_cache_hits++;
+        }
+        return it->second;
+      }
+    }
+
+    search_paths = _search_paths;
+    generation = _search_paths_generation;
+  }
+
+  DCOUT("search_paths = " << search_paths);
+  DCOUT("assetPath = " << assetPath);
+
+  // Probe files without the lock. Same as io::FindFile.
+  std::string resolved_path;
+  uint64_t num_probes{0};
+  if (!assetPath.empty()) {
+    for (size_t i = 0; i < search_paths.size(); i++) {
+      std::string abs_path = io::ExpandFilePath(
+          io::JoinPath(search_paths[i], assetPath), /* userdata */ nullptr);
+      num_probes++;
+      if (io::FileExists(abs_path, /* userdata */ nullptr)) {
+        resolved_path = abs_path;
+        break;
+      }
+    }
+  }
+
+  {
+    RESOLVER_LOCK();
+
+    _stats.probes += num_probes;
+
+    // Do not cache the result when search paths are modified during the
+    // resolution.
+    if (_resolve_cache_enabled &&
+        (generation == _search_paths_generation)) {
+      _cached_resolved_paths[assetPath] = resolved_path;
+    }
+  }
+
+  return resolved_path;
+}
+
 bool AssetResolutionResolver::find(const std::string &assetPath) const {
-  DCOUT("search_paths = " << _search_paths);
   DCOUT("assetPath = " << assetPath);
 
   std::string ext = io::GetFileExtension(assetPath);
@@ -40,7 +187,7 @@ bool AssetResolutionResolver::find(const std::string &assetPath) const {
       // Use custom handler's userdata
       void *userdata = _asset_resolution_handlers.at(ext).userdata;
 
-      int ret = _asset_resolution_handlers.at(ext).resolve_fun(assetPath.c_str(), _search_paths, &resolvedPath, &err, userdata);
+      int ret = _asset_resolution_handlers.at(ext).resolve_fun(assetPath.c_str(), get_search_paths_copy(), &resolvedPath, &err, userdata);
       if (ret != 0) {
         return false;
       }
@@ -58,8 +205,7 @@ bool AssetResolutionResolver::find(const std::string &assetPath) const {
     }
   }
 
-  // TODO: Cache resolition.
-  std::string fpath = io::FindFile(assetPath, _search_paths);
+  std::string fpath = resolve_file(assetPath);
   return fpath.size();
 }
 
@@ -76,7 +222,7 @@ std::string AssetResolutionResolver::resolve(
       // Use custom handler's userdata
       void *userdata = _asset_resolution_handlers.at(ext).userdata;
 
-      int ret = _asset_resolution_handlers.at(ext).resolve_fun(assetPath.c_str(), _search_paths, &resolvedPath, &err, userdata);
+      int ret = _asset_resolution_handlers.at(ext).resolve_fun(assetPath.c_str(), get_search_paths_copy(), &resolvedPath, &err, userdata);
       if (ret != 0) {
         return std::string();
       }
@@ -88,10 +234,7 @@ std::string AssetResolutionResolver::resolve(
     }
   }
 
-  DCOUT("search_paths = " << _search_paths);
-  DCOUT("assetPath = " << assetPath);
-  // TODO: Cache resolition.
-  return io::FindFile(assetPath, _search_paths);
+  return resolve_file(assetPath);
 }
 
 bool AssetResolutionResolver::open_asset(const std::string &resolvedPath, const std::string &assetPath,
@@ -153,8 +296,24 @@ bool AssetResolutionResolver::open_asset(const std::string &resolvedPath, const
     }
   }
 
-  std::vector<uint8_t> data;
   size_t max_bytes = 1024 * 1024 * _max_asset_bytes_in_mb;
+
+  if (_use_mmap && io::MMapFile::supported()) {
+    auto mmap_file = std::make_shared<io::MMapFile>();
+    std::string mmap_err;
+    if (mmap_file->open(resolvedPath, &mmap_err, max_bytes,
+                        _mmap_threshold_bytes)) {
+      const uint8_t *addr = mmap_file->data();
+      size_t nbytes = mmap_file->size();
+      asset_out->set_shared(std::move(mmap_file), addr, nbytes);
+      return true;
+    }
+
+    // Fallback to read the file.
+    DCOUT("mmap failed: " << mmap_err);
+  }
+
+  std::vector<uint8_t> data;
   if (!io::ReadWholeFile(&data, err, resolvedPath, max_bytes,
                            /* userdata */ nullptr)) {
 
@@ -8,10 +8,17 @@
 // `ar`, `Ar` and `AR`. ;-)
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#if defined(TINYUSDZ_ENABLE_THREAD)
+#include <mutex>
+#endif
+
 #include "nonstd/optional.hpp"
 #include "value-types.hh"
 
@@ -21,22 +28,122 @@ namespace tinyusdz {
 /// Abstract class for asset(e.g. file, memory, uri, ...)
 /// Similar to ArAsset in pxrUSD.
 ///
+/// Asset content is stored in one of the following storages:
+///
+/// - Owned: std::vector owned by the Asset(default).
+/// - View: Non-owning view of the memory. The memory must outlive the Asset.
+/// - Shared: Memory kept alive by a shared `holder`(e.g. memory mapped file,
+///   shared buffer, the whole USDZ archive for its sub-asset).
+///
+/// Copying an Asset with View or Shared storage does not copy the content.
+/// Non-const accessors(`data()`, `resize()`) convert the storage to Owned by
+/// copying the content(copy-on-write), so use a const Asset to read the
+/// content.
+///
 class Asset {
  public:
-  size_t size() const { return buf_.size(); }
+  size_t size() const { return external_ ? view_size_ : buf_.size(); }
 
-  const uint8_t *data() const { return buf_.data(); }
+  const uint8_t *data() const {
+    return external_ ? view_addr_ : buf_.data();
+  }
 
-  uint8_t *data() { return buf_.data(); }
+  uint8_t *data() {
+    make_owned();
+    return buf_.data();
+  }
 
-  void resize(size_t sz) { buf_.resize(sz); }
+  void resize(size_t sz) {
+    make_owned();
+    buf_.resize(sz);
+  }
 
-  void shrink_to_fit() { buf_.shrink_to_fit(); }
+  void shrink_to_fit() {
+    if (!external_) {
+      buf_.shrink_to_fit();
+    }
+  }
 
-  void set_data(const std::vector<uint8_t> &&rhs) {
+  void set_data(std::vector<uint8_t> &&rhs) {
+    reset_external();
+    buf_ = std::move(rhs);
+  }
+
+  void set_data(const std::vector<uint8_t> &rhs) {
+    reset_external();
     buf_ = rhs;
   }
 
+  ///
+  /// Set non-owning view of the memory.
+  ///
+  void set_view(const uint8_t *addr, size_t nbytes) {
+    reset_external();
+    std::vector<uint8_t>().swap(buf_);
+    external_ = true;
+    view_addr_ = addr;
+    view_size_ = addr ? nbytes : 0;
+  }
+
+  ///
+  /// Set the memory which is kept alive by `holder`.
+  ///
+  void set_shared(std::shared_ptr<const void> holder, const uint8_t *addr,
+                  size_t nbytes) {
+    set_view(addr, nbytes);
+    holder_ = std::move(holder);
+  }
+
+  void set_shared(std::shared_ptr<const std::vector<uint8_t>> buf) {
+    if (!buf) {
+      set_data(std::vector<uint8_t>());
+      return;
+    }
+    const uint8_t *addr = buf->data();
+    size_t nbytes = buf->size();
+    set_shared(std::move(buf), addr, nbytes);
+  }
+
+  ///
+  /// Convert Owned storage to Shared storage(without copy), so that copies
+  /// and slices of this Asset share the content.
+  ///
+  void share() {
+    if (!external_) {
+      set_shared(
+          std::make_shared<const std::vector<uint8_t>>(std::move(buf_)));
+    }
+  }
+
+  ///
+  /// Sub-range of the content. `offset` and `nbytes` are clamped to the
+  /// content size. The content is shared for View/Shared storage, and copied
+  /// for Owned storage(call `share()` first to avoid the copy).
+  ///
+  Asset slice(size_t offset, size_t nbytes) const {
+    Asset asset;
+    asset.version_ = version_;
+    asset.name_ = name_;
+    asset.resolved_name_ = resolved_name_;
+
+    const size_t sz = size();
+    offset = (offset < sz) ? offset : sz;
+    nbytes = (nbytes < (sz - offset)) ? nbytes : (sz - offset);
+
+    if (external_) {
+      asset.set_shared(holder_, view_addr_ + offset, nbytes);
+    } else {
+      asset.buf_.assign(buf_.begin() + std::ptrdiff_t(offset),
+                        buf_.begin() + std::ptrdiff_t(offset + nbytes));
+    }
+
+    return asset;
+  }
+
+  bool is_owned() const { return !external_; }
+  bool is_view() const { return external_ && !holder_; }
+  bool is_shared() const { return external_ && holder_; }
+
   void set_name(const std::string &name) {
     name_ = name;
   }
@@ -62,10 +169,31 @@ class Asset {
   }
 
  private:
+  void make_owned() {
+    if (external_) {
+      std::vector<uint8_t> buf(view_addr_, view_addr_ + view_size_);
+      reset_external();
+      buf_ = std::move(buf);
+    }
+  }
+
+  void reset_external() {
+    external_ = false;
+    view_addr_ = nullptr;
+    view_size_ = 0;
+    holder_.reset();
+  }
+
   std::string version_; // optional. 
   std::string name_;
   std::string resolved_name_;
   std::vector<uint8_t> buf_;
+
+  // View/Shared storage
+  bool external_{false};
+  const uint8_t *view_addr_{nullptr};
+  size_t view_size_{0};
+  std::shared_ptr<const void> holder_;  // nullptr for View storage
 };
 
 
@@ -147,17 +275,45 @@ typedef bool (*ResolvePathHandler)(const std::string &path,
                                    std::string *err);
 #endif
 
+///
+/// Statistics of the built-in(filesystem) asset path resolution.
+///
+struct AssetResolutionStats {
+  uint64_t resolve_calls{0};  // The number of resolve()/find() calls.
+  uint64_t cache_hits{0};     // Resolved from the cache(including negative).
+  uint64_t negative_cache_hits{0};  // Found as "not exist" in the cache.
+  uint64_t probes{0};  // The number of file existence checks(e.g. stat())
+};
+
+///
+/// Resolved paths of the built-in(filesystem) resolution are memoized per
+/// asset path, including "not found" results(negative cache). The cache is
+/// invalidated when search paths are modified(negative results only when a
+/// search path is appended). Files created or removed after the resolution
+/// are not noticed until `clear_resolve_cache()` or
+/// `invalidate_resolve_cache()` is called. Results of a custom
+/// AssetResolutionHandler are not cached.
+///
+/// resolve(), find() and open_asset() are thread-safe when TinyUSDZ is built
+/// with TINYUSDZ_ENABLE_THREAD. Modifying search paths is also thread-safe,
+/// but `search_paths()` returns a reference and must not be used concurrently
+/// with the modification.
+///
 class AssetResolutionResolver {
  public:
   AssetResolutionResolver() = default;
   ~AssetResolutionResolver() {}
 
+  // NOTE: Resolve cache and stats are not copied.
   AssetResolutionResolver(const AssetResolutionResolver &rhs) {
     if (this != &rhs) {
       //_resolve_path_handler = rhs._resolve_path_handler;
       _asset_resolution_handlers = rhs._asset_resolution_handlers;
       _userdata = rhs._userdata;
       _search_paths = rhs._search_paths;
+      _resolve_cache_enabled = rhs._resolve_cache_enabled;
+      _use_mmap = rhs._use_mmap;
+      _mmap_threshold_bytes = rhs._mmap_threshold_bytes;
     }
   }
 
@@ -166,7 +322,10 @@ class AssetResolutionResolver {
       // _resolve_path_handler = rhs._resolve_path_handler;
       _asset_resolution_handlers = rhs._asset_resolution_handlers;
       _userdata = rhs._userdata;
-      _search_paths = rhs._search_paths;
+      set_search_paths(rhs._search_paths);
+      _resolve_cache_enabled = rhs._resolve_cache_enabled;
+      _use_mmap = rhs._use_mmap;
+      _mmap_threshold_bytes = rhs._mmap_threshold_bytes;
     }
     return (*this);
   }
@@ -176,7 +335,11 @@ class AssetResolutionResolver {
       //_resolve_path_handler = rhs._resolve_path_handler;
       _asset_resolution_handlers = rhs._asset_resolution_handlers;
       _userdata = rhs._userdata;
-      _search_paths = std::move(rhs._search_paths);
+      set_search_paths(rhs._search_paths);
+      _resolve_cache_enabled = rhs._resolve_cache_enabled;
+      _use_mmap = rhs._use_mmap;
+      _mmap_threshold_bytes = rhs._mmap_threshold_bytes;
+      rhs.set_search_paths({});
     }
     return (*this);
   }
@@ -184,14 +347,16 @@ class AssetResolutionResolver {
   // TinyUSDZ does not provide global search paths at the moment.
   // static void SetDefaultSearchPath(const std::vector<std::string> &p);
 
-  void set_search_paths(const std::vector<std::string> &paths) {
-    // TODO: Validate input paths.
-    _search_paths = paths;
-  }
+  ///
+  /// Set search paths. Duplicated paths are removed(the first one is used).
+  /// Clears the resolve cache.
+  ///
+  void set_search_paths(const std::vector<std::string> &paths);
 
-  void add_seartch_path(const std::string &path) {
-    _search_paths.push_back(path);
-  }
+  ///
+  /// Append a search path. No-op when `path` is already in the search paths.
+  ///
+  void add_seartch_path(const std::string &path);
 
   const std::vector<std::string> &search_paths() const { return _search_paths; }
 
@@ -275,7 +440,58 @@ class AssetResolutionResolver {
     return _max_asset_bytes_in_mb;
   }
 
+  ///
+  /// Use memory mapped file to open an asset with the built-in file handler,
+  /// when the platform supports it(default true). The content of the opened
+  /// Asset is shared with the mapping instead of being copied. Only files of
+  /// `mmap_threshold()` bytes or larger are mapped.
+  ///
+  /// NOTE: Disable it when asset files may be modified while Assets(or Layers
+  /// cached with them) are alive. Reading a mapping of a truncated or
+  /// rewritten file raises SIGBUS on Posix.
+  ///
+  void set_use_mmap(bool enabled) { _use_mmap = enabled; }
+
+  bool use_mmap() const { return _use_mmap; }
+
+  ///
+  /// Minimum file size in bytes to use memory mapped file(default 1 MB).
+  /// Smaller files are read into memory.
+  ///
+  void set_mmap_threshold(size_t nbytes) { _mmap_threshold_bytes = nbytes; }
+
+  size_t mmap_threshold() const { return _mmap_threshold_bytes; }
+
+  ///
+  /// Enable/disable memoization of the resolved paths(default enabled).
+  /// Disabling also clears the cache.
+  ///
+  void set_resolve_cache_enabled(bool enabled);
+
+  bool resolve_cache_enabled() const { return _resolve_cache_enabled; }
+
+  ///
+  /// Clear all cached resolution results(e.g. after files are added or
+  /// removed).
+  ///
+  void clear_resolve_cache();
+
+  ///
+  /// Remove the cached resolution result of `assetPath`.
+  ///
+  void invalidate_resolve_cache(const std::string &assetPath);
+
+  AssetResolutionStats stats() const;
+
+  void reset_stats();
+
  private:
+  // Resolve `assetPath` with the built-in file handler.
+  std::string resolve_file(const std::string &assetPath) const;
+
+  // Thread-safe copy of search paths.
+  std::vector<std::string> get_search_paths_copy() const;
+
   //ResolvePathHandler _resolve_path_handler{nullptr};
   void *_userdata{nullptr};
   std::vector<std::string> _search_paths;
@@ -283,9 +499,22 @@ class AssetResolutionResolver {
 
   std::map<std::string, AssetResolutionHandler> _asset_resolution_handlers;
 
-  // TODO: Cache resolution result
-  // mutable _dirty{true};
-  // mutable std::map<std::string, std::string> _cached_resolved_paths;
+  bool _resolve_cache_enabled{true};
+  bool _use_mmap{true};
+  size_t _mmap_threshold_bytes{1024 * 1024};
+
+  // asset path -> resolved path. Empty resolved path = not found.
+  mutable std::unordered_map<std::string, std::string> _cached_resolved_paths;
+
+  // Incremented when search paths are modified, to discard the result of
+  // in-flight resolution.
+  uint64_t _search_paths_generation{0};
+
+  mutable AssetResolutionStats _stats;
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  mutable std::mutex _mutex;
+#endif
 };
 
 // forward decl
@@ -3,18 +3,24 @@
 
 #include "composition.hh"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <set>
 #include <stack>
+#include <unordered_map>
 
 #include "asset-resolution.hh"
 #include "common-macros.inc"
 #include "io-util.hh"
+#include "performance.hh"
 #include "pprinter.hh"
 #include "prim-pprint.hh"
 #include "prim-reconstruct.hh"
 #include "prim-types.hh"
 #include "str-util.hh"
 #include "tiny-format.hh"
+#include "thread-pool.hh"
 #include "tinyusdz.hh"
 #include "usdGeom.hh"
 #include "usdLux.hh"
@@ -74,14 +80,102 @@ RECONSTRUCT_PRIM_DECL(Shader);
 
 namespace {
 
-bool IsVisited(const std::vector<std::set<std::string>> layer_names_stack,
-               const std::string &name) {
-  for (size_t i = 0; i < layer_names_stack.size(); i++) {
-    if (layer_names_stack[i].count(name)) {
-      return true;
+// Tracks subLayer assets on the path from the root Layer to the Layer being
+// composed, to detect circular subLayers.
+//
+// Asset paths are interned to integer ids, so the check is a single hash
+// lookup regardless of the depth of the subLayer stack.
+class AssetVisitTracker {
+ public:
+  uint32_t intern(const std::string &asset_path) {
+    auto it = _ids.find(asset_path);
+    if (it != _ids.end()) {
+      return it->second;
     }
+
+    uint32_t id = uint32_t(_ids.size());
+    _ids.emplace(asset_path, id);
+    _on_path.push_back(0);
+    return id;
   }
-  return false;
+
+  bool is_visited(uint32_t id) const { return _on_path[id] != 0; }
+
+  // Assume `id` is not on the path.
+  void push(uint32_t id) {
+    _path.push_back(id);
+    _on_path[id] = 1;
+  }
+
+  void pop() {
+    _on_path[_path.back()] = 0;
+    _path.pop_back();
+  }
+
+ private:
+  std::unordered_map<std::string, uint32_t> _ids;
+  std::vector<uint32_t> _path;     // ids from the root.
+  std::vector<uint8_t> _on_path;  // id -> 1 when the id is in `_path`.
+};
+
+// Records the scope as a trace event to CompositionStats. No-op when `stats` is
+// nullptr.
+class TraceScope {
+ public:
+  TraceScope(CompositionStats *stats, const char *name, const char *category,
+             const std::string &asset, const std::string &prim = std::string())
+      : _stats(stats) {
+    if (!_stats) {
+      return;
+    }
+
+    if (_stats->record_events()) {
+      _event.name = name;
+      _event.category = category;
+      _event.asset = asset;
+      _event.prim = prim;
+    }
+    _event.start_ms = performance::now();
+  }
+
+  ~TraceScope() {
+    if (_stats && _stats->record_events()) {
+      _event.duration_ms = elapsed_ms();
+      _stats->add_event(std::move(_event));
+    }
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+  double elapsed_ms() const {
+    return _stats ? (performance::now() - _event.start_ms) : 0.0;
+  }
+
+ private:
+  CompositionStats *_stats{nullptr};
+  CompositionTraceEvent _event;
+};
+
+// 64bit FNV-1a hash. Process 8 bytes at once for speed(the result is
+// different from the byte-wise FNV-1a, but it is only used for detecting the
+// change of the asset content).
+uint64_t HashAssetContent(const uint8_t *data, size_t nbytes) {
+  const uint64_t kPrime = 0x100000001b3ull;
+  uint64_t h = 0xcbf29ce484222325ull;
+
+  size_t i = 0;
+  for (; (i + 8) <= nbytes; i += 8) {
+    uint64_t v;
+    memcpy(&v, data + i, 8);
+    h = (h ^ v) * kPrime;
+  }
+
+  for (; i < nbytes; i++) {
+    h = (h ^ uint64_t(data[i])) * kPrime;
+  }
+
+  return h;
 }
 
 std::string GetExtension(const std::string &name) {
@@ -131,8 +225,10 @@ bool IsBuiltinFileFormat(const std::string &name) {
 // TODO: support loading non-USD asset
 bool LoadAsset(AssetResolutionResolver &resolver,
                const std::map<std::string, FileFormatHandler> &fileformats,
-               const value::AssetPath &assetPath, const Path &primPath,
-               Layer *dst_layer, const PrimSpec **dst_primspec_root,
+               LayerCache *layer_cache, std::set<std::string> *loaded_assets,
+               CompositionStats *stats, const value::AssetPath &assetPath,
+               const Path &primPath, std::shared_ptr<const Layer> *dst_layer,
+               const PrimSpec **dst_primspec_root,
                const bool error_when_no_prims_found,
                const bool error_when_asset_not_found,
                const bool error_when_unsupported_fileformat, std::string *warn,
@@ -142,6 +238,10 @@ bool LoadAsset(AssetResolutionResolver &resolver,
         "[Internal error]. `dst_layer` output arg is nullptr.");
   }
 
+  if (dst_primspec_root) {
+    (*dst_primspec_root) = nullptr;
+  }
+
   std::string asset_path = assetPath.GetAssetPath();
   std::string ext = GetExtension(asset_path);
 
@@ -164,11 +264,14 @@ bool LoadAsset(AssetResolutionResolver &resolver,
           fmt::format("Failed to resolve asset path `{}`", asset_path));
     } else {
       PUSH_WARN(fmt::format("Asset not found: `{}`", asset_path));
-      (*dst_primspec_root) = nullptr;
       return true;
     }
   }
 
+  if (loaded_assets) {
+    loaded_assets->insert(resolved_path);
+  }
+
   // Add resolved asset_path's basedir to search path.
   std::string base_dir = io::GetBaseDir(resolved_path);
   if (base_dir.size()) {
@@ -176,14 +279,6 @@ bool LoadAsset(AssetResolutionResolver &resolver,
     resolver.add_seartch_path(base_dir);
   }
 
-  Asset asset;
-  if (!resolver.open_asset(resolved_path, asset_path, &asset, warn, err)) {
-    PUSH_ERROR_AND_RETURN(fmt::format("Failed to open asset `{}`.", resolved_path));
-  }
-
-  DCOUT("Opened resolved assst: " << resolved_path
-                               << ", asset_path: " << asset_path);
-
   if (IsBuiltinFileFormat(asset_path)) {
     if (IsUSDFileFormat(asset_path) || IsMtlxFileFormat(asset_path)) {
       // ok
@@ -216,74 +311,129 @@ bool LoadAsset(AssetResolutionResolver &resolver,
     }
   }
 
-  Layer layer;
-  std::string _warn;
-  std::string _err;
-
-  if (IsUSDFileFormat(asset_path)) {
-    if (!LoadLayerFromMemory(asset.data(), asset.size(), asset_path, &layer, &_warn, &_err)) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("Failed to open `{}` as Layer: {}", asset_path, _err));
-    }
-  } else if (IsMtlxFileFormat(asset_path)) {
-
+  if (IsMtlxFileFormat(asset_path)) {
     // primPath must be '</MaterialX>'
     if (primPath.prim_part() != "/MaterialX") {
       PUSH_ERROR_AND_RETURN("Prim path must be </MaterialX>, but got: " + primPath.prim_part());
     }
+  }
 
-    PrimSpec ps;
-    if (!LoadMaterialXFromAsset(asset, asset_path, ps, &_warn, &_err)) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("Failed to open mtlx asset `{}`", asset_path));
+  std::shared_ptr<const Layer> cached_layer;
+
+  // Fast path: Do not read the asset.
+  if (layer_cache && !layer_cache->validate_content()) {
+    cached_layer = layer_cache->find(resolved_path);
+  }
+
+  Asset asset;
+  if (!cached_layer) {
+    TraceScope trace(stats, "read", "asset", asset_path);
+
+    if (!resolver.open_asset(resolved_path, asset_path, &asset, warn, err)) {
+      PUSH_ERROR_AND_RETURN(fmt::format("Failed to open asset `{}`.", resolved_path));
     }
 
-    ps.name() = "MaterialX";
-    layer.primspecs()["MaterialX"] = ps;
+    DCOUT("Opened resolved assst: " << resolved_path
+                                 << ", asset_path: " << asset_path);
 
+    if (stats) {
+      stats->add(&CompositionCounters::bytes_read, uint64_t(asset.size()));
+    }
+
+    if (layer_cache && layer_cache->validate_content()) {
+      cached_layer = layer_cache->find(resolved_path, &asset);
+    }
+  }
+
+  if (cached_layer) {
+    if (stats) {
+      stats->add(&CompositionCounters::asset_cache_hits);
+    }
+
+    // Report warnings of the Layer loaded by PrefetchAssets here, so that
+    // they are in the same order as the single-threaded composition.
+    std::string cached_warn = layer_cache->take_warning(resolved_path);
+    if (cached_warn.size() && warn) {
+      (*warn) += cached_warn;
+    }
   } else {
-    if (fileformats.count(ext)) {
-      PrimSpec ps;
-      const FileFormatHandler &handler= fileformats.at(ext);
+    TraceScope trace(stats, "parse", "asset", asset_path);
+
+    Layer layer;
+    std::string _warn;
+    std::string _err;
 
-      if (!handler.reader(asset, ps, &_warn, &_err, handler.userdata)) {
+    if (IsUSDFileFormat(asset_path)) {
+      // Read through const Asset to avoid copy-on-write of mmap-ed content.
+      const Asset &casset = asset;
+      if (!LoadLayerFromMemory(casset.data(), casset.size(), asset_path, &layer, &_warn, &_err)) {
         PUSH_ERROR_AND_RETURN(
-            fmt::format("Failed to read asset `{}` error: {}", asset_path, _err));
+            fmt::format("Failed to open `{}` as Layer: {}", asset_path, _err));
       }
+    } else if (IsMtlxFileFormat(asset_path)) {
 
-      if (ps.name().empty()) {
+      PrimSpec ps;
+      if (!LoadMaterialXFromAsset(asset, asset_path, ps, &_warn, &_err)) {
         PUSH_ERROR_AND_RETURN(
-            fmt::format("PrimSpec element_name is empty. asset `{}`", asset_path));
+            fmt::format("Failed to open mtlx asset `{}`: {}", asset_path, _err));
       }
 
-      layer.primspecs()[ps.name()] = ps;
-      DCOUT("Read asset from custom fileformat handler: " << ext);
+      ps.name() = "MaterialX";
+      layer.primspecs()["MaterialX"] = ps;
+
     } else {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("FileFormat handler not found for asset `{}`", asset_path));
+      if (fileformats.count(ext)) {
+        PrimSpec ps;
+        const FileFormatHandler &handler= fileformats.at(ext);
+
+        if (!handler.reader(asset, ps, &_warn, &_err, handler.userdata)) {
+          PUSH_ERROR_AND_RETURN(
+              fmt::format("Failed to read asset `{}` error: {}", asset_path, _err));
+        }
+
+        if (ps.name().empty()) {
+          PUSH_ERROR_AND_RETURN(
+              fmt::format("PrimSpec element_name is empty. asset `{}`", asset_path));
+        }
+
+        layer.primspecs()[ps.name()] = ps;
+        DCOUT("Read asset from custom fileformat handler: " << ext);
+      } else {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("FileFormat handler not found for asset `{}`", asset_path));
+      }
     }
-  }
 
-  DCOUT("layer = " << print_layer(layer, 0));
+    DCOUT("layer = " << print_layer(layer, 0));
 
-  // TODO: Recursively resolve `references`
+    // TODO: Recursively resolve `references`
 
-  if (_warn.size()) {
-    if (warn) {
-      (*warn) += _warn;
+    if (_warn.size()) {
+      if (warn) {
+        (*warn) += _warn;
+      }
+    }
+
+    cached_layer = std::make_shared<const Layer>(std::move(layer));
+
+    if (layer_cache) {
+      layer_cache->insert(resolved_path, asset, cached_layer);
+    }
+
+    if (stats) {
+      stats->add(&CompositionCounters::assets_loaded);
+      stats->add_parse_time(trace.elapsed_ms());
     }
   }
 
+  const Layer &layer = *cached_layer;
+
   if (layer.primspecs().empty()) {
     if (error_when_no_prims_found) {
       PUSH_ERROR_AND_RETURN(fmt::format("No prims in layer `{}`", asset_path));
     }
 
-    if (dst_primspec_root) {
-      (*dst_primspec_root) = nullptr;
-    }
-
-    (*dst_layer) = std::move(layer);
+    (*dst_layer) = std::move(cached_layer);
 
     return true;
   }
@@ -318,39 +468,214 @@ bool LoadAsset(AssetResolutionResolver &resolver,
     (*dst_primspec_root) = src_ps;
   }
 
-  (*dst_layer) = std::move(layer);
+  (*dst_layer) = std::move(cached_layer);
 
   return true;
 }
 
+//
+// Load(parse) USD assets concurrently and store them to `layer_cache`, so
+// that following LoadAsset() calls in the (serial) composition pass hit the
+// cache.
+//
+// Asset paths are resolved serially in the given order, in the same manner as
+// LoadAsset, since resolving an asset appends its base dir to the search
+// paths(so the result depends on the order). This is done with a copy of
+// `resolver`, so the search paths seen by the serial pass are the same as
+// the single-threaded composition. Errors are ignored here; they are reported
+// by LoadAsset. Warnings are stored to `layer_cache` with the Layer and
+// reported when LoadAsset uses it.
+// Non-USD assets are not prefetched(FileFormatHandler may not be
+// thread-safe).
+//
+void PrefetchAssets(const AssetResolutionResolver &_resolver,
+                    const std::vector<value::AssetPath> &asset_paths,
+                    LayerCache *layer_cache, uint32_t num_threads,
+                    CompositionStats *stats) {
+  if (!layer_cache) {
+    return;
+  }
+
+  num_threads = ThreadPool::resolve_num_threads(num_threads);
+  if (num_threads <= 1) {
+    return;
+  }
+
+  AssetResolutionResolver resolver = _resolver;
+
+  struct PrefetchItem {
+    std::string asset_path;
+    std::string resolved_path;
+  };
+
+  std::vector<PrefetchItem> items;
+  std::set<std::string> resolved_paths;
+
+  for (const auto &assetPath : asset_paths) {
+    std::string asset_path = assetPath.GetAssetPath();
+    if (asset_path.empty() || !IsUSDFileFormat(asset_path)) {
+      continue;
+    }
+
+    std::string resolved_path = resolver.resolve(asset_path);
+    if (resolved_path.empty()) {
+      continue;
+    }
+
+    std::string base_dir = io::GetBaseDir(resolved_path);
+    if (base_dir.size()) {
+      resolver.add_seartch_path(base_dir);
+    }
+
+    if (!resolved_paths.insert(resolved_path).second) {
+      // Already listed.
+      continue;
+    }
+
+    if (!layer_cache->validate_content() &&
+        layer_cache->contains(resolved_path)) {
+      continue;
+    }
+
+    PrefetchItem item;
+    item.asset_path = asset_path;
+    item.resolved_path = resolved_path;
+    items.emplace_back(std::move(item));
+  }
+
+  if (items.size() < 2) {
+    // Nothing to be parallelized.
+    return;
+  }
+
+  ThreadPool pool(uint32_t((std::min)(size_t(num_threads), items.size())));
+
+  for (auto &item : items) {
+    PrefetchItem *pitem = &item;
+    pool.submit([&resolver, layer_cache, stats, pitem]() {
+      Asset asset;
+      std::string _warn;
+      std::string _err;
+      {
+        TraceScope trace(stats, "read", "asset", pitem->asset_path);
+        if (!resolver.open_asset(pitem->resolved_path, pitem->asset_path,
+                                 &asset, &_warn, &_err)) {
+          return;
+        }
+      }
+
+      // LoadAsset opens the asset again(and reports its warnings) when the
+      // cache validates content.
+      if (layer_cache->validate_content()) {
+        _warn.clear();
+      }
+
+      if (stats) {
+        stats->add(&CompositionCounters::bytes_read, uint64_t(asset.size()));
+      }
+
+      if (layer_cache->contains(pitem->resolved_path, &asset)) {
+        return;
+      }
+
+      const Asset &casset = asset;
+
+      TraceScope trace(stats, "parse", "asset", pitem->asset_path);
+
+      Layer layer;
+      if (!LoadLayerFromMemory(casset.data(), casset.size(), pitem->asset_path,
+                               &layer, &_warn, &_err)) {
+        return;
+      }
+
+      layer_cache->insert(pitem->resolved_path, asset,
+                          std::make_shared<const Layer>(std::move(layer)),
+                          _warn);
+
+      if (stats) {
+        stats->add(&CompositionCounters::assets_loaded);
+        stats->add_parse_time(trace.elapsed_ms());
+      }
+    });
+  }
+
+  pool.wait();
+}
+
+void CollectReferenceAssetPathsRec(uint32_t depth, const PrimSpec &primspec,
+                                   uint32_t max_depth,
+                                   std::vector<value::AssetPath> *asset_paths) {
+  if (depth > max_depth) {
+    return;
+  }
+
+  // Same order with CompositeReferencesRec.
+  for (const auto &child : primspec.children()) {
+    CollectReferenceAssetPathsRec(depth + 1, child, max_depth, asset_paths);
+  }
+
+  if (primspec.metas().references) {
+    for (const auto &reference : primspec.metas().references.value().second) {
+      asset_paths->push_back(reference.asset_path);
+    }
+  }
+}
+
+void CollectPayloadAssetPathsRec(uint32_t depth, const std::string &prim_path,
+                                 const PrimSpec &primspec,
+                                 const PayloadLoadRules *load_rules,
+                                 uint32_t max_depth,
+                                 std::vector<value::AssetPath> *asset_paths) {
+  if (depth > max_depth) {
+    return;
+  }
+
+  // Same order with CompositePayloadRec.
+  for (const auto &child : primspec.children()) {
+    CollectPayloadAssetPathsRec(depth + 1, prim_path + "/" + child.name(),
+                                child, load_rules, max_depth, asset_paths);
+  }
+
+  if (primspec.metas().payload &&
+      (!load_rules || load_rules->is_loaded(prim_path))) {
+    for (const auto &pl : primspec.metas().payload.value().second) {
+      asset_paths->push_back(pl.asset_path);
+    }
+  }
+}
+
 
 bool CompositeSublayersRec(AssetResolutionResolver &resolver,
-                           const Layer &in_layer,
-                           std::vector<std::set<std::string>> layer_names_stack,
+                           const Layer &in_layer, uint32_t depth,
+                           AssetVisitTracker &visited,
                            Layer *composited_layer, std::string *warn,
                            std::string *err,
                            const SublayersCompositionOptions &options) {
-  if (layer_names_stack.size() > options.max_depth) {
+  if (depth > options.max_depth) {
     if (err) {
       (*err) += "subLayer is nested too deeply.";
     }
     return false;
   }
 
-  layer_names_stack.emplace_back(std::set<std::string>());
-  std::set<std::string> &curr_layer_names = layer_names_stack.back();
+  if (options.num_threads != 1) {
+    std::vector<value::AssetPath> asset_paths;
+    for (const auto &layer : in_layer.metas().subLayers) {
+      asset_paths.push_back(layer.assetPath);
+    }
+
+    PrefetchAssets(resolver, asset_paths, options.layer_cache,
+                   options.num_threads, options.stats);
+  }
 
   for (const auto &layer : in_layer.metas().subLayers) {
     // TODO: subLayerOffset
     std::string sublayer_asset_path = layer.assetPath.GetAssetPath();
     DCOUT("Load subLayer " << sublayer_asset_path);
 
-    // Do cyclic referencing check.
-    // TODO: Use resolved name?
-    if (IsVisited(layer_names_stack, sublayer_asset_path)) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("Circular referenceing detected for subLayer: {} in {}",
-                      sublayer_asset_path, in_layer.name()));
+    TraceScope trace(options.stats, "subLayers", "arc", sublayer_asset_path);
+    if (options.stats) {
+      options.stats->add(&CompositionCounters::sublayer_arcs);
     }
 
     std::string layer_filepath = resolver.resolve(sublayer_asset_path);
@@ -360,26 +685,50 @@ bool CompositeSublayersRec(AssetResolutionResolver &resolver,
                                         resolver.search_paths_str()));
     }
 
-    tinyusdz::Layer sublayer;
-    if (!LoadAsset(resolver, options.fileformats, layer.assetPath, /* not_used */Path::make_root_path(), &sublayer, /* primspec_root */nullptr, options.error_when_no_prims_in_sublayer, options.error_when_asset_not_found, options.error_when_unsupported_fileformat, warn, err)) {
+    // Do cyclic referencing check(with resolved path).
+    const uint32_t asset_id = visited.intern(layer_filepath);
+    if (visited.is_visited(asset_id)) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("Circular referenceing detected for subLayer: {} in {}",
+                      sublayer_asset_path, in_layer.name()));
+    }
+
+    // NOTE: `sublayer` may be shared with other composition arcs through
+    // LayerCache, so do not modify it.
+    std::shared_ptr<const Layer> sublayer;
+    if (!LoadAsset(resolver, options.fileformats, options.layer_cache, options.loaded_assets, options.stats, layer.assetPath, /* not_used */Path::make_root_path(), &sublayer, /* primspec_root */nullptr, options.error_when_no_prims_in_sublayer, options.error_when_asset_not_found, options.error_when_unsupported_fileformat, warn, err)) {
       PUSH_ERROR_AND_RETURN(fmt::format("Load asset in subLayer failed: `{}`", layer.assetPath));
     }
 
-    curr_layer_names.insert(sublayer_asset_path);
+    if (!sublayer) {
+      // LoadAsset allowed not-found or unsupported file. so do nothing.
+      continue;
+    }
 
     Layer composited_sublayer;
 
     // Recursively load subLayer
-    if (!CompositeSublayersRec(resolver, sublayer, layer_names_stack,
+    visited.push(asset_id);
+    if (!CompositeSublayersRec(resolver, *sublayer, depth + 1, visited,
                                &composited_sublayer, warn, err, options)) {
       return false;
     }
+    visited.pop();
 
     {
       // 1/2. merge sublayer's sublayers
 
       // NOTE: `over` specifier is ignored when merging Prims among different
       // subLayers
+      if (composited_layer->primspecs().empty()) {
+        // Fast path(e.g. the first subLayer). PrimSpec names are already
+        // validated, so move the whole map instead of moving PrimSpecs one by
+        // one, which is quadratic for a deeply nested subLayer stack.
+        composited_layer->primspecs() =
+            std::move(composited_sublayer.primspecs());
+        composited_sublayer.primspecs().clear();
+      }
+
       for (auto &prim : composited_sublayer.primspecs()) {
         if (composited_layer->has_primspec(prim.first)) {
           // Skip
@@ -395,12 +744,11 @@ bool CompositeSublayersRec(AssetResolutionResolver &resolver,
       }
 
       // 2/2. merge sublayer
-      for (auto &prim : sublayer.primspecs()) {
+      for (const auto &prim : sublayer->primspecs()) {
         if (composited_layer->has_primspec(prim.first)) {
           // Skip
         } else {
-          if (!composited_layer->emplace_primspec(prim.first,
-                                                  std::move(prim.second))) {
+          if (!composited_layer->add_primspec(prim.first, prim.second)) {
             PUSH_ERROR_AND_RETURN(
                 fmt::format("Compositing PrimSpec {} in {} failed.", prim.first,
                             layer_filepath));
@@ -411,13 +759,321 @@ bool CompositeSublayersRec(AssetResolutionResolver &resolver,
     }
   }
 
-  layer_names_stack.pop_back();
+  return true;
+}
+
+}  // namespace
+
+std::shared_ptr<const Layer> LayerCache::find(const std::string &resolved_path,
+                                              const Asset *asset) {
+  uint64_t nbytes{0};
+  uint64_t hash{0};
+  if (_validate_content && asset) {
+    // Compute the hash outside of the lock.
+    nbytes = uint64_t(asset->size());
+    hash = HashAssetContent(asset->data(), asset->size());
+  }
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  auto it = _entries.find(resolved_path);
+  if (it == _entries.end()) {
+    _stats.misses++;
+    return nullptr;
+  }
+
+  if (_validate_content) {
+    if (!asset || (it->second.nbytes != nbytes) || (it->second.hash != hash)) {
+      // Content changed(or cannot be validated).
+      _entries.erase(it);
+      _stats.invalidations++;
+      _stats.misses++;
+      return nullptr;
+    }
+  }
+
+  _stats.hits++;
+  return it->second.layer;
+}
+
+bool LayerCache::contains(const std::string &resolved_path,
+                          const Asset *asset) const {
+  uint64_t nbytes{0};
+  uint64_t hash{0};
+  if (_validate_content) {
+    if (!asset) {
+      return false;
+    }
+    nbytes = uint64_t(asset->size());
+    hash = HashAssetContent(asset->data(), asset->size());
+  }
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  auto it = _entries.find(resolved_path);
+  if (it == _entries.end()) {
+    return false;
+  }
+
+  if (_validate_content) {
+    return (it->second.nbytes == nbytes) && (it->second.hash == hash);
+  }
 
   return true;
 }
 
+void LayerCache::insert(const std::string &resolved_path, const Asset &asset,
+                        std::shared_ptr<const Layer> layer,
+                        const std::string &warn) {
+  Entry entry;
+  entry.nbytes = uint64_t(asset.size());
+  if (_validate_content) {
+    entry.hash = HashAssetContent(asset.data(), asset.size());
+  }
+  entry.layer = std::move(layer);
+  entry.warn = warn;
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  _entries[resolved_path] = std::move(entry);
+}
+
+std::string LayerCache::take_warning(const std::string &resolved_path) {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  auto it = _entries.find(resolved_path);
+  if (it == _entries.end()) {
+    return std::string();
+  }
+
+  std::string warn;
+  warn.swap(it->second.warn);
+  return warn;
+}
+
+bool LayerCache::erase(const std::string &resolved_path) {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  return _entries.erase(resolved_path) > 0;
+}
+
+size_t LayerCache::size() const {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  return _entries.size();
+}
+
+void LayerCache::clear() {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  _entries.clear();
+}
+
+LayerCacheStats LayerCache::stats() const {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  return _stats;
+}
+
+void LayerCache::reset_stats() {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  _stats = LayerCacheStats();
+}
+
+namespace {
+
+std::string EscapeJSONString(const std::string &str) {
+  std::string s;
+  s.reserve(str.size());
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        s += "\\\"";
+        break;
+      case '\\':
+        s += "\\\\";
+        break;
+      case '\n':
+        s += "\\n";
+        break;
+      case '\r':
+        s += "\\r";
+        break;
+      case '\t':
+        s += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", int(c));
+          s += buf;
+        } else {
+          s += c;
+        }
+        break;
+    }
+  }
+  return s;
+}
+
+// tiny-format does not support precision.
+std::string FormatFixed3(double v) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.3f", v);
+  return buf;
+}
+
 }  // namespace
 
+CompositionStats::CompositionStats(bool record_events)
+    : _record_events(record_events), _start_ms(performance::now()) {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  // The creating thread is always thread_id 0, even when a worker thread
+  // adds the first event.
+  _thread_ids.emplace(std::this_thread::get_id(), 0);
+#endif
+}
+
+uint32_t CompositionStats::thread_id() {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  // Assume `_mutex` is locked.
+  auto it = _thread_ids.find(std::this_thread::get_id());
+  if (it != _thread_ids.end()) {
+    return it->second;
+  }
+
+  uint32_t id = uint32_t(_thread_ids.size());
+  _thread_ids.emplace(std::this_thread::get_id(), id);
+  return id;
+#else
+  return 0;
+#endif
+}
+
+void CompositionStats::add(uint64_t CompositionCounters::*counter,
+                           uint64_t n) {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  _counters.*counter += n;
+}
+
+void CompositionStats::add_parse_time(double ms) {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  _counters.parse_time_ms += ms;
+}
+
+void CompositionStats::add_event(CompositionTraceEvent &&event) {
+  if (!_record_events) {
+    return;
+  }
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  event.thread_id = thread_id();
+  _events.emplace_back(std::move(event));
+}
+
+CompositionCounters CompositionStats::counters() const {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  return _counters;
+}
+
+std::vector<CompositionTraceEvent> CompositionStats::events() const {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  return _events;
+}
+
+void CompositionStats::clear() {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::lock_guard<std::mutex> lock(_mutex);
+#endif
+
+  _counters = CompositionCounters();
+  _events.clear();
+}
+
+std::string CompositionStats::to_chrome_trace_json() const {
+  const CompositionCounters c = counters();
+  const std::vector<CompositionTraceEvent> evs = events();
+
+  std::string s = "{\"traceEvents\":[";
+
+  for (size_t i = 0; i < evs.size(); i++) {
+    const CompositionTraceEvent &ev = evs[i];
+    if (i > 0) {
+      s += ",";
+    }
+
+    // Complete event("X"). Timestamps are in microseconds.
+    s += "\n{\"name\":\"" + EscapeJSONString(ev.name) + "\"";
+    s += ",\"cat\":\"" + EscapeJSONString(ev.category) + "\"";
+    s += ",\"ph\":\"X\"";
+    s += ",\"ts\":" + FormatFixed3((ev.start_ms - _start_ms) * 1000.0);
+    s += ",\"dur\":" + FormatFixed3(ev.duration_ms * 1000.0);
+    s += fmt::format(",\"pid\":1,\"tid\":{}", ev.thread_id);
+    s += ",\"args\":{";
+    bool has_arg{false};
+    if (ev.asset.size()) {
+      s += "\"asset\":\"" + EscapeJSONString(ev.asset) + "\"";
+      has_arg = true;
+    }
+    if (ev.prim.size()) {
+      if (has_arg) {
+        s += ",";
+      }
+      s += "\"prim\":\"" + EscapeJSONString(ev.prim) + "\"";
+    }
+    s += "}}";
+  }
+
+  s += "\n],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{";
+  s += fmt::format("\"sublayer_arcs\":{}", c.sublayer_arcs);
+  s += fmt::format(",\"reference_arcs\":{}", c.reference_arcs);
+  s += fmt::format(",\"payload_arcs\":{}", c.payload_arcs);
+  s += fmt::format(",\"inherit_arcs\":{}", c.inherit_arcs);
+  s += fmt::format(",\"assets_loaded\":{}", c.assets_loaded);
+  s += fmt::format(",\"asset_cache_hits\":{}", c.asset_cache_hits);
+  s += fmt::format(",\"bytes_read\":{}", c.bytes_read);
+  s += fmt::format(",\"override_merges\":{}", c.override_merges);
+  s += fmt::format(",\"inherit_merges\":{}", c.inherit_merges);
+  s += ",\"parse_time_ms\":" + FormatFixed3(c.parse_time_ms);
+  s += "}\n}\n";
+
+  return s;
+}
+
 bool CompositeSublayers(AssetResolutionResolver &resolver,
                         const Layer &in_layer, Layer *composited_layer,
                         std::string *warn, std::string *err,
@@ -426,10 +1082,19 @@ bool CompositeSublayers(AssetResolutionResolver &resolver,
     return false;
   }
 
-  std::vector<std::set<std::string>> layer_names_stack;
+  TraceScope trace(options.stats, "CompositeSublayers", "pass",
+                   in_layer.name());
+
+  AssetVisitTracker visited;
+
+  // Assets are not modified during the composition.
+  LayerCache local_layer_cache(/* validate_content */ false);
+  if (!options.layer_cache) {
+    options.layer_cache = &local_layer_cache;
+  }
 
   DCOUT("Resolve subLayers..");
-  if (!CompositeSublayersRec(resolver, in_layer, layer_names_stack,
+  if (!CompositeSublayersRec(resolver, in_layer, /* depth */ 0, visited,
                              composited_layer, warn, err, options)) {
     PUSH_ERROR_AND_RETURN("Composite subLayers failed.");
   }
@@ -449,6 +1114,9 @@ bool CompositeSublayers(AssetResolutionResolver &resolver,
         if (!OverridePrimSpec(dst, prim.second, warn, err)) {
           return false;
         }
+        if (options.stats) {
+          options.stats->add(&CompositionCounters::override_merges);
+        }
       } else if (prim.second.specifier() == Specifier::Def) {
         DCOUT("overewrite prim: " << prim.first);
         // overwrite
@@ -504,10 +1172,16 @@ bool CompositeReferencesRec(uint32_t depth, AssetResolutionResolver &resolver,
     if ((qual == ListEditQual::ResetToExplicit) ||
         (qual == ListEditQual::Prepend)) {
       for (const auto &reference : refecences) {
-        Layer layer;
+        TraceScope trace(options.stats, "references", "arc",
+                         reference.asset_path.GetAssetPath(), primspec.name());
+        if (options.stats) {
+          options.stats->add(&CompositionCounters::reference_arcs);
+        }
+
+        std::shared_ptr<const Layer> layer;
         const PrimSpec *src_ps{nullptr};
 
-        if (!LoadAsset(resolver, options.fileformats, reference.asset_path, reference.prim_path,
+        if (!LoadAsset(resolver, options.fileformats, options.layer_cache, options.loaded_assets, options.stats, reference.asset_path, reference.prim_path,
                        &layer, &src_ps, /* error_when_no_prims_found */true, options.error_when_asset_not_found,
                        options.error_when_unsupported_fileformat, warn, err)) {
           PUSH_ERROR_AND_RETURN(
@@ -548,10 +1222,16 @@ bool CompositeReferencesRec(uint32_t depth, AssetResolutionResolver &resolver,
       PUSH_ERROR_AND_RETURN("Invalid listedit qualifier to for `references`.");
     } else if (qual == ListEditQual::Append) {
       for (const auto &reference : refecences) {
-        Layer layer;
+        TraceScope trace(options.stats, "references", "arc",
+                         reference.asset_path.GetAssetPath(), primspec.name());
+        if (options.stats) {
+          options.stats->add(&CompositionCounters::reference_arcs);
+        }
+
+        std::shared_ptr<const Layer> layer;
         const PrimSpec *src_ps{nullptr};
 
-        if (!LoadAsset(resolver, options.fileformats, reference.asset_path, reference.prim_path,
+        if (!LoadAsset(resolver, options.fileformats, options.layer_cache, options.loaded_assets, options.stats, reference.asset_path, reference.prim_path,
                        &layer, &src_ps, /* error_when_no_prims */true, options.error_when_asset_not_found,
                        options.error_when_unsupported_fileformat, warn, err)) {
           PUSH_ERROR_AND_RETURN(
@@ -565,6 +1245,9 @@ bool CompositeReferencesRec(uint32_t depth, AssetResolutionResolver &resolver,
         }
 
         // `over` op
+        if (options.stats) {
+          options.stats->add(&CompositionCounters::override_merges);
+        }
         if (!OverridePrimSpec(primspec, *src_ps, warn, err)) {
           PUSH_ERROR_AND_RETURN(
               fmt::format("Failed to reference layer `{}`", reference.asset_path));
@@ -589,6 +1272,7 @@ bool CompositeReferencesRec(uint32_t depth, AssetResolutionResolver &resolver,
 }
 
 bool CompositePayloadRec(uint32_t depth, AssetResolutionResolver &resolver,
+                         const std::string &prim_path,
                          PrimSpec &primspec /* [inout] */, std::string *warn,
                          std::string *err,
                          const PayloadCompositionOptions &options) {
@@ -598,11 +1282,19 @@ bool CompositePayloadRec(uint32_t depth, AssetResolutionResolver &resolver,
 
   // Traverse children first.
   for (auto &child : primspec.children()) {
-    if (!CompositePayloadRec(depth + 1, resolver, child, warn, err, options)) {
+    if (!CompositePayloadRec(depth + 1, resolver,
+                             prim_path + "/" + child.name(), child, warn, err,
+                             options)) {
       return false;
     }
   }
 
+  if (primspec.metas().payload && options.load_rules &&
+      !options.load_rules->is_loaded(prim_path)) {
+    // Unloaded. Keep `payload` metadatum.
+    return true;
+  }
+
   if (primspec.metas().payload) {
     const ListEditQual &qual = primspec.metas().payload.value().first;
     const auto &payloads = primspec.metas().payload.value().second;
@@ -617,9 +1309,15 @@ bool CompositePayloadRec(uint32_t depth, AssetResolutionResolver &resolver,
               "TODO: Prim path(e.g. </xform>) in references.");
         }
 
-        Layer layer;
+        TraceScope trace(options.stats, "payload", "arc",
+                         pl.asset_path.GetAssetPath(), prim_path);
+        if (options.stats) {
+          options.stats->add(&CompositionCounters::payload_arcs);
+        }
+
+        std::shared_ptr<const Layer> layer;
         const PrimSpec *src_ps{nullptr};
-        if (!LoadAsset(resolver, options.fileformats, pl.asset_path, pl.prim_path,
+        if (!LoadAsset(resolver, options.fileformats, options.layer_cache, options.loaded_assets, options.stats, pl.asset_path, pl.prim_path,
                        &layer, &src_ps, /* error_when_no_prims_found */true, options.error_when_asset_not_found,
                        options.error_when_unsupported_fileformat, warn, err)) {
           PUSH_ERROR_AND_RETURN(
@@ -667,9 +1365,15 @@ bool CompositePayloadRec(uint32_t depth, AssetResolutionResolver &resolver,
               "TODO: Prim path(e.g. </xform>) in references.");
         }
 
-        Layer layer;
+        TraceScope trace(options.stats, "payload", "arc",
+                         pl.asset_path.GetAssetPath(), prim_path);
+        if (options.stats) {
+          options.stats->add(&CompositionCounters::payload_arcs);
+        }
+
+        std::shared_ptr<const Layer> layer;
         const PrimSpec *src_ps{nullptr};
-        if (!LoadAsset(resolver, options.fileformats, pl.asset_path, pl.prim_path,
+        if (!LoadAsset(resolver, options.fileformats, options.layer_cache, options.loaded_assets, options.stats, pl.asset_path, pl.prim_path,
                        &layer, &src_ps, /* error_when_no_prims_found */true, options.error_when_asset_not_found,
                        options.error_when_unsupported_fileformat, warn, err)) {
           PUSH_ERROR_AND_RETURN(
@@ -683,6 +1387,9 @@ bool CompositePayloadRec(uint32_t depth, AssetResolutionResolver &resolver,
         }
 
         // `over` op
+        if (options.stats) {
+          options.stats->add(&CompositionCounters::override_merges);
+        }
         if (!OverridePrimSpec(primspec, *src_ps, warn, err)) {
           PUSH_ERROR_AND_RETURN(
               fmt::format("Failed to reference layer `{}`", asset_path));
@@ -734,14 +1441,14 @@ bool CompositeVariantRec(uint32_t depth, PrimSpec &primspec /* [inout] */,
 
 bool CompositeInheritsRec(uint32_t depth, const Layer &layer,
                           PrimSpec &primspec /* [inout] */, std::string *warn,
-                          std::string *err) {
+                          std::string *err, CompositionStats *stats) {
   if (depth > (1024 * 1024)) {
     PUSH_ERROR_AND_RETURN("Too deep.");
   }
 
   // Traverse children first.
   for (auto &child : primspec.children()) {
-    if (!CompositeInheritsRec(depth + 1, layer, child, warn, err)) {
+    if (!CompositeInheritsRec(depth + 1, layer, child, warn, err, stats)) {
       return false;
     }
   }
@@ -765,6 +1472,12 @@ bool CompositeInheritsRec(uint32_t depth, const Layer &layer,
 
     const Path &inheritPath = inherits[0];
 
+    TraceScope trace(stats, "inherits", "arc", std::string(),
+                     primspec.name());
+    if (stats) {
+      stats->add(&CompositionCounters::inherit_arcs);
+    }
+
     const PrimSpec *inheritPrimSpec{nullptr};
 
     if (!layer.find_primspec_at(inheritPath, &inheritPrimSpec, err)) {
@@ -784,6 +1497,9 @@ bool CompositeInheritsRec(uint32_t depth, const Layer &layer,
       if (!InheritPrimSpec(primspec, *inheritPrimSpec, warn, err)) {
         return false;
       }
+      if (stats) {
+        stats->add(&CompositionCounters::inherit_merges);
+      }
 
       // remove `inherits` metadataum.
       primspec.metas().inherits.reset();
@@ -811,8 +1527,28 @@ bool CompositeReferences(AssetResolutionResolver &resolver,
     return false;
   }
 
+  TraceScope trace(options.stats, "CompositeReferences", "pass",
+                   in_layer.name());
+
   Layer dst = in_layer;  // deep copy
 
+  // Assets are not modified during the composition.
+  LayerCache local_layer_cache(/* validate_content */ false);
+  if (!options.layer_cache) {
+    options.layer_cache = &local_layer_cache;
+  }
+
+  if (options.num_threads != 1) {
+    std::vector<value::AssetPath> asset_paths;
+    for (const auto &item : dst.primspecs()) {
+      CollectReferenceAssetPathsRec(/* depth */ 0, item.second,
+                                    options.max_depth, &asset_paths);
+    }
+
+    PrefetchAssets(resolver, asset_paths, options.layer_cache,
+                   options.num_threads, options.stats);
+  }
+
   for (auto &item : dst.primspecs()) {
     if (!CompositeReferencesRec(/* depth */ 0, resolver, item.second, warn, err,
                                 options)) {
@@ -833,10 +1569,32 @@ bool CompositePayload(AssetResolutionResolver &resolver, const Layer &in_layer,
     return false;
   }
 
+  TraceScope trace(options.stats, "CompositePayload", "pass",
+                   in_layer.name());
+
   Layer dst = in_layer;  // deep copy
 
+  // Assets are not modified during the composition.
+  LayerCache local_layer_cache(/* validate_content */ false);
+  if (!options.layer_cache) {
+    options.layer_cache = &local_layer_cache;
+  }
+
+  if (options.num_threads != 1) {
+    std::vector<value::AssetPath> asset_paths;
+    for (const auto &item : dst.primspecs()) {
+      CollectPayloadAssetPathsRec(/* depth */ 0, "/" + item.first,
+                                  item.second, options.load_rules,
+                                  options.max_depth, &asset_paths);
+    }
+
+    PrefetchAssets(resolver, asset_paths, options.layer_cache,
+                   options.num_threads, options.stats);
+  }
+
   for (auto &item : dst.primspecs()) {
-    if (!CompositePayloadRec(/* depth */ 0, resolver, item.second, warn, err,
+    if (!CompositePayloadRec(/* depth */ 0, resolver, "/" + item.first,
+                             item.second, warn, err,
                              options)) {
       PUSH_ERROR_AND_RETURN("Composite `payload` failed.");
     }
@@ -869,15 +1627,19 @@ bool CompositeVariant(const Layer &in_layer, Layer *composited_layer,
 }
 
 bool CompositeInherits(const Layer &in_layer, Layer *composited_layer,
-                       std::string *warn, std::string *err) {
+                       std::string *warn, std::string *err,
+                       CompositionStats *stats) {
   if (!composited_layer) {
     return false;
   }
 
+  TraceScope trace(stats, "CompositeInherits", "pass", in_layer.name());
+
   Layer dst = in_layer;  // deep copy
 
   for (auto &item : dst.primspecs()) {
-    if (!CompositeInheritsRec(/* depth */ 0, dst, item.second, warn, err)) {
+    if (!CompositeInheritsRec(/* depth */ 0, dst, item.second, warn, err,
+                              stats)) {
       PUSH_ERROR_AND_RETURN("Composite `inherits` failed.");
     }
   }
@@ -890,8 +1652,22 @@ bool CompositeInherits(const Layer &in_layer, Layer *composited_layer,
 
 namespace detail {
 
+// Copy or move Prim metadata from PrimSpec.
+static const PrimMeta &ForwardPrimMeta(const PrimSpec &primspec) {
+  return primspec.metas();
+}
+
+static PrimMeta &&ForwardPrimMeta(PrimSpec &primspec) {
+  return std::move(primspec.metas());
+}
+
+//
+// PrimSpecT = `const PrimSpec` : copy metadata, `PrimSpec` : move metadata.
+// Property values are copied in both cases.
+//
+template <typename PrimSpecT>
 static nonstd::optional<Prim> ReconstructPrimFromPrimSpec(
-    const PrimSpec &primspec, std::string *warn, std::string *err) {
+    PrimSpecT &primspec, std::string *warn, std::string *err) {
   (void)warn;
 
   // TODO:
@@ -907,20 +1683,20 @@ static nonstd::optional<Prim> ReconstructPrimFromPrimSpec(
                  << " elementName: " << primspec.name());                \
       return nonstd::nullopt;                                            \
     }                                                                    \
-    typed_prim.meta = primspec.metas();                                  \
+    typed_prim.meta = ForwardPrimMeta(primspec);                         \
     typed_prim.name = primspec.name();                                   \
     typed_prim.spec = primspec.specifier();                              \
     /*typed_prim.propertyNames() = properties; */                        \
     /*typed_prim.primChildrenNames() = primChildren;*/                   \
-    value::Value primdata = typed_prim;                                  \
-    Prim prim(primspec.name(), primdata);                                \
+    value::Value primdata = std::move(typed_prim);                       \
+    Prim prim(primspec.name(), std::move(primdata));                     \
     prim.prim_type_name() = primspec.typeName();                         \
     /* also add primChildren to Prim */                                  \
     /* prim.metas().primChildren = primChildren; */                      \
     return std::move(prim);                                              \
   } else
 
-  if (primspec.typeName() == "Model") {
+  if (primspec.typeName().empty() || (primspec.typeName() == "Model")) {
     // Code is mostly identical to RECONSTRUCT_PRIM.
     // Difference is store primTypeName to Model class itself.
     Model typed_prim;
@@ -928,14 +1704,14 @@ static nonstd::optional<Prim> ReconstructPrimFromPrimSpec(
       PUSH_ERROR("Failed to reconstruct Model");
       return nonstd::nullopt;
     }
-    typed_prim.meta = primspec.metas();
+    typed_prim.meta = ForwardPrimMeta(primspec);
     typed_prim.name = primspec.name();
     typed_prim.prim_type_name = primspec.typeName();
     typed_prim.spec = primspec.specifier();
     // typed_prim.propertyNames() = properties;
     // typed_prim.primChildrenNames() = primChildren;
-    value::Value primdata = typed_prim;
-    Prim prim(primspec.name(), primdata);
+    value::Value primdata = std::move(typed_prim);
+    Prim prim(primspec.name(), std::move(primdata));
     prim.prim_type_name() = primspec.typeName();
     /* also add primChildren to Prim */
     // prim.metas().primChildren = primChildren;
@@ -1074,29 +1850,195 @@ static bool InheritPrimSpecImpl(PrimSpec &dst, const PrimSpec &src,
 
 }  // namespace detail
 
-bool LayerToStage(const Layer &layer, Stage *stage_out, std::string *warn,
-                  std::string *err) {
+namespace {
+
+constexpr uint32_t kMaxPrimSpecDepth = 1024 * 1024;
+
+//
+// Root PrimSpec names in `primChildren` order(when valid), otherwise in
+// lexicographical order so that the result does not depend on the hash map
+// order.
+//
+std::vector<std::string> GetRootPrimSpecOrder(const Layer &layer) {
+  std::vector<std::string> names;
+  names.reserve(layer.primspecs().size());
+
+  const auto &primChildren = layer.metas().primChildren;
+  if (primChildren.size() == layer.primspecs().size()) {
+    std::set<std::string> seen;
+    for (const auto &tok : primChildren) {
+      if (!layer.primspecs().count(tok.str()) ||
+          !seen.insert(tok.str()).second) {
+        break;
+      }
+      names.push_back(tok.str());
+    }
+
+    if (names.size() == layer.primspecs().size()) {
+      return names;
+    }
+    names.clear();
+  }
+
+  for (const auto &item : layer.primspecs()) {
+    names.push_back(item.first);
+  }
+  std::sort(names.begin(), names.end());
+
+  return names;
+}
+
+void ReleasePrimSpec(const PrimSpec &primspec) { (void)primspec; }
+
+void ReleasePrimSpec(PrimSpec &primspec) {
+  // Free memory as soon as possible.
+  prim::PropertyMap().swap(primspec.props());
+  std::vector<PrimSpec>().swap(primspec.children());
+}
+
+//
+// PrimSpecT = `const PrimSpec` : copy PrimSpec, `PrimSpec` : move
+// metadata/children and release PrimSpec data once its Prim is built.
+//
+template <typename PrimSpecT>
+bool PrimSpecToPrimRec(uint32_t depth, PrimSpecT &primspec,
+                       nonstd::optional<Prim> *out, std::string *warn,
+                       std::string *err) {
+  if (depth > kMaxPrimSpecDepth) {
+    PUSH_ERROR_AND_RETURN("PrimSpec tree too deep.");
+  }
+
+  const size_t err_len = err ? err->size() : 0;
+
+  nonstd::optional<Prim> prim =
+      detail::ReconstructPrimFromPrimSpec(primspec, warn, err);
+  if (!prim) {
+    if (err && (err->size() != err_len)) {
+      return false;
+    }
+
+    // Unsupported Prim type. Skip the subtree.
+    if (warn) {
+      (*warn) += fmt::format("Prim `{}` is skipped.\n", primspec.name());
+    }
+    (*out) = nonstd::nullopt;
+    return true;
+  }
+
+  for (auto &child : primspec.children()) {
+    nonstd::optional<Prim> child_prim;
+    if (!PrimSpecToPrimRec(depth + 1, child, &child_prim, warn, err)) {
+      return false;
+    }
+
+    if (child_prim) {
+      if (!prim.value().add_child(std::move(child_prim.value()),
+                                  /* rename_element_name */ false, err)) {
+        return false;
+      }
+    }
+  }
+
+  ReleasePrimSpec(primspec);
+
+  (*out) = std::move(prim);
+  return true;
+}
+
+//
+// LayerT = `const Layer` : copy PrimSpecs, `Layer` : move PrimSpecs.
+//
+template <typename LayerT>
+bool LayerToStageImpl(LayerT &layer, Stage *stage_out, std::string *warn,
+                      std::string *err, const LayerToStageOptions &options) {
   if (!stage_out) {
-    if (err) {
-      (*err) += "`stage_ptr` is nullptr.";
+    PUSH_ERROR_AND_RETURN("`stage_ptr` is nullptr.");
+  }
+
+  const std::vector<std::string> root_names = GetRootPrimSpecOrder(layer);
+
+  std::vector<nonstd::optional<Prim>> root_prims(root_names.size());
+  std::vector<std::string> warns(root_names.size());
+  std::vector<std::string> errs(root_names.size());
+  std::vector<char> results(root_names.size(), 0);
+
+  {
+    // Root Prim subtrees are independent, so reconstruct them concurrently.
+    ThreadPool pool(root_names.size() > 1 ? options.num_threads : 1);
+    for (size_t i = 0; i < root_names.size(); i++) {
+      auto &primspec = layer.primspecs().at(root_names[i]);
+      pool.submit([&, i]() {
+        results[i] = PrimSpecToPrimRec(/* depth */ 0, primspec, &root_prims[i],
+                                       &warns[i], &errs[i])
+                         ? 1
+                         : 0;
+      });
+    }
+    pool.wait();
+  }
+
+  Stage stage;
+
+  for (size_t i = 0; i < root_names.size(); i++) {
+    if (warn) {
+      (*warn) += warns[i];
+    }
+
+    if (!results[i]) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "Failed to build Prim `{}` from PrimSpec: {}", root_names[i],
+          errs[i]));
+    }
+
+    if (root_prims[i]) {
+      if (!stage.add_root_prim(std::move(root_prims[i].value()),
+                               /* rename_prim_name */ false)) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("Failed to add root Prim `{}`", root_names[i]));
+      }
     }
+  }
+
+  // Assign prim_id in the Prim traversal order.
+  if (!stage.commit()) {
+    PUSH_ERROR_AND_RETURN("Failed to commit Stage.");
+  }
+
+  (*stage_out) = std::move(stage);
+
+  return true;
+}
+
+}  // namespace
+
+bool LayerToStage(const Layer &layer, Stage *stage_out, std::string *warn,
+                  std::string *err, const LayerToStageOptions &options) {
+  if (!LayerToStageImpl(layer, stage_out, warn, err, options)) {
     return false;
   }
 
-  Stage stage;
+  stage_out->metas() = layer.metas();
 
-  stage.metas() = layer.metas();
+  return true;
+}
 
-  // TODO: primChildren metadatum
-  for (const auto &primspec : layer.primspecs()) {
-    if (auto pv =
-            detail::ReconstructPrimFromPrimSpec(primspec.second, warn, err)) {
-      // TODO
-      (void)pv;
-    }
+bool PrimSpecToPrim(const PrimSpec &primspec, nonstd::optional<Prim> *prim,
+                    std::string *warn, std::string *err) {
+  if (!prim) {
+    PUSH_ERROR_AND_RETURN("`prim` is nullptr.");
+  }
+
+  return PrimSpecToPrimRec(/* depth */ 0, primspec, prim, warn, err);
+}
+
+bool LayerToStage(Layer &&layer, Stage *stage_out, std::string *warn,
+                  std::string *err, const LayerToStageOptions &options) {
+  if (!LayerToStageImpl(layer, stage_out, warn, err, options)) {
+    return false;
   }
 
-  (*stage_out) = stage;
+  stage_out->metas() = std::move(layer.metas());
+  layer.primspecs().clear();
 
   return true;
 }
@@ -1143,6 +2085,104 @@ bool ReferenceLayerToPrimSpec(PrimSpec &dst, const Layer &layer,
   return false;
 }
 
+namespace {
+
+bool HasLoadablePayloadRec(uint32_t depth, const std::string &prim_path,
+                           const PrimSpec &primspec,
+                           const PayloadLoadRules &load_rules,
+                           uint32_t max_depth) {
+  if (depth > max_depth) {
+    return false;
+  }
+
+  if (primspec.metas().payload && load_rules.is_loaded(prim_path)) {
+    return true;
+  }
+
+  for (const auto &child : primspec.children()) {
+    if (HasLoadablePayloadRec(depth + 1, prim_path + "/" + child.name(), child,
+                              load_rules, max_depth)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // namespace
+
+void PayloadLoadRules::set_rule(const Path &prim_path, bool load) {
+  const std::string &s = prim_path.prim_part();
+
+  // Remove rules of the Prim and its descendants.
+  auto it = _rules.lower_bound(s);
+  while (it != _rules.end()) {
+    const std::string &key = it->first;
+    if ((key.size() >= s.size()) && (key.compare(0, s.size(), s) == 0) &&
+        ((key.size() == s.size()) || (key[s.size()] == '/') || (s == "/"))) {
+      it = _rules.erase(it);
+    } else if (key.compare(0, s.size(), s) == 0) {
+      // e.g. "/a" and "/ab". Keys with the same prefix may follow.
+      ++it;
+    } else {
+      break;
+    }
+  }
+
+  if (s == "/") {
+    _default_load = load;
+    return;
+  }
+
+  // No need to store the rule when it is the same as the ancestor's rule.
+  if (is_loaded(s) != load) {
+    _rules[s] = load;
+  }
+}
+
+void PayloadLoadRules::load(const Path &prim_path) { set_rule(prim_path, true); }
+
+void PayloadLoadRules::unload(const Path &prim_path) {
+  set_rule(prim_path, false);
+}
+
+void PayloadLoadRules::load_all() {
+  _rules.clear();
+  _default_load = true;
+}
+
+void PayloadLoadRules::unload_all() {
+  _rules.clear();
+  _default_load = false;
+}
+
+bool PayloadLoadRules::is_loaded(const Path &prim_path) const {
+  return is_loaded(prim_path.prim_part());
+}
+
+bool PayloadLoadRules::is_loaded(const std::string &prim_path) const {
+  if (_rules.empty()) {
+    return _default_load;
+  }
+
+  // Find the nearest rule in "/a/b/c", "/a/b", "/a"
+  std::string s = prim_path;
+  while (s.size() > 1) {
+    const auto it = _rules.find(s);
+    if (it != _rules.end()) {
+      return it->second;
+    }
+
+    size_t pos = s.find_last_of('/');
+    if ((pos == std::string::npos) || (pos == 0)) {
+      break;
+    }
+    s.erase(pos);
+  }
+
+  return _default_load;
+}
+
 bool HasReferences(const Layer &layer, const bool force_check,
                    const ReferencesCompositionOptions options) {
   if (!force_check) {
@@ -1154,6 +2194,16 @@ bool HasReferences(const Layer &layer, const bool force_check,
 
 bool HasPayload(const Layer &layer, const bool force_check,
                 const PayloadCompositionOptions options) {
+  if (options.load_rules) {
+    for (const auto &item : layer.primspecs()) {
+      if (HasLoadablePayloadRec(/* depth */ 0, "/" + item.first, item.second,
+                                *options.load_rules, options.max_depth)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   if (!force_check) {
     return layer.has_unresolved_payload();
   }
@@ -1487,4 +2537,436 @@ bool VariantSelectPrimSpec(
   return true;
 }
 
+namespace {
+
+constexpr uint32_t kMaxVariantIndexDepth = 1024 * 1024;
+constexpr uint32_t kMaxVariantResolveIterations = 1024;
+
+bool HasUnresolvedVariantRec(uint32_t depth, const PrimSpec &primspec) {
+  if (depth > kMaxVariantIndexDepth) {
+    return false;
+  }
+
+  if (primspec.metas().variants && primspec.metas().variantSets) {
+    return true;
+  }
+
+  for (const auto &child : primspec.children()) {
+    if (HasUnresolvedVariantRec(depth + 1, child)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Find PrimSpec at `prim_path`(e.g. "/a/b") in the PrimSpec hierarchy
+// (variants are not looked up).
+template <typename LayerT, typename PrimSpecT>
+PrimSpecT *FindPrimSpecAt(LayerT &layer, const std::string &prim_path) {
+  if ((prim_path.size() < 2) || (prim_path[0] != '/')) {
+    return nullptr;
+  }
+
+  PrimSpecT *ps{nullptr};
+  size_t start = 1;
+  while (start <= prim_path.size()) {
+    size_t end = prim_path.find('/', start);
+    if (end == std::string::npos) {
+      end = prim_path.size();
+    }
+    const std::string name = prim_path.substr(start, end - start);
+
+    if (!ps) {
+      auto it = layer.primspecs().find(name);
+      if (it == layer.primspecs().end()) {
+        return nullptr;
+      }
+      ps = &it->second;
+    } else {
+      PrimSpecT *child{nullptr};
+      for (auto &c : ps->children()) {
+        if (c.name() == name) {
+          child = &c;
+          break;
+        }
+      }
+      if (!child) {
+        return nullptr;
+      }
+      ps = child;
+    }
+
+    start = end + 1;
+  }
+
+  return ps;
+}
+
+bool HasVariantSets(const PrimSpec &ps) {
+  return ps.metas().variantSets || !ps.variantSets().empty();
+}
+
+bool IndexVariantsRec(uint32_t depth, const std::string &path,
+                      const PrimSpec &ps, bool in_variant,
+                      bool is_variant_body, const std::string &update_root,
+                      std::map<std::string, VariantIndex::PrimEntry> *entries,
+                      std::string *err) {
+  if (depth > kMaxVariantIndexDepth) {
+    PUSH_ERROR_AND_RETURN("PrimSpec tree too deep.");
+  }
+
+  const bool has_vsets = HasVariantSets(ps);
+
+  std::string child_update_root = update_root;
+  if (has_vsets) {
+    if (child_update_root.empty()) {
+      child_update_root = path;
+    }
+
+    auto it = entries->find(path);
+    if (it == entries->end()) {
+      VariantIndex::PrimEntry entry;
+      entry.path = Path(path, "");
+      entry.in_variant = in_variant;
+      entry.update_root = Path(child_update_root, "");
+      it = entries->emplace(path, std::move(entry)).first;
+    }
+
+    VariantIndex::PrimEntry &entry = it->second;
+    entry.in_variant = entry.in_variant && in_variant;
+
+    auto add_variant_set = [&entry](const std::string &name) {
+      if (std::find(entry.variant_sets.begin(), entry.variant_sets.end(),
+                    name) == entry.variant_sets.end()) {
+        entry.variant_sets.push_back(name);
+      }
+      // Create an entry even when the variantSet has no variant.
+      entry.variants[name];
+    };
+
+    if (ps.metas().variantSets) {
+      for (const auto &name : ps.metas().variantSets.value().second) {
+        add_variant_set(name);
+      }
+    }
+
+    for (const auto &vset : ps.variantSets()) {
+      add_variant_set(vset.first);
+      std::vector<std::string> &names = entry.variants[vset.first];
+      for (const auto &variant : vset.second.variantSet) {
+        if (std::find(names.begin(), names.end(), variant.first) ==
+            names.end()) {
+          names.push_back(variant.first);
+        }
+      }
+    }
+
+    if (ps.metas().variants) {
+      for (const auto &sel : ps.metas().variants.value()) {
+        if (!entry.authored_selection.count(sel.first)) {
+          entry.authored_selection[sel.first] = sel.second;
+          entry.selection[sel.first] = sel.second;
+        }
+      }
+    }
+  }
+
+  const bool children_in_variant = in_variant || is_variant_body;
+
+  for (const auto &child : ps.children()) {
+    if (!IndexVariantsRec(depth + 1, path + "/" + child.name(), child,
+                          children_in_variant, /* is_variant_body */ false,
+                          child_update_root, entries, err)) {
+      return false;
+    }
+  }
+
+  // Variant contents are composed onto this Prim.
+  for (const auto &vset : ps.variantSets()) {
+    for (const auto &variant : vset.second.variantSet) {
+      if (!IndexVariantsRec(depth + 1, path, variant.second, in_variant,
+                            /* is_variant_body */ true, child_update_root,
+                            entries, err)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void ApplyVariantSelectionRec(
+    uint32_t depth, const std::string &path, PrimSpec &ps,
+    const std::map<std::string, VariantIndex::PrimEntry> &entries) {
+  if (depth > kMaxVariantIndexDepth) {
+    return;
+  }
+
+  if (HasVariantSets(ps)) {
+    const auto it = entries.find(path);
+    if ((it != entries.end()) && !it->second.selection.empty()) {
+      ps.metas().variants = it->second.selection;
+    }
+  }
+
+  for (auto &child : ps.children()) {
+    ApplyVariantSelectionRec(depth + 1, path + "/" + child.name(), child,
+                             entries);
+  }
+}
+
+}  // namespace
+
+bool VariantIndex::build(const Layer &layer, std::string *err) {
+  _layer = layer;
+  return build_index(err);
+}
+
+bool VariantIndex::build(Layer &&layer, std::string *err) {
+  _layer = std::move(layer);
+  return build_index(err);
+}
+
+bool VariantIndex::build_index(std::string *err) {
+  _entries.clear();
+  _dirty_roots.clear();
+
+  const Layer &layer = _layer;
+  for (const auto &item : layer.primspecs()) {
+    if (!IndexVariantsRec(/* depth */ 0, "/" + item.first, item.second,
+                          /* in_variant */ false, /* is_variant_body */ false,
+                          /* update_root */ "", &_entries, err)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const VariantIndex::PrimEntry *VariantIndex::find(const Path &prim_path) const {
+  const auto it = _entries.find(prim_path.prim_part());
+  if (it == _entries.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+bool VariantIndex::set_selection(const Path &prim_path,
+                                 const std::string &variant_set,
+                                 const std::string &variant_name,
+                                 std::string *err) {
+  const auto it = _entries.find(prim_path.prim_part());
+  if (it == _entries.end()) {
+    PUSH_ERROR_AND_RETURN(fmt::format("Prim `{}` does not have variantSets.",
+                                      prim_path.prim_part()));
+  }
+
+  PrimEntry &entry = it->second;
+
+  const auto vit = entry.variants.find(variant_set);
+  if (vit == entry.variants.end()) {
+    PUSH_ERROR_AND_RETURN(fmt::format("variantSet `{}` not found in Prim `{}`.",
+                                      variant_set, prim_path.prim_part()));
+  }
+
+  if (std::find(vit->second.begin(), vit->second.end(), variant_name) ==
+      vit->second.end()) {
+    PUSH_ERROR_AND_RETURN(fmt::format(
+        "variant `{}` not found in variantSet `{}` of Prim `{}`.", variant_name,
+        variant_set, prim_path.prim_part()));
+  }
+
+  const auto sit = entry.selection.find(variant_set);
+  if ((sit != entry.selection.end()) && (sit->second == variant_name)) {
+    // No change.
+    return true;
+  }
+
+  entry.selection[variant_set] = variant_name;
+  _dirty_roots.insert(entry.update_root.prim_part());
+
+  return true;
+}
+
+bool VariantIndex::resolve_subtree(const std::string &path, PrimSpec *ps,
+                                   std::string *warn, std::string *err) const {
+  for (uint32_t i = 0; i < kMaxVariantResolveIterations; i++) {
+    // Variant contents may contain PrimSpecs with variantSets, so apply the
+    // selection on each iteration.
+    ApplyVariantSelectionRec(/* depth */ 0, path, *ps, _entries);
+
+    if (!HasUnresolvedVariantRec(/* depth */ 0, *ps)) {
+      return true;
+    }
+
+    if (!CompositeVariantRec(/* depth */ 0, *ps, warn, err)) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("Failed to resolve variants of Prim `{}`.", path));
+    }
+  }
+
+  PUSH_ERROR_AND_RETURN(
+      fmt::format("variantSets of Prim `{}` are nested too deeply.", path));
+}
+
+bool VariantIndex::compose(Layer *dst, std::string *warn, std::string *err) {
+  if (!dst) {
+    PUSH_ERROR_AND_RETURN("`dst` argument is nullptr.");
+  }
+
+  Layer out;
+  out.metas() = _layer.metas();
+
+  const Layer &layer = _layer;
+  for (const auto &item : layer.primspecs()) {
+    PrimSpec ps = item.second;
+    if (!resolve_subtree("/" + item.first, &ps, warn, err)) {
+      return false;
+    }
+    out.add_primspec(item.first, std::move(ps));
+  }
+
+  (*dst) = std::move(out);
+  _dirty_roots.clear();
+
+  return true;
+}
+
+bool VariantIndex::update(Layer *dst, std::string *warn, std::string *err,
+                          std::vector<Path> *updated_paths) {
+  if (!dst) {
+    PUSH_ERROR_AND_RETURN("`dst` argument is nullptr.");
+  }
+
+  std::string last_root;
+  for (const auto &root : _dirty_roots) {
+    // Skip subtrees of already re-resolved PrimSpec(`_dirty_roots` is
+    // sorted, so a parent path comes first).
+    if (!last_root.empty() && (root.size() > last_root.size()) &&
+        (root.compare(0, last_root.size(), last_root) == 0) &&
+        (root[last_root.size()] == '/')) {
+      continue;
+    }
+
+    const PrimSpec *src =
+        FindPrimSpecAt<const Layer, const PrimSpec>(_layer, root);
+    if (!src) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("PrimSpec `{}` not found in the Layer.", root));
+    }
+
+    PrimSpec *target = FindPrimSpecAt<Layer, PrimSpec>(*dst, root);
+    if (!target) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "PrimSpec `{}` not found in the composed Layer.", root));
+    }
+
+    PrimSpec ps = *src;
+    if (!resolve_subtree(root, &ps, warn, err)) {
+      return false;
+    }
+    (*target) = std::move(ps);
+
+    if (updated_paths) {
+      updated_paths->push_back(Path(root, ""));
+    }
+
+    last_root = root;
+  }
+
+  _dirty_roots.clear();
+
+  return true;
+}
+
+void VariantIndex::to_dictionary(Dictionary *dict) const {
+  if (!dict) {
+    return;
+  }
+
+  for (const auto &item : _entries) {
+    Dictionary variantInfos;
+
+    if (!item.second.variant_sets.empty()) {
+      MetaVariable var;
+      var.set_value(item.second.variant_sets);
+      variantInfos["variantSets"] = var;
+    }
+
+    if (!item.second.selection.empty()) {
+      Dictionary values;
+      for (const auto &sel : item.second.selection) {
+        values[sel.first] = sel.second;
+      }
+      variantInfos["variants"] = values;
+    }
+
+    if (variantInfos.size()) {
+      (*dict)[item.first] = variantInfos;
+    }
+  }
+}
+
+bool ListVariantSelectionMaps(const Layer &layer, VariantSelectorMap &m) {
+  VariantIndex index;
+  if (!index.build(layer)) {
+    return false;
+  }
+
+  for (const auto &item : index.entries()) {
+    VariantSelector selector;
+    selector.vsmap = item.second.selection;
+    if (!item.second.variant_sets.empty() &&
+        item.second.selection.count(item.second.variant_sets[0])) {
+      selector.selection =
+          item.second.selection.at(item.second.variant_sets[0]);
+    }
+    m[item.second.path] = selector;
+  }
+
+  return true;
+}
+
+bool ApplyVariantSelector(const Layer &layer, const VariantSelectorMap &vsmap,
+                          Layer *dst, std::string *warn, std::string *err) {
+  VariantIndex index;
+  if (!index.build(layer, err)) {
+    return false;
+  }
+
+  for (const auto &item : vsmap) {
+    for (const auto &sel : item.second.vsmap) {
+      std::string sel_err;
+      if (!index.set_selection(item.first, sel.first, sel.second, &sel_err)) {
+        // Not an error(same as VariantSelectPrimSpec).
+        if (warn) {
+          (*warn) += sel_err + "\n";
+        }
+      }
+    }
+  }
+
+  return index.compose(dst, warn, err);
+}
+
+bool ApplyVariantSelector(const Layer &layer, const std::string &variant_name,
+                          Layer *dst, std::string *warn, std::string *err) {
+  VariantIndex index;
+  if (!index.build(layer, err)) {
+    return false;
+  }
+
+  for (const auto &item : index.entries()) {
+    for (const auto &vset : item.second.variants) {
+      if (std::find(vset.second.begin(), vset.second.end(), variant_name) !=
+          vset.second.end()) {
+        index.set_selection(item.second.path, vset.first, variant_name);
+      }
+    }
+  }
+
+  return index.compose(dst, warn, err);
+}
+
 }  // namespace tinyusdz
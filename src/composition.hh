@@ -5,6 +5,17 @@
 //
 #pragma once
 
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#if defined(TINYUSDZ_ENABLE_THREAD)
+#include <mutex>
+#include <thread>
+#endif
+
 #include "asset-resolution.hh"
 #include "prim-types.hh"
 
@@ -30,6 +41,238 @@ enum class LoadState : uint32_t {
   Payload = 1 << 3     // load USD from Prim meta payload
 };
 
+struct LayerCacheStats {
+  uint64_t hits{0};
+  uint64_t misses{0};
+  uint64_t invalidations{0};  // The number of stale entries(content changed)
+};
+
+///
+/// Cache of loaded(parsed) Layers for `subLayers`, `references` and `payload`
+/// composition, so that an asset referenced from many places is parsed only
+/// once. Cached Layers are immutable and shared among composition arcs.
+///
+/// Key is the resolved asset path. When `validate_content` is true, the
+/// asset is read on each lookup, and the cached Layer is used only when
+/// the size and hash of its content are unchanged. Set `validate_content`
+/// false to skip reading the asset on cache hit(e.g. assets are not
+/// modified during the composition).
+///
+/// LayerCache is thread-safe when built with TINYUSDZ_ENABLE_THREAD.
+///
+class LayerCache {
+ public:
+  explicit LayerCache(bool validate_content = true)
+      : _validate_content(validate_content) {}
+
+  LayerCache(const LayerCache &) = delete;
+  LayerCache &operator=(const LayerCache &) = delete;
+
+  bool validate_content() const { return _validate_content; }
+
+  ///
+  /// Check if a valid Layer is cached. Unlike `find()`, this does not update
+  /// stats nor erase a stale entry.
+  ///
+  bool contains(const std::string &resolved_path,
+                const Asset *asset = nullptr) const;
+
+  ///
+  /// Find a cached Layer.
+  ///
+  /// @param[in] resolved_path Resolved asset path.
+  /// @param[in] asset Asset content. Required when `validate_content()` is
+  /// true. Ignored otherwise.
+  ///
+  /// @return nullptr when not found(or stale).
+  ///
+  std::shared_ptr<const Layer> find(const std::string &resolved_path,
+                                    const Asset *asset = nullptr);
+
+  ///
+  /// Insert(or replace) Layer for the resolved asset path.
+  ///
+  /// @param[in] asset Asset content where `layer` is loaded from.
+  /// @param[in] warn Warnings of loading the Layer which are not reported yet
+  /// (e.g. the Layer is loaded ahead of the composition). Retrieve them with
+  /// `take_warning()`.
+  ///
+  void insert(const std::string &resolved_path, const Asset &asset,
+              std::shared_ptr<const Layer> layer,
+              const std::string &warn = std::string());
+
+  ///
+  /// Return the pending warnings of the cached Layer and clear them, so that
+  /// they are reported only once.
+  ///
+  std::string take_warning(const std::string &resolved_path);
+
+  bool erase(const std::string &resolved_path);
+
+  size_t size() const;
+
+  void clear();
+
+  LayerCacheStats stats() const;
+
+  void reset_stats();
+
+ private:
+  struct Entry {
+    uint64_t nbytes{0};
+    uint64_t hash{0};
+    std::shared_ptr<const Layer> layer;
+    std::string warn;  // Pending warnings
+  };
+
+  bool _validate_content{true};
+  std::unordered_map<std::string, Entry> _entries;
+  LayerCacheStats _stats;
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  mutable std::mutex _mutex;
+#endif
+};
+
+struct CompositionCounters {
+  // The number of composition arcs expanded.
+  uint64_t sublayer_arcs{0};
+  uint64_t reference_arcs{0};
+  uint64_t payload_arcs{0};
+  uint64_t inherit_arcs{0};
+
+  uint64_t assets_loaded{0};      // Assets read and parsed.
+  uint64_t asset_cache_hits{0};   // Assets found in LayerCache.
+  uint64_t bytes_read{0};         // Total size of assets read.
+  uint64_t override_merges{0};    // `over` merges of PrimSpec.
+  uint64_t inherit_merges{0};     // `inherits` merges of PrimSpec.
+
+  double parse_time_ms{0.0};  // Total time to parse assets.
+};
+
+struct CompositionTraceEvent {
+  std::string name;      // e.g. "references", "parse"
+  std::string category;  // "pass", "arc" or "asset"
+  std::string asset;     // Asset path. Can be empty.
+  std::string prim;      // Prim path(or Prim name). Can be empty.
+  double start_ms{0.0};  // performance::now()
+  double duration_ms{0.0};
+  uint32_t thread_id{0};  // 0 = the thread which created CompositionStats.
+};
+
+///
+/// Statistics and trace events of composition.
+///
+/// Set to `stats` in SublayersCompositionOptions, ReferencesCompositionOptions
+/// and PayloadCompositionOptions(or pass to `CompositeInherits`) to record
+/// per-arc timing and counts. The same instance can be shared among multiple
+/// composition calls. Thread-safe(assets may be loaded concurrently).
+///
+class CompositionStats {
+ public:
+  ///
+  /// @param[in] record_events Record trace events in addition to counters.
+  ///
+  explicit CompositionStats(bool record_events = true);
+
+  CompositionStats(const CompositionStats &) = delete;
+  CompositionStats &operator=(const CompositionStats &) = delete;
+
+  bool record_events() const { return _record_events; }
+
+  ///
+  /// Add `n` to the counter, e.g.
+  /// `add(&CompositionCounters::reference_arcs)`
+  ///
+  void add(uint64_t CompositionCounters::*counter, uint64_t n = 1);
+
+  void add_parse_time(double ms);
+
+  ///
+  /// Add trace event. `thread_id` is set by this function.
+  /// No-op when `record_events()` is false.
+  ///
+  void add_event(CompositionTraceEvent &&event);
+
+  CompositionCounters counters() const;
+
+  std::vector<CompositionTraceEvent> events() const;
+
+  void clear();
+
+  ///
+  /// Export trace events in Chrome trace event format(JSON). Load it in
+  /// chrome://tracing or Perfetto UI. Counters are stored to `otherData`.
+  ///
+  std::string to_chrome_trace_json() const;
+
+ private:
+  uint32_t thread_id();
+
+  bool _record_events{true};
+  double _start_ms{0.0};
+  CompositionCounters _counters;
+  std::vector<CompositionTraceEvent> _events;
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::map<std::thread::id, uint32_t> _thread_ids;
+  mutable std::mutex _mutex;
+#endif
+};
+
+///
+/// Rules to decide which `payload` is loaded in `payload` composition.
+///
+/// A rule is set to a Prim path and applied to the Prim and its descendants
+/// (the nearest rule in ancestors takes effect). Prims without any rule
+/// follow the default rule.
+///
+class PayloadLoadRules {
+ public:
+  explicit PayloadLoadRules(bool load_all = true) : _default_load(load_all) {}
+
+  ///
+  /// Load payloads of the Prim and its descendants.
+  /// Rules set to descendants are removed.
+  ///
+  void load(const Path &prim_path);
+
+  ///
+  /// Unload payloads of the Prim and its descendants.
+  /// Rules set to descendants are removed.
+  ///
+  void unload(const Path &prim_path);
+
+  ///
+  /// Remove all rules and load all payloads.
+  ///
+  void load_all();
+
+  ///
+  /// Remove all rules and unload all payloads.
+  ///
+  void unload_all();
+
+  ///
+  /// @return true when payload of the Prim at `prim_path` is loaded.
+  ///
+  bool is_loaded(const Path &prim_path) const;
+  bool is_loaded(const std::string &prim_path) const;
+
+  ///
+  /// Prim path -> load(true) or unload(false).
+  ///
+  const std::map<std::string, bool> &rules() const { return _rules; }
+
+  bool default_load() const { return _default_load; }
+
+ private:
+  void set_rule(const Path &prim_path, bool load);
+
+  bool _default_load{true};
+  std::map<std::string, bool> _rules;
+};
+
 struct SublayersCompositionOptions {
   // The maximum depth for nested `subLayers`
   uint32_t max_depth = 1024u;
@@ -45,6 +288,25 @@ struct SublayersCompositionOptions {
 
   // File formats
   std::map<std::string, FileFormatHandler> fileformats;
+
+  // Layer cache shared among composition calls. When nullptr, a cache local
+  // to the function call is used.
+  LayerCache *layer_cache{nullptr};
+
+  // The number of threads to load(parse) subLayer assets concurrently.
+  // 0 = use hardware concurrency. 1 = load assets one by one.
+  // Asset paths are resolved on the calling thread, but
+  // AssetResolutionHandler's size/read callbacks may be called concurrently
+  // when this value is not 1.
+  uint32_t num_threads{1};
+
+  // [out] When not nullptr, resolved paths of the assets used in the
+  // composition are added(e.g. for tracking dependencies).
+  std::set<std::string> *loaded_assets{nullptr};
+
+  // [out] When not nullptr, composition statistics and trace events are
+  // recorded.
+  CompositionStats *stats{nullptr};
 };
 
 struct ReferencesCompositionOptions {
@@ -59,6 +321,25 @@ struct ReferencesCompositionOptions {
 
   // File formats
   std::map<std::string, FileFormatHandler> fileformats;
+
+  // Layer cache shared among composition calls. When nullptr, a cache local
+  // to the function call is used.
+  LayerCache *layer_cache{nullptr};
+
+  // The number of threads to load(parse) referenced assets concurrently.
+  // 0 = use hardware concurrency. 1 = load assets one by one.
+  // Asset paths are resolved on the calling thread, but
+  // AssetResolutionHandler's size/read callbacks may be called concurrently
+  // when this value is not 1.
+  uint32_t num_threads{1};
+
+  // [out] When not nullptr, resolved paths of the assets used in the
+  // composition are added(e.g. for tracking dependencies).
+  std::set<std::string> *loaded_assets{nullptr};
+
+  // [out] When not nullptr, composition statistics and trace events are
+  // recorded.
+  CompositionStats *stats{nullptr};
 };
 
 struct PayloadCompositionOptions {
@@ -73,6 +354,30 @@ struct PayloadCompositionOptions {
 
   // File formats
   std::map<std::string, FileFormatHandler> fileformats;
+
+  // Layer cache shared among composition calls. When nullptr, a cache local
+  // to the function call is used.
+  LayerCache *layer_cache{nullptr};
+
+  // Rules to decide which payload is loaded. nullptr = load all payloads.
+  // `payload` metadatum of an unloaded Prim is kept as is, so it can be
+  // loaded later by composing the Layer again with another rule.
+  const PayloadLoadRules *load_rules{nullptr};
+
+  // The number of threads to load(parse) payload assets concurrently.
+  // 0 = use hardware concurrency. 1 = load assets one by one.
+  // Asset paths are resolved on the calling thread, but
+  // AssetResolutionHandler's size/read callbacks may be called concurrently
+  // when this value is not 1.
+  uint32_t num_threads{1};
+
+  // [out] When not nullptr, resolved paths of the assets used in the
+  // composition are added(e.g. for tracking dependencies).
+  std::set<std::string> *loaded_assets{nullptr};
+
+  // [out] When not nullptr, composition statistics and trace events are
+  // recorded.
+  CompositionStats *stats{nullptr};
 };
 
 ///
@@ -89,6 +394,8 @@ bool HasReferences(const Layer &layer, const bool force_check = false, const Ref
 /// Return true when any PrimSpec in the Layer contains `payload` Prim metadataum
 ///
 /// Layer has cached flag for quicky detecting whether Layer has unresolved `payload` or not.
+/// When `options.load_rules` is set, only `payload` to be loaded is
+/// considered(always traverse PrimSpec hierarchy).
 ///
 /// @param[in] layer Layer
 /// @param[in] force_check When true, traverse PrimSpec hierarchy and find `payload` metadatum. Use cached flag in `layer` when false.
@@ -177,8 +484,11 @@ bool CompositeSpecializes(const Layer &layer,
 /// Resolve `inherits` for each PrimSpec, and return composited(flattened) Layer
 /// to `composited_layer` in `layer`.
 ///
+/// @param[out] stats Composition statistics(optional).
+///
 bool CompositeInherits(const Layer &layer,
-    Layer *composited_layer, std::string *warn, std::string *err);
+    Layer *composited_layer, std::string *warn, std::string *err,
+    CompositionStats *stats = nullptr);
 
 ///
 /// Override a PrimSpec with another PrimSpec.
@@ -204,19 +514,43 @@ bool OverridePrimSpec(PrimSpec &dst, const PrimSpec &src, std::string *warn,
 bool InheritPrimSpec(PrimSpec &dst, const PrimSpec &src, std::string *warn,
                      std::string *err);
 
+struct LayerToStageOptions {
+  // The number of threads to build root Prim subtrees concurrently.
+  // 0 = use hardware concurrency. The result(Prim order and prim_id) does
+  // not depend on this value.
+  uint32_t num_threads{1};
+};
+
 ///
 /// Build USD Stage from Layer
 ///
+/// Root Prims are ordered by `primChildren` of the Layer when valid,
+/// otherwise by name. prim_id is assigned(Stage is committed).
+/// Prims of unsupported type are skipped(with warning message).
+///
 bool LayerToStage(const Layer &layer, Stage *stage, std::string *warn,
-                  std::string *err);
+                  std::string *err,
+                  const LayerToStageOptions &options = LayerToStageOptions());
 
 ///
 /// Build USD Stage from Layer
 ///
 /// `layer` object will be destroyed after `stage` is being build.
+/// Prim metadata and PrimSpec hierarchy are moved, and each PrimSpec is
+/// released right after its Prim is built.
 ///
 bool LayerToStage(Layer &&layer, Stage *stage, std::string *warn,
-                  std::string *err);
+                  std::string *err,
+                  const LayerToStageOptions &options = LayerToStageOptions());
+
+///
+/// Build Prim(and its descendant Prims) from PrimSpec.
+///
+/// @param[out] prim Built Prim. nullopt when the Prim type is not supported
+/// (the subtree is skipped with warning message).
+///
+bool PrimSpecToPrim(const PrimSpec &primspec, nonstd::optional<Prim> *prim,
+                    std::string *warn, std::string *err);
 
 struct VariantSelector {
   std::string selection;  // current selection
@@ -263,6 +597,108 @@ bool ApplyVariantSelector(const Layer &layer, const VariantSelectorMap &vsmap,
 bool ApplyVariantSelector(const Layer &layer, const std::string &variant_name,
                           Layer *dst, std::string *warn, std::string *err);
 
+///
+/// Index of variantSets in a Layer.
+///
+/// Built once per Layer. Holds variantSets, variants and the selection of
+/// each Prim(including Prims defined inside variants), so listing variants
+/// is a lookup. After composing variants with `compose()`, changing the
+/// selection with `set_selection()` and calling `update()` re-resolves only
+/// the PrimSpec subtree affected by the change.
+///
+/// Prim path of a Prim inside a variant is the composed path(e.g.
+/// "/root/geom" for `geom` defined in a variant of `/root`).
+///
+class VariantIndex {
+ public:
+  struct PrimEntry {
+    Path path;
+
+    // variantSet names in the evaluation order(`variantSets` metadatum).
+    std::vector<std::string> variant_sets;
+
+    // variantSet name -> variant names
+    std::map<std::string, std::vector<std::string>> variants;
+
+    // Authored selection(`variants` metadatum).
+    VariantSelectionMap authored_selection;
+
+    // Current selection. Initialized with `authored_selection`.
+    VariantSelectionMap selection;
+
+    // true when this Prim is only defined inside variant(s).
+    bool in_variant{false};
+
+    // Path of the PrimSpec subtree to be re-resolved when the selection of
+    // this Prim changes.
+    Path update_root;
+  };
+
+  VariantIndex() = default;
+
+  ///
+  /// Build the index. `layer` is copied(or moved) into VariantIndex.
+  ///
+  bool build(const Layer &layer, std::string *err = nullptr);
+  bool build(Layer &&layer, std::string *err = nullptr);
+
+  ///
+  /// Prim path -> PrimEntry. Only Prims with variantSets are listed.
+  ///
+  const std::map<std::string, PrimEntry> &entries() const { return _entries; }
+
+  ///
+  /// @return nullptr when the Prim does not have variantSets.
+  ///
+  const PrimEntry *find(const Path &prim_path) const;
+
+  ///
+  /// Change the variant selection of the Prim.
+  ///
+  /// @return false when the Prim, variantSet or variant does not exist.
+  ///
+  bool set_selection(const Path &prim_path, const std::string &variant_set,
+                     const std::string &variant_name,
+                     std::string *err = nullptr);
+
+  ///
+  /// Resolve variants in the whole Layer with the current selection.
+  /// Pending selection changes are cleared.
+  ///
+  bool compose(Layer *dst, std::string *warn, std::string *err);
+
+  ///
+  /// Apply selection changes since the last `compose()`/`update()` to `dst`.
+  /// `dst` must be the Layer composed by `compose()` of this index.
+  ///
+  /// @param[out] updated_paths Paths of re-resolved PrimSpec subtrees
+  /// (optional).
+  ///
+  bool update(Layer *dst, std::string *warn, std::string *err,
+              std::vector<Path> *updated_paths = nullptr);
+
+  ///
+  /// @return true when there are selection changes not yet applied.
+  ///
+  bool is_dirty() const { return !_dirty_roots.empty(); }
+
+  ///
+  /// Variant information in the same format as `ExtractVariants`.
+  ///
+  void to_dictionary(Dictionary *dict) const;
+
+  const Layer &layer() const { return _layer; }
+
+ private:
+  bool build_index(std::string *err);
+  bool resolve_subtree(const std::string &path, PrimSpec *ps,
+                       std::string *warn, std::string *err) const;
+
+  Layer _layer;
+  std::map<std::string, PrimEntry> _entries;
+  std::set<std::string> _dirty_roots;  // update_root paths
+};
+
 ///
 /// Implementation of `references`
 ///
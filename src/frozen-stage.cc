@@ -0,0 +1,350 @@
+// SPDX-License-Identifier: Apache 2.0
+// Copyright 2024 - Present, Light Transport Entertainment, Inc.
+#include "frozen-stage.hh"
+
+#include <cstring>
+#include <limits>
+#include <map>
+
+#include "common-macros.inc"
+#include "tiny-format.hh"
+
+#define PushError(s) \
+  if (err) {         \
+    (*err) += s;     \
+  }
+
+namespace tinyusdz {
+
+namespace {
+
+constexpr uint32_t kMaxFrozenStageDepth = 1024 * 128;
+
+//
+// Returns child Prim indices in traversal order.
+// Use `primChildren` metadatum when it is valid, as done in tydra::VisitPrims.
+//
+void GetTraversalOrder(const std::vector<Prim> &children,
+                       const std::vector<value::token> &primChildren,
+                       std::vector<size_t> *order) {
+  order->clear();
+
+  if (!primChildren.empty() && (primChildren.size() == children.size())) {
+    std::map<std::string, size_t> primNameTable;
+    for (size_t i = 0; i < children.size(); i++) {
+      primNameTable.emplace(children[i].element_name(), i);
+    }
+
+    for (size_t i = 0; i < primChildren.size(); i++) {
+      const auto it = primNameTable.find(primChildren[i].str());
+      if (it == primNameTable.end()) {
+        // Invalid `primChildren`. Use the array order.
+        break;
+      }
+      order->push_back(it->second);
+    }
+
+    if (order->size() == children.size()) {
+      return;
+    }
+    order->clear();
+  }
+
+  for (size_t i = 0; i < children.size(); i++) {
+    order->push_back(i);
+  }
+}
+
+size_t CountPrimsRec(const Prim &prim, uint32_t depth) {
+  if (depth > kMaxFrozenStageDepth) {
+    return 0;
+  }
+
+  size_t n = 1;
+  for (const Prim &child : prim.children()) {
+    n += CountPrimsRec(child, depth + 1);
+  }
+  return n;
+}
+
+// Copy Prim except for its children.
+void DetachPrim(const Prim &src, Prim *dst) {
+  dst->get_data() = src.data();
+  dst->specifier() = src.specifier();
+  dst->local_path() = src.local_path();
+  dst->element_path() = src.element_path();
+  dst->prim_type_name() = src.prim_type_name();
+  dst->prim_id() = src.prim_id();
+  dst->variantSets() = src.variantSets();
+}
+
+// Move Prim except for its children. `src` keeps its children.
+void DetachPrim(Prim &src, Prim *dst) {
+  std::vector<Prim> children = std::move(src.children());
+  src.children().clear();
+  (*dst) = std::move(src);
+  src.children() = std::move(children);
+}
+
+void ReleaseChildren(const Prim &prim) { (void)prim; }
+
+void ReleaseChildren(Prim &prim) {
+  // Children are already moved to FrozenStage.
+  std::vector<Prim>().swap(prim.children());
+}
+
+//
+// PrimT = `const Prim` : copy Prim, `Prim` : move Prim.
+//
+template <typename PrimT>
+bool FreezePrimRec(PrimT &prim, const Path &parent_path, int64_t parent_idx,
+                   uint32_t depth, std::vector<Prim> *prims,
+                   std::vector<FrozenPrimNode> *nodes, std::string *name_pool,
+                   int64_t *out_idx, std::string *err) {
+  if (depth > kMaxFrozenStageDepth) {
+    PUSH_ERROR_AND_RETURN("Prim hierarchy too deep.");
+  }
+
+  const std::string &name = prim.element_name();
+  if (name.empty()) {
+    PUSH_ERROR_AND_RETURN(fmt::format(
+        "Prim's elementName is empty. Parent Path = {}",
+        parent_path.full_path_name()));
+  }
+
+  if ((name_pool->size() + name.size() + 1) >
+      size_t((std::numeric_limits<uint32_t>::max)())) {
+    PUSH_ERROR_AND_RETURN("Too many Prims.");
+  }
+
+  FrozenPrimNode node;
+  node.parent = parent_idx;
+  node.depth = depth;
+  node.name_offset = uint32_t(name_pool->size());
+  node.name_length = uint32_t(name.size());
+  name_pool->append(name);
+  name_pool->push_back('\0');
+
+  Path abs_path = parent_path.AppendPrim(name);
+
+  std::vector<size_t> order;
+  GetTraversalOrder(prim.children(), prim.metas().primChildren, &order);
+
+  const int64_t idx = int64_t(prims->size());
+
+  {
+    Prim p(value::Value(nullptr));
+    DetachPrim(prim, &p);
+    p.absolute_path() = abs_path;
+    prims->emplace_back(std::move(p));
+  }
+  nodes->push_back(node);
+
+  int64_t prev_child{-1};
+  for (size_t i : order) {
+    int64_t child_idx{-1};
+    if (!FreezePrimRec(prim.children()[i], abs_path, idx, depth + 1, prims,
+                       nodes, name_pool, &child_idx, err)) {
+      return false;
+    }
+
+    if (prev_child == -1) {
+      (*nodes)[size_t(idx)].first_child = child_idx;
+    } else {
+      (*nodes)[size_t(prev_child)].next_sibling = child_idx;
+    }
+    (*nodes)[size_t(idx)].num_children++;
+    prev_child = child_idx;
+  }
+
+  (*nodes)[size_t(idx)].subtree_end = uint64_t(prims->size());
+
+  ReleaseChildren(prim);
+
+  (*out_idx) = idx;
+  return true;
+}
+
+template <typename StageT>
+bool FreezeStageImpl(StageT &stage, const std::vector<Prim> &root_prims,
+                     std::vector<Prim> *prims,
+                     std::vector<FrozenPrimNode> *nodes,
+                     std::vector<uint64_t> *root_indices,
+                     std::string *name_pool, std::string *err) {
+  size_t num_prims = 0;
+  for (const Prim &root : root_prims) {
+    num_prims += CountPrimsRec(root, 0);
+  }
+
+  // Allocate blocks at once.
+  prims->reserve(num_prims);
+  nodes->reserve(num_prims);
+
+  std::vector<size_t> order;
+  GetTraversalOrder(root_prims, stage.metas().primChildren, &order);
+
+  Path root_path("/", "");
+  for (size_t i : order) {
+    int64_t idx{-1};
+    if (!FreezePrimRec(stage.root_prims()[i], root_path, /* parent */ -1,
+                       /* depth */ 0, prims, nodes, name_pool, &idx, err)) {
+      return false;
+    }
+    root_indices->push_back(uint64_t(idx));
+  }
+
+  for (size_t i = 0; i + 1 < root_indices->size(); i++) {
+    (*nodes)[size_t((*root_indices)[i])].next_sibling =
+        int64_t((*root_indices)[i + 1]);
+  }
+
+  return true;
+}
+
+}  // namespace
+
+void FrozenStage::clear() {
+  _prims.clear();
+  _nodes.clear();
+  _root_indices.clear();
+  _name_pool.clear();
+  _prim_id_to_index.clear();
+  _metas = StageMetas();
+}
+
+const char *FrozenStage::element_name(size_t idx, size_t *len) const {
+  if (idx >= _nodes.size()) {
+    return nullptr;
+  }
+
+  if (len) {
+    (*len) = _nodes[idx].name_length;
+  }
+  return _name_pool.c_str() + _nodes[idx].name_offset;
+}
+
+int64_t FrozenStage::find_child_index(int64_t parent_idx,
+                                      const std::string &name) const {
+  return find_child_index(parent_idx, name.data(), name.size());
+}
+
+int64_t FrozenStage::find_child_index(int64_t parent_idx, const char *name,
+                                      size_t len) const {
+  int64_t idx{-1};
+  if (parent_idx < 0) {
+    idx = _root_indices.empty() ? -1 : int64_t(_root_indices[0]);
+  } else if (size_t(parent_idx) < _nodes.size()) {
+    idx = _nodes[size_t(parent_idx)].first_child;
+  }
+
+  while (idx >= 0) {
+    const FrozenPrimNode &node = _nodes[size_t(idx)];
+    if ((node.name_length == len) &&
+        (std::memcmp(_name_pool.data() + node.name_offset, name, len) == 0)) {
+      return idx;
+    }
+    idx = node.next_sibling;
+  }
+
+  return -1;
+}
+
+int64_t FrozenStage::find_prim_index(const Path &path) const {
+  if (!path.is_valid() || !path.is_absolute_path()) {
+    return -1;
+  }
+
+  const std::string &s = path.prim_part();
+
+  // Split "/a/b/c" into elements without allocating Path objects.
+  int64_t idx{-1};
+  size_t start = 1;  // skip the leading '/'
+  while (start <= s.size()) {
+    size_t end = s.find('/', start);
+    if (end == std::string::npos) {
+      end = s.size();
+    }
+
+    if (end == start) {
+      // empty element(e.g. "/" or "//")
+      return -1;
+    }
+
+    idx = find_child_index(idx, s.data() + start, end - start);
+    if (idx < 0) {
+      return -1;
+    }
+
+    start = end + 1;
+  }
+
+  return idx;
+}
+
+int64_t FrozenStage::find_prim_index_by_prim_id(int64_t prim_id) const {
+  if ((prim_id < 1) || (size_t(prim_id) >= _prim_id_to_index.size())) {
+    return -1;
+  }
+  return _prim_id_to_index[size_t(prim_id)];
+}
+
+namespace {
+
+void BuildPrimIdTable(const std::vector<Prim> &prims,
+                      std::vector<int64_t> *table) {
+  table->clear();
+  for (size_t i = 0; i < prims.size(); i++) {
+    int64_t id = prims[i].prim_id();
+    if (id > 0) {
+      if (size_t(id) >= table->size()) {
+        table->resize(size_t(id) + 1, -1);
+      }
+      (*table)[size_t(id)] = int64_t(i);
+    }
+  }
+}
+
+}  // namespace
+
+bool FreezeStage(const Stage &stage, FrozenStage *dst, std::string *err) {
+  if (!dst) {
+    PUSH_ERROR_AND_RETURN("`dst` argument is nullptr.");
+  }
+
+  dst->clear();
+
+  if (!FreezeStageImpl(stage, stage.root_prims(), &dst->_prims, &dst->_nodes,
+                       &dst->_root_indices, &dst->_name_pool, err)) {
+    dst->clear();
+    return false;
+  }
+
+  BuildPrimIdTable(dst->_prims, &dst->_prim_id_to_index);
+  dst->_metas = stage.metas();
+
+  return true;
+}
+
+bool FreezeStage(Stage &&stage, FrozenStage *dst, std::string *err) {
+  if (!dst) {
+    PUSH_ERROR_AND_RETURN("`dst` argument is nullptr.");
+  }
+
+  dst->clear();
+
+  const Stage &cstage = stage;
+  if (!FreezeStageImpl(stage, cstage.root_prims(), &dst->_prims, &dst->_nodes,
+                       &dst->_root_indices, &dst->_name_pool, err)) {
+    dst->clear();
+    return false;
+  }
+
+  BuildPrimIdTable(dst->_prims, &dst->_prim_id_to_index);
+  dst->_metas = std::move(stage.metas());
+
+  stage.root_prims().clear();
+
+  return true;
+}
+
+}  // namespace tinyusdz
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: Apache 2.0
+// Copyright 2024 - Present, Light Transport Entertainment, Inc.
+//
+// FrozenStage: Read-only, flattened(linearized) representation of Stage.
+//
+// Prims are stored in a single array in depth-first order(the same order as
+// tydra::VisitPrims), and hierarchy is represented by index-based
+// parent/child/sibling links(like glTF's node array). Prim element names are
+// stored in a single string pool.
+//
+// Compared to Stage(tree of `Prim` where each Prim owns its `children`
+// array), FrozenStage requires only a few memory allocations for the
+// hierarchy and traversal does not chase pointers of nested std::vector.
+//
+// NOTE: Property values are still owned by each Prim(value::Value).
+//
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "prim-types.hh"
+#include "stage.hh"
+
+namespace tinyusdz {
+
+///
+/// Hierarchy info of a Prim in FrozenStage.
+/// Index is the index to `FrozenStage::prims()`. -1 = invalid(none).
+///
+struct FrozenPrimNode {
+  int64_t parent{-1};
+  int64_t first_child{-1};
+  int64_t next_sibling{-1};
+
+  // One past the last descendant index. [index, subtree_end) is the subtree
+  // of this Prim. Use this to skip(prune) the subtree in linear traversal.
+  uint64_t subtree_end{0};
+
+  uint32_t num_children{0};
+  uint32_t depth{0};  // Tree depth. 0 = root Prim.
+
+  // elementName in the string pool.
+  uint32_t name_offset{0};
+  uint32_t name_length{0};
+};
+
+class FrozenStage {
+ public:
+  FrozenStage() = default;
+
+  ///
+  /// Number of Prims.
+  ///
+  size_t size() const { return _prims.size(); }
+
+  bool empty() const { return _prims.empty(); }
+
+  ///
+  /// Prims in depth-first order. Each Prim does not have `children()`(use
+  /// `nodes()` to get hierarchy info). `absolute_path()` and `prim_id()` of
+  /// Prim are valid.
+  ///
+  const std::vector<Prim> &prims() const { return _prims; }
+
+  const std::vector<FrozenPrimNode> &nodes() const { return _nodes; }
+
+  const Prim &prim(size_t idx) const { return _prims[idx]; }
+
+  const FrozenPrimNode &node(size_t idx) const { return _nodes[idx]; }
+
+  ///
+  /// Indices of root Prims.
+  ///
+  const std::vector<uint64_t> &root_indices() const { return _root_indices; }
+
+  ///
+  /// elementName of the Prim.
+  ///
+  /// @return nullptr when `idx` is out-of-range. Returned string is
+  /// null-terminated.
+  ///
+  const char *element_name(size_t idx, size_t *len = nullptr) const;
+
+  ///
+  /// Find Prim at the absolute Path.
+  ///
+  /// @return Prim index. -1 when not found.
+  ///
+  int64_t find_prim_index(const Path &path) const;
+
+  ///
+  /// Find Prim from Prim id.
+  ///
+  /// @return Prim index. -1 when not found.
+  ///
+  int64_t find_prim_index_by_prim_id(int64_t prim_id) const;
+
+  ///
+  /// Find child Prim by elementName.
+  ///
+  /// @param[in] parent_idx Parent Prim index. -1 = find from root Prims.
+  /// @return Prim index. -1 when not found.
+  ///
+  int64_t find_child_index(int64_t parent_idx, const std::string &name) const;
+
+  const StageMetas &metas() const { return _metas; }
+
+  void clear();
+
+ private:
+  int64_t find_child_index(int64_t parent_idx, const char *name,
+                           size_t len) const;
+
+  friend bool FreezeStage(const Stage &stage, FrozenStage *dst,
+                          std::string *err);
+  friend bool FreezeStage(Stage &&stage, FrozenStage *dst, std::string *err);
+
+  std::vector<Prim> _prims;
+  std::vector<FrozenPrimNode> _nodes;
+  std::vector<uint64_t> _root_indices;
+  std::string _name_pool;  // null-terminated elementNames.
+
+  // prim_id -> Prim index. -1 = no Prim.
+  std::vector<int64_t> _prim_id_to_index;
+
+  StageMetas _metas;
+};
+
+///
+/// Build FrozenStage from Stage.
+/// Prims are copied. `stage` must be committed(`Stage::commit()`) to preserve
+/// prim_id. (absolute_path is recomputed).
+///
+bool FreezeStage(const Stage &stage, FrozenStage *dst, std::string *err);
+
+///
+/// Build FrozenStage from Stage.
+/// Prim data are moved from `stage`. `stage` becomes empty after this call.
+///
+bool FreezeStage(Stage &&stage, FrozenStage *dst, std::string *err);
+
+}  // namespace tinyusdz
@@ -0,0 +1,718 @@
+// SPDX-License-Identifier: Apache 2.0
+// Copyright 2024 - Present, Light Transport Entertainment, Inc.
+#include "incremental-composition.hh"
+
+#include <algorithm>
+
+#include "common-macros.inc"
+#include "stage.hh"
+#include "tiny-format.hh"
+
+#define PushError(s) \
+  if (err) {         \
+    (*err) += s;     \
+  }
+
+#define PushWarn(s) \
+  if (warn) {       \
+    (*warn) += s;   \
+  }
+
+namespace tinyusdz {
+
+namespace {
+
+constexpr uint32_t kMaxPrimDepth = 1024 * 1024;
+
+// "/a/b/c" -> "a"
+std::string RootPrimName(const Path &path) {
+  const std::string &s = path.prim_part();
+  if (s.size() < 2 || s[0] != '/') {
+    return std::string();
+  }
+  size_t end = s.find('/', 1);
+  if (end == std::string::npos) {
+    end = s.size();
+  }
+  return s.substr(1, end - 1);
+}
+
+// Find PrimSpec at `path` in the PrimSpec tree of the root Prim `root`.
+PrimSpec *FindPrimSpec(PrimSpec &root, const Path &path) {
+  const std::string &s = path.prim_part();
+  if (s.size() < 2 || s[0] != '/') {
+    return nullptr;
+  }
+
+  PrimSpec *ps{nullptr};
+  size_t start = 1;
+  while (start <= s.size()) {
+    size_t end = s.find('/', start);
+    if (end == std::string::npos) {
+      end = s.size();
+    }
+    const std::string name = s.substr(start, end - start);
+
+    if (!ps) {
+      if (root.name() != name) {
+        return nullptr;
+      }
+      ps = &root;
+    } else {
+      PrimSpec *child{nullptr};
+      for (auto &c : ps->children()) {
+        if (c.name() == name) {
+          child = &c;
+          break;
+        }
+      }
+      if (!child) {
+        return nullptr;
+      }
+      ps = child;
+    }
+
+    start = end + 1;
+  }
+
+  return ps;
+}
+
+// Apply variant selections to PrimSpecs which have(unresolved) `variantSets`
+// in the PrimSpec tree of the root Prim `root`. Prim paths of the applied
+// selections are added to `applied`.
+void ApplyVariantSelections(
+    const std::map<std::string, std::map<std::string, std::string>>
+        &selections,
+    PrimSpec &root, std::set<std::string> *applied) {
+  for (const auto &sel : selections) {
+    Path path(sel.first, "");
+    if (RootPrimName(path) != root.name()) {
+      continue;
+    }
+
+    PrimSpec *target = FindPrimSpec(root, path);
+    if (!target || !target->metas().variantSets) {
+      continue;
+    }
+
+    if (!target->metas().variants) {
+      target->metas().variants = VariantSelectionMap();
+    }
+    for (const auto &v : sel.second) {
+      target->metas().variants.value()[v.first] = v.second;
+    }
+
+    if (applied) {
+      applied->insert(sel.first);
+    }
+  }
+}
+
+void CollectInheritRootsRec(uint32_t depth, const PrimSpec &ps,
+                            std::set<std::string> *roots) {
+  if (depth > kMaxPrimDepth) {
+    return;
+  }
+
+  if (ps.metas().inherits) {
+    for (const auto &path : ps.metas().inherits.value().second) {
+      std::string name = RootPrimName(path);
+      if (!name.empty()) {
+        roots->insert(name);
+      }
+    }
+  }
+
+  for (const auto &child : ps.children()) {
+    CollectInheritRootsRec(depth + 1, child, roots);
+  }
+}
+
+}  // namespace
+
+bool IncrementalComposer::open(const AssetResolutionResolver &resolver,
+                               const Layer &layer, std::string *warn,
+                               std::string *err,
+                               const IncrementalCompositionOptions &options) {
+  _resolver = resolver;
+  _options = options;
+
+  _root_layer = layer;
+  _local_layer = Layer();
+  _composed = Layer();
+
+  _sublayer_assets.clear();
+  _deps.clear();
+  _dirty_roots.clear();
+  _variant_selections.clear();
+  _payload_rules = PayloadLoadRules(options.load_payloads);
+  _payload_loads.clear();
+  _layer_cache.clear();
+
+  _needs_sublayers = true;
+  _all_dirty = true;
+
+  return update(warn, err);
+}
+
+bool IncrementalComposer::set_primspec(const PrimSpec &ps, std::string *err) {
+  const std::string &name = ps.name();
+
+  if (_root_layer.has_primspec(name)) {
+    _root_layer.replace_primspec(name, ps);
+  } else if (!_root_layer.add_primspec(name, ps)) {
+    PUSH_ERROR_AND_RETURN(
+        fmt::format("Invalid PrimSpec name `{}`.", name));
+  }
+
+  if (_options.sublayers && !_root_layer.metas().subLayers.empty()) {
+    _needs_sublayers = true;
+  } else if (_local_layer.has_primspec(name)) {
+    _local_layer.replace_primspec(name, ps);
+  } else {
+    _local_layer.add_primspec(name, ps);
+  }
+
+  _dirty_roots.insert(name);
+
+  return true;
+}
+
+bool IncrementalComposer::remove_primspec(const std::string &name) {
+  if (!_root_layer.has_primspec(name)) {
+    return false;
+  }
+
+  _root_layer.primspecs().erase(name);
+
+  if (_options.sublayers && !_root_layer.metas().subLayers.empty()) {
+    // PrimSpec of the same name may exist in subLayers.
+    _needs_sublayers = true;
+  } else {
+    _local_layer.primspecs().erase(name);
+  }
+
+  _dirty_roots.insert(name);
+
+  return true;
+}
+
+bool IncrementalComposer::set_variant_selection(
+    const Path &prim_path, const std::string &variant_set_name,
+    const std::string &variant_name, std::string *err) {
+  const std::string root_name = RootPrimName(prim_path);
+  if (root_name.empty() || !prim_path.is_absolute_path() ||
+      prim_path.is_property_path()) {
+    PUSH_ERROR_AND_RETURN(fmt::format("Invalid Prim path `{}`.",
+                                      prim_path.full_path_name()));
+  }
+
+  if (variant_set_name.empty()) {
+    PUSH_ERROR_AND_RETURN("variantSet name is empty.");
+  }
+
+  _variant_selections[prim_path.prim_part()][variant_set_name] =
+      variant_name;
+  _dirty_roots.insert(root_name);
+
+  return true;
+}
+
+bool IncrementalComposer::load_payload(const Path &prim_path,
+                                       std::string *err) {
+  const std::string root_name = RootPrimName(prim_path);
+  if (root_name.empty() || !prim_path.is_absolute_path() ||
+      prim_path.is_property_path()) {
+    PUSH_ERROR_AND_RETURN(fmt::format("Invalid Prim path `{}`.",
+                                      prim_path.full_path_name()));
+  }
+
+  _payload_rules.load(prim_path);
+
+  // Loading payloads only adds PrimSpecs, so compose them into the composed
+  // root Prim.
+  _payload_loads[root_name].push_back(prim_path.prim_part());
+
+  return true;
+}
+
+bool IncrementalComposer::unload_payload(const Path &prim_path,
+                                         std::string *err) {
+  const std::string root_name = RootPrimName(prim_path);
+  if (root_name.empty() || !prim_path.is_absolute_path() ||
+      prim_path.is_property_path()) {
+    PUSH_ERROR_AND_RETURN(fmt::format("Invalid Prim path `{}`.",
+                                      prim_path.full_path_name()));
+  }
+
+  _payload_rules.unload(prim_path);
+
+  // Composed PrimSpecs from the payloads cannot be removed, so recompose
+  // the root Prim.
+  _dirty_roots.insert(root_name);
+
+  return true;
+}
+
+bool IncrementalComposer::mark_asset_dirty(const std::string &resolved_path) {
+  _layer_cache.erase(resolved_path);
+
+  bool found{false};
+
+  if (_sublayer_assets.count(resolved_path)) {
+    _needs_sublayers = true;
+    _all_dirty = true;
+    found = true;
+  }
+
+  for (const auto &item : _deps) {
+    if (item.second.assets.count(resolved_path)) {
+      _dirty_roots.insert(item.first);
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+const std::set<std::string> *IncrementalComposer::asset_dependencies(
+    const std::string &root_name) const {
+  const auto it = _deps.find(root_name);
+  if (it == _deps.end()) {
+    return nullptr;
+  }
+  return &it->second.assets;
+}
+
+bool IncrementalComposer::composite_sublayers(std::string *warn,
+                                              std::string *err) {
+  _stats.num_sublayer_compositions++;
+
+  if (!_options.sublayers || _root_layer.metas().subLayers.empty()) {
+    _sublayer_assets.clear();
+    _local_layer = _root_layer;
+    return true;
+  }
+
+  SublayersCompositionOptions sublayers_options = _options.sublayers_options;
+  sublayers_options.layer_cache = &_layer_cache;
+
+  std::set<std::string> assets;
+  sublayers_options.loaded_assets = &assets;
+
+  Layer dst;
+  if (!CompositeSublayers(_resolver, _root_layer, &dst, warn, err,
+                          sublayers_options)) {
+    PUSH_ERROR_AND_RETURN("Composite `subLayers` failed.");
+  }
+
+  _local_layer = std::move(dst);
+  _sublayer_assets = std::move(assets);
+
+  return true;
+}
+
+bool IncrementalComposer::compose_arcs(
+    const std::string &name, Layer &layer, RootDeps &deps,
+    const PayloadLoadRules &payload_rules, std::set<std::string> &in_progress,
+    std::set<std::string> &done, std::set<std::string> *applied_selections,
+    std::string *warn, std::string *err) {
+  const Layer &local_layer = _local_layer;
+
+  ReferencesCompositionOptions references_options =
+      _options.references_options;
+  references_options.layer_cache = &_layer_cache;
+  references_options.loaded_assets = &deps.assets;
+
+  PayloadCompositionOptions payload_options = _options.payload_options;
+  payload_options.layer_cache = &_layer_cache;
+  payload_options.loaded_assets = &deps.assets;
+  payload_options.load_rules = &payload_rules;
+
+  for (uint32_t i = 0; i < _options.max_iterations; i++) {
+    bool all_resolved = true;
+
+    if (_options.references && layer.check_unresolved_references()) {
+      all_resolved = false;
+
+      Layer dst;
+      if (!CompositeReferences(_resolver, layer, &dst, warn, err,
+                               references_options)) {
+        PUSH_ERROR_AND_RETURN(fmt::format(
+            "Composite `references` failed. Prim `{}`", name));
+      }
+      layer = std::move(dst);
+    }
+
+    if (_options.payload &&
+        HasPayload(layer, /* force_check */ true, payload_options)) {
+      all_resolved = false;
+
+      Layer dst;
+      if (!CompositePayload(_resolver, layer, &dst, warn, err,
+                            payload_options)) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("Composite `payload` failed. Prim `{}`", name));
+      }
+      layer = std::move(dst);
+    }
+
+    if (_options.inherits && layer.check_unresolved_inherits()) {
+      all_resolved = false;
+
+      std::set<std::string> targets;
+      CollectInheritRootsRec(/* depth */ 0, layer.primspecs().at(name),
+                             &targets);
+
+      // Temporarily add inherited root Prims to the Layer.
+      std::vector<std::string> added;
+      for (const auto &target : targets) {
+        if (target == name) {
+          continue;
+        }
+        deps.inherited_roots.insert(target);
+
+        // Compose the inherited root Prim first when it is also dirty.
+        if (_dirty_roots.count(target) && !in_progress.count(target)) {
+          if (!compose_root(target, in_progress, done, warn, err)) {
+            return false;
+          }
+        }
+
+        const PrimSpec *src{nullptr};
+        if (done.count(target) || !_dirty_roots.count(target)) {
+          const Layer &composed = _composed;
+          const auto it = composed.primspecs().find(target);
+          if (it != composed.primspecs().end()) {
+            src = &it->second;
+          }
+        }
+        if (!src) {
+          const auto it = local_layer.primspecs().find(target);
+          if (it != local_layer.primspecs().end()) {
+            src = &it->second;
+          }
+        }
+
+        if (src && layer.add_primspec(target, *src)) {
+          added.push_back(target);
+        }
+      }
+
+      Layer dst;
+      if (!CompositeInherits(layer, &dst, warn, err)) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("Composite `inherits` failed. Prim `{}`", name));
+      }
+
+      for (const auto &target : added) {
+        dst.primspecs().erase(target);
+      }
+      layer = std::move(dst);
+    }
+
+    // Apply variant selections here(not to the local PrimSpec), since the
+    // Prim or its variantSets may come from references or payload.
+    if (_options.variant_sets) {
+      ApplyVariantSelections(_variant_selections, layer.primspecs().at(name),
+                             applied_selections);
+    }
+
+    if (_options.variant_sets && layer.check_unresolved_variant()) {
+      all_resolved = false;
+
+      Layer dst;
+      if (!CompositeVariant(layer, &dst, warn, err)) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("Composite `variantSet` failed. Prim `{}`", name));
+      }
+      layer = std::move(dst);
+    }
+
+    if (all_resolved) {
+      break;
+    }
+  }
+
+  return true;
+}
+
+bool IncrementalComposer::load_payloads(
+    const std::string &name, const std::vector<std::string> &prim_paths,
+    std::set<std::string> &in_progress, std::set<std::string> &done,
+    std::string *warn, std::string *err) {
+  if (done.count(name)) {
+    return true;
+  }
+
+  const Layer &composed = _composed;
+  const auto it = composed.primspecs().find(name);
+  if (it == composed.primspecs().end()) {
+    return true;
+  }
+
+  in_progress.insert(name);
+
+  Layer layer;
+  layer.metas() = composed.metas();
+  layer.add_primspec(name, it->second);
+
+  // Load only the requested payloads. Other arcs of the composed root Prim
+  // are already resolved, so only PrimSpecs from the payloads are composed.
+  PayloadLoadRules payload_rules(/* load_all */ false);
+  for (const auto &path : prim_paths) {
+    payload_rules.load(Path(path, ""));
+  }
+
+  RootDeps deps = _deps[name];
+  if (!compose_arcs(name, layer, deps, payload_rules, in_progress, done,
+                    /* applied_selections */ nullptr, warn, err)) {
+    return false;
+  }
+
+  _composed.primspecs().erase(name);
+  _composed.primspecs().emplace(name, std::move(layer.primspecs().at(name)));
+  _deps[name] = std::move(deps);
+
+  _stats.num_payload_updates++;
+
+  _updated_prims.push_back(name);
+  in_progress.erase(name);
+  done.insert(name);
+
+  return true;
+}
+
+bool IncrementalComposer::compose_root(const std::string &name,
+                                       std::set<std::string> &in_progress,
+                                       std::set<std::string> &done,
+                                       std::string *warn, std::string *err) {
+  if (done.count(name)) {
+    return true;
+  }
+
+  const Layer &local_layer = _local_layer;
+  const auto local_it = local_layer.primspecs().find(name);
+  if (local_it == local_layer.primspecs().end()) {
+    // Removed.
+    if (_composed.primspecs().erase(name)) {
+      _removed_prims.push_back(name);
+    }
+    _deps.erase(name);
+    done.insert(name);
+    return true;
+  }
+
+  in_progress.insert(name);
+
+  Layer layer;
+  layer.metas() = local_layer.metas();
+
+  layer.add_primspec(name, local_it->second);
+
+  RootDeps deps;
+  std::set<std::string> applied_selections;
+  if (!compose_arcs(name, layer, deps, _payload_rules, in_progress, done,
+                    &applied_selections, warn, err)) {
+    return false;
+  }
+
+  if (_options.variant_sets) {
+    for (const auto &sel : _variant_selections) {
+      if ((RootPrimName(Path(sel.first, "")) == name) &&
+          !applied_selections.count(sel.first)) {
+        PUSH_WARN(fmt::format(
+            "Variant selection for `{}` is not used. The Prim is not found "
+            "or it has no variantSets.",
+            sel.first));
+      }
+    }
+  }
+
+  _composed.primspecs().erase(name);
+  _composed.primspecs().emplace(name, std::move(layer.primspecs().at(name)));
+  _deps[name] = std::move(deps);
+
+  _updated_prims.push_back(name);
+  in_progress.erase(name);
+  done.insert(name);
+
+  return true;
+}
+
+bool IncrementalComposer::update(std::string *warn, std::string *err) {
+  _updated_prims.clear();
+  _removed_prims.clear();
+
+  _stats.num_updates++;
+
+  if (_needs_sublayers) {
+    if (!composite_sublayers(warn, err)) {
+      return false;
+    }
+    _composed.metas() = _local_layer.metas();
+    _needs_sublayers = false;
+  }
+
+  if (_all_dirty) {
+    const Layer &local_layer = _local_layer;
+    for (const auto &item : local_layer.primspecs()) {
+      _dirty_roots.insert(item.first);
+    }
+    const Layer &composed = _composed;
+    for (const auto &item : composed.primspecs()) {
+      _dirty_roots.insert(item.first);
+    }
+    _all_dirty = false;
+  }
+
+  // Dirty root Prims are recomposed with the latest payload load rules.
+  for (const auto &name : _dirty_roots) {
+    _payload_loads.erase(name);
+  }
+
+  if (_dirty_roots.empty() && _payload_loads.empty()) {
+    _stats.num_reused_prims += _composed.primspecs().size();
+    return true;
+  }
+
+  // Root Prims which inherit dirty root Prims are also dirty.
+  {
+    std::map<std::string, std::vector<std::string>> inheritors;
+    for (const auto &item : _deps) {
+      for (const auto &target : item.second.inherited_roots) {
+        inheritors[target].push_back(item.first);
+      }
+    }
+
+    std::vector<std::string> worklist(_dirty_roots.begin(),
+                                      _dirty_roots.end());
+    for (const auto &item : _payload_loads) {
+      worklist.push_back(item.first);
+    }
+    while (!worklist.empty()) {
+      std::string name = worklist.back();
+      worklist.pop_back();
+
+      const auto it = inheritors.find(name);
+      if (it == inheritors.end()) {
+        continue;
+      }
+      for (const auto &inheritor : it->second) {
+        if (_dirty_roots.insert(inheritor).second) {
+          worklist.push_back(inheritor);
+        }
+      }
+    }
+  }
+
+  std::set<std::string> in_progress;
+  std::set<std::string> done;
+  for (const auto &item : _payload_loads) {
+    if (_dirty_roots.count(item.first)) {
+      // Inherits a root Prim with newly loaded payloads.
+      continue;
+    }
+    if (!load_payloads(item.first, item.second, in_progress, done, warn,
+                       err)) {
+      return false;
+    }
+  }
+
+  for (const auto &name : _dirty_roots) {
+    if (!compose_root(name, in_progress, done, warn, err)) {
+      return false;
+    }
+  }
+
+  _stats.num_recomposed_prims += _updated_prims.size();
+  _stats.num_reused_prims += _composed.primspecs().size() -
+                             (std::min)(_composed.primspecs().size(),
+                                        _updated_prims.size());
+
+  _dirty_roots.clear();
+  _payload_loads.clear();
+
+  return true;
+}
+
+bool IncrementalComposer::apply_to_stage(Stage *stage, std::string *warn,
+                                         std::string *err) const {
+  if (!stage) {
+    PUSH_ERROR_AND_RETURN("`stage` is nullptr.");
+  }
+
+  std::set<std::string> removed(_removed_prims.begin(),
+                                _removed_prims.end());
+
+  for (const auto &name : _updated_prims) {
+    const auto it = _composed.primspecs().find(name);
+    if (it == _composed.primspecs().end()) {
+      continue;
+    }
+
+    nonstd::optional<Prim> prim;
+    if (!PrimSpecToPrim(it->second, &prim, warn, err)) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("Failed to build Prim `{}` from PrimSpec.", name));
+    }
+
+    if (!prim) {
+      // Unsupported Prim type.
+      removed.insert(name);
+      continue;
+    }
+
+    if (!stage->replace_root_prim(name, std::move(prim.value()))) {
+      PUSH_ERROR_AND_RETURN(fmt::format("Failed to replace root Prim `{}`: {}",
+                                        name, stage->get_error()));
+    }
+  }
+
+  if (!removed.empty()) {
+    std::vector<Prim> &root_prims = stage->root_prims();
+    root_prims.erase(std::remove_if(root_prims.begin(), root_prims.end(),
+                                    [&removed](const Prim &prim) {
+                                      return removed.count(
+                                                 prim.element_name()) > 0;
+                                    }),
+                     root_prims.end());
+
+    if (!stage->commit()) {
+      PUSH_ERROR_AND_RETURN("Failed to commit Stage.");
+    }
+  }
+
+  stage->metas() = _composed.metas();
+
+  return true;
+}
+
+bool LoadPayload(IncrementalComposer &composer, const Path &prim_path,
+                 Stage *stage, std::string *warn, std::string *err) {
+  if (!composer.load_payload(prim_path, err)) {
+    return false;
+  }
+
+  if (!composer.update(warn, err)) {
+    return false;
+  }
+
+  return composer.apply_to_stage(stage, warn, err);
+}
+
+bool UnloadPayload(IncrementalComposer &composer, const Path &prim_path,
+                   Stage *stage, std::string *warn, std::string *err) {
+  if (!composer.unload_payload(prim_path, err)) {
+    return false;
+  }
+
+  if (!composer.update(warn, err)) {
+    return false;
+  }
+
+  return composer.apply_to_stage(stage, warn, err);
+}
+
+}  // namespace tinyusdz
@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: Apache 2.0
+// Copyright 2024 - Present, Light Transport Entertainment, Inc.
+//
+// Incremental composition.
+//
+// IncrementalComposer keeps the composed(flattened) Layer and dependency
+// info of each root Prim(resolved asset paths loaded by `references` and
+// `payload`, and root Prims referred by `inherits`), so that editing a
+// PrimSpec, an asset or a variant selection recomposes only the affected
+// root Prim subtrees.
+//
+// The granularity of recomposition is a root Prim(and its subtree).
+//
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "asset-resolution.hh"
+#include "composition.hh"
+#include "prim-types.hh"
+
+namespace tinyusdz {
+
+struct IncrementalCompositionOptions {
+  // The maximum number of composition iterations(references, payload,
+  // inherits and variantSets) for each root Prim.
+  uint32_t max_iterations{32};
+
+  bool sublayers{true};
+  bool references{true};
+  bool payload{true};
+  bool inherits{true};
+  bool variant_sets{true};
+
+  // Load all payloads at `open()`. When false, no payload is loaded until
+  // `load_payload()` is called.
+  bool load_payloads{true};
+
+  // `layer_cache` and `loaded_assets`(and `load_rules` in
+  // `payload_options`) in these options are ignored(IncrementalComposer
+  // uses its own LayerCache, records loaded assets and manages payload load
+  // rules by itself).
+  SublayersCompositionOptions sublayers_options;
+  ReferencesCompositionOptions references_options;
+  PayloadCompositionOptions payload_options;
+};
+
+struct IncrementalCompositionStats {
+  uint64_t num_updates{0};
+  uint64_t num_sublayer_compositions{0};
+  uint64_t num_recomposed_prims{0};  // root Prims recomposed
+  uint64_t num_payload_updates{0};   // root Prims updated by payload loads
+  uint64_t num_reused_prims{0};      // root Prims kept as is
+};
+
+class IncrementalComposer {
+ public:
+  IncrementalComposer() = default;
+
+  IncrementalComposer(const IncrementalComposer &) = delete;
+  IncrementalComposer &operator=(const IncrementalComposer &) = delete;
+
+  ///
+  /// Set the root Layer and compose all Prims.
+  ///
+  /// @param[in] resolver AssetResolutionResolver. Copied and kept in
+  /// IncrementalComposer.
+  /// @param[in] layer Root Layer.
+  ///
+  bool open(const AssetResolutionResolver &resolver, const Layer &layer,
+            std::string *warn, std::string *err,
+            const IncrementalCompositionOptions &options =
+                IncrementalCompositionOptions());
+
+  ///
+  /// Add or replace root PrimSpec in the root Layer.
+  /// `ps.name()` is used as the Prim name.
+  ///
+  bool set_primspec(const PrimSpec &ps, std::string *err = nullptr);
+
+  ///
+  /// Remove root PrimSpec from the root Layer.
+  ///
+  /// @return false when the PrimSpec is not found.
+  ///
+  bool remove_primspec(const std::string &name);
+
+  ///
+  /// Set variant selection of the Prim at `prim_path`. The selection
+  /// precedes `variants` metadatum authored in the root Layer and in the
+  /// assets loaded by `references` and `payload`(the selection is applied
+  /// after these arcs are composed, so the Prim may come from them).
+  /// `update()` reports a warning when the Prim is not found or it has no
+  /// variantSets.
+  ///
+  bool set_variant_selection(const Path &prim_path,
+                             const std::string &variant_set_name,
+                             const std::string &variant_name,
+                             std::string *err = nullptr);
+
+  ///
+  /// Load payloads of the Prim at `prim_path` and its descendants.
+  ///
+  /// Newly loaded payloads are composed into the already composed root Prim
+  /// at `update()`, without recomposing the whole root Prim.
+  ///
+  bool load_payload(const Path &prim_path, std::string *err = nullptr);
+
+  ///
+  /// Unload payloads of the Prim at `prim_path` and its descendants.
+  /// The root Prim is recomposed at `update()`.
+  ///
+  bool unload_payload(const Path &prim_path, std::string *err = nullptr);
+
+  bool is_payload_loaded(const Path &prim_path) const {
+    return _payload_rules.is_loaded(prim_path);
+  }
+
+  const PayloadLoadRules &payload_load_rules() const { return _payload_rules; }
+
+  ///
+  /// Notify the content of the asset is modified.
+  ///
+  /// @param[in] resolved_path Resolved asset path.
+  /// @return true when any root Prim(or subLayers) depends on the asset.
+  ///
+  bool mark_asset_dirty(const std::string &resolved_path);
+
+  ///
+  /// Recompose dirty root Prims.
+  ///
+  /// `updated_prims()` and `removed_prims()` are reset on each call.
+  ///
+  bool update(std::string *warn, std::string *err);
+
+  ///
+  /// @return true when there are modifications not yet composed by
+  /// `update()`.
+  ///
+  bool is_dirty() const {
+    return _needs_sublayers || _all_dirty || !_dirty_roots.empty() ||
+           !_payload_loads.empty();
+  }
+
+  ///
+  /// Composed(flattened) Layer.
+  ///
+  const Layer &composed_layer() const { return _composed; }
+
+  ///
+  /// Names of root Prims recomposed in the last `update()` call.
+  /// Callers can apply the changes to Stage, e.g. by
+  /// `Stage::replace_root_prim`.
+  ///
+  const std::vector<std::string> &updated_prims() const {
+    return _updated_prims;
+  }
+
+  ///
+  /// Names of root Prims removed in the last `update()` call.
+  ///
+  const std::vector<std::string> &removed_prims() const {
+    return _removed_prims;
+  }
+
+  ///
+  /// Apply root Prims updated and removed in the last `update()` call to
+  /// `stage`, which is built from `composed_layer()`(e.g. by
+  /// `LayerToStage`). Updated root Prims are rebuilt and replaced by
+  /// `Stage::replace_root_prim`. Other root Prims are kept as is.
+  ///
+  bool apply_to_stage(Stage *stage, std::string *warn,
+                      std::string *err) const;
+
+  ///
+  /// Resolved asset paths the root Prim depends on. nullptr when the root
+  /// Prim is not found.
+  ///
+  const std::set<std::string> *asset_dependencies(
+      const std::string &root_name) const;
+
+  const IncrementalCompositionStats &stats() const { return _stats; }
+
+  void reset_stats() { _stats = IncrementalCompositionStats(); }
+
+ private:
+  struct RootDeps {
+    std::set<std::string> assets;          // resolved asset paths
+    std::set<std::string> inherited_roots;  // root Prim names
+  };
+
+  bool composite_sublayers(std::string *warn, std::string *err);
+  bool compose_root(const std::string &name,
+                    std::set<std::string> &in_progress,
+                    std::set<std::string> &done, std::string *warn,
+                    std::string *err);
+  bool compose_arcs(const std::string &name, Layer &layer, RootDeps &deps,
+                    const PayloadLoadRules &payload_rules,
+                    std::set<std::string> &in_progress,
+                    std::set<std::string> &done,
+                    std::set<std::string> *applied_selections,
+                    std::string *warn, std::string *err);
+  bool load_payloads(const std::string &name,
+                     const std::vector<std::string> &prim_paths,
+                     std::set<std::string> &in_progress,
+                     std::set<std::string> &done, std::string *warn,
+                     std::string *err);
+
+  AssetResolutionResolver _resolver;
+  IncrementalCompositionOptions _options;
+
+  Layer _root_layer;
+  Layer _local_layer;  // root Layer + subLayers
+  Layer _composed;
+
+  std::set<std::string> _sublayer_assets;
+  std::map<std::string, RootDeps> _deps;
+
+  std::set<std::string> _dirty_roots;
+  bool _needs_sublayers{false};  // Merge subLayers again.
+  bool _all_dirty{false};        // Recompose all root Prims.
+
+  PayloadLoadRules _payload_rules;
+
+  // Root Prim name -> Prim paths of payloads to be loaded at `update()`.
+  std::map<std::string, std::vector<std::string>> _payload_loads;
+
+  // Prim path -> (variantSet name -> variant name)
+  std::map<std::string, std::map<std::string, std::string>>
+      _variant_selections;
+
+  LayerCache _layer_cache{/* validate_content */ false};
+
+  std::vector<std::string> _updated_prims;
+  std::vector<std::string> _removed_prims;
+
+  IncrementalCompositionStats _stats;
+};
+
+///
+/// Load payloads of the Prim at `prim_path` and its descendants, and apply
+/// the newly composed Prims to `stage`.
+/// `stage` must be built from `composer.composed_layer()`.
+///
+bool LoadPayload(IncrementalComposer &composer, const Path &prim_path,
+                 Stage *stage, std::string *warn, std::string *err);
+
+///
+/// Unload payloads of the Prim at `prim_path` and its descendants, and apply
+/// the recomposed Prims to `stage`. See `LoadPayload`.
+///
+bool UnloadPayload(IncrementalComposer &composer, const Path &prim_path,
+                   Stage *stage, std::string *warn, std::string *err);
+
+}  // namespace tinyusdz
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MIT
 #include <algorithm>
 #include <fstream>
+#include <limits>
 
 #ifdef _WIN32
 
@@ -43,6 +44,13 @@
 // Assume Posix
 #include <wordexp.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TINYUSDZ_IO_POSIX_MMAP
+
 #endif
 
 #endif  // _WIN32
@@ -268,6 +276,179 @@ bool ReadWholeFile(std::vector<uint8_t> *out, std::string *err,
 #endif
 }
 
+MMapFile::~MMapFile() { close(); }
+
+bool MMapFile::supported() {
+#if defined(TINYUSDZ_ANDROID_LOAD_FROM_ASSETS)
+  return false;
+#elif defined(_WIN32) || defined(TINYUSDZ_IO_POSIX_MMAP)
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool MMapFile::open(const std::string &filepath, std::string *err,
+                    size_t filesize_max, size_t filesize_min) {
+  close();
+
+#if defined(TINYUSDZ_ANDROID_LOAD_FROM_ASSETS)
+  (void)filepath;
+  (void)filesize_max;
+  (void)filesize_min;
+  if (err) {
+    (*err) += "mmap is not supported when loading from AssetManager.\n";
+  }
+  return false;
+#elif defined(_WIN32)
+  HANDLE file = CreateFileW(UTF8ToWchar(filepath).c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    if (err) {
+      (*err) += "File open error : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  LARGE_INTEGER sz;
+  if (!GetFileSizeEx(file, &sz) || (sz.QuadPart <= 0)) {
+    CloseHandle(file);
+    if (err) {
+      (*err) += "File is empty or invalid : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  if (uint64_t(sz.QuadPart) > uint64_t((std::numeric_limits<size_t>::max)()) ||
+      ((filesize_max > 0) && (uint64_t(sz.QuadPart) > filesize_max))) {
+    CloseHandle(file);
+    if (err) {
+      (*err) += "File size is too large : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  if (uint64_t(sz.QuadPart) < filesize_min) {
+    CloseHandle(file);
+    if (err) {
+      (*err) += "File size is too small to mmap : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    if (err) {
+      (*err) += "Failed to create file mapping : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  void *addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!addr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    if (err) {
+      (*err) += "Failed to map file : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  _file = file;
+  _mapping = mapping;
+  _addr = reinterpret_cast<const uint8_t *>(addr);
+  _size = size_t(sz.QuadPart);
+  return true;
+#elif defined(TINYUSDZ_IO_POSIX_MMAP)
+#if defined(O_CLOEXEC)
+  int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+#else
+  int fd = ::open(filepath.c_str(), O_RDONLY);
+#endif
+  if (fd == -1) {
+    if (err) {
+      (*err) += "File open error : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  struct stat sb;
+  if ((fstat(fd, &sb) != 0) || !S_ISREG(sb.st_mode) || (sb.st_size <= 0)) {
+    ::close(fd);
+    if (err) {
+      (*err) += "File is empty or not a regular file : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  if (uint64_t(sb.st_size) > uint64_t((std::numeric_limits<size_t>::max)()) ||
+      ((filesize_max > 0) && (uint64_t(sb.st_size) > filesize_max))) {
+    ::close(fd);
+    if (err) {
+      (*err) += "File size is too large : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  if (uint64_t(sb.st_size) < filesize_min) {
+    ::close(fd);
+    if (err) {
+      (*err) += "File size is too small to mmap : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  size_t sz = size_t(sb.st_size);
+  void *addr = mmap(nullptr, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping is valid after closing the file descriptor.
+  ::close(fd);
+
+  if (addr == MAP_FAILED) {
+    if (err) {
+      (*err) += "Failed to mmap file : " + filepath + "\n";
+    }
+    return false;
+  }
+
+  _addr = reinterpret_cast<const uint8_t *>(addr);
+  _size = sz;
+  return true;
+#else
+  (void)filepath;
+  (void)filesize_max;
+  (void)filesize_min;
+  if (err) {
+    (*err) += "mmap is not supported on this platform.\n";
+  }
+  return false;
+#endif
+}
+
+void MMapFile::close() {
+#if defined(_WIN32)
+  if (_addr) {
+    UnmapViewOfFile(_addr);
+  }
+  if (_mapping) {
+    CloseHandle(_mapping);
+  }
+  if (_file) {
+    CloseHandle(_file);
+  }
+  _mapping = nullptr;
+  _file = nullptr;
+#elif defined(TINYUSDZ_IO_POSIX_MMAP)
+  if (_addr) {
+    munmap(const_cast<uint8_t *>(_addr), _size);
+  }
+#endif
+  _addr = nullptr;
+  _size = 0;
+}
+
 bool ReadFileHeader(std::vector<uint8_t> *out, std::string *err,
                     const std::string &filepath, uint32_t max_read_bytes,
                     void *userdata) {
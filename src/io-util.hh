@@ -110,6 +110,48 @@ bool ReadWholeFile(std::vector<uint8_t> *out, std::string *err,
                    const std::string &filepath, size_t filesize_max = 0,
                    void *userdata = nullptr);
 
+///
+/// Read-only memory mapped file.
+/// Supported on Windows and Posix platforms(not supported on Android(asset
+/// manager), iOS, emscripten and WASI). Use ReadWholeFile() when
+/// `MMapFile::supported()` is false.
+///
+/// NOTE: Mapped content becomes invalid(e.g. SIGBUS on Posix) when the file
+/// is truncated by another process while mapped.
+///
+class MMapFile {
+ public:
+  MMapFile() = default;
+  ~MMapFile();
+
+  MMapFile(const MMapFile &) = delete;
+  MMapFile &operator=(const MMapFile &) = delete;
+
+  static bool supported();
+
+  ///
+  /// @param[in] filepath File path(UTF-8).
+  /// @param[in] filesize_max Maximum file size in bytes. 0 = no limit.
+  /// @param[in] filesize_min Minimum file size in bytes. Smaller files are not
+  /// mapped(returns false).
+  ///
+  bool open(const std::string &filepath, std::string *err,
+            size_t filesize_max = 0, size_t filesize_min = 0);
+
+  void close();
+
+  const uint8_t *data() const { return _addr; }
+  size_t size() const { return _size; }
+
+ private:
+  const uint8_t *_addr{nullptr};
+  size_t _size{0};
+#ifdef _WIN32
+  void *_file{nullptr};     // HANDLE
+  void *_mapping{nullptr};  // HANDLE
+#endif
+};
+
 ///
 /// Read first N bytes from a file.
 /// Example is for detect file formats.
@@ -8,12 +8,13 @@ namespace tinyusdz {
 namespace performance {
 
 double now() {
-  auto t = std::chrono::system_clock::now();
+  // Use monotonic clock, since `now()` is used for measuring elapsed time.
+  auto t = std::chrono::steady_clock::now();
 
-  // to milliseconds.
-  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()); 
+  // to milliseconds(with fractional part).
+  std::chrono::duration<double, std::milli> ms = t.time_since_epoch();
 
-  return double(ms.count());
+  return ms.count();
 }
 
 } // namespace performance
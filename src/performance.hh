@@ -7,7 +7,8 @@
 namespace tinyusdz {
 namespace performance {
 
-// Return current time in [ms]
+// Return current time in [ms](monotonic clock, with fractional part).
+// Use it for measuring elapsed time.
 double now();
 
 } // performance
@@ -341,7 +341,7 @@ static ParseResult ParseTypedAttribute(std::set<std::string> &table, /* inout */
           }
 
           if (auto pv = attr.get_value<T>()) {
-            target.set_value(pv.value());
+            target.set_value(std::move(pv.value()));
           } else {
             ret.code = ParseResult::ResultCode::InternalError;
             ret.err = fmt::format("Fallback. Failed to retrieve value with requested type `{}`.", value::TypeTraits<T>::type_name());
@@ -351,10 +351,8 @@ static ParseResult ParseTypedAttribute(std::set<std::string> &table, /* inout */
         } else if (attr.get_var().is_timesamples()) {
           // e.g. "float radius.timeSamples = {0: 1.2, 1: 2.3}"
 
-          Animatable<T> anim;
           if (auto av = ConvertToAnimatable<T>(attr.get_var())) {
-            anim = av.value();
-            target.set_value(anim);
+            target.set_value(std::move(av.value()));
           } else {
             // Conversion failed.
             DCOUT("ConvertToAnimatable failed.");
@@ -364,7 +362,7 @@ static ParseResult ParseTypedAttribute(std::set<std::string> &table, /* inout */
           }
         } else if (attr.get_var().is_scalar()) {
           if (auto pv = attr.get_value<T>()) {
-            target.set_value(pv.value());
+            target.set_value(std::move(pv.value()));
           } else {
             ret.code = ParseResult::ResultCode::InternalError;
             ret.err = "Invalid attribute value.";
@@ -485,7 +483,7 @@ static ParseResult ParseTypedAttribute(std::set<std::string> &table, /* inout */
           target.set_blocked(true);
         } else if (attr.get_var().is_scalar()) {
           if (auto pv = attr.get_value<T>()) {
-            target.set_value(pv.value());
+            target.set_value(std::move(pv.value()));
           } else {
             ret.code = ParseResult::ResultCode::InternalError;
             ret.err = "Internal data corrupsed.";
@@ -609,7 +607,7 @@ static ParseResult ParseTypedAttribute(std::set<std::string> &table, /* inout */
           }
 
           if (auto pv = attr.get_value<T>()) {
-            target.set_value(pv.value());
+            target.set_value(std::move(pv.value()));
           } else {
             ret.code = ParseResult::ResultCode::InternalError;
             ret.err = fmt::format("Failed to retrieve value with requested type `{}`.", value::TypeTraits<T>::type_name());
@@ -619,10 +617,8 @@ static ParseResult ParseTypedAttribute(std::set<std::string> &table, /* inout */
         } else if (attr.get_var().is_timesamples()) {
           // e.g. "float radius.timeSamples = {0: 1.2, 1: 2.3}"
 
-          Animatable<T> anim;
           if (auto av = ConvertToAnimatable<T>(attr.get_var())) {
-            anim = av.value();
-            target.set_value(anim);
+            target.set_value(std::move(av.value()));
           } else {
             // Conversion failed.
             DCOUT("ConvertToAnimatable failed.");
@@ -632,7 +628,7 @@ static ParseResult ParseTypedAttribute(std::set<std::string> &table, /* inout */
           }
         } else if (attr.get_var().is_scalar()) {
           if (auto pv = attr.get_var().get_value<T>()) {
-            target.set_value(pv.value());
+            target.set_value(std::move(pv.value()));
           } else {
             ret.code = ParseResult::ResultCode::InternalError;
             ret.err = fmt::format("Failed to retrieve value with requested type `{}`.", value::TypeTraits<T>::type_name());
@@ -760,7 +756,7 @@ static ParseResult ParseTypedAttribute(std::set<std::string> &table, /* inout */
           target.set_blocked(true);
         } else if (attr.get_var().is_scalar()) {
           if (auto pv = attr.get_value<T>()) {
-            target.set_value(pv.value());
+            target.set_value(std::move(pv.value()));
           } else {
             ret.code = ParseResult::ResultCode::VariabilityMismatch;
             ret.err = "Internal data corrupsed.";
@@ -902,8 +898,7 @@ static ParseResult ParseExtentAttribute(std::set<std::string> &table, /* inout *
 
         Animatable<Extent> anim;
         if (auto av = ConvertToAnimatable<Extent>(attr.get_var())) {
-          anim = av.value();
-          target.set_value(anim);
+          target.set_value(std::move(av.value()));
         } else {
           // Conversion failed.
           DCOUT("ConvertToAnimatable failed.");
@@ -1915,7 +1910,7 @@ bool ReconstructXformOpsFromProperties(
           }
         } else if (auto rotY = SplitXformOpToken(tok, kRotateY)) {
           op.op_type = XformOp::OpType::RotateY;
-          op.suffix = rotX.value();
+          op.suffix = rotY.value();
 
           if (attr.get_var().is_timesamples()) {
             op.set_timesamples(attr.get_var().ts_raw());
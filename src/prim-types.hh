@@ -23,6 +23,7 @@
 #include <vector>
 
 #if defined(TINYUSDZ_ENABLE_THREAD)
+#include <atomic>
 #include <mutex>
 #include <thread>
 #endif
@@ -49,6 +50,34 @@
 
 namespace tinyusdz {
 
+#if defined(TINYUSDZ_ENABLE_THREAD)
+///
+/// std::mutex which can be a member of copyable/movable class(e.g. Prim,
+/// Layer). Copy/move constructs a new unlocked mutex(lock state is not
+/// copied).
+///
+class CopyableMutex : public std::mutex {
+ public:
+  CopyableMutex() = default;
+  CopyableMutex(const CopyableMutex &) : std::mutex() {}
+  CopyableMutex &operator=(const CopyableMutex &) { return *this; }
+};
+
+///
+/// std::atomic<bool> which can be a member of copyable/movable class. Copy
+/// constructs/assigns `false`(for a state valid only for the object itself).
+///
+class CopyableAtomicBool : public std::atomic<bool> {
+ public:
+  CopyableAtomicBool() : std::atomic<bool>(false) {}
+  CopyableAtomicBool(const CopyableAtomicBool &) : std::atomic<bool>(false) {}
+  CopyableAtomicBool &operator=(const CopyableAtomicBool &) {
+    store(false);
+    return *this;
+  }
+};
+#endif
+
 // SpecType enum must be same order with pxrUSD's SdfSpecType(since enum value
 // is stored in Crate directly)
 enum class SpecType {
@@ -1043,12 +1072,16 @@ struct TypedTimeSamples {
         (*dst) = std::move(p);
         return true;
       } else {
-        if (it == _samples.end()) {
-          // ???
-          return false;
-        }
-
-        (*dst) = it->value;
+        // Held: Use the sample at or before `t`.
+        // Use the first sample when `t` is before the first sample.
+        auto uit = std::upper_bound(
+            _samples.begin(), _samples.end(), t,
+            [](double tval, const Sample &a) { return tval < a.t; });
+        size_t idx = (uit == _samples.begin())
+                         ? 0
+                         : size_t(std::distance(_samples.begin(), uit) - 1);
+
+        (*dst) = _samples[idx].value;
         return true;
       }
     }
@@ -1173,12 +1206,19 @@ struct Animatable {
     _blocked = false;
   }
 
+  void set(T &&v) {
+    _value = std::move(v);
+    _blocked = false;
+  }
+
   const TypedTimeSamples<T> &get_timesamples() const { return _ts; }
 
   Animatable() {}
 
   Animatable(const T &v) : _value(v) {}
 
+  Animatable(T &&v) : _value(std::move(v)) {}
+
   // TODO: Init with timesamples
 
  private:
@@ -1220,6 +1260,8 @@ class TypedAttribute {
 
   void set_value(const T &v) { _attrib = v; }
 
+  void set_value(T &&v) { _attrib = std::move(v); }
+
   const nonstd::optional<T> get_value() const {
     if (_attrib) {
       return _attrib.value();
@@ -1408,6 +1450,8 @@ class TypedAttributeWithFallback {
 
   void set_value(const T &v) { _attrib = v; }
 
+  void set_value(T &&v) { _attrib = std::move(v); }
+
   void set_value_empty() { _empty = true; }
 
   bool is_value_empty() const { return _empty; }
@@ -2995,7 +3039,7 @@ class Prim {
   std::map<std::string, VariantSet> _variantSets;
 
 #if defined(TINYUSDZ_ENABLE_THREAD)
-  mutable std::mutex _mutex;
+  mutable CopyableMutex _mutex;
 #endif
 };
 
@@ -3403,6 +3447,7 @@ struct Layer {
     }
 
     _prim_specs.emplace(name, ps);
+    _dirty = true;
 
     return true;
   }
@@ -3428,6 +3473,7 @@ struct Layer {
     }
 
     _prim_specs.emplace(name, std::move(ps));
+    _dirty = true;
 
     return true;
   }
@@ -3453,6 +3499,7 @@ struct Layer {
     }
 
     _prim_specs.at(name) = ps;
+    _dirty = true;
 
     return true;
   }
@@ -3478,6 +3525,7 @@ struct Layer {
     }
 
     _prim_specs.at(name) = std::move(ps);
+    _dirty = true;
 
     return true;
   }
@@ -3486,7 +3534,11 @@ struct Layer {
     return _prim_specs;
   }
 
-  std::unordered_map<std::string, PrimSpec> &primspecs() { return _prim_specs; }
+  // NOTE: Invalidates the PrimSpec path cache(PrimSpecs may be modified).
+  std::unordered_map<std::string, PrimSpec> &primspecs() {
+    _dirty = true;
+    return _prim_specs;
+  }
 
   const LayerMetas &metas() const { return _metas; }
   LayerMetas &metas() { return _metas; }
@@ -3584,7 +3636,7 @@ struct Layer {
   LayerMetas _metas;
 
 #if defined(TINYUSDZ_ENABLE_THREAD)
-  mutable std::mutex _mutex;
+  mutable CopyableMutex _mutex;
 #endif
 
   // Cached primspec path.
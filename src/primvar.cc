@@ -78,15 +78,25 @@ bool PrimVar::get_interpolated_value(const double t, const value::TimeSampleInte
         const value::Value &p0 = samples[idx0].value;
         const value::Value &p1 = samples[idx1].value;
 
+        if (!value::IsLerpSupportedType(p0.type_id())) {
+          // e.g. matrix4d. Fallback to held interpolation.
+          (*dst) = (dt < 1.0) ? p0 : p1;
+          return true;
+        }
+
         bool ret = value::Lerp(p0, p1, dt, dst);
         return ret;
       } else {
-        if (it == samples.end()) {
-          // ???
-          return false;
-        }
-
-        (*dst) = it->value;
+        // Held: Use the sample at or before `t`.
+        // Use the first sample when `t` is before the first sample.
+        auto uit = std::upper_bound(
+            samples.begin(), samples.end(), t,
+            [](double tval, const value::TimeSamples::Sample &a) { return tval < a.t; });
+        size_t idx = (uit == samples.begin())
+                         ? 0
+                         : size_t(std::distance(samples.begin(), uit) - 1);
+
+        (*dst) = samples[idx].value;
         return true;
       }
     }
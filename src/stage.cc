@@ -136,30 +136,71 @@ nonstd::expected<const Prim *, std::string> Stage::GetPrimAtPath(
         "Path is not absolute. Non-absolute Path is TODO.\n");
   }
 
-  if (_dirty) {
-    DCOUT("clear cache.");
-    // Clear cache.
-    _prim_path_cache.clear();
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  // Lookup updates the index lazily when the Stage is not committed(or
+  // copied), so serialize concurrent lookups(e.g. from Tydra workers) until
+  // the index covers all Prims.
+  std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+  if (!_index_complete.load(std::memory_order_acquire) ||
+      root_nodes_changed()) {
+    lock.lock();
+  }
+#endif
 
-    _dirty = false;
-  } else {
-    // First find from a cache.
-    auto ret = _prim_path_cache.find(path.prim_part());
-    if (ret != _prim_path_cache.end()) {
-      DCOUT("Found cache.");
-      return ret->second;
+  if (root_nodes_changed()) {
+    // Root Prims are added or removed through `root_prims()`.
+    _dirty = true;
+    _prim_id_table_dirty = true;
+  }
+
+  if (_prim_id_table_dirty || (_prim_id_table_owner != this)) {
+    update_prim_id_table();
+  }
+
+  // First find from the index.
+  {
+    const auto it = _prim_path_index.find(path.prim_part());
+    if (it != _prim_path_index.end()) {
+      if (it->second < _prim_id_table.size()) {
+        const Prim *p = _prim_id_table[size_t(it->second)];
+        // Check if the entry is not stale.
+        if (p && (p->absolute_path().prim_part() == path.prim_part())) {
+          DCOUT("Found in index.");
+          return p;
+        }
+      }
     }
   }
 
+  if (!_dirty) {
+    // The index covers all Prims in the Stage.
+    DCOUT("Not found.");
+    return nonstd::make_unexpected("Cannot find path <" +
+                                   path.full_path_name() +
+                                   "> int the Stage.\n");
+  }
 
   // Brute-force search.
-  for (const auto &parent : _root_nodes) {
+  for (const auto &parent : root_prims()) {
     if (auto pv =
             GetPrimAtPathRec(&parent, /* root */ "", path, /* depth */ 0)) {
-      // Add to cache.
-      // Assume pointer address does not change unless dirty state.
-      _prim_path_cache[path.prim_part()] = pv.value();
-      return pv.value();
+      // Add to index when the Prim has valid prim_id and absolute_path.
+      // prim_id may be stale(e.g. Prim copied without `commit()`), so do not
+      // overwrite the slot of another Prim having the same prim_id.
+      const Prim *p = pv.value();
+      if ((p->prim_id() > 0) && has_prim_id(uint64_t(p->prim_id())) &&
+          (p->absolute_path().prim_part() == path.prim_part())) {
+        size_t id = size_t(p->prim_id());
+        if (id >= _prim_id_table.size()) {
+          _prim_id_table.resize(id + 1, nullptr);
+        }
+        const Prim *slot = _prim_id_table[id];
+        if (!slot || (slot == p) || (slot->prim_id() != p->prim_id())) {
+          _prim_id_table[id] = p;
+          _prim_path_index[path.prim_part()] = uint64_t(id);
+        }
+      }
+      return p;
     }
   }
 
@@ -242,25 +283,56 @@ bool Stage::find_prim_by_prim_id(const uint64_t prim_id, const Prim *&prim,
     return false;
   }
 
-  if (_prim_id_dirty) {
-    DCOUT("clear prim_id cache.");
-    // Clear cache.
-    _prim_id_cache.clear();
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  // Lookup updates the index lazily when the Stage is not committed(or
+  // copied), so serialize concurrent lookups(e.g. from Tydra workers) until
+  // the index covers all Prims.
+  std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+  if (!_index_complete.load(std::memory_order_acquire) ||
+      root_nodes_changed()) {
+    lock.lock();
+  }
+#endif
 
-    _prim_id_dirty = false;
-  } else {
-    // First find from a cache.
-    auto ret = _prim_id_cache.find(prim_id);
-    if (ret != _prim_id_cache.end()) {
-      DCOUT("Found cache.");
-      return ret->second;
+  if (root_nodes_changed()) {
+    // Root Prims are added or removed through `root_prims()`.
+    _dirty = true;
+    _prim_id_table_dirty = true;
+  }
+
+  if (_prim_id_table_dirty || (_prim_id_table_owner != this)) {
+    update_prim_id_table();
+  }
+
+  // First find from the table.
+  if (prim_id < _prim_id_table.size()) {
+    const Prim *p = _prim_id_table[size_t(prim_id)];
+    if (p && (p->prim_id() == int64_t(prim_id))) {
+      prim = p;
+      return true;
+    }
+  }
+
+  if (!_dirty) {
+    // The table covers all Prims in the Stage.
+    if (err) {
+      (*err) = fmt::format("Prim with prim_id {} not found in the Stage.", prim_id);
     }
+    return false;
   }
 
   const Prim *p{nullptr};
   for (const auto &root : root_prims()) {
     if (FindPrimByPrimIdRec(prim_id, &root, &p, 0, err)) {
-      _prim_id_cache[prim_id] = p;
+      if (has_prim_id(prim_id)) {
+        if (prim_id >= _prim_id_table.size()) {
+          _prim_id_table.resize(size_t(prim_id) + 1, nullptr);
+        }
+        const Prim *slot = _prim_id_table[size_t(prim_id)];
+        if (!slot || (slot->prim_id() != int64_t(prim_id))) {
+          _prim_id_table[size_t(prim_id)] = p;
+        }
+      }
       prim = p;
       return true;
     }
@@ -558,11 +630,12 @@ bool Stage::has_prim_id(const uint64_t prim_id) const {
 
 namespace {
 
-bool ComputeAbsPathAndAssignPrimIdRec(const Stage &stage, Prim &prim,
-                                      const Path &parentPath, uint32_t depth,
-                                      bool assign_prim_id,
-                                      bool force_assign_prim_id = true,
-                                      std::string *err = nullptr) {
+bool ComputeAbsPathAndAssignPrimIdRec(
+    const Stage &stage, Prim &prim, const Path &parentPath, uint32_t depth,
+    bool assign_prim_id, bool force_assign_prim_id,
+    std::unordered_map<std::string, uint64_t> *path_index,
+    std::vector<const Prim *> *id_table, bool *all_indexed,
+    std::string *err = nullptr) {
   if (depth > 1024 * 1024 * 128) {
     // too deep node.
     if (err) {
@@ -596,10 +669,26 @@ bool ComputeAbsPathAndAssignPrimIdRec(const Stage &stage, Prim &prim,
     }
   }
 
+  if (prim.prim_id() > 0) {
+    size_t id = size_t(prim.prim_id());
+    if (id >= id_table->size()) {
+      id_table->resize(id + 1, nullptr);
+    }
+    if ((*id_table)[id]) {
+      // prim_id is not unique.
+      (*all_indexed) = false;
+    } else {
+      (*id_table)[id] = &prim;
+      (*path_index)[abs_path.prim_part()] = uint64_t(id);
+    }
+  } else {
+    (*all_indexed) = false;
+  }
+
   for (Prim &child : prim.children()) {
-    if (!ComputeAbsPathAndAssignPrimIdRec(stage, child, abs_path, depth + 1,
-                                          assign_prim_id, force_assign_prim_id,
-                                          err)) {
+    if (!ComputeAbsPathAndAssignPrimIdRec(
+            stage, child, abs_path, depth + 1, assign_prim_id,
+            force_assign_prim_id, path_index, id_table, all_indexed, err)) {
       return false;
     }
   }
@@ -607,35 +696,137 @@ bool ComputeAbsPathAndAssignPrimIdRec(const Stage &stage, Prim &prim,
   return true;
 }
 
+void UpdatePrimIdTableRec(const Prim &prim, uint32_t depth,
+                          std::vector<const Prim *> *id_table) {
+  if (depth > 1024 * 1024 * 128) {
+    // too deep node.
+    return;
+  }
+
+  if (prim.prim_id() > 0) {
+    size_t id = size_t(prim.prim_id());
+    if (id >= id_table->size()) {
+      id_table->resize(id + 1, nullptr);
+    }
+    // Keep the first Prim when prim_id is duplicated(stale prim_id).
+    if (!(*id_table)[id]) {
+      (*id_table)[id] = &prim;
+    }
+  }
+
+  for (const Prim &child : prim.children()) {
+    UpdatePrimIdTableRec(child, depth + 1, id_table);
+  }
+}
+
+void UnregisterPrimIndexRec(const Prim &prim, uint32_t depth,
+                            std::unordered_map<std::string, uint64_t> *path_index,
+                            std::vector<const Prim *> *id_table) {
+  if (depth > 1024 * 1024 * 128) {
+    // too deep node.
+    return;
+  }
+
+  if (prim.prim_id() > 0) {
+    size_t id = size_t(prim.prim_id());
+    if ((id < id_table->size()) && ((*id_table)[id] == &prim)) {
+      (*id_table)[id] = nullptr;
+    }
+  }
+
+  const auto it = path_index->find(prim.absolute_path().prim_part());
+  if ((it != path_index->end()) && (int64_t(it->second) == prim.prim_id())) {
+    path_index->erase(it);
+  }
+
+  for (const Prim &child : prim.children()) {
+    UnregisterPrimIndexRec(child, depth + 1, path_index, id_table);
+  }
+}
+
 }  // namespace
 
+void Stage::update_prim_id_table() const {
+  std::fill(_prim_id_table.begin(), _prim_id_table.end(), nullptr);
+
+  for (const Prim &root : _root_nodes) {
+    UpdatePrimIdTableRec(root, 1, &_prim_id_table);
+  }
+
+  _prim_id_table_owner = this;
+  _prim_id_table_dirty = false;
+  set_indexed_root_nodes();
+  update_index_complete();
+}
+
+void Stage::unregister_prim_index(const Prim &prim) const {
+  if (_prim_id_table_dirty || (_prim_id_table_owner != this)) {
+    update_prim_id_table();
+  }
+  UnregisterPrimIndexRec(prim, 1, &_prim_path_index, &_prim_id_table);
+}
+
 bool Stage::compute_absolute_prim_path_and_assign_prim_id(
     bool force_assign_prim_id) {
+  if (force_assign_prim_id) {
+    // All Prims get new prim_id, so start from 1 to keep `_prim_id_table`
+    // dense.
+    _prim_id_allocator = HandleAllocator<uint64_t>();
+  }
+
+  _prim_path_index.clear();
+  _prim_id_table.clear();
+
+  bool all_indexed{true};
+
   Path rootPath("/", "");
-  for (Prim &root : root_prims()) {
+  for (Prim &root : _root_nodes) {
     if (!ComputeAbsPathAndAssignPrimIdRec(*this, root, rootPath, 1,
                                           /* assign_prim_id */ true,
-                                          force_assign_prim_id, &_err)) {
+                                          force_assign_prim_id,
+                                          &_prim_path_index, &_prim_id_table,
+                                          &all_indexed, &_err)) {
+      _dirty = true;
+      _prim_id_table_dirty = true;
+      update_index_complete();
       return false;
     }
   }
 
-  // TODO: Only set dirty when prim_id changed.
-  _prim_id_dirty = true;
+  _prim_id_table_owner = this;
+  _prim_id_table_dirty = false;
+  _dirty = !all_indexed;
+  set_indexed_root_nodes();
+  update_index_complete();
 
   return true;
 }
 
 bool Stage::compute_absolute_prim_path() {
+  _prim_path_index.clear();
+  _prim_id_table.clear();
+
+  bool all_indexed{true};
+
   Path rootPath("/", "");
-  for (Prim &root : root_prims()) {
+  for (Prim &root : _root_nodes) {
     if (!ComputeAbsPathAndAssignPrimIdRec(
             *this, root, rootPath, 1, /* assign prim_id */ false,
-            /* force_assign_prim_id */ true, &_err)) {
+            /* force_assign_prim_id */ true, &_prim_path_index,
+            &_prim_id_table, &all_indexed, &_err)) {
+      _dirty = true;
+      _prim_id_table_dirty = true;
+      update_index_complete();
       return false;
     }
   }
 
+  _prim_id_table_owner = this;
+  _prim_id_table_dirty = false;
+  _dirty = !all_indexed;
+  set_indexed_root_nodes();
+  update_index_complete();
+
   return true;
 }
 
@@ -701,9 +892,24 @@ bool Stage::add_root_prim(Prim &&prim, bool rename_prim_name) {
 
 
   _root_node_nameSet.insert(elementName);
+
+  if (root_nodes_changed()) {
+    _prim_id_table_dirty = true;
+  }
+
+  const Prim *prev_addr = _root_nodes.data();
   _root_nodes.emplace_back(std::move(prim));
 
+  if (prev_addr != _root_nodes.data()) {
+    // Reallocated. Existing index entries are still valid, but Prim addresses
+    // are changed.
+    _prim_id_table_dirty = true;
+  }
+  set_indexed_root_nodes();
+
+  // New Prim subtree is not indexed until `commit()`
   _dirty = true;
+  update_index_complete();
 
   return true;
 
@@ -741,6 +947,10 @@ bool Stage::replace_root_prim(const std::string &prim_name, Prim &&prim) {
     }
   }
 
+  if (root_nodes_changed()) {
+    _prim_id_table_dirty = true;
+  }
+
   // Simple linear scan
   auto result = std::find_if(_root_nodes.begin(), _root_nodes.end(), [prim_name](const Prim &p) {
     return (p.element_name() == prim_name);
@@ -754,6 +964,9 @@ bool Stage::replace_root_prim(const std::string &prim_name, Prim &&prim) {
     }
     prim.element_path() = Path(prim_name, /* prop_part */"");
 
+    // Only invalidate index entries of the replaced subtree.
+    unregister_prim_index(*result);
+
     (*result) = std::move(prim); // replace
 
   } else {
@@ -765,10 +978,18 @@ bool Stage::replace_root_prim(const std::string &prim_name, Prim &&prim) {
     prim.element_path() = Path(prim_name, /* prop_part */"");
 
     _root_node_nameSet.insert(prim_name);
+
+    const Prim *prev_addr = _root_nodes.data();
     _root_nodes.emplace_back(std::move(prim)); // add
+
+    if (prev_addr != _root_nodes.data()) {
+      _prim_id_table_dirty = true;
+    }
+    set_indexed_root_nodes();
   }
 
   _dirty = true;
+  update_index_complete();
 
   return true;
 }
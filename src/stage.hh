@@ -7,6 +7,8 @@
 #include "composition.hh"
 #include "prim-types.hh"
 
+#include <unordered_map>
+
 #if defined(TINYUSDZ_ENABLE_THREAD)
 #include <mutex>
 #endif
@@ -37,6 +39,11 @@ class Stage {
   /// @returns Const pointer to Prim(to avoid a copy). Never returns nullptr
   /// upon success.
   ///
+  /// Lookup may update the Prim lookup index when the Stage is not committed.
+  /// It is safe to call lookup APIs concurrently when TinyUSDZ is built with
+  /// TINYUSDZ_ENABLE_THREAD(lookups are serialized until the index covers all
+  /// Prims, e.g. after `commit()`).
+  ///
   nonstd::expected<const Prim *, std::string> GetPrimAtPath(
       const Path &path) const;
 
@@ -128,6 +135,11 @@ class Stage {
   /// @return Array of Root Prims.
   /// TODO: Deprecate non-const `root_prims()` API and use `add_root_prim()` instead.
   ///
+  /// NOTE: Call `commit()` after modifying Prims through the returned
+  /// reference. Until then, lookup falls back to Prim tree traversal when root
+  /// Prims are added or removed, but other modifications(e.g. adding child
+  /// Prims) are not reflected to the Prim lookup index.
+  ///
   std::vector<Prim> &root_prims() { return _root_nodes; }
 
   ///
@@ -214,6 +226,9 @@ class Stage {
   ///
   /// @brief Commit Stage state.
   ///
+  /// Also (re)builds Prim lookup index used in `GetPrimAtPath` and
+  /// `find_prim_by_prim_id`.
+  ///
   bool commit() {
     // Currently we always allocate Prim ID.
     return compute_absolute_prim_path_and_assign_prim_id(true);
@@ -245,7 +260,11 @@ class Stage {
  private:
 
 #if defined(TINYUSDZ_ENABLE_THREAD)
-  mutable std::mutex _mutex;
+  mutable CopyableMutex _mutex;
+
+  // true when the lookup index covers all Prims of this Stage. Lookups do not
+  // modify the index in that case, so they run without locking `_mutex`.
+  mutable CopyableAtomicBool _index_complete;
 #endif
 
 #if 0 // Deprecated. remove.
@@ -295,17 +314,58 @@ class Stage {
   mutable std::string _err;
   mutable std::string _warn;
 
-  // Cached prim path.
-  // key : prim_part string (e.g. "/path/bora")
-  mutable std::map<std::string, const Prim *> _prim_path_cache;
+  //
+  // Prim lookup index. Built in `compute_absolute_prim_path_and_assign_prim_id`
+  // (`commit`) and updated incrementally in `add_root_prim` and
+  // `replace_root_prim`.
+  //
+
+  // key : prim_part string (e.g. "/path/bora"), value : prim_id
+  mutable std::unordered_map<std::string, uint64_t> _prim_path_index;
+
+  // Dense prim_id -> Prim lookup table. index = prim_id. nullptr = no Prim
+  // assigned for the prim_id.
+  mutable std::vector<const Prim *> _prim_id_table;
+
+  // Stage instance which `_prim_id_table` was built for.
+  // Pointers in `_prim_id_table` are not valid for a copied Stage.
+  mutable const Stage *_prim_id_table_owner{nullptr};
+
+  mutable bool _dirty{true}; // True when Stage content changes(addition, deletion, composition/flatten, etc.) after the last `commit()`. Lookup falls back to Prim tree traversal when the index misses.
 
-  // Cached prim_id -> Prim lookup
-  // key : prim_id
-  mutable std::map<uint64_t, const Prim *> _prim_id_cache;
+  mutable bool _prim_id_table_dirty{true}; // True when Prim address may be changed(e.g. reallocation of `_root_nodes`)
+
+  // `_root_nodes` array the index was built for. Root Prims added or removed
+  // through non-const `root_prims()` are detected by comparing them.
+  mutable const Prim *_indexed_root_nodes{nullptr};
+  mutable size_t _num_indexed_root_nodes{0};
+
+  bool root_nodes_changed() const {
+    return (_root_nodes.data() != _indexed_root_nodes) ||
+           (_root_nodes.size() != _num_indexed_root_nodes);
+  }
+
+  void set_indexed_root_nodes() const {
+    _indexed_root_nodes = _root_nodes.data();
+    _num_indexed_root_nodes = _root_nodes.size();
+  }
+
+  // Call after the index state is modified.
+  void update_index_complete() const {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+    _index_complete.store(!_dirty && !_prim_id_table_dirty &&
+                              (_prim_id_table_owner == this) &&
+                              !root_nodes_changed(),
+                          std::memory_order_release);
+#endif
+  }
 
-  mutable bool _dirty{true}; // True when Stage content changes(addition, deletion, composition/flatten, etc.)
+  // Rebuild Prim pointers in `_prim_id_table` by traversing Prim tree.
+  // No Path string is constructed.
+  void update_prim_id_table() const;
 
-  mutable bool _prim_id_dirty{true}; // True when Prim Id assignent changed(TODO: Unify with `_dirty` flag)
+  // Remove index entries of Prim subtree.
+  void unregister_prim_index(const Prim &prim) const;
 
   mutable HandleAllocator<uint64_t> _prim_id_allocator;
 };
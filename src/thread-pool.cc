@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: Apache 2.0
+// Copyright 2024 - Present, Light Transport Entertainment, Inc.
+#include "thread-pool.hh"
+
+#include <algorithm>
+
+namespace tinyusdz {
+
+namespace {
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+// Pool and worker index of the current thread.
+thread_local const ThreadPool *tls_pool = nullptr;
+thread_local uint32_t tls_worker_index = 0;
+#endif
+
+}  // namespace
+
+uint32_t ThreadPool::resolve_num_threads(uint32_t num_threads) {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  if (num_threads == 0) {
+    num_threads = (std::max)(1u, std::thread::hardware_concurrency());
+  }
+  return (std::min)(1024u, num_threads);
+#else
+  (void)num_threads;
+  return 1;
+#endif
+}
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+
+ThreadPool::ThreadPool(uint32_t num_threads) {
+  _num_threads = resolve_num_threads(num_threads);
+
+  for (uint32_t i = 0; i < _num_threads; i++) {
+    _queues.emplace_back(new WorkQueue());
+  }
+
+  for (uint32_t i = 0; i < _num_threads; i++) {
+    _workers.emplace_back([this, i]() { worker_main(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _quit = true;
+  }
+  _task_cv.notify_all();
+
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+}
+
+uint32_t ThreadPool::thread_index() const {
+  if (tls_pool == this) {
+    return tls_worker_index;
+  }
+  return 0;
+}
+
+void ThreadPool::submit(std::function<void()> &&task) {
+  uint32_t idx;
+  if (tls_pool == this) {
+    idx = tls_worker_index;
+  } else {
+    idx = _next_queue.fetch_add(1) % _num_threads;
+  }
+
+  _num_pending.fetch_add(1);
+
+  {
+    std::lock_guard<std::mutex> lock(_queues[idx]->mutex);
+    _queues[idx]->tasks.emplace_back(std::move(task));
+  }
+
+  {
+    // Update under the lock to avoid lost wakeup.
+    std::lock_guard<std::mutex> lock(_mutex);
+    _num_queued.fetch_add(1);
+  }
+  _task_cv.notify_one();
+}
+
+bool ThreadPool::pop_task(uint32_t idx, std::function<void()> *task) {
+  // Own queue(LIFO)
+  {
+    WorkQueue &q = *_queues[idx];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.tasks.empty()) {
+      (*task) = std::move(q.tasks.back());
+      q.tasks.pop_back();
+      _num_queued.fetch_sub(1);
+      return true;
+    }
+  }
+
+  // Steal from other queues(FIFO)
+  for (uint32_t i = 1; i < _num_threads; i++) {
+    WorkQueue &q = *_queues[(idx + i) % _num_threads];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.tasks.empty()) {
+      (*task) = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      _num_queued.fetch_sub(1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::worker_main(uint32_t idx) {
+  tls_pool = this;
+  tls_worker_index = idx;
+
+  for (;;) {
+    std::function<void()> task;
+    if (pop_task(idx, &task)) {
+      task();
+
+      if (_num_pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _done_cv.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _task_cv.wait(lock,
+                  [this]() { return _quit || (_num_queued.load() > 0); });
+    if (_quit) {
+      break;
+    }
+  }
+
+  tls_pool = nullptr;
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _done_cv.wait(lock, [this]() { return _num_pending.load() == 0; });
+}
+
+#else  // !TINYUSDZ_ENABLE_THREAD
+
+ThreadPool::ThreadPool(uint32_t num_threads) {
+  (void)num_threads;
+  _num_threads = 1;
+}
+
+ThreadPool::~ThreadPool() {}
+
+uint32_t ThreadPool::thread_index() const { return 0; }
+
+void ThreadPool::submit(std::function<void()> &&task) {
+  // Run immediately.
+  task();
+}
+
+void ThreadPool::wait() {}
+
+#endif
+
+}  // namespace tinyusdz
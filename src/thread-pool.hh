@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: Apache 2.0
+// Copyright 2024 - Present, Light Transport Entertainment, Inc.
+//
+// Simple work-stealing thread pool.
+//
+// When TinyUSDZ is built without TINYUSDZ_ENABLE_THREAD, no thread is
+// created and tasks are executed immediately on the calling thread(in
+// submission order).
+//
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace tinyusdz {
+
+class ThreadPool {
+ public:
+  ///
+  /// @param[in] num_threads The number of worker threads. 0 = Use
+  /// std::thread::hardware_concurrency().
+  ///
+  explicit ThreadPool(uint32_t num_threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ///
+  /// The number of worker threads. 1 when built without
+  /// TINYUSDZ_ENABLE_THREAD.
+  ///
+  uint32_t num_threads() const { return _num_threads; }
+
+  ///
+  /// Submit a task.
+  ///
+  /// When called from a worker thread, the task is pushed to the worker's
+  /// local queue(LIFO, stolen by other workers from the other end).
+  ///
+  void submit(std::function<void()> &&task);
+
+  ///
+  /// Wait until all submitted tasks(including tasks submitted from tasks) are
+  /// finished. Must not be called from a worker thread.
+  ///
+  void wait();
+
+  ///
+  /// Index of the worker thread which runs the current task. [0,
+  /// num_threads()). Returns 0 for non-worker thread.
+  ///
+  uint32_t thread_index() const;
+
+  ///
+  /// Resolve the number of threads(0 = hardware concurrency).
+  ///
+  static uint32_t resolve_num_threads(uint32_t num_threads);
+
+ private:
+  uint32_t _num_threads{1};
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void worker_main(uint32_t idx);
+  bool pop_task(uint32_t idx, std::function<void()> *task);
+
+  std::vector<std::unique_ptr<WorkQueue>> _queues;
+  std::vector<std::thread> _workers;
+
+  std::mutex _mutex;
+  std::condition_variable _task_cv;  // notified when a task is submitted.
+  std::condition_variable _done_cv;  // notified when all tasks finished.
+
+  std::atomic<uint64_t> _num_pending{0};  // submitted but not finished.
+  std::atomic<int64_t> _num_queued{0};    // submitted but not started.
+  std::atomic<uint32_t> _next_queue{0};
+  bool _quit{false};
+#endif
+};
+
+}  // namespace tinyusdz
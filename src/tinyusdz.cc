@@ -1138,7 +1138,9 @@ bool LoadLayerFromAsset(AssetResolutionResolver &resolver, const std::string &re
     PUSH_ERROR_AND_RETURN(fmt::format("Failed to open asset `{}`.", resolved_asset_name));
   }
 
-  return LoadLayerFromMemory(asset.data(), asset.size(), resolved_asset_name, layer, warn, err,
+  // Read through const Asset to avoid copy-on-write of mmap-ed content.
+  const Asset &casset = asset;
+  return LoadLayerFromMemory(casset.data(), casset.size(), resolved_asset_name, layer, warn, err,
                            options);
 }
 
@@ -80,7 +80,7 @@ struct USDLoadOptions {
   ///
   bool load_sublayers{false}; // true: Load `subLayers`
   bool load_references{false}; // true: Load `references`
-  bool load_payloads{false}; // true: Load `paylod` at top USD loading(no lazy loading).
+  bool load_payloads{false}; // true: Load `paylod` at top USD loading(no lazy loading). Use LoadPayload(incremental-composition.hh) for on-demand loading.
 
   ///
   /// Max MBs allowed for each asset file(e.g. jpeg)
@@ -7,11 +7,13 @@
 #include "pprinter.hh"
 #include "prim-types.hh"
 #include "str-util.hh"
+#include "thread-pool.hh"
 #include "tiny-format.hh"
 #include "tinyusdz.hh"
 #include "usdGeom.hh"
 #include "usdShade.hh"
 #include "value-pprint.hh"
+#include "xform.hh"
 #include "image-util.hh"
 
 #if defined(TINYUSDZ_WITH_COLORIO)
@@ -172,19 +174,174 @@ nonstd::expected<VertexAttribute, std::string> GetTextureCoordinate(
   return std::move(vattr);
 }
 
+// Faces per task in parallel triangulation.
+constexpr size_t kTriangulationFacesPerTask = 4096;
+
 ///
-/// For GeomSubset. Build offset table to corresponding array index in
-/// mesh.faceVertexIndices. No need to use this function for triangulated mesh,
-/// since the index can be easily computed as `3 * subset.indices[i]`
+/// Triangulate a single polygon(face).
 ///
-bool BuildFaceVertexIndexOffsets(const std::vector<uint32_t> &faceVertexCounts,
-                                 std::vector<size_t> &faceVertexIndexOffsets) {
-  size_t offset = 0;
-  for (size_t i = 0; i < faceVertexCounts.size(); i++) {
-    uint32_t npolys = faceVertexCounts[i];
+/// @param[in] faceIndices faceVertexIndices of the face.
+/// @param[in] npolys The number of vertices of the face(3 or more).
+/// @param[out] dst Triangle corners in [0, npolys). Must have the capacity of
+/// `3 * (npolys - 2)`.
+/// @param[out] ntris The number of triangles written to `dst`. Can be less
+/// than `npolys - 2` for polygon with collinear vertices.
+/// @param[inout] polygon_2d Scratch buffer.
+///
+/// Return false when a polygon is degenerated.
+///
+template <typename T, typename BaseTy>
+bool TriangulateFace(
+    const std::vector<T> &points, const uint32_t *faceIndices, uint32_t npolys,
+    uint32_t *dst, size_t *ntris,
+    std::vector<std::vector<std::array<BaseTy, 2>>> &polygon_2d,
+    std::string &err) {
+  for (size_t k = 0; k < npolys; k++) {
+    if (faceIndices[k] >= points.size()) {
+      err = fmt::format("Invalid vertex index.\n");
+      return false;
+    }
+  }
+
+  if (npolys == 3) {
+    // No need for triangulation.
+    dst[0] = 0;
+    dst[1] = 1;
+    dst[2] = 2;
+    (*ntris) = 1;
+    return true;
+  }
+
+  const auto vsub = [](const T &a, const T &b) -> T {
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+  };
+
+  if (npolys == 4) {
+    const T p[4] = {points[faceIndices[0]], points[faceIndices[1]],
+                    points[faceIndices[2]], points[faceIndices[3]]};
+
+    const T d02 = vsub(p[2], p[0]);
+    const T d13 = vsub(p[3], p[1]);
+
+    // Area vector of the quad(x 2)
+    const T n = vcross(d02, d13);
+
+    // Concave quad must be split at the diagonal through the reflex vertex.
+    // Otherwise split at the shorter diagonal.
+    int reflex = -1;
+    for (int k = 0; k < 4; k++) {
+      const T e0 = vsub(p[k], p[(k + 3) % 4]);
+      const T e1 = vsub(p[(k + 1) % 4], p[k]);
+      if (vdot(vcross(e0, e1), n) < BaseTy(0)) {
+        reflex = k;
+        break;
+      }
+    }
+
+    bool split02;
+    if (reflex == -1) {
+      split02 = vdot(d02, d02) <= vdot(d13, d13);
+    } else {
+      split02 = (reflex % 2) == 0;
+    }
+
+    if (split02) {
+      dst[0] = 0;
+      dst[1] = 1;
+      dst[2] = 2;
+      dst[3] = 0;
+      dst[4] = 2;
+      dst[5] = 3;
+    } else {
+      dst[0] = 0;
+      dst[1] = 1;
+      dst[2] = 3;
+      dst[3] = 1;
+      dst[4] = 2;
+      dst[5] = 3;
+    }
+    (*ntris) = 2;
+    return true;
+  }
+
+  // Find the normal axis of the polygon using Newell's method
+  T n = {BaseTy(0), BaseTy(0), BaseTy(0)};
+
+  for (size_t k = 0; k < npolys; ++k) {
+    const T &point1 = points[faceIndices[k]];
+    const T &point2 = points[faceIndices[(k + 1) % npolys]];
+
+    T a = {point1[0] - point2[0], point1[1] - point2[1],
+           point1[2] - point2[2]};
+    T b = {point1[0] + point2[0], point1[1] + point2[1],
+           point1[2] + point2[2]};
+
+    n[0] += (a[1] * b[2]);
+    n[1] += (a[2] * b[0]);
+    n[2] += (a[0] * b[1]);
+  }
+  BaseTy length_n = vlength(n);
+  // Check if zero length normal
+  if (std::fabs(length_n) < std::numeric_limits<BaseTy>::epsilon()) {
+    err = "Degenerated polygon found.\n";
+    return false;
+  }
+
+  n = vnormalize(n);
+
+  T axis_w, axis_v, axis_u;
+  axis_w = n;
+  T a;
+  if (std::fabs(axis_w[0]) > BaseTy(0.9999999)) {  // TODO: use 1.0 - eps?
+    a = {BaseTy(0), BaseTy(1), BaseTy(0)};
+  } else {
+    a = {BaseTy(1), BaseTy(0), BaseTy(0)};
+  }
+  axis_v = vnormalize(vcross(axis_w, a));
+  axis_u = vcross(axis_w, axis_v);
+
+  // Project vertices onto the plane of the polygon, instead of picking a
+  // plane aligned with an axis (which can flip polygons).
+  polygon_2d.resize(1);  // Single polygon only(no holes)
+  std::vector<std::array<BaseTy, 2>> &polyline = polygon_2d[0];
+  polyline.resize(npolys);
+
+  BaseTy area = BaseTy(0);  // signed area(x 2) of the projected polygon.
+  for (size_t k = 0; k < npolys; k++) {
+    const T &v = points[faceIndices[k]];
+    polyline[k] = {vdot(v, axis_u), vdot(v, axis_v)};
+  }
+  for (size_t k = 0; k < npolys; k++) {
+    const auto &p0 = polyline[k];
+    const auto &p1 = polyline[(k + 1) % npolys];
+    area += p0[0] * p1[1] - p1[0] * p0[1];
+  }
 
-    faceVertexIndexOffsets.push_back(offset);
-    offset += npolys;
+  std::vector<uint32_t> indices = mapbox::earcut<uint32_t>(polygon_2d);
+
+  if (((indices.size() % 3) != 0) || (indices.size() > 3 * (npolys - 2))) {
+    // This should not be happen, though.
+    err = "Failed to triangulate.\n";
+    return false;
+  }
+
+  (*ntris) = indices.size() / 3;
+
+  // Keep the winding order of the input polygon.
+  BaseTy tri_area = BaseTy(0);
+  for (size_t k = 0; k < (*ntris); k++) {
+    const auto &p0 = polyline[indices[3 * k + 0]];
+    const auto &p1 = polyline[indices[3 * k + 1]];
+    const auto &p2 = polyline[indices[3 * k + 2]];
+    tri_area += (p1[0] - p0[0]) * (p2[1] - p0[1]) -
+                (p2[0] - p0[0]) * (p1[1] - p0[1]);
+  }
+  const bool flip = (tri_area < BaseTy(0)) != (area < BaseTy(0));
+
+  for (size_t k = 0; k < (*ntris); k++) {
+    dst[3 * k + 0] = indices[3 * k + 0];
+    dst[3 * k + 1] = indices[3 * k + (flip ? 2 : 1)];
+    dst[3 * k + 2] = indices[3 * k + (flip ? 1 : 2)];
   }
 
   return true;
@@ -197,6 +354,13 @@ bool BuildFaceVertexIndexOffsets(const std::vector<uint32_t> &faceVertexCounts,
 /// indexMap[i] stores array index in original faceVertexIndices. For remapping
 /// primvar attributes.)
 ///
+/// Quads are split at the shorter diagonal(or at the diagonal through the
+/// reflex vertex for concave quads), and n-gons are triangulated with
+/// earcut. The winding order of the input polygon is preserved.
+///
+/// Output arrays are allocated upfront, and faces are triangulated in
+/// parallel when `num_threads` is not 1 and the mesh has many faces.
+///
 /// Return false when a polygon is degenerated.
 /// No overlap check at the moment
 ///
@@ -209,16 +373,23 @@ bool TriangulatePolygon(const std::vector<T> &points,
                         std::vector<uint32_t> &triangulatedFaceVertexCounts,
                         std::vector<uint32_t> &triangulatedFaceVertexIndices,
                         std::vector<size_t> &faceVertexIndexMap,
-                        std::string &err) {
+                        std::string &err, uint32_t num_threads = 1) {
   triangulatedFaceVertexCounts.clear();
   triangulatedFaceVertexIndices.clear();
 
   faceVertexIndexMap.clear();
 
+  const size_t num_faces = faceVertexCounts.size();
+
+  // faceVertexIndex offset of each face.
+  std::vector<size_t> faceIndexOffsets(num_faces);
+  // Triangle offset of each face. `npolys - 2` triangles at most.
+  std::vector<size_t> triOffsets(num_faces + 1);
+
   size_t faceIndexOffset = 0;
+  triOffsets[0] = 0;
 
-  // For each polygon(face)
-  for (size_t i = 0; i < faceVertexCounts.size(); i++) {
+  for (size_t i = 0; i < num_faces; i++) {
     uint32_t npolys = faceVertexCounts[i];
 
     if (npolys < 3) {
@@ -237,150 +408,107 @@ bool TriangulatePolygon(const std::vector<T> &points,
       return false;
     }
 
-    if (npolys == 3) {
-      // No need for triangulation.
-      triangulatedFaceVertexCounts.push_back(3);
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 0]);
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 1]);
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 2]);
-      faceVertexIndexMap.push_back(i);
-#if 1
-    } else if (npolys == 4) {
-      // Use simple split
-      // TODO: Split at shortest edge?
-      triangulatedFaceVertexCounts.push_back(3);
-      triangulatedFaceVertexCounts.push_back(3);
-
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 0]);
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 1]);
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 2]);
-
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 0]);
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 2]);
-      triangulatedFaceVertexIndices.push_back(
-          faceVertexIndices[faceIndexOffset + 3]);
-
-      faceVertexIndexMap.push_back(i);
-      faceVertexIndexMap.push_back(i);
-#endif
-    } else {
-      // Find the normal axis of the polygon using Newell's method
-      T n = {BaseTy(0), BaseTy(0), BaseTy(0)};
-
-      size_t vi0;
-      size_t vi0_2;
+    faceIndexOffsets[i] = faceIndexOffset;
+    triOffsets[i + 1] = triOffsets[i] + (npolys - 2);
 
-      for (size_t k = 0; k < npolys; ++k) {
-        vi0 = faceVertexIndices[faceIndexOffset + k];
-
-        size_t j = (k + 1) % npolys;
-        vi0_2 = faceVertexIndices[faceIndexOffset + j];
+    faceIndexOffset += npolys;
+  }
 
-        if (vi0 >= points.size()) {
-          err = fmt::format("Invalid vertex index.\n");
-          return false;
-        }
+  const size_t max_tris = triOffsets[num_faces];
 
-        if (vi0_2 >= points.size()) {
-          err = fmt::format("Invalid vertex index.\n");
-          return false;
-        }
+  triangulatedFaceVertexIndices.resize(3 * max_tris);
+  faceVertexIndexMap.resize(3 * max_tris);
 
-        T v0 = points[vi0];
-        T v1 = points[vi0_2];
+  // The number of triangles of each face.
+  std::vector<uint32_t> faceNumTris(num_faces, 0);
 
-        const T point1 = {v0[0], v0[1], v0[2]};
-        const T point2 = {v1[0], v1[1], v1[2]};
+  const auto triangulate_faces = [&](size_t begin, size_t end,
+                                     std::string &task_err) {
+    std::vector<std::vector<std::array<BaseTy, 2>>> polygon_2d;
 
-        T a = {point1[0] - point2[0], point1[1] - point2[1],
-               point1[2] - point2[2]};
-        T b = {point1[0] + point2[0], point1[1] + point2[1],
-               point1[2] + point2[2]};
+    for (size_t i = begin; i < end; i++) {
+      const size_t tri_offset = triOffsets[i];
+      size_t ntris = 0;
+      uint32_t *dst = &triangulatedFaceVertexIndices[3 * tri_offset];
 
-        n[0] += (a[1] * b[2]);
-        n[1] += (a[2] * b[0]);
-        n[2] += (a[0] * b[1]);
-      }
-      BaseTy length_n = vlength(n);
-      // Check if zero length normal
-      if (std::fabs(length_n) < std::numeric_limits<BaseTy>::epsilon()) {
-        err = "Degenerated polygon found.\n";
+      if (!TriangulateFace<T, BaseTy>(
+              points, &faceVertexIndices[faceIndexOffsets[i]],
+              faceVertexCounts[i], dst, &ntris, polygon_2d, task_err)) {
+        task_err = fmt::format("Failed to triangulate face[{}]: {}", i,
+                               task_err);
         return false;
       }
 
-      // Negative is to flip the normal to the correct direction
-      n = vnormalize(n);
-
-      T axis_w, axis_v, axis_u;
-      axis_w = n;
-      T a;
-      if (std::fabs(axis_w[0]) > BaseTy(0.9999999)) {  // TODO: use 1.0 - eps?
-        a = {BaseTy(0), BaseTy(1), BaseTy(0)};
-      } else {
-        a = {BaseTy(1), BaseTy(0), BaseTy(0)};
+      // local corner index -> faceVertexIndex
+      for (size_t k = 0; k < 3 * ntris; k++) {
+        size_t src = faceIndexOffsets[i] + dst[k];
+        dst[k] = faceVertexIndices[src];
+        faceVertexIndexMap[3 * tri_offset + k] = src;
       }
-      axis_v = vnormalize(vcross(axis_w, a));
-      axis_u = vcross(axis_w, axis_v);
-
-      using Point3D = std::array<BaseTy, 3>;
-      using Point2D = std::array<BaseTy, 2>;
-      std::vector<Point2D> polyline;
-
-      // TMW change: Find best normal and project v0x and v0y to those
-      // coordinates, instead of picking a plane aligned with an axis (which
-      // can flip polygons).
 
-      // Fill polygon data.
-      for (size_t k = 0; k < npolys; k++) {
-        size_t vidx = faceVertexIndices[faceIndexOffset + k];
+      faceNumTris[i] = uint32_t(ntris);
+    }
 
-        value::float3 v = points[vidx];
-        // Point3 polypoint = {v0[0],v0[1],v0[2]};
+    return true;
+  };
 
-        // world to local
-        Point3D loc = {vdot(v, axis_u), vdot(v, axis_v), vdot(v, axis_w)};
+  num_threads = ThreadPool::resolve_num_threads(num_threads);
+  const size_t num_tasks =
+      (std::min)(size_t(num_threads) * 4,
+                 (num_faces + kTriangulationFacesPerTask - 1) /
+                     kTriangulationFacesPerTask);
 
-        polyline.push_back({loc[0], loc[1]});
+  if ((num_threads <= 1) || (num_tasks <= 1)) {
+    if (!triangulate_faces(0, num_faces, err)) {
+      return false;
+    }
+  } else {
+    const size_t faces_per_task = (num_faces + num_tasks - 1) / num_tasks;
+
+    std::vector<uint8_t> results(num_tasks, 0);
+    std::vector<std::string> errs(num_tasks);
+
+    {
+      ThreadPool pool(uint32_t((std::min)(size_t(num_threads), num_tasks)));
+      for (size_t t = 0; t < num_tasks; t++) {
+        pool.submit([&, t]() {
+          size_t begin = t * faces_per_task;
+          size_t end = (std::min)(num_faces, begin + faces_per_task);
+          if (triangulate_faces(begin, end, errs[t])) {
+            results[t] = 1;
+          }
+        });
       }
+      pool.wait();
+    }
 
-      std::vector<std::vector<Point2D>> polygon_2d;
-      // Single polygon only(no holes)
-
-      std::vector<uint32_t> indices = mapbox::earcut<uint32_t>(polygon_2d);
-      //  => result = 3 * faces, clockwise
-
-      if ((indices.size() % 3) != 0) {
-        // This should not be happen, though.
-        err = "Failed to triangulate.\n";
+    for (size_t t = 0; t < num_tasks; t++) {
+      if (!results[t]) {
+        err = errs[t];
         return false;
       }
+    }
+  }
 
-      size_t ntris = indices.size() / 3;
-
-      for (size_t k = 0; k < ntris; k++) {
-        triangulatedFaceVertexCounts.push_back(3);
-        triangulatedFaceVertexIndices.push_back(
-            faceVertexIndices[faceIndexOffset + indices[3 * k + 0]]);
-        triangulatedFaceVertexIndices.push_back(
-            faceVertexIndices[faceIndexOffset + indices[3 * k + 1]]);
-        triangulatedFaceVertexIndices.push_back(
-            faceVertexIndices[faceIndexOffset + indices[3 * k + 2]]);
-
-        faceVertexIndexMap.push_back(i);
+  // Remove unused triangle slots(polygon with collinear vertices).
+  size_t num_tris = 0;
+  for (size_t i = 0; i < num_faces; i++) {
+    const size_t src = triOffsets[i];
+    const size_t n = faceNumTris[i];
+    if (src != num_tris) {
+      for (size_t k = 0; k < 3 * n; k++) {
+        triangulatedFaceVertexIndices[3 * num_tris + k] =
+            triangulatedFaceVertexIndices[3 * src + k];
+        faceVertexIndexMap[3 * num_tris + k] = faceVertexIndexMap[3 * src + k];
       }
     }
-
-    faceIndexOffset += npolys;
+    num_tris += n;
   }
 
+  triangulatedFaceVertexIndices.resize(3 * num_tris);
+  faceVertexIndexMap.resize(3 * num_tris);
+  triangulatedFaceVertexCounts.assign(num_tris, 3);
+
   return true;
 }
 
@@ -503,1221 +631,4589 @@ bool ListUVNames(const RenderMaterial &material,
 
 }  // namespace
 
-bool RenderSceneConverter::ConvertMesh(const int64_t rmaterial_id,
-                                       const GeomMesh &mesh,
-                                       RenderMesh *dstMesh) {
-  if (!dstMesh) {
-    PUSH_ERROR_AND_RETURN("`dst` mesh pointer is nullptr");
-  }
+namespace {
 
-  RenderMesh dst;
+// Per face-corner attribute to be compared in vertex welding.
+struct WeldStream {
+  const uint8_t *data{nullptr};
+  size_t elem_size{0};  // in bytes
+};
 
-  bool triangulate = _mesh_config.triangulate;
+inline uint64_t HashBytes(const uint8_t *p, size_t n, uint64_t h) {
+  // FNV-1a
+  for (size_t i = 0; i < n; i++) {
+    h ^= uint64_t(p[i]);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
 
-  // indices
-  // TODO: timeSamples, connections
-  if (const auto pv = mesh.faceVertexIndices.get_value()) {
-    std::vector<int32_t> indices;
-    if (pv.value().get_scalar(&indices)) {
-      // to uint32
-      std::transform(indices.cbegin(), indices.cend(),
-                     std::back_inserter(dst.faceVertexIndices),
-                     [](int32_t v) { return uint32_t(v); });
-    }
+inline uint64_t MixHash(uint64_t h) {
+  // splitmix64 finalizer. FNV-1a alone has weak lower bits.
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+template <typename T, typename IndexTy>
+std::vector<T> GatherElements(const std::vector<T> &src,
+                              const std::vector<IndexTy> &ids) {
+  std::vector<T> dst(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    dst[i] = src[ids[i]];
   }
+  return dst;
+}
 
-  if (const auto pv = mesh.faceVertexCounts.get_value()) {
-    std::vector<int32_t> counts;
-    if (pv.value().get_scalar(&counts)) {
-      // to uint32
-      std::transform(counts.cbegin(), counts.cend(),
-                     std::back_inserter(dst.faceVertexCounts),
-                     [](int32_t v) { return uint32_t(v); });
-    }
+std::vector<uint8_t> GatherBytes(const std::vector<uint8_t> &src,
+                                 size_t elem_size,
+                                 const std::vector<uint32_t> &ids) {
+  std::vector<uint8_t> dst(ids.size() * elem_size);
+  for (size_t i = 0; i < ids.size(); i++) {
+    memcpy(dst.data() + i * elem_size, src.data() + ids[i] * elem_size,
+           elem_size);
   }
+  return dst;
+}
 
-  if (mesh.get_points().size()) {
-    dst.points.resize(mesh.get_points().size());
-    memcpy(dst.points.data(), mesh.get_points().data(),
-           sizeof(value::float3) * mesh.get_points().size());
+void PackVertexIndices(const std::vector<uint32_t> &indices,
+                       size_t num_vertices, BufferData *dst) {
+  dst->count = 1;
+  if (num_vertices <= 65536) {
+    dst->componentType = ComponentType::UInt16;
+    dst->data.resize(indices.size() * sizeof(uint16_t));
+    uint16_t *p = reinterpret_cast<uint16_t *>(dst->data.data());
+    for (size_t i = 0; i < indices.size(); i++) {
+      p[i] = uint16_t(indices[i]);
+    }
+  } else {
+    dst->componentType = ComponentType::UInt32;
+    dst->data.resize(indices.size() * sizeof(uint32_t));
+    memcpy(dst->data.data(), indices.data(),
+           indices.size() * sizeof(uint32_t));
   }
+}
 
-  // normals
-  {
-    std::vector<value::normal3f> normals = mesh.get_normals();
-    Interpolation interp = mesh.get_normalsInterpolation();
+}  // namespace
 
-    if (normals.size()) {
-      if (interp == Interpolation::Uniform) {
-        auto result = UniformToFaceVarying(normals, dst.faceVertexCounts, dst.faceVertexIndices);
-        if (!result) {
-          PUSH_ERROR_AND_RETURN(
-              fmt::format("Convert uniform `normals` attribute to failed: {}", result.error()));
-        }
+bool WeldFaceVertices(RenderMesh &mesh, std::string *err) {
+  // Used in PUSH_ERROR_AND_RETURN
+  const auto PushError = [err](const std::string &msg) {
+    if (err) {
+      (*err) += msg;
+    }
+  };
 
-        dst.facevaryingNormals.resize(result.value().size());
-        memcpy(dst.facevaryingNormals.data(), result.value().data(),
-               sizeof(value::normal3f) * result.value().size());
+  if (mesh.is_indexed) {
+    PUSH_ERROR_AND_RETURN("RenderMesh is already indexed.");
+  }
 
-      } else if ((interp == Interpolation::Vertex) || (interp == Interpolation::Varying)) {
-        auto result = VertexToFaceVarying(normals, dst.faceVertexCounts, dst.faceVertexIndices);
-        if (!result) {
-          PUSH_ERROR_AND_RETURN(
-              fmt::format("Convert vertex/varying `normals` attribute to failed: {}", result.error()));
-        }
+  const std::vector<uint32_t> &fvIndices = mesh.faceVertexIndices;
+  const size_t num_fvs = fvIndices.size();
 
-        dst.facevaryingNormals.resize(result.value().size());
-        memcpy(dst.facevaryingNormals.data(), result.value().data(),
-               sizeof(value::normal3f) * result.value().size());
+  if (num_fvs >= size_t((std::numeric_limits<uint32_t>::max)())) {
+    PUSH_ERROR_AND_RETURN("Too many faceVertexIndices.");
+  }
 
-      } else if (interp == Interpolation::FaceVarying) {
-        dst.facevaryingNormals.resize(normals.size());
-        memcpy(dst.facevaryingNormals.data(), normals.data(),
-               sizeof(value::normal3f) * normals.size());
-      } else {
-        PUSH_ERROR_AND_RETURN(
-            "Unsupported/unimplemented interpolation for `normals` attribute: " +
-            to_string(interp) + ".\n");
-      }
-    } else {
-      dst.facevaryingNormals.clear();
-      dst.normalsInterpolation = interp;
+  for (size_t i = 0; i < num_fvs; i++) {
+    if (fvIndices[i] >= mesh.points.size()) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "faceVertexIndices[{}] {} exceeds the number of points {}.", i,
+          fvIndices[i], mesh.points.size()));
     }
   }
 
-  // Compute total faceVarying elements;
-  size_t num_fvs = 0;
-  for (size_t i = 0; i < dst.faceVertexCounts.size(); i++) {
-    num_fvs += dst.faceVertexCounts[i];
+  std::vector<WeldStream> streams;
+
+  if (mesh.facevaryingNormals.size()) {
+    if (mesh.facevaryingNormals.size() != num_fvs) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("The number of facevaryingNormals {} does not match to "
+                      "the number of faceVertexIndices {}.",
+                      mesh.facevaryingNormals.size(), num_fvs));
+    }
+    WeldStream stream;
+    stream.data =
+        reinterpret_cast<const uint8_t *>(mesh.facevaryingNormals.data());
+    stream.elem_size = sizeof(vec3);
+    streams.push_back(stream);
   }
 
-  DCOUT("num_fvs = " << num_fvs);
+  for (const auto &it : mesh.facevaryingTexcoords) {
+    if (it.second.size() != num_fvs) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("The number of texcoords(slot {}) {} does not match to "
+                      "the number of faceVertexIndices {}.",
+                      it.first, it.second.size(), num_fvs));
+    }
+    WeldStream stream;
+    stream.data = reinterpret_cast<const uint8_t *>(it.second.data());
+    stream.elem_size = sizeof(vec2);
+    streams.push_back(stream);
+  }
 
-  // uvs from primvars.
-  // uvname(varname) is grabbed from RenderMaterial.
-  //
-  // TODO: list-up varname from PreviewSurfaceShader members.
-  //
-  // Procedure:
-  // - Find Shader
-  // - Lookup PrimvarReader
-  //
+  for (const auto &it : mesh.primvars) {
+    const VertexAttribute &vattr = it.second;
+    if ((vattr.variability == VertexVariability::Indexed) ||
+        vattr.indices.size()) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "Welding a mesh with indexed primvar(slot {}) is not supported.",
+          it.first));
+    }
 
-  if ((rmaterial_id > -1) && (size_t(rmaterial_id) < materials.size())) {
-    const RenderMaterial &material = materials[size_t(rmaterial_id)];
+    if (vattr.variability == VertexVariability::FaceVarying) {
+      if (vattr.counts() != num_fvs) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("The number of faceVarying primvar(slot {}) elements "
+                        "{} does not match to the number of "
+                        "faceVertexIndices {}.",
+                        it.first, vattr.counts(), num_fvs));
+      }
+      if (num_fvs) {
+        WeldStream stream;
+        stream.data = vattr.data.data();
+        stream.elem_size = vattr.data.size() / num_fvs;
+        streams.push_back(stream);
+      }
+    } else if ((vattr.variability == VertexVariability::Vertex) ||
+               (vattr.variability == VertexVariability::Varying)) {
+      if (vattr.counts() != mesh.points.size()) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("The number of vertex primvar(slot {}) elements {} "
+                        "does not match to the number of points {}.",
+                        it.first, vattr.counts(), mesh.points.size()));
+      }
+    }
+  }
 
-    StringAndIdMap uvname_map;
-    if (!ListUVNames(material, textures, uvname_map)) {
+  const auto corner_equal = [&](size_t a, size_t b) {
+    if (fvIndices[a] != fvIndices[b]) {
       return false;
     }
+    for (const auto &stream : streams) {
+      if (memcmp(stream.data + a * stream.elem_size,
+                 stream.data + b * stream.elem_size, stream.elem_size) != 0) {
+        return false;
+      }
+    }
+    return true;
+  };
 
-    for (auto it = uvname_map.i_begin(); it != uvname_map.i_end(); it++) {
-      uint64_t slotId = it->first;
-      std::string uvname = it->second;
+  // Open addressing hash table of vertex ids.
+  constexpr uint32_t kInvalidId = (std::numeric_limits<uint32_t>::max)();
+  size_t table_size = 16;
+  while (table_size < num_fvs * 2) {
+    table_size <<= 1;
+  }
+  std::vector<uint32_t> table(table_size, kInvalidId);
 
-      auto ret = GetTextureCoordinate(*_stage, mesh, uvname);
-      if (ret) {
-        const VertexAttribute vattr = ret.value();
+  std::vector<uint32_t> vertex_corners;  // vertex id -> first face-corner
+  std::vector<uint32_t> indices(num_fvs);
 
-        if (vattr.format != VertexAttributeFormat::Vec2) {
-          PUSH_ERROR_AND_RETURN(
-              fmt::format("Texcoord VertexAttribute must be Vec2 type.\n"));
-        }
+  for (size_t c = 0; c < num_fvs; c++) {
+    uint64_t h = HashBytes(reinterpret_cast<const uint8_t *>(&fvIndices[c]),
+                           sizeof(uint32_t), 14695981039346656037ull);
+    for (const auto &stream : streams) {
+      h = HashBytes(stream.data + c * stream.elem_size, stream.elem_size, h);
+    }
 
-        if (vattr.variability != VertexVariability::FaceVarying) {
-          PUSH_ERROR_AND_RETURN(
-              fmt::format("TODO: non-facevarying UV texcoord attribute is not "
-                          "support yet: {}.\n",
-                          uvname));
-        }
+    size_t slot = size_t(MixHash(h)) & (table_size - 1);
+    for (;;) {
+      uint32_t vid = table[slot];
+      if (vid == kInvalidId) {
+        vid = uint32_t(vertex_corners.size());
+        vertex_corners.push_back(uint32_t(c));
+        table[slot] = vid;
+        indices[c] = vid;
+        break;
+      }
 
-        if (vattr.counts() != num_fvs) {
-          PUSH_ERROR_AND_RETURN(
-              fmt::format("The number of UV texcoord attributes {} does not "
-                          "match to the number of facevarying elements {}\n",
-                          vattr.counts(), num_fvs));
-        }
+      if (corner_equal(vertex_corners[vid], c)) {
+        indices[c] = vid;
+        break;
+      }
 
-        DCOUT("Add texcoord attr `" << uvname << "` to slot Id " << slotId);
-        std::vector<vec2> uvs(vattr.counts());
-        memcpy(uvs.data(), vattr.data.data(), vattr.data.size());
+      slot = (slot + 1) & (table_size - 1);
+    }
+  }
 
-        dst.facevaryingTexcoords.emplace(slotId, uvs);
+  std::vector<uint32_t> point_ids(vertex_corners.size());
+  for (size_t v = 0; v < vertex_corners.size(); v++) {
+    point_ids[v] = fvIndices[vertex_corners[v]];
+  }
 
-      } else {
-        PUSH_ERROR_AND_RETURN(ret.error());
+  for (auto &it : mesh.primvars) {
+    VertexAttribute &vattr = it.second;
+    if (vattr.variability == VertexVariability::FaceVarying) {
+      if (num_fvs) {
+        vattr.data = GatherBytes(vattr.data, vattr.data.size() / num_fvs,
+                                 vertex_corners);
+      }
+      vattr.variability = VertexVariability::Vertex;
+    } else if ((vattr.variability == VertexVariability::Vertex) ||
+               (vattr.variability == VertexVariability::Varying)) {
+      if (mesh.points.size()) {
+        vattr.data = GatherBytes(vattr.data,
+                                 vattr.data.size() / mesh.points.size(),
+                                 point_ids);
       }
     }
   }
 
-  if (triangulate) {
-    std::string err;
+  mesh.points = GatherElements(mesh.points, point_ids);
 
-    std::vector<uint32_t> triangulatedFaceVertexCounts;  // should be all 3's
-    std::vector<uint32_t> triangulatedFaceVertexIndices;
-    std::vector<size_t> faceVertexIndexMap;
-    if (!TriangulatePolygon<value::float3, float>(
-            dst.points, dst.faceVertexCounts, dst.faceVertexIndices,
-            triangulatedFaceVertexCounts, triangulatedFaceVertexIndices,
-            faceVertexIndexMap, err)) {
-      PUSH_ERROR_AND_RETURN("Triangulation failed: " + err);
-    }
+  mesh.vertexNormals.clear();
+  if (mesh.facevaryingNormals.size()) {
+    mesh.vertexNormals = GatherElements(mesh.facevaryingNormals, vertex_corners);
+  }
+  mesh.facevaryingNormals.clear();
 
-    // TODO: Triangulate primvars with faceVertexIndexMap
+  mesh.vertexTexcoords.clear();
+  for (const auto &it : mesh.facevaryingTexcoords) {
+    mesh.vertexTexcoords.emplace(it.first,
+                                 GatherElements(it.second, vertex_corners));
+  }
+  mesh.facevaryingTexcoords.clear();
 
-    dst.faceVertexCounts = std::move(triangulatedFaceVertexCounts);
-    dst.faceVertexIndices = std::move(triangulatedFaceVertexIndices);
+  mesh.faceVertexIndices = std::move(indices);
+  PackVertexIndices(mesh.faceVertexIndices, mesh.points.size(), &mesh.indices);
 
-  }  // triangulate
+  mesh.is_indexed = true;
+
+  return true;
+}
+
+namespace {
 
-  // for GeomSubsets
-  if (mesh.geom_subset_children.size()) {
-    std::vector<size_t> faceVertexIndexOffsets;
+// Source of a vertex element.
+struct VertexElementSource {
+  const float *data{nullptr};  // nullptr = fill zeros.
+  uint32_t num_components{0};
+  bool per_point{false};  // Indexed by point index for non-indexed mesh.
+};
 
-    if (!BuildFaceVertexIndexOffsets(dst.faceVertexCounts,
-                                     faceVertexIndexOffsets)) {
-      PUSH_ERROR_AND_RETURN("Build faceVertexIndexOffsets failed.");
+inline void WriteVertexElement(const float *src, uint32_t num_components,
+                               VertexElementFormat format, uint8_t *dst) {
+  for (uint32_t k = 0; k < num_components; k++) {
+    const float v = src ? src[k] : 0.0f;
+    switch (format) {
+      case VertexElementFormat::Float: {
+        memcpy(dst + k * sizeof(float), &v, sizeof(float));
+        break;
+      }
+      case VertexElementFormat::Half: {
+        const value::half h = value::float_to_half_full(v);
+        memcpy(dst + k * sizeof(uint16_t), &h.value, sizeof(uint16_t));
+        break;
+      }
+      case VertexElementFormat::SNorm16: {
+        const float c = (std::max)(-1.0f, (std::min)(1.0f, v));
+        const int16_t i = int16_t(std::lround(c * 32767.0f));
+        memcpy(dst + k * sizeof(int16_t), &i, sizeof(int16_t));
+        break;
+      }
+      case VertexElementFormat::UNorm16: {
+        const float c = (std::max)(0.0f, (std::min)(1.0f, v));
+        const uint16_t u = uint16_t(std::lround(c * 65535.0f));
+        memcpy(dst + k * sizeof(uint16_t), &u, sizeof(uint16_t));
+        break;
+      }
     }
   }
+}
 
-  (*dstMesh) = std::move(dst);
-  return true;
+std::vector<VertexElement> DefaultVertexLayout() {
+  std::vector<VertexElement> elements(3);
+  elements[0].semantic = VertexElementSemantic::Position;
+  elements[1].semantic = VertexElementSemantic::Normal;
+  elements[2].semantic = VertexElementSemantic::Texcoord;
+  return elements;
 }
 
-namespace {
+}  // namespace
 
-#if 1
-// Convert UsdTranform2d -> PrimvarReader_float2 shader network.
-nonstd::expected<bool, std::string> ConvertTexTransform2d(
-    const Stage &stage, const Path &tx_abs_path, const UsdTransform2d &tx,
-    UVTexture *tex_out) {
-  float rotation;  // in angles
-  if (!tx.rotation.get_value().get_scalar(&rotation)) {
-    return nonstd::make_unexpected(
-        fmt::format("Failed to retrieve rotation attribute from {}\n",
-                    tx_abs_path.full_path_name()));
-  }
+bool BuildInterleavedVertexBuffer(const RenderMesh &mesh,
+                                  const std::vector<VertexElement> &elements,
+                                  VertexBufferLayout *layout, BufferData *dst,
+                                  std::string *err) {
+  // Used in PUSH_ERROR_AND_RETURN
+  const auto PushError = [err](const std::string &msg) {
+    if (err) {
+      (*err) += msg;
+    }
+  };
 
-  value::float2 scale;
-  if (!tx.scale.get_value().get_scalar(&scale)) {
-    return nonstd::make_unexpected(
-        fmt::format("Failed to retrieve scale attribute from {}\n",
-                    tx_abs_path.full_path_name()));
+  if (!layout || !dst) {
+    PUSH_ERROR_AND_RETURN("`layout` or `dst` is nullptr.");
   }
 
-  value::float2 translation;
-  if (!tx.translation.get_value().get_scalar(&translation)) {
-    return nonstd::make_unexpected(
-        fmt::format("Failed to retrieve translation attribute from {}\n",
-                    tx_abs_path.full_path_name()));
-  }
+  const size_t num_vertices =
+      mesh.is_indexed ? mesh.points.size() : mesh.faceVertexIndices.size();
 
-  // must be authored and connected to PrimvarReader.
-  if (!tx.in.authored()) {
-    return nonstd::make_unexpected("`inputs:in` must be authored.\n");
+  if (!mesh.is_indexed) {
+    for (size_t i = 0; i < mesh.faceVertexIndices.size(); i++) {
+      if (mesh.faceVertexIndices[i] >= mesh.points.size()) {
+        PUSH_ERROR_AND_RETURN(fmt::format(
+            "faceVertexIndices[{}] {} exceeds the number of points {}.", i,
+            mesh.faceVertexIndices[i], mesh.points.size()));
+      }
+    }
   }
 
-  if (!tx.in.is_connection()) {
-    return nonstd::make_unexpected("`inputs:in` must be a connection.\n");
+  VertexBufferLayout dst_layout;
+  std::vector<VertexElementSource> sources;
+
+  uint32_t offset = 0;
+  for (const auto &element : elements) {
+    VertexElementSource source;
+
+    switch (element.semantic) {
+      case VertexElementSemantic::Position: {
+        source.data = reinterpret_cast<const float *>(mesh.points.data());
+        source.num_components = 3;
+        source.per_point = true;
+        break;
+      }
+      case VertexElementSemantic::Normal: {
+        const std::vector<vec3> &normals =
+            mesh.is_indexed ? mesh.vertexNormals : mesh.facevaryingNormals;
+        source.num_components = 3;
+        if (normals.size()) {
+          if (normals.size() != num_vertices) {
+            PUSH_ERROR_AND_RETURN(
+                fmt::format("The number of normals {} does not match to the "
+                            "number of vertices {}.",
+                            normals.size(), num_vertices));
+          }
+          source.data = reinterpret_cast<const float *>(normals.data());
+        }
+        break;
+      }
+      case VertexElementSemantic::Texcoord: {
+        const auto &texcoords = mesh.is_indexed ? mesh.vertexTexcoords
+                                                : mesh.facevaryingTexcoords;
+        source.num_components = 2;
+        const auto it = texcoords.find(element.slot);
+        if (it != texcoords.end()) {
+          if (it->second.size() != num_vertices) {
+            PUSH_ERROR_AND_RETURN(
+                fmt::format("The number of texcoords(slot {}) {} does not "
+                            "match to the number of vertices {}.",
+                            element.slot, it->second.size(), num_vertices));
+          }
+          source.data = reinterpret_cast<const float *>(it->second.data());
+        }
+        break;
+      }
+      case VertexElementSemantic::Primvar: {
+        const auto it = mesh.primvars.find(element.slot);
+        if (it == mesh.primvars.end()) {
+          PUSH_ERROR_AND_RETURN(
+              fmt::format("Primvar slot {} not found.", element.slot));
+        }
+        const VertexAttribute &vattr = it->second;
+
+        switch (vattr.format) {
+          case VertexAttributeFormat::Float: {
+            source.num_components = 1;
+            break;
+          }
+          case VertexAttributeFormat::Vec2: {
+            source.num_components = 2;
+            break;
+          }
+          case VertexAttributeFormat::Vec3: {
+            source.num_components = 3;
+            break;
+          }
+          case VertexAttributeFormat::Vec4: {
+            source.num_components = 4;
+            break;
+          }
+          default: {
+            PUSH_ERROR_AND_RETURN(fmt::format(
+                "Unsupported primvar format for vertex buffer: {}(slot {}).",
+                to_string(vattr.format), element.slot));
+          }
+        }
+
+        if ((vattr.stride != 0) &&
+            (vattr.stride != source.num_components * sizeof(float))) {
+          PUSH_ERROR_AND_RETURN(fmt::format(
+              "Primvar slot {} must be tightly packed.", element.slot));
+        }
+
+        if ((vattr.variability == VertexVariability::Vertex) ||
+            (vattr.variability == VertexVariability::Varying)) {
+          source.per_point = true;
+          if (vattr.counts() != mesh.points.size()) {
+            PUSH_ERROR_AND_RETURN(
+                fmt::format("The number of primvar(slot {}) elements {} does "
+                            "not match to the number of points {}.",
+                            element.slot, vattr.counts(),
+                            mesh.points.size()));
+          }
+        } else if ((vattr.variability == VertexVariability::FaceVarying) &&
+                   !mesh.is_indexed && vattr.indices.empty()) {
+          if (vattr.counts() != num_vertices) {
+            PUSH_ERROR_AND_RETURN(
+                fmt::format("The number of primvar(slot {}) elements {} does "
+                            "not match to the number of vertices {}.",
+                            element.slot, vattr.counts(), num_vertices));
+          }
+        } else {
+          PUSH_ERROR_AND_RETURN(fmt::format(
+              "Unsupported primvar variability for vertex buffer: {}(slot "
+              "{}).",
+              to_string(vattr.variability), element.slot));
+        }
+
+        source.data = reinterpret_cast<const float *>(vattr.data.data());
+        break;
+      }
+    }
+
+    VertexElement dst_element = element;
+    dst_element.num_components = source.num_components;
+    dst_element.offset = offset;
+
+    const uint32_t component_size =
+        (element.format == VertexElementFormat::Float) ? 4 : 2;
+    offset += source.num_components * component_size;
+    offset = (offset + 3u) & ~3u;  // 4 bytes align
+
+    dst_layout.elements.push_back(dst_element);
+    sources.push_back(source);
   }
 
-  const auto &paths = tx.in.get_connections();
-  if (paths.size() != 1) {
-    return nonstd::make_unexpected(
-        "`inputs:in` must be a single connection Path.\n");
+  dst_layout.stride = offset;
+
+  dst->componentType = ComponentType::UInt8;
+  dst->count = 1;
+  dst->data.assign(num_vertices * size_t(dst_layout.stride), 0);
+
+  for (size_t v = 0; v < num_vertices; v++) {
+    uint8_t *vertex = dst->data.data() + v * dst_layout.stride;
+    const size_t point_idx = mesh.is_indexed ? v : mesh.faceVertexIndices[v];
+
+    for (size_t e = 0; e < sources.size(); e++) {
+      const VertexElementSource &source = sources[e];
+      const VertexElement &element = dst_layout.elements[e];
+
+      const float *src = nullptr;
+      if (source.data) {
+        const size_t idx = source.per_point ? point_idx : v;
+        src = source.data + idx * source.num_components;
+      }
+
+      WriteVertexElement(src, source.num_components, element.format,
+                         vertex + element.offset);
+    }
   }
 
-  std::string prim_part = paths[0].prim_part();
-  std::string prop_part = paths[0].prop_part();
+  (*layout) = std::move(dst_layout);
 
-  if (prop_part != "outputs:result") {
-    return nonstd::make_unexpected(
-        "`inputs:in` connection Path's property part must be "
-        "`outputs:result`\n");
+  return true;
+}
+
+namespace {
+
+///
+/// Reorder faces. `face_order[i]` is the source face index of the i-th face.
+/// Per-face(`materialIds`, uniform primvars) and per face-corner(faceVarying
+/// normals, texcoords and primvars) attributes follow the face order.
+///
+bool PermuteFaces(RenderMesh &mesh, const std::vector<uint32_t> &face_order,
+                  std::string *err) {
+  // Used in PUSH_ERROR_AND_RETURN
+  const auto PushError = [err](const std::string &msg) {
+    if (err) {
+      (*err) += msg;
+    }
+  };
+
+  const size_t num_faces = mesh.faceVertexCounts.size();
+  if (face_order.size() != num_faces) {
+    PUSH_ERROR_AND_RETURN("Invalid face order.");
   }
 
-  std::string err;
+  std::vector<size_t> face_offsets(num_faces + 1, 0);
+  for (size_t f = 0; f < num_faces; f++) {
+    face_offsets[f + 1] = face_offsets[f] + mesh.faceVertexCounts[f];
+  }
+  const size_t num_corners = face_offsets[num_faces];
+  if (num_corners != mesh.faceVertexIndices.size()) {
+    PUSH_ERROR_AND_RETURN(
+        "Invalid faceVertexIndices or faceVertexCounts. The sum of "
+        "faceVertexCounts must be equal to the size of faceVertexIndices.");
+  }
 
-  const Prim *pprim{nullptr};
-  if (!stage.find_prim_at_path(Path(prim_part, ""), pprim, &err)) {
-    return nonstd::make_unexpected(fmt::format(
-        "`inputs:in` connection Path not found in the Stage. {}\n", prim_part));
+  std::vector<uint32_t> counts(num_faces);
+  std::vector<uint32_t> corner_order;
+  corner_order.reserve(num_corners);
+  for (size_t i = 0; i < num_faces; i++) {
+    const uint32_t f = face_order[i];
+    if (f >= num_faces) {
+      PUSH_ERROR_AND_RETURN("Invalid face order.");
+    }
+    counts[i] = mesh.faceVertexCounts[f];
+    for (size_t c = face_offsets[f]; c < face_offsets[f + 1]; c++) {
+      corner_order.push_back(uint32_t(c));
+    }
   }
 
-  if (!pprim) {
-    return nonstd::make_unexpected(
-        fmt::format("[InternalError] Prim is nullptr: {}\n", prim_part));
+  mesh.faceVertexCounts = std::move(counts);
+  mesh.faceVertexIndices =
+      GatherElements(mesh.faceVertexIndices, corner_order);
+
+  if (mesh.materialIds.size() == num_faces) {
+    mesh.materialIds = GatherElements(mesh.materialIds, face_order);
   }
 
-  const Shader *pshader = pprim->as<Shader>();
-  if (!pshader) {
-    return nonstd::make_unexpected(
-        fmt::format("{} must be Shader Prim, but got {}\n", prim_part,
-                    pprim->prim_type_name()));
+  if (mesh.facevaryingNormals.size() == num_corners) {
+    mesh.facevaryingNormals =
+        GatherElements(mesh.facevaryingNormals, corner_order);
   }
 
-  const UsdPrimvarReader_float2 *preader =
-      pshader->value.as<UsdPrimvarReader_float2>();
-  if (preader) {
-    return nonstd::make_unexpected(fmt::format(
-        "Shader {} must be UsdPrimvarReader_float2 type, but got {}\n",
-        prim_part, pshader->info_id));
+  for (auto &it : mesh.facevaryingTexcoords) {
+    if (it.second.size() == num_corners) {
+      it.second = GatherElements(it.second, corner_order);
+    }
   }
 
-  // Get value producing attribute(i.e, follow .connection and return
-  // terminal Attribute value)
-  value::token varname;
-#if 0
-  if (!tydra::EvaluateShaderAttribute(stage, *pshader, "inputs:varname",
-                                      &varname, &err)) {
-    return nonstd::make_unexpected(
-        fmt::format("Failed to evaluate UsdPrimvarReader_float2's "
-                    "inputs:varname: {}\n",
-                    err));
+  for (auto &it : mesh.primvars) {
+    VertexAttribute &vattr = it.second;
+
+    // Indexed primvar: reorder indices. `data` is a table of values.
+    if (vattr.indices.size()) {
+      if (((vattr.variability == VertexVariability::FaceVarying) ||
+           (vattr.variability == VertexVariability::Indexed)) &&
+          (vattr.indices.size() == num_corners)) {
+        vattr.indices = GatherElements(vattr.indices, corner_order);
+      } else if ((vattr.variability == VertexVariability::Uniform) &&
+                 (vattr.indices.size() == num_faces)) {
+        vattr.indices = GatherElements(vattr.indices, face_order);
+      }
+      continue;
+    }
+
+    const size_t count = vattr.counts();
+    if (count == 0) {
+      continue;
+    }
+
+    if ((vattr.variability == VertexVariability::FaceVarying) &&
+        (count == num_corners)) {
+      vattr.data =
+          GatherBytes(vattr.data, vattr.data.size() / count, corner_order);
+    } else if ((vattr.variability == VertexVariability::Uniform) &&
+               (count == num_faces)) {
+      vattr.data =
+          GatherBytes(vattr.data, vattr.data.size() / count, face_order);
+    }
   }
-#else
-  TerminalAttributeValue attr;
-  if (!tydra::EvaluateAttribute(stage, *pprim, "inputs:varname", &attr, &err)) {
-    return nonstd::make_unexpected(
-        "`inputs:varname` evaluation failed: " + err + "\n");
+
+  if (mesh.is_indexed) {
+    PackVertexIndices(mesh.faceVertexIndices, mesh.points.size(),
+                      &mesh.indices);
   }
-  if (auto pv = attr.as<value::token>()) {
-    varname = *pv;
-  } else {
-    return nonstd::make_unexpected(
-        "`inputs:varname` must be `token` type, but got " + attr.type_name() +
-        "\n");
+
+  return true;
+}
+
+///
+/// Reverse the winding order of each face(the first corner is kept).
+/// Per face-corner attributes and meshlet triangles follow the new order.
+///
+bool FlipFaceWinding(RenderMesh &mesh, std::string *err) {
+  // Used in PUSH_ERROR_AND_RETURN
+  const auto PushError = [err](const std::string &msg) {
+    if (err) {
+      (*err) += msg;
+    }
+  };
+
+  std::vector<uint32_t> corner_order;
+  corner_order.reserve(mesh.faceVertexIndices.size());
+  size_t offset = 0;
+  for (const uint32_t count : mesh.faceVertexCounts) {
+    if (count == 0) {
+      continue;
+    }
+    corner_order.push_back(uint32_t(offset));
+    for (size_t c = count - 1; c > 0; c--) {
+      corner_order.push_back(uint32_t(offset + c));
+    }
+    offset += count;
   }
-  if (varname.str().empty()) {
-    return nonstd::make_unexpected("`inputs:varname` is empty token\n");
+
+  const size_t num_corners = corner_order.size();
+  if (num_corners != mesh.faceVertexIndices.size()) {
+    PUSH_ERROR_AND_RETURN(
+        "Invalid faceVertexIndices or faceVertexCounts. The sum of "
+        "faceVertexCounts must be equal to the size of faceVertexIndices.");
   }
-  DCOUT("inputs:varname = " << varname);
-#endif
 
-  // Build transform matrix.
-  // https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Khronos/KHR_texture_transform
-  // Since USD uses post-multiply,
-  //
-  // matrix = scale * rotate * translate
-  //
-  {
-    mat3 s;
-    s.set_scale(scale[0], scale[1], 1.0f);
+  mesh.faceVertexIndices =
+      GatherElements(mesh.faceVertexIndices, corner_order);
 
-    mat3 r = mat3::identity();
+  if (mesh.facevaryingNormals.size() == num_corners) {
+    mesh.facevaryingNormals =
+        GatherElements(mesh.facevaryingNormals, corner_order);
+  }
 
-    r.m[0][0] = std::cos(math::radian(rotation));
-    r.m[0][1] = std::sin(math::radian(rotation));
+  for (auto &it : mesh.facevaryingTexcoords) {
+    if (it.second.size() == num_corners) {
+      it.second = GatherElements(it.second, corner_order);
+    }
+  }
 
-    r.m[1][0] = -std::sin(math::radian(rotation));
-    r.m[1][1] = std::cos(math::radian(rotation));
+  for (auto &it : mesh.primvars) {
+    VertexAttribute &vattr = it.second;
+    // Indexed primvar: reorder indices. `data` is a table of values.
+    if (vattr.indices.size()) {
+      if (((vattr.variability == VertexVariability::FaceVarying) ||
+           (vattr.variability == VertexVariability::Indexed)) &&
+          (vattr.indices.size() == num_corners)) {
+        vattr.indices = GatherElements(vattr.indices, corner_order);
+      }
+      continue;
+    }
 
-    mat3 t = mat3::identity();
-    t.set_translation(translation[0], translation[1], 1.0f);
+    const size_t count = vattr.counts();
+    if (count == 0) {
+      continue;
+    }
 
-    tex_out->transform = s * r * t;
+    if ((vattr.variability == VertexVariability::FaceVarying) &&
+        (count == num_corners)) {
+      vattr.data =
+          GatherBytes(vattr.data, vattr.data.size() / count, corner_order);
+    }
   }
 
-  tex_out->tx_rotation = rotation;
-  tex_out->tx_translation = translation;
-  tex_out->tx_scale = scale;
-  tex_out->has_transform2d = true;
+  if (mesh.is_indexed) {
+    PackVertexIndices(mesh.faceVertexIndices, mesh.points.size(),
+                      &mesh.indices);
+  }
 
-  tex_out->varname_uv = varname.str();
+  // (a, b, c) -> (a, c, b)
+  for (size_t t = 0; (t + 2) < mesh.meshletTriangles.size(); t += 3) {
+    std::swap(mesh.meshletTriangles[t + 1], mesh.meshletTriangles[t + 2]);
+  }
 
   return true;
 }
-#endif
 
-template <typename T>
-nonstd::expected<bool, std::string> GetConnectedUVTexture(
-    const Stage &stage, const TypedAnimatableAttributeWithFallback<T> &src,
-    Path *tex_abs_path, const UsdUVTexture **dst, const Shader **shader_out) {
-  if (!dst) {
-    return nonstd::make_unexpected("[InternalError] dst is nullptr.\n");
+// Forsyth's vertex cache optimization parameters.
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+constexpr uint32_t kVertexCacheSize = 32;
+constexpr uint32_t kMaxValence = 64;  // valence boost is clamped.
+
+struct ForsythScoreTable {
+  float cache[kVertexCacheSize];
+  float valence[kMaxValence];
+
+  ForsythScoreTable() {
+    const float kCacheDecayPower = 1.5f;
+    const float kLastTriScore = 0.75f;
+    const float kValenceBoostScale = 2.0f;
+    const float kValenceBoostPower = 0.5f;
+
+    for (uint32_t i = 0; i < kVertexCacheSize; i++) {
+      if (i < 3) {
+        // Vertices used by the last triangle.
+        cache[i] = kLastTriScore;
+      } else {
+        const float s = 1.0f - float(i - 3) / float(kVertexCacheSize - 3);
+        cache[i] = std::pow(s, kCacheDecayPower);
+      }
+    }
+
+    valence[0] = 0.0f;
+    for (uint32_t i = 1; i < kMaxValence; i++) {
+      valence[i] = kValenceBoostScale * std::pow(float(i), -kValenceBoostPower);
+    }
   }
 
-  if (!src.is_connection()) {
-    return nonstd::make_unexpected("Attribute must be connection.\n");
+  float score(int32_t cache_pos, uint32_t live_tris) const {
+    if (live_tris == 0) {
+      // No triangle left which uses the vertex.
+      return -1.0f;
+    }
+
+    float s = (cache_pos >= 0) ? cache[cache_pos] : 0.0f;
+    s += valence[(std::min)(live_tris, kMaxValence - 1)];
+    return s;
   }
+};
 
-  if (src.get_connections().size() != 1) {
-    return nonstd::make_unexpected(
-        "Attribute connections must be single connection Path.\n");
+}  // namespace
+
+bool OptimizeVertexCache(RenderMesh &mesh, std::string *err) {
+  // Used in PUSH_ERROR_AND_RETURN
+  const auto PushError = [err](const std::string &msg) {
+    if (err) {
+      (*err) += msg;
+    }
+  };
+
+  for (size_t i = 0; i < mesh.faceVertexCounts.size(); i++) {
+    if (mesh.faceVertexCounts[i] != 3) {
+      PUSH_ERROR_AND_RETURN("Mesh must be triangulated.");
+    }
   }
 
-  const Path &path = src.get_connections()[0];
+  const size_t num_tris = mesh.faceVertexCounts.size();
+  const std::vector<uint32_t> &indices = mesh.faceVertexIndices;
+  if (indices.size() != 3 * num_tris) {
+    PUSH_ERROR_AND_RETURN(
+        "Invalid faceVertexIndices or faceVertexCounts for triangle mesh.");
+  }
 
-  const std::string prim_part = path.prim_part();
-  const std::string prop_part = path.prop_part();
+  const size_t num_vertices = mesh.points.size();
+  if (num_vertices >= size_t((std::numeric_limits<uint32_t>::max)())) {
+    PUSH_ERROR_AND_RETURN("Too many points.");
+  }
 
-  if (prop_part != "outputs:rgb") {
-    return nonstd::make_unexpected(
-        "connection Path's property part must be `outputs:rgb` at the moment "
-        "for "
-        "UsdUVTexture, but got " +
-        prop_part + " \n");
+  for (size_t i = 0; i < indices.size(); i++) {
+    if (indices[i] >= num_vertices) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "faceVertexIndices[{}] {} exceeds the number of points {}.", i,
+          indices[i], num_vertices));
+    }
+  }
+
+  //
+  // 1. Triangle order
+  //
+
+  // vertex -> triangles adjacency(CSR). The first `live[v]` triangles of the
+  // range are not emitted yet.
+  std::vector<uint32_t> adj_offsets(num_vertices + 1, 0);
+  for (size_t i = 0; i < indices.size(); i++) {
+    adj_offsets[indices[i] + 1]++;
+  }
+  for (size_t v = 0; v < num_vertices; v++) {
+    adj_offsets[v + 1] += adj_offsets[v];
+  }
+  std::vector<uint32_t> adj_tris(indices.size());
+  std::vector<uint32_t> live(num_vertices, 0);
+  for (size_t i = 0; i < indices.size(); i++) {
+    const uint32_t v = indices[i];
+    adj_tris[adj_offsets[v] + live[v]++] = uint32_t(i / 3);
+  }
+
+  static const ForsythScoreTable table;
+
+  std::vector<int32_t> cache_pos(num_vertices, -1);
+  std::vector<float> vertex_scores(num_vertices);
+  for (size_t v = 0; v < num_vertices; v++) {
+    vertex_scores[v] = table.score(-1, live[v]);
+  }
+
+  std::vector<float> tri_scores(num_tris);
+  int64_t best = -1;
+  float best_score = -1.0f;
+  for (size_t t = 0; t < num_tris; t++) {
+    tri_scores[t] = vertex_scores[indices[3 * t + 0]] +
+                    vertex_scores[indices[3 * t + 1]] +
+                    vertex_scores[indices[3 * t + 2]];
+    if (tri_scores[t] > best_score) {
+      best_score = tri_scores[t];
+      best = int64_t(t);
+    }
   }
 
-  const Prim *prim{nullptr};
-  std::string err;
-  if (!stage.find_prim_at_path(Path(prim_part, ""), prim, &err)) {
-    return nonstd::make_unexpected(
-        fmt::format("Prim {} not found in the Stage: {}\n", prim_part, err));
+  std::vector<uint8_t> emitted(num_tris, 0);
+  std::vector<uint32_t> tri_order;
+  tri_order.reserve(num_tris);
+
+  uint32_t cache[kVertexCacheSize + 3];
+  uint32_t new_cache[kVertexCacheSize + 3];
+  size_t cache_count = 0;
+  size_t cursor = 0;  // the first unemitted triangle
+
+  for (size_t i = 0; i < num_tris; i++) {
+    if (best < 0) {
+      // Dead end. Restart from the first unemitted triangle.
+      while (emitted[cursor]) {
+        cursor++;
+      }
+      best = int64_t(cursor);
+    }
+
+    const uint32_t t = uint32_t(best);
+    emitted[t] = 1;
+    tri_order.push_back(t);
+
+    size_t n = 0;
+    for (size_t k = 0; k < 3; k++) {
+      const uint32_t v = indices[3 * t + k];
+
+      // Remove the triangle from live triangles of the vertex.
+      uint32_t *tris = &adj_tris[adj_offsets[v]];
+      for (uint32_t a = 0; a < live[v]; a++) {
+        if (tris[a] == t) {
+          std::swap(tris[a], tris[live[v] - 1]);
+          live[v]--;
+          break;
+        }
+      }
+
+      if (std::find(new_cache, new_cache + n, v) == new_cache + n) {
+        new_cache[n++] = v;
+      }
+    }
+
+    const size_t tri_verts = n;
+    for (size_t j = 0; j < cache_count; j++) {
+      if (std::find(new_cache, new_cache + tri_verts, cache[j]) ==
+          new_cache + tri_verts) {
+        new_cache[n++] = cache[j];
+      }
+    }
+
+    // Update scores of vertices in the cache(and evicted ones) and
+    // triangles using them.
+    for (size_t j = 0; j < n; j++) {
+      const uint32_t v = new_cache[j];
+      cache_pos[v] = (j < kVertexCacheSize) ? int32_t(j) : -1;
+
+      const float score = table.score(cache_pos[v], live[v]);
+      const float delta = score - vertex_scores[v];
+      vertex_scores[v] = score;
+
+      const uint32_t *tris = &adj_tris[adj_offsets[v]];
+      for (uint32_t a = 0; a < live[v]; a++) {
+        tri_scores[tris[a]] += delta;
+      }
+    }
+
+    cache_count = (std::min)(n, size_t(kVertexCacheSize));
+    memcpy(cache, new_cache, sizeof(uint32_t) * cache_count);
+
+    // Next triangle from the triangles using vertices in the cache.
+    best = -1;
+    best_score = -1.0f;
+    for (size_t j = 0; j < cache_count; j++) {
+      const uint32_t v = cache[j];
+      const uint32_t *tris = &adj_tris[adj_offsets[v]];
+      for (uint32_t a = 0; a < live[v]; a++) {
+        if (tri_scores[tris[a]] > best_score) {
+          best_score = tri_scores[tris[a]];
+          best = int64_t(tris[a]);
+        }
+      }
+    }
+  }
+
+  if (!PermuteFaces(mesh, tri_order, err)) {
+    return false;
+  }
+
+  //
+  // 2. Vertex order(first use). Unused points are placed at the end.
+  //
+  constexpr uint32_t kUnused = (std::numeric_limits<uint32_t>::max)();
+  std::vector<uint32_t> remap(num_vertices, kUnused);
+  std::vector<uint32_t> vertex_order;
+  vertex_order.reserve(num_vertices);
+
+  for (uint32_t &v : mesh.faceVertexIndices) {
+    if (remap[v] == kUnused) {
+      remap[v] = uint32_t(vertex_order.size());
+      vertex_order.push_back(v);
+    }
+    v = remap[v];
+  }
+  for (size_t v = 0; v < num_vertices; v++) {
+    if (remap[v] == kUnused) {
+      remap[v] = uint32_t(vertex_order.size());
+      vertex_order.push_back(uint32_t(v));
+    }
+  }
+
+  mesh.points = GatherElements(mesh.points, vertex_order);
+
+  if (mesh.vertexNormals.size() == num_vertices) {
+    mesh.vertexNormals = GatherElements(mesh.vertexNormals, vertex_order);
+  }
+
+  for (auto &it : mesh.vertexTexcoords) {
+    if (it.second.size() == num_vertices) {
+      it.second = GatherElements(it.second, vertex_order);
+    }
+  }
+
+  for (auto &it : mesh.primvars) {
+    VertexAttribute &vattr = it.second;
+    const size_t count = vattr.counts();
+    if (vattr.indices.empty() && count && (count == num_vertices) &&
+        ((vattr.variability == VertexVariability::Vertex) ||
+         (vattr.variability == VertexVariability::Varying))) {
+      vattr.data =
+          GatherBytes(vattr.data, vattr.data.size() / count, vertex_order);
+    }
+  }
+
+  if (mesh.is_indexed) {
+    PackVertexIndices(mesh.faceVertexIndices, mesh.points.size(),
+                      &mesh.indices);
+  }
+
+  mesh.submeshes.clear();
+
+  return true;
+}
+
+bool SortFacesByMaterial(RenderMesh &mesh, std::string *err) {
+  // Used in PUSH_ERROR_AND_RETURN
+  const auto PushError = [err](const std::string &msg) {
+    if (err) {
+      (*err) += msg;
+    }
+  };
+
+  const size_t num_faces = mesh.faceVertexCounts.size();
+  if (num_faces >= size_t((std::numeric_limits<uint32_t>::max)())) {
+    PUSH_ERROR_AND_RETURN("Too many faces.");
+  }
+
+  if (mesh.materialIds.size() && (mesh.materialIds.size() != num_faces)) {
+    PUSH_ERROR_AND_RETURN(fmt::format(
+        "The number of materialIds {} must be equal to the number of faces "
+        "{}.",
+        mesh.materialIds.size(), num_faces));
+  }
+
+  // Distinct materials(ascending).
+  std::vector<int32_t> mat_ids(mesh.materialIds);
+  std::sort(mat_ids.begin(), mat_ids.end());
+  mat_ids.erase(std::unique(mat_ids.begin(), mat_ids.end()), mat_ids.end());
+
+  if (mat_ids.size() > 1) {
+    // Counting sort(stable).
+    std::vector<uint32_t> bucket_offsets(mat_ids.size() + 1, 0);
+    std::vector<uint32_t> face_buckets(num_faces);
+    for (size_t f = 0; f < num_faces; f++) {
+      face_buckets[f] = uint32_t(
+          std::lower_bound(mat_ids.begin(), mat_ids.end(),
+                           mesh.materialIds[f]) -
+          mat_ids.begin());
+      bucket_offsets[face_buckets[f] + 1]++;
+    }
+    for (size_t b = 0; b < mat_ids.size(); b++) {
+      bucket_offsets[b + 1] += bucket_offsets[b];
+    }
+
+    std::vector<uint32_t> face_order(num_faces);
+    for (size_t f = 0; f < num_faces; f++) {
+      face_order[bucket_offsets[face_buckets[f]]++] = uint32_t(f);
+    }
+
+    if (!PermuteFaces(mesh, face_order, err)) {
+      return false;
+    }
+  }
+
+  mesh.submeshes.clear();
+
+  SubmeshRange range;
+  range.material_id = mesh.materialIds.empty() ? -1 : mesh.materialIds[0];
+  for (size_t f = 0; f < num_faces; f++) {
+    const int32_t mat_id = mesh.materialIds.empty() ? -1 : mesh.materialIds[f];
+    if (mat_id != range.material_id) {
+      mesh.submeshes.push_back(range);
+
+      range.face_offset += range.face_count;
+      range.index_offset += range.index_count;
+      range.face_count = 0;
+      range.index_count = 0;
+      range.material_id = mat_id;
+    }
+    range.face_count++;
+    range.index_count += mesh.faceVertexCounts[f];
+  }
+
+  if (range.face_count) {
+    mesh.submeshes.push_back(range);
+  }
+
+  return true;
+}
+
+namespace {
+
+inline const vec3 &MeshVertexPosition(const RenderMesh &mesh, uint32_t vid) {
+  // vertex id = point index for indexed mesh, face-corner index otherwise.
+  return mesh.is_indexed ? mesh.points[vid]
+                         : mesh.points[mesh.faceVertexIndices[vid]];
+}
+
+void ComputeMeshletBounds(const RenderMesh &mesh, Meshlet &meshlet) {
+  const uint32_t *vertices = &mesh.meshletVertices[meshlet.vertex_offset];
+  const uint8_t *triangles = &mesh.meshletTriangles[meshlet.triangle_offset];
+
+  // Bounding sphere(center of AABB).
+  vec3 bmin = MeshVertexPosition(mesh, vertices[0]);
+  vec3 bmax = bmin;
+  for (uint32_t i = 1; i < meshlet.vertex_count; i++) {
+    const vec3 &p = MeshVertexPosition(mesh, vertices[i]);
+    for (size_t k = 0; k < 3; k++) {
+      bmin[k] = (std::min)(bmin[k], p[k]);
+      bmax[k] = (std::max)(bmax[k], p[k]);
+    }
+  }
+
+  vec3 center;
+  for (size_t k = 0; k < 3; k++) {
+    center[k] = 0.5f * (bmin[k] + bmax[k]);
+  }
+
+  float radius2 = 0.0f;
+  for (uint32_t i = 0; i < meshlet.vertex_count; i++) {
+    const vec3 &p = MeshVertexPosition(mesh, vertices[i]);
+    const float dx = p[0] - center[0];
+    const float dy = p[1] - center[1];
+    const float dz = p[2] - center[2];
+    radius2 = (std::max)(radius2, dx * dx + dy * dy + dz * dz);
+  }
+
+  meshlet.center = center;
+  meshlet.radius = std::sqrt(radius2);
+
+  // Normal cone.
+  std::vector<value::float3> normals;
+  normals.reserve(meshlet.triangle_count);
+
+  value::float3 axis{0.0f, 0.0f, 0.0f};
+  for (uint32_t t = 0; t < meshlet.triangle_count; t++) {
+    const vec3 &p0 = MeshVertexPosition(mesh, vertices[triangles[3 * t + 0]]);
+    const vec3 &p1 = MeshVertexPosition(mesh, vertices[triangles[3 * t + 1]]);
+    const vec3 &p2 = MeshVertexPosition(mesh, vertices[triangles[3 * t + 2]]);
+
+    const value::float3 e0{p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    const value::float3 e1{p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    const value::float3 n = vcross(e0, e1);
+    const float len = vlength(n);
+    if (len <= std::numeric_limits<float>::min()) {
+      // Skip degenerated triangle.
+      continue;
+    }
+
+    const value::float3 nn{n[0] / len, n[1] / len, n[2] / len};
+    normals.push_back(nn);
+    axis[0] += nn[0];
+    axis[1] += nn[1];
+    axis[2] += nn[2];
+  }
+
+  const float axis_len = vlength(axis);
+  if (normals.empty() || (axis_len <= std::numeric_limits<float>::min())) {
+    meshlet.cone_axis = {0.0f, 0.0f, 1.0f};
+    meshlet.cone_cutoff = -1.0f;
+    return;
+  }
+
+  axis = {axis[0] / axis_len, axis[1] / axis_len, axis[2] / axis_len};
+
+  float cutoff = 1.0f;
+  for (const auto &n : normals) {
+    cutoff = (std::min)(cutoff, vdot(n, axis));
+  }
+
+  meshlet.cone_axis = {axis[0], axis[1], axis[2]};
+  meshlet.cone_cutoff = cutoff;
+}
+
+}  // namespace
+
+bool BuildMeshlets(RenderMesh &mesh, uint32_t max_vertices,
+                   uint32_t max_triangles, std::string *err) {
+  // Used in PUSH_ERROR_AND_RETURN
+  const auto PushError = [err](const std::string &msg) {
+    if (err) {
+      (*err) += msg;
+    }
+  };
+
+  if ((max_vertices < 3) || (max_vertices > 256)) {
+    PUSH_ERROR_AND_RETURN(fmt::format(
+        "max_vertices must be in range [3, 256], but got {}.", max_vertices));
+  }
+
+  if ((max_triangles < 1) || (max_triangles > 512)) {
+    PUSH_ERROR_AND_RETURN(fmt::format(
+        "max_triangles must be in range [1, 512], but got {}.",
+        max_triangles));
+  }
+
+  for (size_t i = 0; i < mesh.faceVertexCounts.size(); i++) {
+    if (mesh.faceVertexCounts[i] != 3) {
+      PUSH_ERROR_AND_RETURN("Mesh must be triangulated.");
+    }
+  }
+
+  const size_t num_tris = mesh.faceVertexCounts.size();
+  if (mesh.faceVertexIndices.size() != 3 * num_tris) {
+    PUSH_ERROR_AND_RETURN(
+        "Invalid faceVertexIndices or faceVertexCounts for triangle mesh.");
+  }
+
+  const size_t num_vertices =
+      mesh.is_indexed ? mesh.points.size() : mesh.faceVertexIndices.size();
+
+  if (num_vertices >= size_t((std::numeric_limits<uint32_t>::max)())) {
+    PUSH_ERROR_AND_RETURN("Too many vertices.");
+  }
+
+  // Vertex id of each triangle corner.
+  std::vector<uint32_t> tri_vertices(3 * num_tris);
+  for (size_t i = 0; i < 3 * num_tris; i++) {
+    if (mesh.faceVertexIndices[i] >= mesh.points.size()) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "faceVertexIndices[{}] {} exceeds the number of points {}.", i,
+          mesh.faceVertexIndices[i], mesh.points.size()));
+    }
+    tri_vertices[i] = mesh.is_indexed ? mesh.faceVertexIndices[i] : uint32_t(i);
+  }
+
+  // vertex -> triangles adjacency(CSR)
+  std::vector<uint32_t> adj_offsets(num_vertices + 1, 0);
+  for (size_t i = 0; i < 3 * num_tris; i++) {
+    adj_offsets[tri_vertices[i] + 1]++;
+  }
+  for (size_t v = 0; v < num_vertices; v++) {
+    adj_offsets[v + 1] += adj_offsets[v];
+  }
+  std::vector<uint32_t> adj_tris(3 * num_tris);
+  {
+    std::vector<uint32_t> cursor(adj_offsets.begin(), adj_offsets.end() - 1);
+    for (size_t i = 0; i < 3 * num_tris; i++) {
+      adj_tris[cursor[tri_vertices[i]]++] = uint32_t(i / 3);
+    }
+  }
+
+  constexpr uint32_t kNotInMeshlet = (std::numeric_limits<uint32_t>::max)();
+  constexpr uint8_t kNotCandidate = 0xff;
+
+  const bool has_materials = (mesh.materialIds.size() == num_tris);
+  const auto tri_material = [&](uint32_t t) {
+    return has_materials ? mesh.materialIds[t] : -1;
+  };
+
+  std::vector<uint8_t> emitted(num_tris, 0);
+  // Local vertex index in the current meshlet.
+  std::vector<uint32_t> local_ids(num_vertices, kNotInMeshlet);
+
+  std::vector<Meshlet> meshlets;
+  std::vector<uint32_t> meshlet_vertices;
+  std::vector<uint8_t> meshlet_triangles;
+  meshlet_vertices.reserve(3 * num_tris);
+  meshlet_triangles.reserve(3 * num_tris);
+
+  // Triangles adjacent to the current meshlet are bucketed by their
+  // score(the number of vertices not yet in the meshlet, [0, 2]). Scores
+  // only decrease while the meshlet grows, so a triangle is pushed again to
+  // the lower bucket and stale entries are skipped on pop.
+  std::vector<uint8_t> scores(num_tris, kNotCandidate);
+  std::vector<uint32_t> buckets[3];
+  size_t bucket_heads[3] = {0, 0, 0};  // FIFO
+  std::vector<uint32_t> touched;  // triangles scored in the current meshlet
+  size_t seed_cursor = 0;         // the first unemitted triangle
+
+  Meshlet meshlet;
+
+  const auto finish_meshlet = [&]() {
+    for (uint32_t i = 0; i < meshlet.vertex_count; i++) {
+      local_ids[meshlet_vertices[meshlet.vertex_offset + i]] = kNotInMeshlet;
+    }
+    for (const uint32_t t : touched) {
+      scores[t] = kNotCandidate;
+    }
+    touched.clear();
+    for (size_t b = 0; b < 3; b++) {
+      buckets[b].clear();
+      bucket_heads[b] = 0;
+    }
+
+    meshlets.push_back(meshlet);
+
+    meshlet = Meshlet();
+    meshlet.vertex_offset = uint32_t(meshlet_vertices.size());
+    meshlet.triangle_offset = uint32_t(meshlet_triangles.size());
+  };
+
+  const auto add_vertex = [&](uint32_t vid) {
+    local_ids[vid] = meshlet.vertex_count++;
+    meshlet_vertices.push_back(vid);
+
+    for (uint32_t a = adj_offsets[vid]; a < adj_offsets[vid + 1]; a++) {
+      const uint32_t t = adj_tris[a];
+      if (emitted[t] || (tri_material(t) != meshlet.material_id)) {
+        continue;
+      }
+
+      if (scores[t] == kNotCandidate) {
+        uint8_t score = 0;
+        for (size_t k = 0; k < 3; k++) {
+          if (local_ids[tri_vertices[3 * t + k]] == kNotInMeshlet) {
+            score++;
+          }
+        }
+        scores[t] = score;
+        touched.push_back(t);
+      } else {
+        scores[t]--;
+      }
+      buckets[scores[t]].push_back(t);
+    }
+  };
+
+  const auto add_triangle = [&](uint32_t t) {
+    if (meshlet.triangle_count == 0) {
+      meshlet.material_id = tri_material(t);
+    }
+    emitted[t] = 1;
+    for (size_t k = 0; k < 3; k++) {
+      const uint32_t vid = tri_vertices[3 * t + k];
+      if (local_ids[vid] == kNotInMeshlet) {
+        add_vertex(vid);
+      }
+      meshlet_triangles.push_back(uint8_t(local_ids[vid]));
+    }
+    meshlet.triangle_count++;
+  };
+
+  for (size_t num_emitted = 0; num_emitted < num_tris; num_emitted++) {
+    // Candidate which adds the fewest new vertices. Older candidates
+    // first, so that the meshlet grows compact(rather than strip-like).
+    uint32_t best = kNotInMeshlet;
+    uint32_t best_score = 0;
+    for (uint32_t b = 0; (b < 3) && (best == kNotInMeshlet); b++) {
+      while (bucket_heads[b] < buckets[b].size()) {
+        const uint32_t t = buckets[b][bucket_heads[b]++];
+        if (!emitted[t] && (scores[t] == b)) {
+          best = t;
+          best_score = b;
+          break;
+        }
+      }
+    }
+
+    if (best == kNotInMeshlet) {
+      // No triangle adjacent to the meshlet(e.g. disconnected parts, or
+      // non-indexed mesh which does not share vertices). Continue with the
+      // first unemitted triangle.
+      while (emitted[seed_cursor]) {
+        seed_cursor++;
+      }
+      best = uint32_t(seed_cursor);
+      best_score = 0;
+      for (size_t k = 0; k < 3; k++) {
+        if (local_ids[tri_vertices[3 * best + k]] == kNotInMeshlet) {
+          best_score++;
+        }
+      }
+    }
+
+    const bool fits = (tri_material(best) == meshlet.material_id) &&
+                      (meshlet.vertex_count + best_score <= max_vertices) &&
+                      (meshlet.triangle_count < max_triangles);
+
+    // Otherwise start a new meshlet. `best` is a neighbor of the previous
+    // meshlet if any, to keep locality.
+    if (!fits && meshlet.triangle_count) {
+      finish_meshlet();
+    }
+
+    add_triangle(best);
+  }
+
+  if (meshlet.triangle_count) {
+    finish_meshlet();
+  }
+
+  mesh.meshlets = std::move(meshlets);
+  mesh.meshletVertices = std::move(meshlet_vertices);
+  mesh.meshletTriangles = std::move(meshlet_triangles);
+
+  for (auto &m : mesh.meshlets) {
+    ComputeMeshletBounds(mesh, m);
+  }
+
+  return true;
+}
+
+bool RenderSceneConverter::ConvertMesh(const int64_t rmaterial_id,
+                                       const GeomMesh &mesh,
+                                       RenderMesh *dstMesh) {
+  return ConvertMesh(rmaterial_id, std::vector<MaterialSubset>(), mesh,
+                     dstMesh);
+}
+
+bool RenderSceneConverter::ConvertMesh(
+    const int64_t rmaterial_id,
+    const std::vector<MaterialSubset> &material_subsets, const GeomMesh &mesh,
+    RenderMesh *dstMesh) {
+  if (!dstMesh) {
+    PUSH_ERROR_AND_RETURN("`dst` mesh pointer is nullptr");
+  }
+
+  RenderMesh dst;
+
+  bool triangulate = _mesh_config.triangulate;
+
+  // indices
+  // TODO: timeSamples, connections
+  if (const auto pv = mesh.faceVertexIndices.get_value()) {
+    std::vector<int32_t> indices;
+    if (pv.value().get_scalar(&indices)) {
+      // to uint32
+      std::transform(indices.cbegin(), indices.cend(),
+                     std::back_inserter(dst.faceVertexIndices),
+                     [](int32_t v) { return uint32_t(v); });
+    }
+  }
+
+  if (const auto pv = mesh.faceVertexCounts.get_value()) {
+    std::vector<int32_t> counts;
+    if (pv.value().get_scalar(&counts)) {
+      // to uint32
+      std::transform(counts.cbegin(), counts.cend(),
+                     std::back_inserter(dst.faceVertexCounts),
+                     [](int32_t v) { return uint32_t(v); });
+    }
+  }
+
+  // per-face material
+  {
+    const size_t num_faces = dst.faceVertexCounts.size();
+    const auto valid_material_id = [](const int64_t id) {
+      return (id > -1) && (id < (std::numeric_limits<int32_t>::max)());
+    };
+
+    // Do not assign materialIds when no material bound to this Mesh.
+    if (valid_material_id(rmaterial_id)) {
+      dst.materialIds.assign(num_faces, int32_t(rmaterial_id));
+    }
+
+    for (const auto &subset : material_subsets) {
+      if (!valid_material_id(subset.material_id)) {
+        continue;
+      }
+
+      if (dst.materialIds.empty()) {
+        dst.materialIds.assign(num_faces, -1);
+      }
+
+      for (const uint32_t face : subset.faces) {
+        if (face >= num_faces) {
+          PUSH_ERROR_AND_RETURN(
+              fmt::format("GeomSubset face index {} exceeds the number of "
+                          "faces {}.",
+                          face, num_faces));
+        }
+        dst.materialIds[face] = int32_t(subset.material_id);
+      }
+    }
+  }
+
+  if (mesh.get_points().size()) {
+    dst.points.resize(mesh.get_points().size());
+    memcpy(dst.points.data(), mesh.get_points().data(),
+           sizeof(value::float3) * mesh.get_points().size());
+  }
+
+  // normals
+  {
+    std::vector<value::normal3f> normals = mesh.get_normals();
+    Interpolation interp = mesh.get_normalsInterpolation();
+
+    if (normals.size()) {
+      if (interp == Interpolation::Uniform) {
+        auto result = UniformToFaceVarying(normals, dst.faceVertexCounts, dst.faceVertexIndices);
+        if (!result) {
+          PUSH_ERROR_AND_RETURN(
+              fmt::format("Convert uniform `normals` attribute to failed: {}", result.error()));
+        }
+
+        dst.facevaryingNormals.resize(result.value().size());
+        memcpy(dst.facevaryingNormals.data(), result.value().data(),
+               sizeof(value::normal3f) * result.value().size());
+
+      } else if ((interp == Interpolation::Vertex) || (interp == Interpolation::Varying)) {
+        auto result = VertexToFaceVarying(normals, dst.faceVertexCounts, dst.faceVertexIndices);
+        if (!result) {
+          PUSH_ERROR_AND_RETURN(
+              fmt::format("Convert vertex/varying `normals` attribute to failed: {}", result.error()));
+        }
+
+        dst.facevaryingNormals.resize(result.value().size());
+        memcpy(dst.facevaryingNormals.data(), result.value().data(),
+               sizeof(value::normal3f) * result.value().size());
+
+      } else if (interp == Interpolation::FaceVarying) {
+        dst.facevaryingNormals.resize(normals.size());
+        memcpy(dst.facevaryingNormals.data(), normals.data(),
+               sizeof(value::normal3f) * normals.size());
+      } else {
+        PUSH_ERROR_AND_RETURN(
+            "Unsupported/unimplemented interpolation for `normals` attribute: " +
+            to_string(interp) + ".\n");
+      }
+    } else {
+      dst.facevaryingNormals.clear();
+      dst.normalsInterpolation = interp;
+    }
+  }
+
+  // Compute total faceVarying elements;
+  size_t num_fvs = 0;
+  for (size_t i = 0; i < dst.faceVertexCounts.size(); i++) {
+    num_fvs += dst.faceVertexCounts[i];
+  }
+
+  DCOUT("num_fvs = " << num_fvs);
+
+  // uvs from primvars.
+  // uvname(varname) is grabbed from RenderMaterial.
+  //
+  // TODO: list-up varname from PreviewSurfaceShader members.
+  //
+  // Procedure:
+  // - Find Shader
+  // - Lookup PrimvarReader
+  //
+
+  StringAndIdMap uvname_map;
+  {
+    // UV names of all materials bound to this Mesh.
+    std::vector<int32_t> mat_ids(dst.materialIds);
+    std::sort(mat_ids.begin(), mat_ids.end());
+    mat_ids.erase(std::unique(mat_ids.begin(), mat_ids.end()), mat_ids.end());
+
+    for (const int32_t mat_id : mat_ids) {
+      if ((mat_id > -1) && (size_t(mat_id) < materials.size())) {
+        if (!ListUVNames(materials[size_t(mat_id)], textures, uvname_map)) {
+          return false;
+        }
+      }
+    }
+  }
+
+  for (auto it = uvname_map.i_begin(); it != uvname_map.i_end(); it++) {
+    uint64_t slotId = it->first;
+    std::string uvname = it->second;
+
+    auto ret = GetTextureCoordinate(*_stage, mesh, uvname);
+    if (ret) {
+      const VertexAttribute vattr = ret.value();
+
+      if (vattr.format != VertexAttributeFormat::Vec2) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("Texcoord VertexAttribute must be Vec2 type.\n"));
+      }
+
+      if (vattr.variability != VertexVariability::FaceVarying) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("TODO: non-facevarying UV texcoord attribute is not "
+                        "support yet: {}.\n",
+                        uvname));
+      }
+
+      if (vattr.counts() != num_fvs) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("The number of UV texcoord attributes {} does not "
+                        "match to the number of facevarying elements {}\n",
+                        vattr.counts(), num_fvs));
+      }
+
+      DCOUT("Add texcoord attr `" << uvname << "` to slot Id " << slotId);
+      std::vector<vec2> uvs(vattr.counts());
+      memcpy(uvs.data(), vattr.data.data(), vattr.data.size());
+
+      dst.facevaryingTexcoords.emplace(slotId, uvs);
+
+    } else {
+      PUSH_ERROR_AND_RETURN(ret.error());
+    }
+  }
+
+  // Weld before triangulation: Triangulation only requires positions, so
+  // welded `points` and `faceVertexIndices` can be triangulated as is.
+  if (_mesh_config.build_indexed_mesh) {
+    std::string err;
+    if (!WeldFaceVertices(dst, &err)) {
+      PUSH_ERROR_AND_RETURN("Failed to build indexed mesh: " + err);
+    }
+  }
+
+  if (triangulate) {
+    std::string err;
+
+    std::vector<uint32_t> triangulatedFaceVertexCounts;  // should be all 3's
+    std::vector<uint32_t> triangulatedFaceVertexIndices;
+    std::vector<size_t> faceVertexIndexMap;
+    if (!TriangulatePolygon<value::float3, float>(
+            dst.points, dst.faceVertexCounts, dst.faceVertexIndices,
+            triangulatedFaceVertexCounts, triangulatedFaceVertexIndices,
+            faceVertexIndexMap, err, _mesh_config.num_threads)) {
+      PUSH_ERROR_AND_RETURN("Triangulation failed: " + err);
+    }
+
+    // Remap faceVarying attributes to triangulated face-corners.
+    if (dst.facevaryingNormals.size() == dst.faceVertexIndices.size()) {
+      dst.facevaryingNormals =
+          GatherElements(dst.facevaryingNormals, faceVertexIndexMap);
+    }
+
+    for (auto &it : dst.facevaryingTexcoords) {
+      if (it.second.size() == dst.faceVertexIndices.size()) {
+        it.second = GatherElements(it.second, faceVertexIndexMap);
+      }
+    }
+
+    // TODO: Triangulate primvars with faceVertexIndexMap
+
+    // Per-face material of each triangle(source face of its first corner).
+    if (dst.materialIds.size() == dst.faceVertexCounts.size()) {
+      std::vector<uint32_t> cornerFaces;
+      cornerFaces.reserve(dst.faceVertexIndices.size());
+      for (size_t f = 0; f < dst.faceVertexCounts.size(); f++) {
+        cornerFaces.insert(cornerFaces.end(), dst.faceVertexCounts[f],
+                           uint32_t(f));
+      }
+
+      std::vector<int32_t> triangulatedMaterialIds(
+          triangulatedFaceVertexCounts.size());
+      for (size_t t = 0; t < triangulatedMaterialIds.size(); t++) {
+        triangulatedMaterialIds[t] =
+            dst.materialIds[cornerFaces[faceVertexIndexMap[3 * t]]];
+      }
+      dst.materialIds = std::move(triangulatedMaterialIds);
+    }
+
+    dst.faceVertexCounts = std::move(triangulatedFaceVertexCounts);
+    dst.faceVertexIndices = std::move(triangulatedFaceVertexIndices);
+
+    if (dst.is_indexed) {
+      PackVertexIndices(dst.faceVertexIndices, dst.points.size(), &dst.indices);
+    }
+
+  }  // triangulate
+
+  if (_mesh_config.optimize_vertex_cache) {
+    if (!triangulate) {
+      PUSH_ERROR_AND_RETURN(
+          "`triangulate` must be enabled to optimize vertex cache.");
+    }
+
+    std::string err;
+    if (!OptimizeVertexCache(dst, &err)) {
+      PUSH_ERROR_AND_RETURN("Failed to optimize vertex cache: " + err);
+    }
+  }
+
+  // After vertex cache optimization: Faces keep the optimized order within
+  // each material.
+  if (_mesh_config.sort_faces_by_material) {
+    std::string err;
+    if (!SortFacesByMaterial(dst, &err)) {
+      PUSH_ERROR_AND_RETURN("Failed to sort faces by material: " + err);
+    }
+  }
+
+  if (_mesh_config.build_meshlets) {
+    if (!triangulate) {
+      PUSH_ERROR_AND_RETURN(
+          "`triangulate` must be enabled to build meshlets.");
+    }
+
+    std::string err;
+    if (!BuildMeshlets(dst, _mesh_config.meshlet_max_vertices,
+                       _mesh_config.meshlet_max_triangles, &err)) {
+      PUSH_ERROR_AND_RETURN("Failed to build meshlets: " + err);
+    }
+  }
+
+  if (_mesh_config.build_interleaved_vertex_buffer) {
+    std::string err;
+    if (!BuildInterleavedVertexBuffer(
+            dst,
+            _mesh_config.vertex_layout.empty() ? DefaultVertexLayout()
+                                               : _mesh_config.vertex_layout,
+            &dst.vertexLayout, &dst.vertexBuffer, &err)) {
+      PUSH_ERROR_AND_RETURN("Failed to build interleaved vertex buffer: " +
+                            err);
+    }
+  }
+
+  (*dstMesh) = std::move(dst);
+  return true;
+}
+
+namespace {
+
+#if 1
+// Convert UsdTranform2d -> PrimvarReader_float2 shader network.
+nonstd::expected<bool, std::string> ConvertTexTransform2d(
+    const Stage &stage, const Path &tx_abs_path, const UsdTransform2d &tx,
+    UVTexture *tex_out) {
+  float rotation;  // in angles
+  if (!tx.rotation.get_value().get_scalar(&rotation)) {
+    return nonstd::make_unexpected(
+        fmt::format("Failed to retrieve rotation attribute from {}\n",
+                    tx_abs_path.full_path_name()));
+  }
+
+  value::float2 scale;
+  if (!tx.scale.get_value().get_scalar(&scale)) {
+    return nonstd::make_unexpected(
+        fmt::format("Failed to retrieve scale attribute from {}\n",
+                    tx_abs_path.full_path_name()));
+  }
+
+  value::float2 translation;
+  if (!tx.translation.get_value().get_scalar(&translation)) {
+    return nonstd::make_unexpected(
+        fmt::format("Failed to retrieve translation attribute from {}\n",
+                    tx_abs_path.full_path_name()));
+  }
+
+  // must be authored and connected to PrimvarReader.
+  if (!tx.in.authored()) {
+    return nonstd::make_unexpected("`inputs:in` must be authored.\n");
+  }
+
+  if (!tx.in.is_connection()) {
+    return nonstd::make_unexpected("`inputs:in` must be a connection.\n");
+  }
+
+  const auto &paths = tx.in.get_connections();
+  if (paths.size() != 1) {
+    return nonstd::make_unexpected(
+        "`inputs:in` must be a single connection Path.\n");
+  }
+
+  std::string prim_part = paths[0].prim_part();
+  std::string prop_part = paths[0].prop_part();
+
+  if (prop_part != "outputs:result") {
+    return nonstd::make_unexpected(
+        "`inputs:in` connection Path's property part must be "
+        "`outputs:result`\n");
+  }
+
+  std::string err;
+
+  const Prim *pprim{nullptr};
+  if (!stage.find_prim_at_path(Path(prim_part, ""), pprim, &err)) {
+    return nonstd::make_unexpected(fmt::format(
+        "`inputs:in` connection Path not found in the Stage. {}\n", prim_part));
+  }
+
+  if (!pprim) {
+    return nonstd::make_unexpected(
+        fmt::format("[InternalError] Prim is nullptr: {}\n", prim_part));
+  }
+
+  const Shader *pshader = pprim->as<Shader>();
+  if (!pshader) {
+    return nonstd::make_unexpected(
+        fmt::format("{} must be Shader Prim, but got {}\n", prim_part,
+                    pprim->prim_type_name()));
+  }
+
+  const UsdPrimvarReader_float2 *preader =
+      pshader->value.as<UsdPrimvarReader_float2>();
+  if (preader) {
+    return nonstd::make_unexpected(fmt::format(
+        "Shader {} must be UsdPrimvarReader_float2 type, but got {}\n",
+        prim_part, pshader->info_id));
+  }
+
+  // Get value producing attribute(i.e, follow .connection and return
+  // terminal Attribute value)
+  value::token varname;
+#if 0
+  if (!tydra::EvaluateShaderAttribute(stage, *pshader, "inputs:varname",
+                                      &varname, &err)) {
+    return nonstd::make_unexpected(
+        fmt::format("Failed to evaluate UsdPrimvarReader_float2's "
+                    "inputs:varname: {}\n",
+                    err));
+  }
+#else
+  TerminalAttributeValue attr;
+  if (!tydra::EvaluateAttribute(stage, *pprim, "inputs:varname", &attr, &err)) {
+    return nonstd::make_unexpected(
+        "`inputs:varname` evaluation failed: " + err + "\n");
+  }
+  if (auto pv = attr.as<value::token>()) {
+    varname = *pv;
+  } else {
+    return nonstd::make_unexpected(
+        "`inputs:varname` must be `token` type, but got " + attr.type_name() +
+        "\n");
+  }
+  if (varname.str().empty()) {
+    return nonstd::make_unexpected("`inputs:varname` is empty token\n");
+  }
+  DCOUT("inputs:varname = " << varname);
+#endif
+
+  // Build transform matrix.
+  // https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Khronos/KHR_texture_transform
+  // Since USD uses post-multiply,
+  //
+  // matrix = scale * rotate * translate
+  //
+  {
+    mat3 s;
+    s.set_scale(scale[0], scale[1], 1.0f);
+
+    mat3 r = mat3::identity();
+
+    r.m[0][0] = std::cos(math::radian(rotation));
+    r.m[0][1] = std::sin(math::radian(rotation));
+
+    r.m[1][0] = -std::sin(math::radian(rotation));
+    r.m[1][1] = std::cos(math::radian(rotation));
+
+    mat3 t = mat3::identity();
+    t.set_translation(translation[0], translation[1], 1.0f);
+
+    tex_out->transform = s * r * t;
+  }
+
+  tex_out->tx_rotation = rotation;
+  tex_out->tx_translation = translation;
+  tex_out->tx_scale = scale;
+  tex_out->has_transform2d = true;
+
+  tex_out->varname_uv = varname.str();
+
+  return true;
+}
+#endif
+
+template <typename T>
+nonstd::expected<bool, std::string> GetConnectedUVTexture(
+    const Stage &stage, const TypedAnimatableAttributeWithFallback<T> &src,
+    Path *tex_abs_path, const UsdUVTexture **dst, const Shader **shader_out) {
+  if (!dst) {
+    return nonstd::make_unexpected("[InternalError] dst is nullptr.\n");
+  }
+
+  if (!src.is_connection()) {
+    return nonstd::make_unexpected("Attribute must be connection.\n");
+  }
+
+  if (src.get_connections().size() != 1) {
+    return nonstd::make_unexpected(
+        "Attribute connections must be single connection Path.\n");
+  }
+
+  const Path &path = src.get_connections()[0];
+
+  const std::string prim_part = path.prim_part();
+  const std::string prop_part = path.prop_part();
+
+  if (prop_part != "outputs:rgb") {
+    return nonstd::make_unexpected(
+        "connection Path's property part must be `outputs:rgb` at the moment "
+        "for "
+        "UsdUVTexture, but got " +
+        prop_part + " \n");
+  }
+
+  const Prim *prim{nullptr};
+  std::string err;
+  if (!stage.find_prim_at_path(Path(prim_part, ""), prim, &err)) {
+    return nonstd::make_unexpected(
+        fmt::format("Prim {} not found in the Stage: {}\n", prim_part, err));
+  }
+
+  if (!prim) {
+    return nonstd::make_unexpected("[InternalError] Prim ptr is null.\n");
+  }
+
+  if (tex_abs_path) {
+    (*tex_abs_path) = Path(prim_part, "");
+  }
+
+  if (const Shader *pshader = prim->as<Shader>()) {
+    if (const UsdUVTexture *ptex = pshader->value.as<UsdUVTexture>()) {
+      DCOUT("ptex = " << ptex);
+      (*dst) = ptex;
+
+      if (shader_out) {
+        (*shader_out) = pshader;
+      }
+
+      return true;
+    }
+  }
+
+  return nonstd::make_unexpected(fmt::format(
+      "Prim {} must be Shader, but got {}", prim_part, prim->prim_type_name()));
+}
+
+}  // namespace
+
+// W.I.P.
+// Convert UsdUVTexture shader node.
+// @return true upon conversion success(textures.back() contains the converted
+// UVTexture)
+//
+// Possible network configuration
+//
+// - UsdUVTexture -> UsdPrimvarReader
+// - UsdUVTexture -> UsdTransform2d -> UsdPrimvarReader
+bool RenderSceneConverter::ConvertUVTexture(const Path &tex_abs_path,
+                                            const AssetInfo &assetInfo,
+                                            const UsdUVTexture &texture,
+                                            UVTexture *tex_out) {
+  DCOUT("ConvertUVTexture " << tex_abs_path);
+
+  if (!tex_out) {
+    PUSH_ERROR_AND_RETURN("tex_out arg is nullptr.");
+  }
+  std::string err;
+
+  UVTexture tex;
+
+  // First load texture file.
+  if (!texture.file.authored()) {
+    PUSH_ERROR_AND_RETURN(fmt::format("`asset:file` is not authored. Path = {}",
+                                      tex_abs_path.prim_part()));
+  }
+
+  value::AssetPath assetPath;
+  if (auto apath = texture.file.get_value()) {
+    if (!apath.value().get_scalar(&assetPath)) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("Failed to get `asset:file` value from Path {} (Maybe "
+                      "`asset:file` is timeSample value?)",
+                      tex_abs_path.prim_part()));
+    }
+  } else {
+    PUSH_ERROR_AND_RETURN(
+        fmt::format("Failed to get `asset:file` value from Path {}",
+                    tex_abs_path.prim_part()));
+  }
+
+  // TextureImage and BufferData
+  {
+    TextureImage texImage;
+    BufferData assetImageBuffer;
+
+    // Texel data is treated as byte array
+    assetImageBuffer.componentType = ComponentType::UInt8;
+    assetImageBuffer.count = 1;
+
+    if (_scene_config.load_texture_assets) {
+      std::string warn;
+
+      TextureImageLoaderFunction tex_loader_fun =
+          _material_config.texture_image_loader_function;
+
+      if (!tex_loader_fun) {
+        tex_loader_fun = DefaultTextureImageLoaderFunction;
+      }
+
+      bool tex_ok = tex_loader_fun(
+          assetPath, assetInfo, _asset_resolver, &texImage, &assetImageBuffer.data,
+          _material_config.texture_image_loader_function_userdata, &warn, &err);
+
+      if (!tex_ok && !_material_config.allow_texture_load_failure) {
+        PUSH_ERROR_AND_RETURN("Failed to load texture image: " + err);
+      }
+
+      if (warn.size()) {
+        DCOUT("WARN: " << warn);
+        PushWarn(warn);
+      }
+
+      if (err.size()) {
+        // report as warning.
+        PushWarn(err);
+      }
+
+      // store unresolved asset path.
+      texImage.asset_identifier = assetPath.GetAssetPath();
+
+    } else {
+      // store resolved asset path.
+      texImage.asset_identifier =
+          _asset_resolver.resolve(assetPath.GetAssetPath());
+    }
+
+    // colorSpace
+    if (texture.sourceColorSpace.authored()) {
+      UsdUVTexture::SourceColorSpace cs;
+      if (texture.sourceColorSpace.get_value().get_scalar(&cs)) {
+        if (cs == UsdUVTexture::SourceColorSpace::SRGB) {
+          texImage.usdColorSpace = tydra::ColorSpace::sRGB;
+        } else if (cs == UsdUVTexture::SourceColorSpace::Raw) {
+          texImage.usdColorSpace = tydra::ColorSpace::Linear;
+        } else if (cs == UsdUVTexture::SourceColorSpace::Auto) {
+          // TODO: Read colorspace from a file.
+          if ((texImage.assetTexelComponentType == ComponentType::UInt8) ||
+              (texImage.assetTexelComponentType == ComponentType::Int8)) {
+            texImage.usdColorSpace = tydra::ColorSpace::sRGB;
+          } else {
+            texImage.usdColorSpace = tydra::ColorSpace::Linear;
+          }
+        }
+      }
+    }
+
+    BufferData imageBuffer;
+
+    // Linearlization and widen texel bit depth if required.
+    if (_material_config.linearize_color_space) {
+
+      size_t width = size_t(texImage.width);
+      size_t height = size_t(texImage.height);
+      size_t channels = size_t(texImage.channels);
+      if (channels == 4) {
+        PUSH_ERROR_AND_RETURN(fmt::format("TODO: RGBA color channels are not supported yet."));
+      }
+      if (channels > 4) {
+        PUSH_ERROR_AND_RETURN(fmt::format("TODO: Multiband color channels(5 or more) are not supported(yet)."));
+      }
+
+      if (assetImageBuffer.componentType == tydra::ComponentType::UInt8) {
+
+        if (texImage.usdColorSpace == tydra::ColorSpace::sRGB) {
+
+          if (_material_config.preserve_texel_bitdepth) {
+
+            // u8 sRGB -> u8 Linear
+            imageBuffer.componentType = tydra::ComponentType::UInt8;
+
+            bool ret = srgb_8bit_to_linear_8bit(assetImageBuffer.data, width, height ,channels, /* channel stride */channels, &imageBuffer.data);
+            if (!ret) {
+              PUSH_ERROR_AND_RETURN("Failed to convert sRGB u8 image to Linear u8 image.");
+            }
+
+            imageBuffer.count = 1;
+
+          } else {
+
+            // u8 sRGB -> fp32 Linear
+            imageBuffer.componentType = tydra::ComponentType::Float;
+
+            std::vector<float> buf;
+            bool ret = srgb_8bit_to_linear_f32(assetImageBuffer.data, width, height ,channels, /* channel stride */channels, &buf);
+            if (!ret) {
+              PUSH_ERROR_AND_RETURN("Failed to convert sRGB u8 image to Linear f32 image.");
+            }
+
+            imageBuffer.data.resize(buf.size() * sizeof(float));
+            memcpy(imageBuffer.data.data(), buf.data(), sizeof(float) * buf.size());
+            imageBuffer.count = 1;
+          }
+
+          texImage.colorSpace = tydra::ColorSpace::Linear;
+
+        } else if (texImage.usdColorSpace == tydra::ColorSpace::Linear) {
+
+          if (_material_config.preserve_texel_bitdepth) {
+
+            // no op.
+            imageBuffer = std::move(assetImageBuffer);
+
+          } else {
+
+            // u8 -> fp32
+            imageBuffer.componentType = tydra::ComponentType::Float;
+
+            std::vector<float> buf;
+            bool ret = u8_to_f32_image(assetImageBuffer.data, width, height ,channels, &buf);
+            if (!ret) {
+              PUSH_ERROR_AND_RETURN("Failed to convert u8 image to f32 image.");
+            }
+
+            imageBuffer.data.resize(buf.size() * sizeof(float));
+            memcpy(imageBuffer.data.data(), buf.data(), sizeof(float) * buf.size());
+            imageBuffer.count = 1;
+          }
+
+          texImage.colorSpace = tydra::ColorSpace::Linear;
+
+        } else {
+          PUSH_ERROR(fmt::format("TODO: Color space {}", to_string(texImage.usdColorSpace)));
+        }
+
+      } else if (assetImageBuffer.componentType == tydra::ComponentType::Float) {
+
+        // ignore preserve_texel_bitdepth
+
+        if (texImage.usdColorSpace == tydra::ColorSpace::sRGB) {
+
+          // srgb f32 -> linear f32
+          std::vector<float> in_buf;
+          std::vector<float> out_buf;
+          in_buf.resize(assetImageBuffer.data.size() / sizeof(float));
+          memcpy(in_buf.data(), assetImageBuffer.data.data(), in_buf.size() * sizeof(float));
+
+          out_buf.resize(assetImageBuffer.data.size() / sizeof(float));
+
+          bool ret = srgb_f32_to_linear_f32(in_buf, width, height ,channels, /* channel stride */channels, &out_buf);
+
+          imageBuffer.data.resize(assetImageBuffer.data.size());
+          memcpy(imageBuffer.data.data(), out_buf.data(), imageBuffer.data.size());
+
+          if (!ret) {
+            PUSH_ERROR_AND_RETURN("Failed to convert sRGB f32 image to Linear f32 image.");
+          }
+
+        } else if (texImage.usdColorSpace == tydra::ColorSpace::Linear) {
+
+          // no op
+          imageBuffer = std::move(assetImageBuffer);
+
+        } else {
+          PUSH_ERROR(fmt::format("TODO: Color space {}", to_string(texImage.usdColorSpace)));
+        }
+
+      } else {
+        PUSH_ERROR(fmt::format("TODO: asset texture texel format {}", to_string(assetImageBuffer.componentType)));
+      }
+
+
+    } else {
+
+      // Same color space.
+
+      if (assetImageBuffer.componentType == tydra::ComponentType::UInt8) {
+
+        if (_material_config.preserve_texel_bitdepth) {
+
+          // Do nothing.
+          imageBuffer = std::move(assetImageBuffer);
+
+        } else {
+
+          // u8 to f32
+          imageBuffer.componentType = tydra::ComponentType::Float;
+
+        }
+
+        texImage.colorSpace = texImage.usdColorSpace;
+
+      } else if (assetImageBuffer.componentType == tydra::ComponentType::Float) {
+
+        // ignore preserve_texel_bitdepth
+
+        // f32 to f32, so no op
+        imageBuffer = std::move(assetImageBuffer);
+
+      } else {
+        PUSH_ERROR(fmt::format("TODO: asset texture texel format {}", to_string(assetImageBuffer.componentType)));
+      }
+
+    }
+
+    // Assign buffer id
+    texImage.buffer_id = int64_t(buffers.size());
+
+    // TODO: Share image data as much as possible.
+    // e.g. Texture A and B uses same image file, but texturing parameter is
+    // different.
+    buffers.emplace_back(imageBuffer);
+
+
+    tex.texture_image_id = int64_t(images.size());
+
+    images.emplace_back(texImage);
+  }
+
+  //
+  // Convert other UVTexture parameters
+  //
+
+  if (texture.bias.authored()) {
+    tex.bias = texture.bias.get_value();
+  }
+
+  if (texture.scale.authored()) {
+    tex.scale = texture.scale.get_value();
+  }
+
+  if (texture.st.authored()) {
+    if (texture.st.is_connection()) {
+      const auto &paths = texture.st.get_connections();
+      if (paths.size() != 1) {
+        PUSH_ERROR_AND_RETURN(
+            "UsdUVTexture inputs:st connection must be single Path.");
+      }
+      const Path &path = paths[0];
+
+      const Prim *readerPrim{nullptr};
+      if (!_stage->find_prim_at_path(Path(path.prim_part(), ""), readerPrim,
+                                     &err)) {
+        PUSH_ERROR_AND_RETURN(
+            "UsdUVTexture inputs:st connection targetPath not found in the "
+            "Stage: " +
+            err);
+      }
+
+      if (!readerPrim) {
+        PUSH_ERROR_AND_RETURN(
+            "[InternlError] Invalid Prim connected to inputs:st");
+      }
+
+      const Shader *pshader = readerPrim->as<Shader>();
+      if (!pshader) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("UsdUVTexture inputs:st connected Prim must be "
+                        "Shader Prim, but got {} Prim",
+                        readerPrim->prim_type_name()));
+      }
+
+      // currently UsdTranform2d or PrimvarReaer_float2 only for inputs:st
+      if (const UsdPrimvarReader_float2 *preader =
+              pshader->value.as<UsdPrimvarReader_float2>()) {
+        if (!preader) {
+          PUSH_ERROR_AND_RETURN(
+              fmt::format("Shader's info:id must be UsdPrimvarReader_float2, "
+                          "but got {}",
+                          pshader->info_id));
+        }
+
+        // Get value producing attribute(i.e, follow .connection and return
+        // terminal Attribute value)
+        value::token varname;
+        TerminalAttributeValue attr;
+        if (!tydra::EvaluateAttribute(*_stage, *readerPrim, "inputs:varname",
+                                      &attr, &err)) {
+          PUSH_ERROR_AND_RETURN(
+              fmt::format("Failed to evaluate UsdPrimvarReader_float2's "
+                          "inputs:varname.\n{}",
+                          err));
+        }
+
+        if (auto pv = attr.as<value::token>()) {
+          varname = *pv;
+        } else if (auto ps = attr.as<std::string>()) {
+          // UsdPrimvarReader's `inputs:varname` is `string` type in the
+          // recent spec.
+          varname = value::token(*ps);
+        } else {
+          PUSH_ERROR_AND_RETURN(
+              "`inputs:varname` must be `token` or `string` type, but got " +
+              attr.type_name());
+        }
+        if (varname.str().empty()) {
+          PUSH_ERROR_AND_RETURN("`inputs:varname` is empty token.");
+        }
+        DCOUT("inputs:varname = " << varname);
+
+        tex.varname_uv = varname.str();
+      } else if (const UsdTransform2d *ptransform =
+                     pshader->value.as<UsdTransform2d>()) {
+        auto result = ConvertTexTransform2d(*_stage, path, *ptransform, &tex);
+        if (!result) {
+          PUSH_ERROR_AND_RETURN(result.error());
+        }
+      } else {
+        PUSH_ERROR_AND_RETURN(
+            "Unsupported Shader type for `inputs:st` connection: " +
+            pshader->info_id + "\n");
+      }
+
+    } else {
+      Animatable<value::texcoord2f> fallbacks = texture.st.get_value();
+      value::texcoord2f uv;
+      if (fallbacks.get_scalar(&uv)) {
+        tex.fallback_uv[0] = uv[0];
+        tex.fallback_uv[1] = uv[1];
+      } else {
+        // TODO: report warning.
+        PUSH_WARN(
+            "Failed to get fallback `st` texcoord attribute. Maybe `st` is "
+            "timeSamples attribute?\n");
+      }
+    }
+  }
+
+  if (texture.wrapS.authored()) {
+    tinyusdz::UsdUVTexture::Wrap wrap;
+
+    if (!texture.wrapS.get_value().get_scalar(&wrap)) {
+      PUSH_ERROR_AND_RETURN("Invalid UsdUVTexture inputs:wrapS value.");
+    }
+
+    if (wrap == UsdUVTexture::Wrap::Repeat) {
+      tex.wrapS = UVTexture::WrapMode::REPEAT;
+    } else if (wrap == UsdUVTexture::Wrap::Mirror) {
+      tex.wrapS = UVTexture::WrapMode::MIRROR;
+    } else if (wrap == UsdUVTexture::Wrap::Clamp) {
+      tex.wrapS = UVTexture::WrapMode::CLAMP_TO_EDGE;
+    } else if (wrap == UsdUVTexture::Wrap::Black) {
+      tex.wrapS = UVTexture::WrapMode::CLAMP_TO_BORDER;
+    } else {
+      tex.wrapS = UVTexture::WrapMode::CLAMP_TO_EDGE;
+    }
+  }
+
+  if (texture.wrapT.authored()) {
+    tinyusdz::UsdUVTexture::Wrap wrap;
+
+    if (!texture.wrapT.get_value().get_scalar(&wrap)) {
+      PUSH_ERROR_AND_RETURN("Invalid UsdUVTexture inputs:wrapT value.");
+    }
+
+    if (wrap == UsdUVTexture::Wrap::Repeat) {
+      tex.wrapT = UVTexture::WrapMode::REPEAT;
+    } else if (wrap == UsdUVTexture::Wrap::Mirror) {
+      tex.wrapT = UVTexture::WrapMode::MIRROR;
+    } else if (wrap == UsdUVTexture::Wrap::Clamp) {
+      tex.wrapT = UVTexture::WrapMode::CLAMP_TO_EDGE;
+    } else if (wrap == UsdUVTexture::Wrap::Black) {
+      tex.wrapT = UVTexture::WrapMode::CLAMP_TO_BORDER;
+    } else {
+      tex.wrapT = UVTexture::WrapMode::CLAMP_TO_EDGE;
+    }
+  }
+
+  DCOUT("Converted UVTexture.");
+
+  (*tex_out) = tex;
+  return true;
+}
+
+template <typename T, typename Dty>
+bool RenderSceneConverter::ConvertPreviewSurfaceShaderParam(
+    const Path &shader_abs_path,
+    const TypedAttributeWithFallback<Animatable<T>> &param,
+    const std::string &param_name, ShaderParam<Dty> &dst_param) {
+  if (!param.authored()) {
+    return true;
+  }
+
+  if (param.is_blocked()) {
+    PUSH_ERROR_AND_RETURN(fmt::format("{} attribute is blocked.", param_name));
+  } else if (param.is_connection()) {
+    DCOUT(fmt::format("{] is attribute connection.", param_name));
+
+    const UsdUVTexture *ptex{nullptr};
+    const Shader *pshader{nullptr};
+    Path texPath;
+    auto result = GetConnectedUVTexture(*_stage, param, &texPath, &ptex, &pshader);
+
+    if (!result) {
+      PUSH_ERROR_AND_RETURN(result.error());
+    }
+
+    if (!ptex) {
+      PUSH_ERROR_AND_RETURN("[InternalError] ptex is nullptr.");
+    }
+    DCOUT("ptex = " << ptex->name);
+
+    if (!pshader) {
+      PUSH_ERROR_AND_RETURN("[InternalError] pshader is nullptr.");
+    }
+
+    DCOUT("Get connected UsdUVTexture Prim: " << texPath);
+
+    UVTexture rtex;
+    const AssetInfo &assetInfo = pshader->metas().get_assetInfo();
+    if (!ConvertUVTexture(texPath, assetInfo, *ptex, &rtex)) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "Failed to convert UVTexture connected to {}", param_name));
+    }
+
+    uint64_t texId = textures.size();
+    textures.push_back(rtex);
+
+    textureMap.add(texId, shader_abs_path.prim_part() + "." + param_name);
+
+    DCOUT(fmt::format("TexId {} = {}",
+                      shader_abs_path.prim_part() + ".diffuseColor", texId));
+
+    dst_param.textureId = int32_t(texId);
+
+    return true;
+  } else {
+    T val;
+    if (!param.get_value().get_scalar(&val)) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("Failed to get {} at `default` timecode.", param_name));
+    }
+
+    dst_param.set_value(val);
+
+    return true;
+  }
+}
+
+// TODO: timeSamples
+bool RenderSceneConverter::ConvertPreviewSurfaceShader(
+    const Path &shader_abs_path, const UsdPreviewSurface &shader,
+    PreviewSurfaceShader *rshader_out) {
+  if (!rshader_out) {
+    PUSH_ERROR_AND_RETURN("rshader_out arg is nullptr.");
+  }
+
+  PreviewSurfaceShader rshader;
+
+  if (shader.useSpecularWorkflow.authored()) {
+    if (shader.useSpecularWorkflow.is_blocked()) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("useSpecularWorkflow attribute is blocked."));
+    } else if (shader.useSpecularWorkflow.is_connection()) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("TODO: useSpecularWorkflow with connection."));
+    } else {
+      int val;
+      if (!shader.useSpecularWorkflow.get_value().get_scalar(&val)) {
+        PUSH_ERROR_AND_RETURN(fmt::format(
+            "Failed to get useSpcularWorkFlow value at `default` timecode."));
+      }
+
+      rshader.useSpecularWorkFlow = val ? true : false;
+    }
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.diffuseColor,
+                                        "diffuseColor", rshader.diffuseColor)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.normal,
+                                        "normal", rshader.normal)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.roughness,
+                                        "roughness", rshader.roughness)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.metallic,
+                                        "metallic", rshader.metallic)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.clearcoat,
+                                        "clearcoat", rshader.clearcoat)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(
+          shader_abs_path, shader.clearcoatRoughness, "clearcoatRoughness",
+          rshader.clearcoatRoughness)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.opacity,
+                                        "opacity", rshader.opacity)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(
+          shader_abs_path, shader.opacityThreshold, "opacityThreshold",
+          rshader.opacityThreshold)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.ior, "ior",
+                                        rshader.ior)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.occlusion,
+                                        "occlusion", rshader.occlusion)) {
+    return false;
+  }
+
+  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.displacement,
+                                        "displacement", rshader.displacement)) {
+    return false;
+  }
+
+  (*rshader_out) = rshader;
+  return true;
+}
+
+bool RenderSceneConverter::ConvertMaterial(const Path &mat_abs_path,
+                                           const tinyusdz::Material &material,
+                                           RenderMaterial *rmat_out) {
+  if (!_stage) {
+    PUSH_ERROR_AND_RETURN("stage is nullptr.");
+  }
+
+  if (!rmat_out) {
+    PUSH_ERROR_AND_RETURN("rmat_out argument is nullptr.");
+  }
+
+  RenderMaterial rmat;
+  rmat.abs_path = mat_abs_path.prim_part();
+  rmat.name = mat_abs_path.element_name();
+  DCOUT("rmat.abs_path = " << rmat.abs_path);
+  DCOUT("rmat.name = " << rmat.name);
+
+  std::string err;
+
+  Path surfacePath;
+
+  //
+  // surface shader
+  {
+    if (material.surface.authored()) {
+      auto paths = material.surface.get_connections();
+      DCOUT("paths = " << paths);
+      // must have single targetPath.
+      if (paths.size() != 1) {
+        PUSH_ERROR_AND_RETURN(
+            fmt::format("{}'s outputs:surface must be connection with single "
+                        "target Path.\n",
+                        mat_abs_path.full_path_name()));
+      }
+      surfacePath = paths[0];
+    } else {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("{}'s outputs:surface isn't authored.\n",
+                      mat_abs_path.full_path_name()));
+    }
+
+    const Prim *shaderPrim{nullptr};
+    if (!_stage->find_prim_at_path(
+            Path(surfacePath.prim_part(), /* prop part */ ""), shaderPrim,
+            &err)) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "{}'s outputs:surface isn't connected to exising Prim path.\n",
+          mat_abs_path.full_path_name()));
+    }
+
+    if (!shaderPrim) {
+      // this should not happen though.
+      PUSH_ERROR_AND_RETURN("[InternalError] invalid Shader Prim.\n");
+    }
+
+    const Shader *shader = shaderPrim->as<Shader>();
+
+    if (!shader) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("{}'s outputs:surface must be connected to Shader Prim, "
+                      "but connected to `{}` Prim.\n",
+                      shaderPrim->prim_type_name()));
+    }
+
+    // Currently must be UsdPreviewSurface
+    const UsdPreviewSurface *psurface = shader->value.as<UsdPreviewSurface>();
+    if (!psurface) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("Shader's info:id must be UsdPreviewSurface, but got {}",
+                      shader->info_id));
+    }
+
+    // prop part must be `outputs:surface` for now.
+    if (surfacePath.prop_part() != "outputs:surface") {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("{}'s outputs:surface connection must point to property "
+                      "`outputs:surface`, but got `{}`",
+                      mat_abs_path.full_path_name(), surfacePath.prop_part()));
+    }
+
+    PreviewSurfaceShader pss;
+    if (!ConvertPreviewSurfaceShader(surfacePath, *psurface, &pss)) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "Failed to convert UsdPreviewSurface : {}", surfacePath.prim_part()));
+    }
+
+    rmat.surfaceShader = pss;
+  }
+
+  DCOUT("Converted Material: " << mat_abs_path);
+
+  (*rmat_out) = rmat;
+  return true;
+}
+
+namespace {
+
+struct MeshItem {
+  Path abs_path;
+  const GeomMesh *mesh{nullptr};
+  std::string element_name;
+  int64_t rmaterial_id{-1};  // -1 = no material bound.
+  std::vector<MaterialSubset> material_subsets;  // GeomSubset materials
+};
+
+struct MaterialItem {
+  Path abs_path;
+  const Material *material{nullptr};
+};
+
+struct InstancerItem {
+  Path abs_path;
+  const PointInstancer *instancer{nullptr};
+};
+
+// Prototype of `instanceable` Prims(meshes of its first instance).
+struct PrototypeItem {
+  std::string abs_path;  // Path of the first instanceable Prim.
+
+  // Relative path of GeomMesh from the instanceable Prim -> index to
+  // ConvertItems::meshes
+  std::map<std::string, size_t> meshes;
+};
+
+// GeomMesh in an instance of `instanceable` Prim.
+struct InstancedMeshItem {
+  Path abs_path;
+  size_t mesh{0};       // index to ConvertItems::meshes
+  size_t prototype{0};  // index to ConvertItems::prototypes
+};
+
+// Instanceable Prim being traversed. level = -1: not in instanceable Prim.
+struct InstanceRoot {
+  int32_t level{-1};
+  std::string abs_path;
+  size_t prototype{0};
+  bool source{false};  // The first instance of the prototype.
+};
+
+// Meshes and Materials to be converted, in the order of Prim traversal.
+struct ConvertItems {
+  RenderSceneConverter *converter{nullptr};
+  bool build_instances{false};
+  std::vector<MeshItem> meshes;
+  std::vector<MaterialItem> materials;  // Materials not yet converted.
+
+  std::vector<InstancerItem> instancers;
+  std::vector<PrototypeItem> prototypes;
+  std::unordered_map<std::string, size_t> prototype_ids;  // content key
+  std::vector<InstancedMeshItem> instanced_meshes;
+  InstanceRoot instance;
+};
+
+template <typename T>
+uint64_t HashElements(const std::vector<T> &v, uint64_t h) {
+  return HashBytes(reinterpret_cast<const uint8_t *>(v.data()),
+                   v.size() * sizeof(T), h);
+}
+
+// Hash a value with its type id. Scalar and array of numeric types are
+// hashed as bytes.
+uint64_t HashValue(const value::Value &v, uint64_t h) {
+  const uint32_t type_id = v.type_id();
+  h = HashBytes(reinterpret_cast<const uint8_t *>(&type_id), sizeof(uint32_t),
+                h);
+
+#define HASH_NUMERIC_VALUE(__ty)                                         \
+  if (const std::vector<__ty> *pv = v.as<std::vector<__ty>>()) {         \
+    return HashElements(*pv, h);                                         \
+  }                                                                      \
+  if (const __ty *pv = v.as<__ty>()) {                                   \
+    return HashBytes(reinterpret_cast<const uint8_t *>(pv), sizeof(__ty), \
+                     h);                                                 \
+  }
+
+  HASH_NUMERIC_VALUE(float)
+  HASH_NUMERIC_VALUE(value::float2)
+  HASH_NUMERIC_VALUE(value::float3)
+  HASH_NUMERIC_VALUE(value::float4)
+  HASH_NUMERIC_VALUE(double)
+  HASH_NUMERIC_VALUE(value::double2)
+  HASH_NUMERIC_VALUE(value::double3)
+  HASH_NUMERIC_VALUE(value::double4)
+  HASH_NUMERIC_VALUE(value::half)
+  HASH_NUMERIC_VALUE(value::half2)
+  HASH_NUMERIC_VALUE(value::half3)
+  HASH_NUMERIC_VALUE(value::half4)
+  HASH_NUMERIC_VALUE(int32_t)
+  HASH_NUMERIC_VALUE(value::int2)
+  HASH_NUMERIC_VALUE(value::int3)
+  HASH_NUMERIC_VALUE(value::int4)
+  HASH_NUMERIC_VALUE(uint32_t)
+
+#undef HASH_NUMERIC_VALUE
+
+  // Other types(e.g. string, token) are rarely used for primvars.
+  const std::string str = value::pprint_value(v);
+  return HashBytes(reinterpret_cast<const uint8_t *>(str.data()), str.size(),
+                   h);
+}
+
+// Hash the default value and timeSamples of a primvar.
+uint64_t HashPrimVar(const primvar::PrimVar &var, uint64_t h) {
+  const uint8_t blocked = var.is_blocked() ? 1 : 0;
+  h = HashBytes(&blocked, 1, h);
+
+  if (var.is_scalar()) {
+    h = HashValue(var.value_raw(), h);
+  }
+
+  if (var.is_timesamples()) {
+    for (const auto &sample : var.ts_raw().get_samples()) {
+      h = HashBytes(reinterpret_cast<const uint8_t *>(&sample.t),
+                    sizeof(double), h);
+      const uint8_t sample_blocked = sample.blocked ? 1 : 0;
+      h = HashBytes(&sample_blocked, 1, h);
+      if (!sample.blocked) {
+        h = HashValue(sample.value, h);
+      }
+    }
+  }
+
+  return h;
+}
+
+// Material path relative to the instanceable Prim when the Material is a
+// descendant of it(so that instances of the same asset get the same key).
+std::string InstanceMaterialKey(const Path &material_path,
+                                const std::string &instance_path) {
+  const std::string path = material_path.full_path_name();
+  if (startsWith(path, instance_path + "/")) {
+    return path.substr(instance_path.size());
+  }
+  return path;
+}
+
+//
+// Build the content key of `instanceable` Prim from GeomMeshes in its
+// subtree(relative path, geometry, normals, primvars and bound Materials).
+// Instances having the same key share the converted meshes.
+//
+// NOTE: Instances can override attributes of the prototype(e.g. a different
+// `primvars:st`) in the referencing layer, so every attribute used in the mesh
+// conversion is part of the key.
+//
+void BuildInstanceKeyRec(const Stage &stage, const std::string &instance_path,
+                         const Path &abs_path, const Prim &prim,
+                         uint32_t depth, std::string *key) {
+  if (depth > 1024 * 128) {
+    return;
+  }
+
+  if (const GeomMesh *mesh = prim.as<GeomMesh>()) {
+    const std::vector<value::point3f> points = mesh->get_points();
+    const std::vector<int32_t> counts = mesh->get_faceVertexCounts();
+    const std::vector<int32_t> indices = mesh->get_faceVertexIndices();
+
+    const std::vector<value::normal3f> normals = mesh->get_normals();
+
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = HashElements(points, h);
+    h = HashElements(counts, h);
+    h = HashElements(indices, h);
+    h = HashElements(normals, h);
+
+    (*key) += abs_path.full_path_name().substr(instance_path.size());
+    (*key) += fmt::format(" {} {} {} {} {} {}", points.size(), counts.size(),
+                          indices.size(), normals.size(),
+                          to_string(mesh->get_normalsInterpolation()), h);
+
+    // texcoords and other primvars.
+    for (const auto &primvar : mesh->get_primvars()) {
+      uint64_t ph = 0xcbf29ce484222325ull;
+      ph = HashPrimVar(primvar.get_attribute().get_var(), ph);
+      ph = HashElements(primvar.get_indices(), ph);
+
+      (*key) += fmt::format(" {}:{}:{}:{}", primvar.name(),
+                            to_string(primvar.get_interpolation()),
+                            primvar.get_elementSize(), ph);
+    }
+
+    Path material_path;
+    const Material *material{nullptr};
+    if (FindBoundMaterial(stage, abs_path, /* suffix */ "", &material_path,
+                          &material, /* err */ nullptr) &&
+        material) {
+      (*key) += " " + InstanceMaterialKey(material_path, instance_path);
+    }
+
+    for (const auto &child : prim.children()) {
+      if (!child.is<GeomSubset>()) {
+        continue;
+      }
+
+      if (GetBoundMaterial(stage, child, /* suffix */ "", &material_path,
+                           &material, /* err */ nullptr) &&
+          material) {
+        (*key) += " " + child.element_name() + "=" +
+                  InstanceMaterialKey(material_path, instance_path);
+      }
+    }
+
+    (*key) += "\n";
+  }
+
+  for (const auto &child : prim.children()) {
+    BuildInstanceKeyRec(stage, instance_path,
+                        abs_path.AppendPrim(child.element_name()), child,
+                        depth + 1, key);
+  }
+}
+
+//
+// Collect GeomMesh and its bound Material. RenderMaterial index is assigned
+// in the order of the first reference from GeomMesh, so the conversion result
+// does not depend on the conversion order.
+//
+bool CollectMeshVisitor(const tinyusdz::Path &abs_path,
+                        const tinyusdz::Prim &prim, const int32_t level,
+                        void *userdata, std::string *err) {
+  if (!userdata) {
+    return false;
+  }
+
+  ConvertItems *items = reinterpret_cast<ConvertItems *>(userdata);
+  RenderSceneConverter *converter = items->converter;
+
+  if (level > 1024 * 1024) {
+    if (err) {
+      (*err) += "Scene graph is too deep.\n";
+    }
+    // Too deep
+    return false;
+  }
+
+  if (items->build_instances) {
+    // Left the subtree of the instanceable Prim.
+    if ((items->instance.level >= 0) && (level <= items->instance.level)) {
+      items->instance = InstanceRoot();
+    }
+
+    if (const tinyusdz::PointInstancer *instancer =
+            prim.as<tinyusdz::PointInstancer>()) {
+      InstancerItem instancer_item;
+      instancer_item.abs_path = abs_path;
+      instancer_item.instancer = instancer;
+      items->instancers.emplace_back(std::move(instancer_item));
+    }
+
+    // Nested instanceable Prims are treated as a part of the outermost
+    // instanceable Prim.
+    if ((items->instance.level < 0) && prim.metas().instanceable &&
+        prim.metas().instanceable.value()) {
+      const std::string instance_path = abs_path.full_path_name();
+
+      std::string key;
+      BuildInstanceKeyRec(*converter->GetStagePtr(), instance_path, abs_path,
+                          prim, 0, &key);
+
+      if (!key.empty()) {
+        InstanceRoot &instance = items->instance;
+        instance.level = level;
+        instance.abs_path = instance_path;
+
+        const auto it = items->prototype_ids.find(key);
+        if (it == items->prototype_ids.end()) {
+          instance.prototype = items->prototypes.size();
+          instance.source = true;
+
+          PrototypeItem prototype;
+          prototype.abs_path = instance_path;
+          items->prototypes.emplace_back(std::move(prototype));
+          items->prototype_ids[key] = instance.prototype;
+        } else {
+          instance.prototype = it->second;
+          instance.source = false;
+        }
+      }
+    }
+  }
+
+  if (const tinyusdz::GeomMesh *pmesh = prim.as<tinyusdz::GeomMesh>()) {
+    DCOUT("Material: " << abs_path);
+
+    // Relative path from the instanceable Prim.
+    std::string instance_rel_path;
+    if (items->instance.level >= 0) {
+      instance_rel_path =
+          abs_path.full_path_name().substr(items->instance.abs_path.size());
+
+      // Reuse the mesh of the first instance.
+      if (!items->instance.source) {
+        const PrototypeItem &prototype =
+            items->prototypes[items->instance.prototype];
+        const auto it = prototype.meshes.find(instance_rel_path);
+        if (it != prototype.meshes.end()) {
+          InstancedMeshItem instanced;
+          instanced.abs_path = abs_path;
+          instanced.mesh = it->second;
+          instanced.prototype = items->instance.prototype;
+          items->instanced_meshes.emplace_back(std::move(instanced));
+          return true;
+        }
+      }
+    }
+
+    // Get RenderMaterial index of the bound Material. Assign a new index when
+    // the Material is not yet listed.
+    const auto get_material_id = [&](const tinyusdz::Path &material_path,
+                                     const tinyusdz::Material *material,
+                                     int64_t *rmaterial_id) {
+      // Materials converted so far + Materials to be converted.
+      const uint64_t num_materials =
+          uint64_t(converter->materials.size() + items->materials.size());
+
+      const auto matIt =
+          converter->materialMap.find(material_path.full_path_name());
+
+      if (matIt != converter->materialMap.s_end()) {
+        // Got material in the cache.
+        uint64_t mat_id = matIt->second;
+        if (mat_id >= num_materials) {  // this should not happen though
+          if (err) {
+            (*err) += "Material index out-of-range.\n";
+          }
+          return false;
+        }
+
+        if (mat_id >= (std::numeric_limits<int64_t>::max)()) {
+          if (err) {
+            (*err) += "Material index too large.\n";
+          }
+          return false;
+        }
+
+        (*rmaterial_id) = int64_t(mat_id);
+
+      } else {
+        // Assign new material ID
+        uint64_t mat_id = num_materials;
+
+        if (mat_id >= (std::numeric_limits<int64_t>::max)()) {
+          if (err) {
+            (*err) += "Material index too large.\n";
+          }
+          return false;
+        }
+        (*rmaterial_id) = int64_t(mat_id);
+
+        converter->materialMap.add(material_path.full_path_name(), mat_id);
+        DCOUT("Add material: " << mat_id << " " << material_path);
+
+        MaterialItem mat_item;
+        mat_item.abs_path = material_path;
+        mat_item.material = material;
+        items->materials.emplace_back(std::move(mat_item));
+      }
+
+      return true;
+    };
+
+    tinyusdz::Path bound_material_path;
+    const tinyusdz::Material *bound_material{nullptr};
+    bool ret = tinyusdz::tydra::FindBoundMaterial(
+        *converter->GetStagePtr(), /* GeomMesh prim path */ abs_path,
+        /* suffix */ "", &bound_material_path, &bound_material, err);
+
+    int64_t rmaterial_id = -1;
+
+    if (ret && bound_material) {
+      DCOUT("Bound material path: " << bound_material_path);
+
+      if (!get_material_id(bound_material_path, bound_material,
+                           &rmaterial_id)) {
+        return false;
+      }
+    }
+
+    // Per-face material(GeomSubset with familyName "materialBind")
+    std::vector<MaterialSubset> material_subsets;
+    for (const auto &child : prim.children()) {
+      const tinyusdz::GeomSubset *subset = child.as<tinyusdz::GeomSubset>();
+      if (!subset || !subset->familyName ||
+          (subset->familyName.value().str() != "materialBind")) {
+        continue;
+      }
+
+      tinyusdz::Path subset_material_path;
+      const tinyusdz::Material *subset_material{nullptr};
+      if (!tinyusdz::tydra::GetBoundMaterial(
+              *converter->GetStagePtr(), child, /* suffix */ "",
+              &subset_material_path, &subset_material, err) ||
+          !subset_material) {
+        continue;
+      }
+
+      DCOUT("GeomSubset " << subset->name
+                          << " bound material path: " << subset_material_path);
+
+      MaterialSubset material_subset;
+      if (!get_material_id(subset_material_path, subset_material,
+                           &material_subset.material_id)) {
+        return false;
+      }
+      material_subset.faces = subset->indices;
+      material_subsets.emplace_back(std::move(material_subset));
+    }
+
+    MeshItem mesh_item;
+    mesh_item.abs_path = abs_path;
+    mesh_item.mesh = pmesh;
+    mesh_item.element_name = prim.element_name();
+    mesh_item.rmaterial_id = rmaterial_id;
+    mesh_item.material_subsets = std::move(material_subsets);
+    items->meshes.emplace_back(std::move(mesh_item));
+
+    if ((items->instance.level >= 0) && items->instance.source) {
+      const size_t mesh_idx = items->meshes.size() - 1;
+      items->prototypes[items->instance.prototype].meshes[instance_rel_path] =
+          mesh_idx;
+
+      InstancedMeshItem instanced;
+      instanced.abs_path = abs_path;
+      instanced.mesh = mesh_idx;
+      instanced.prototype = items->instance.prototype;
+      items->instanced_meshes.emplace_back(std::move(instanced));
+    }
   }
 
-  if (!prim) {
-    return nonstd::make_unexpected("[InternalError] Prim ptr is null.\n");
+  return true;  // continue traversal
+}
+
+// `textureId` of each parameter of PreviewSurfaceShader(in a fixed order).
+std::vector<int32_t *> GetTextureIds(PreviewSurfaceShader &shader) {
+  return {&shader.diffuseColor.textureId,
+          &shader.normal.textureId,
+          &shader.metallic.textureId,
+          &shader.roughness.textureId,
+          &shader.clearcoat.textureId,
+          &shader.clearcoatRoughness.textureId,
+          &shader.opacity.textureId,
+          &shader.opacityThreshold.textureId,
+          &shader.ior.textureId,
+          &shader.displacement.textureId,
+          &shader.occlusion.textureId};
+}
+
+void OffsetTextureIds(PreviewSurfaceShader &shader, int32_t offset) {
+  for (int32_t *texture_id : GetTextureIds(shader)) {
+    if ((*texture_id) >= 0) {
+      (*texture_id) += offset;
+    }
   }
+}
 
-  if (tex_abs_path) {
-    (*tex_abs_path) = Path(prim_part, "");
+void PushUpdatedId(std::vector<int32_t> *ids, const int64_t id) {
+  if (ids) {
+    ids->push_back(int32_t(id));
   }
+}
 
-  if (const Shader *pshader = prim->as<Shader>()) {
-    if (const UsdUVTexture *ptex = pshader->value.as<UsdUVTexture>()) {
-      DCOUT("ptex = " << ptex);
-      (*dst) = ptex;
+void SortUpdatedIds(std::vector<int32_t> &ids) {
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
 
-      if (shader_out) {
-        (*shader_out) = pshader;
-      }
+bool IsSameBuffer(const BufferData &a, const BufferData &b) {
+  return (a.componentType == b.componentType) && (a.count == b.count) &&
+         (a.data == b.data);
+}
 
-      return true;
+// Compare TextureImages except for `buffer_id` and `handle`.
+bool IsSameTextureImage(const TextureImage &a, const TextureImage &b) {
+  return (a.asset_identifier == b.asset_identifier) &&
+         (a.texelComponentType == b.texelComponentType) &&
+         (a.assetTexelComponentType == b.assetTexelComponentType) &&
+         (a.colorSpace == b.colorSpace) &&
+         (a.usdColorSpace == b.usdColorSpace) && (a.width == b.width) &&
+         (a.height == b.height) && (a.channels == b.channels) &&
+         (a.miplevel == b.miplevel);
+}
+
+bool IsSameMatrix(const value::matrix4d &a, const value::matrix4d &b) {
+  return memcmp(a.m, b.m, sizeof(a.m)) == 0;
+}
+
+// Compare nodes except for `handle`.
+bool IsSameNodes(const std::vector<Node> &a, const std::vector<Node> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < a.size(); i++) {
+    if ((a[i].nodeType != b[i].nodeType) || (a[i].id != b[i].id) ||
+        (a[i].abs_path != b[i].abs_path) || (a[i].children != b[i].children) ||
+        !IsSameMatrix(a[i].local_matrix, b[i].local_matrix) ||
+        !IsSameMatrix(a[i].global_matrix, b[i].global_matrix)) {
+      return false;
     }
   }
 
-  return nonstd::make_unexpected(fmt::format(
-      "Prim {} must be Shader, but got {}", prim_part, prim->prim_type_name()));
+  return true;
 }
 
-}  // namespace
+bool IsSameInstances(const std::vector<MeshInstances> &a,
+                     const std::vector<MeshInstances> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
 
-// W.I.P.
-// Convert UsdUVTexture shader node.
-// @return true upon conversion success(textures.back() contains the converted
-// UVTexture)
-//
-// Possible network configuration
-//
-// - UsdUVTexture -> UsdPrimvarReader
-// - UsdUVTexture -> UsdTransform2d -> UsdPrimvarReader
-bool RenderSceneConverter::ConvertUVTexture(const Path &tex_abs_path,
-                                            const AssetInfo &assetInfo,
-                                            const UsdUVTexture &texture,
-                                            UVTexture *tex_out) {
-  DCOUT("ConvertUVTexture " << tex_abs_path);
+  for (size_t i = 0; i < a.size(); i++) {
+    if ((a[i].abs_path != b[i].abs_path) || (a[i].mesh_id != b[i].mesh_id) ||
+        (a[i].transforms.size() != b[i].transforms.size())) {
+      return false;
+    }
 
-  if (!tex_out) {
-    PUSH_ERROR_AND_RETURN("tex_out arg is nullptr.");
+    if (a[i].transforms.size() &&
+        memcmp(a[i].transforms.data(), b[i].transforms.data(),
+               sizeof(mat4) * a[i].transforms.size())) {
+      return false;
+    }
   }
-  std::string err;
 
-  UVTexture tex;
+  return true;
+}
 
-  // First load texture file.
-  if (!texture.file.authored()) {
-    PUSH_ERROR_AND_RETURN(fmt::format("`asset:file` is not authored. Path = {}",
-                                      tex_abs_path.prim_part()));
+template <typename T>
+bool IsSameSampler(const AnimationSampler<T> &a, const AnimationSampler<T> &b) {
+  if ((a.interpolation != b.interpolation) ||
+      (a.samples.size() != b.samples.size())) {
+    return false;
   }
 
-  value::AssetPath assetPath;
-  if (auto apath = texture.file.get_value()) {
-    if (!apath.value().get_scalar(&assetPath)) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("Failed to get `asset:file` value from Path {} (Maybe "
-                      "`asset:file` is timeSample value?)",
-                      tex_abs_path.prim_part()));
+  for (size_t i = 0; i < a.samples.size(); i++) {
+    if ((a.samples[i].t != b.samples[i].t) ||
+        memcmp(&a.samples[i].value, &b.samples[i].value, sizeof(T))) {
+      return false;
     }
-  } else {
-    PUSH_ERROR_AND_RETURN(
-        fmt::format("Failed to get `asset:file` value from Path {}",
-                    tex_abs_path.prim_part()));
   }
 
-  // TextureImage and BufferData
-  {
-    TextureImage texImage;
-    BufferData assetImageBuffer;
-
-    // Texel data is treated as byte array
-    assetImageBuffer.componentType = ComponentType::UInt8;
-    assetImageBuffer.count = 1;
+  return true;
+}
 
-    if (_scene_config.load_texture_assets) {
-      std::string warn;
+bool IsSameAnimations(const std::vector<Animation> &a,
+                      const std::vector<Animation> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
 
-      TextureImageLoaderFunction tex_loader_fun =
-          _material_config.texture_image_loader_function;
+  for (size_t i = 0; i < a.size(); i++) {
+    if ((a[i].path != b[i].path) ||
+        (a[i].channels.size() != b[i].channels.size())) {
+      return false;
+    }
 
-      if (!tex_loader_fun) {
-        tex_loader_fun = DefaultTextureImageLoaderFunction;
+    for (size_t c = 0; c < a[i].channels.size(); c++) {
+      const AnimationChannel &ca = a[i].channels[c];
+      const AnimationChannel &cb = b[i].channels[c];
+      if ((ca.taget_node != cb.taget_node) ||
+          !IsSameSampler(ca.transforms, cb.transforms) ||
+          !IsSameSampler(ca.translations, cb.translations) ||
+          !IsSameSampler(ca.rotations, cb.rotations) ||
+          !IsSameSampler(ca.scales, cb.scales)) {
+        return false;
       }
+    }
+  }
 
-      bool tex_ok = tex_loader_fun(
-          assetPath, assetInfo, _asset_resolver, &texImage, &assetImageBuffer.data,
-          _material_config.texture_image_loader_function_userdata, &warn, &err);
+  return true;
+}
 
-      if (!tex_ok && !_material_config.allow_texture_load_failure) {
-        PUSH_ERROR_AND_RETURN("Failed to load texture image: " + err);
-      }
+enum class PathChange {
+  None,
+  Self,  // The Prim(or its property), its descendant or ancestor is changed.
+  AncestorProperty,  // Only properties of ancestors(e.g. xformOps) are
+                     // changed.
+};
 
-      if (warn.size()) {
-        DCOUT("WARN: " << warn);
-        PushWarn(warn);
-      }
+//
+// A changed Prim path means any content of the Prim subtree may be changed.
+// A changed property path(e.g. `/root.xformOp:translate`) only changes the
+// property.
+//
+PathChange FindPathChange(const Path &path,
+                          const std::vector<Path> &changed_paths) {
+  PathChange change = PathChange::None;
+  for (const auto &changed : changed_paths) {
+    const bool is_property = changed.is_prim_property_path();
+    const Path changed_prim(changed.prim_part(), "");
+
+    if (changed_prim.has_prefix(path)) {
+      return PathChange::Self;
+    }
 
-      if (err.size()) {
-        // report as warning.
-        PushWarn(err);
+    if (path.has_prefix(changed_prim)) {
+      if (!is_property) {
+        return PathChange::Self;
       }
+      change = PathChange::AncestorProperty;
+    }
+  }
 
-      // store unresolved asset path.
-      texImage.asset_identifier = assetPath.GetAssetPath();
+  return change;
+}
 
-    } else {
-      // store resolved asset path.
-      texImage.asset_identifier =
-          _asset_resolver.resolve(assetPath.GetAssetPath());
-    }
+// Material ids of the mesh(bound Material, then GeomSubset Materials).
+std::vector<int64_t> GetMeshMaterialIds(const MeshItem &item) {
+  std::vector<int64_t> ids;
+  ids.push_back(item.rmaterial_id);
+  for (const auto &subset : item.material_subsets) {
+    ids.push_back(subset.material_id);
+  }
+  return ids;
+}
 
-    // colorSpace
-    if (texture.sourceColorSpace.authored()) {
-      UsdUVTexture::SourceColorSpace cs;
-      if (texture.sourceColorSpace.get_value().get_scalar(&cs)) {
-        if (cs == UsdUVTexture::SourceColorSpace::SRGB) {
-          texImage.usdColorSpace = tydra::ColorSpace::sRGB;
-        } else if (cs == UsdUVTexture::SourceColorSpace::Raw) {
-          texImage.usdColorSpace = tydra::ColorSpace::Linear;
-        } else if (cs == UsdUVTexture::SourceColorSpace::Auto) {
-          // TODO: Read colorspace from a file.
-          if ((texImage.assetTexelComponentType == ComponentType::UInt8) ||
-              (texImage.assetTexelComponentType == ComponentType::Int8)) {
-            texImage.usdColorSpace = tydra::ColorSpace::sRGB;
-          } else {
-            texImage.usdColorSpace = tydra::ColorSpace::Linear;
-          }
-        }
+//
+// Store RenderMaterial converted by `worker`(and its textures, images and
+// buffers) as the `material_id`-th material of `dst`.
+//
+// A new material is appended along with its textures, images and buffers.
+// When the material already exists, it is replaced and a texture of the same
+// shader parameter overwrites the previous texture(and its image and
+// buffer) in place. `update` receives the ids of the modified elements.
+//
+void StoreMaterial(RenderSceneConverter &worker, RenderMaterial &&rmat,
+                   const size_t material_id, RenderSceneConverter &dst,
+                   RenderSceneUpdate *update) {
+  std::vector<int32_t> *updated_materials =
+      update ? &update->materials : nullptr;
+  std::vector<int32_t> *updated_textures = update ? &update->textures : nullptr;
+  std::vector<int32_t> *updated_images = update ? &update->images : nullptr;
+  std::vector<int32_t> *updated_buffers = update ? &update->buffers : nullptr;
+
+  if (material_id >= dst.materials.size()) {
+    const int64_t texture_offset = int64_t(dst.textures.size());
+    const int64_t image_offset = int64_t(dst.images.size());
+    const int64_t buffer_offset = int64_t(dst.buffers.size());
+
+    for (auto &image : worker.images) {
+      if (image.buffer_id >= 0) {
+        image.buffer_id += buffer_offset;
       }
+      PushUpdatedId(updated_images, int64_t(dst.images.size()));
+      dst.images.emplace_back(std::move(image));
     }
 
-    BufferData imageBuffer;
-
-    // Linearlization and widen texel bit depth if required.
-    if (_material_config.linearize_color_space) {
+    for (auto &buffer : worker.buffers) {
+      PushUpdatedId(updated_buffers, int64_t(dst.buffers.size()));
+      dst.buffers.emplace_back(std::move(buffer));
+    }
 
-      size_t width = size_t(texImage.width);
-      size_t height = size_t(texImage.height);
-      size_t channels = size_t(texImage.channels);
-      if (channels == 4) {
-        PUSH_ERROR_AND_RETURN(fmt::format("TODO: RGBA color channels are not supported yet."));
-      }
-      if (channels > 4) {
-        PUSH_ERROR_AND_RETURN(fmt::format("TODO: Multiband color channels(5 or more) are not supported(yet)."));
+    for (auto &texture : worker.textures) {
+      if (texture.texture_image_id >= 0) {
+        texture.texture_image_id += image_offset;
       }
+      PushUpdatedId(updated_textures, int64_t(dst.textures.size()));
+      dst.textures.emplace_back(std::move(texture));
+    }
 
-      if (assetImageBuffer.componentType == tydra::ComponentType::UInt8) {
+    for (auto it = worker.textureMap.i_begin();
+         it != worker.textureMap.i_end(); it++) {
+      dst.textureMap.add(it->first + uint64_t(texture_offset), it->second);
+    }
 
-        if (texImage.usdColorSpace == tydra::ColorSpace::sRGB) {
+    OffsetTextureIds(rmat.surfaceShader, int32_t(texture_offset));
 
-          if (_material_config.preserve_texel_bitdepth) {
+    DCOUT("Add material: " << rmat.abs_path << " ( " << rmat.name << " ) ");
+    PushUpdatedId(updated_materials, int64_t(dst.materials.size()));
+    dst.materials.emplace_back(std::move(rmat));
+    return;
+  }
 
-            // u8 sRGB -> u8 Linear
-            imageBuffer.componentType = tydra::ComponentType::UInt8;
+  RenderMaterial &prev = dst.materials[material_id];
 
-            bool ret = srgb_8bit_to_linear_8bit(assetImageBuffer.data, width, height ,channels, /* channel stride */channels, &imageBuffer.data);
-            if (!ret) {
-              PUSH_ERROR_AND_RETURN("Failed to convert sRGB u8 image to Linear u8 image.");
-            }
+  // worker's texture id -> texture id of `dst`. -1 = append.
+  std::vector<int64_t> texture_ids(worker.textures.size(), -1);
+  {
+    const std::vector<int32_t *> prev_ids = GetTextureIds(prev.surfaceShader);
+    const std::vector<int32_t *> ids = GetTextureIds(rmat.surfaceShader);
+    for (size_t k = 0; k < ids.size(); k++) {
+      const int32_t id = *ids[k];
+      const int32_t prev_id = *prev_ids[k];
+      if ((id >= 0) && (size_t(id) < texture_ids.size()) && (prev_id >= 0) &&
+          (size_t(prev_id) < dst.textures.size())) {
+        texture_ids[size_t(id)] = prev_id;
+      }
+    }
+  }
 
-            imageBuffer.count = 1;
+  for (size_t t = 0; t < worker.textures.size(); t++) {
+    UVTexture &texture = worker.textures[t];
 
-          } else {
+    int64_t prev_image_id = -1;
+    if (texture_ids[t] >= 0) {
+      prev_image_id = dst.textures[size_t(texture_ids[t])].texture_image_id;
+      if (size_t(prev_image_id) >= dst.images.size()) {
+        prev_image_id = -1;
+      }
+    }
 
-            // u8 sRGB -> fp32 Linear
-            imageBuffer.componentType = tydra::ComponentType::Float;
+    if ((texture.texture_image_id >= 0) &&
+        (size_t(texture.texture_image_id) < worker.images.size())) {
+      TextureImage &image = worker.images[size_t(texture.texture_image_id)];
 
-            std::vector<float> buf;
-            bool ret = srgb_8bit_to_linear_f32(assetImageBuffer.data, width, height ,channels, /* channel stride */channels, &buf);
-            if (!ret) {
-              PUSH_ERROR_AND_RETURN("Failed to convert sRGB u8 image to Linear f32 image.");
-            }
+      int64_t prev_buffer_id = -1;
+      if (prev_image_id >= 0) {
+        prev_buffer_id = dst.images[size_t(prev_image_id)].buffer_id;
+        if (size_t(prev_buffer_id) >= dst.buffers.size()) {
+          prev_buffer_id = -1;
+        }
+      }
 
-            imageBuffer.data.resize(buf.size() * sizeof(float));
-            memcpy(imageBuffer.data.data(), buf.data(), sizeof(float) * buf.size());
-            imageBuffer.count = 1;
+      bool buffer_updated = false;
+      if ((image.buffer_id >= 0) &&
+          (size_t(image.buffer_id) < worker.buffers.size())) {
+        BufferData &buffer = worker.buffers[size_t(image.buffer_id)];
+        if (prev_buffer_id >= 0) {
+          BufferData &prev_buffer = dst.buffers[size_t(prev_buffer_id)];
+          if (!IsSameBuffer(prev_buffer, buffer)) {
+            prev_buffer = std::move(buffer);
+            buffer_updated = true;
+            PushUpdatedId(updated_buffers, prev_buffer_id);
           }
+          image.buffer_id = prev_buffer_id;
+        } else {
+          image.buffer_id = int64_t(dst.buffers.size());
+          buffer_updated = true;
+          PushUpdatedId(updated_buffers, int64_t(dst.buffers.size()));
+          dst.buffers.emplace_back(std::move(buffer));
+        }
+      } else {
+        image.buffer_id = -1;
+      }
 
-          texImage.colorSpace = tydra::ColorSpace::Linear;
-
-        } else if (texImage.usdColorSpace == tydra::ColorSpace::Linear) {
-
-          if (_material_config.preserve_texel_bitdepth) {
-
-            // no op.
-            imageBuffer = std::move(assetImageBuffer);
+      if (prev_image_id >= 0) {
+        TextureImage &prev_image = dst.images[size_t(prev_image_id)];
+        if (buffer_updated || (prev_image.buffer_id != image.buffer_id) ||
+            !IsSameTextureImage(prev_image, image)) {
+          image.handle = prev_image.handle;
+          prev_image = std::move(image);
+          PushUpdatedId(updated_images, prev_image_id);
+        }
+        texture.texture_image_id = prev_image_id;
+      } else {
+        texture.texture_image_id = int64_t(dst.images.size());
+        PushUpdatedId(updated_images, int64_t(dst.images.size()));
+        dst.images.emplace_back(std::move(image));
+      }
+    } else {
+      texture.texture_image_id = -1;
+    }
 
-          } else {
+    if (texture_ids[t] >= 0) {
+      UVTexture &prev_texture = dst.textures[size_t(texture_ids[t])];
+      texture.handle = prev_texture.handle;
+      prev_texture = std::move(texture);
+    } else {
+      texture_ids[t] = int64_t(dst.textures.size());
+      dst.textures.emplace_back(std::move(texture));
 
-            // u8 -> fp32
-            imageBuffer.componentType = tydra::ComponentType::Float;
+      const auto it = worker.textureMap.find(uint64_t(t));
+      if (it != worker.textureMap.i_end()) {
+        dst.textureMap.add(uint64_t(texture_ids[t]), it->second);
+      }
+    }
+    PushUpdatedId(updated_textures, texture_ids[t]);
+  }
 
-            std::vector<float> buf;
-            bool ret = u8_to_f32_image(assetImageBuffer.data, width, height ,channels, &buf);
-            if (!ret) {
-              PUSH_ERROR_AND_RETURN("Failed to convert u8 image to f32 image.");
-            }
+  for (int32_t *texture_id : GetTextureIds(rmat.surfaceShader)) {
+    if (((*texture_id) >= 0) && (size_t(*texture_id) < texture_ids.size())) {
+      (*texture_id) = int32_t(texture_ids[size_t(*texture_id)]);
+    }
+  }
 
-            imageBuffer.data.resize(buf.size() * sizeof(float));
-            memcpy(imageBuffer.data.data(), buf.data(), sizeof(float) * buf.size());
-            imageBuffer.count = 1;
-          }
+  DCOUT("Update material: " << rmat.abs_path << " ( " << rmat.name << " ) ");
+  rmat.handle = prev.handle;
+  rmat.surfaceShader.handle = prev.surfaceShader.handle;
+  prev = std::move(rmat);
+  PushUpdatedId(updated_materials, int64_t(material_id));
+}
 
-          texImage.colorSpace = tydra::ColorSpace::Linear;
+void CollectWorldMatricesRec(
+    const XformNode &node,
+    std::unordered_map<std::string, value::matrix4d> &world_matrices,
+    uint32_t depth) {
+  if (depth > 1024 * 1024) {
+    return;
+  }
 
-        } else {
-          PUSH_ERROR(fmt::format("TODO: Color space {}", to_string(texImage.usdColorSpace)));
-        }
+  if (node.prim) {
+    world_matrices[node.absolute_path.full_path_name()] =
+        node.get_world_matrix();
+  }
 
-      } else if (assetImageBuffer.componentType == tydra::ComponentType::Float) {
+  for (const auto &child : node.children) {
+    CollectWorldMatricesRec(child, world_matrices, depth + 1);
+  }
+}
 
-        // ignore preserve_texel_bitdepth
+mat4 ToMat4(const value::matrix4d &m) {
+  mat4 dst;
+  for (size_t i = 0; i < 4; i++) {
+    for (size_t j = 0; j < 4; j++) {
+      dst.m[i][j] = float(m.m[i][j]);
+    }
+  }
+  return dst;
+}
 
-        if (texImage.usdColorSpace == tydra::ColorSpace::sRGB) {
+template <typename T>
+bool GetInstancerArray(const TypedAttribute<Animatable<std::vector<T>>> &attr,
+                       std::vector<T> *dst) {
+  // TODO: timeSamples, connections
+  if (!attr.authored() || attr.is_blocked() || attr.is_connection()) {
+    return false;
+  }
 
-          // srgb f32 -> linear f32
-          std::vector<float> in_buf;
-          std::vector<float> out_buf;
-          in_buf.resize(assetImageBuffer.data.size() / sizeof(float));
-          memcpy(in_buf.data(), assetImageBuffer.data.data(), in_buf.size() * sizeof(float));
+  if (const auto pv = attr.get_value()) {
+    return pv.value().get(value::TimeCode::Default(), dst);
+  }
 
-          out_buf.resize(assetImageBuffer.data.size() / sizeof(float));
+  return false;
+}
 
-          bool ret = srgb_f32_to_linear_f32(in_buf, width, height ,channels, /* channel stride */channels, &out_buf);
+//
+// Compose instance matrices of PointInstancer and its world matrix:
+// out[i] = scale[i] x orientation[i] x translate[i] x world
+//
+// Instances are processed in blocks of structure-of-arrays so that the
+// compiler can vectorize the arithmetic loop.
+//
+void BuildInstanceMatrices(const size_t n, const value::point3f *positions,
+                           const value::quath *orientations,
+                           const value::float3 *scales,
+                           const value::matrix4f &world, mat4 *out) {
+  constexpr size_t kBlockSize = 256;
+
+  float q[4][kBlockSize];
+  float s[3][kBlockSize];
+  float t[3][kBlockSize];
+  float m[16][kBlockSize];
+
+  float w[16];
+  for (size_t i = 0; i < 16; i++) {
+    w[i] = world.m[i / 4][i % 4];
+  }
 
-          imageBuffer.data.resize(assetImageBuffer.data.size());
-          memcpy(imageBuffer.data.data(), out_buf.data(), imageBuffer.data.size());
+  for (size_t offset = 0; offset < n; offset += kBlockSize) {
+    const size_t count = (std::min)(kBlockSize, n - offset);
 
-          if (!ret) {
-            PUSH_ERROR_AND_RETURN("Failed to convert sRGB f32 image to Linear f32 image.");
-          }
+    // Gather
+    for (size_t k = 0; k < count; k++) {
+      const size_t i = offset + k;
+      t[0][k] = positions[i][0];
+      t[1][k] = positions[i][1];
+      t[2][k] = positions[i][2];
+    }
 
-        } else if (texImage.usdColorSpace == tydra::ColorSpace::Linear) {
+    if (orientations) {
+      for (size_t k = 0; k < count; k++) {
+        const value::quath &o = orientations[offset + k];
+        q[0][k] = value::half_to_float(o.imag[0]);
+        q[1][k] = value::half_to_float(o.imag[1]);
+        q[2][k] = value::half_to_float(o.imag[2]);
+        q[3][k] = value::half_to_float(o.real);
+      }
+    } else {
+      for (size_t k = 0; k < count; k++) {
+        q[0][k] = q[1][k] = q[2][k] = 0.0f;
+        q[3][k] = 1.0f;
+      }
+    }
 
-          // no op
-          imageBuffer = std::move(assetImageBuffer);
+    if (scales) {
+      for (size_t k = 0; k < count; k++) {
+        s[0][k] = scales[offset + k][0];
+        s[1][k] = scales[offset + k][1];
+        s[2][k] = scales[offset + k][2];
+      }
+    } else {
+      for (size_t k = 0; k < count; k++) {
+        s[0][k] = s[1][k] = s[2][k] = 1.0f;
+      }
+    }
 
-        } else {
-          PUSH_ERROR(fmt::format("TODO: Color space {}", to_string(texImage.usdColorSpace)));
+    // Compute(no branch, no gather/scatter)
+    for (size_t k = 0; k < count; k++) {
+      const float len2 =
+          q[0][k] * q[0][k] + q[1][k] * q[1][k] + q[2][k] * q[2][k] +
+          q[3][k] * q[3][k];
+      // Zero-length quaternion = no rotation.
+      const float inv = (len2 > 0.0f) ? (2.0f / len2) : 0.0f;
+      const float x = q[0][k], y = q[1][k], z = q[2][k], qw = q[3][k];
+
+      // Rotation in row-major(p' = p x R)
+      const float r00 = 1.0f - inv * (y * y + z * z);
+      const float r01 = inv * (x * y + z * qw);
+      const float r02 = inv * (x * z - y * qw);
+      const float r10 = inv * (x * y - z * qw);
+      const float r11 = 1.0f - inv * (x * x + z * z);
+      const float r12 = inv * (y * z + x * qw);
+      const float r20 = inv * (x * z + y * qw);
+      const float r21 = inv * (y * z - x * qw);
+      const float r22 = 1.0f - inv * (x * x + y * y);
+
+      // (S x R x T) x W
+      const float l[3][3] = {{s[0][k] * r00, s[0][k] * r01, s[0][k] * r02},
+                             {s[1][k] * r10, s[1][k] * r11, s[1][k] * r12},
+                             {s[2][k] * r20, s[2][k] * r21, s[2][k] * r22}};
+      for (size_t r = 0; r < 3; r++) {
+        for (size_t c = 0; c < 4; c++) {
+          m[r * 4 + c][k] = l[r][0] * w[0 * 4 + c] + l[r][1] * w[1 * 4 + c] +
+                            l[r][2] * w[2 * 4 + c];
         }
+      }
+      for (size_t c = 0; c < 4; c++) {
+        m[12 + c][k] = t[0][k] * w[0 * 4 + c] + t[1][k] * w[1 * 4 + c] +
+                       t[2][k] * w[2 * 4 + c] + w[3 * 4 + c];
+      }
+    }
 
-      } else {
-        PUSH_ERROR(fmt::format("TODO: asset texture texel format {}", to_string(assetImageBuffer.componentType)));
+    // Scatter
+    for (size_t k = 0; k < count; k++) {
+      mat4 &dst = out[offset + k];
+      for (size_t i = 0; i < 16; i++) {
+        dst.m[i / 4][i % 4] = m[i][k];
       }
+    }
+  }
+}
 
+value::matrix4d FindWorldMatrix(
+    const std::unordered_map<std::string, value::matrix4d> &world_matrices,
+    const std::string &abs_path) {
+  const auto it = world_matrices.find(abs_path);
+  if (it == world_matrices.end()) {
+    return value::matrix4d::identity();
+  }
+  return it->second;
+}
 
-    } else {
+//
+// Build MeshInstances of the prototype meshes of PointInstancer.
+// `mesh_ids` is the RenderScene mesh index of each mesh item. Prototype
+// meshes are flagged in `prototype_meshes`(indexed by RenderScene mesh
+// index).
+//
+// The prototype root Prim's transform is applied, but not the transforms of
+// its ancestors(e.g. the PointInstancer itself).
+//
+// A malformed PointInstancer is skipped with a warning(its prototype meshes
+// are drawn as regular meshes).
+//
+void ConvertPointInstancer(
+    const InstancerItem &item, const std::vector<MeshItem> &mesh_items,
+    const std::unordered_map<std::string, value::matrix4d> &world_matrices,
+    const std::vector<size_t> &mesh_ids, const bool baked,
+    std::vector<MeshInstances> *instances,
+    std::vector<uint8_t> &prototype_meshes, std::string *warn) {
+  const PointInstancer &instancer = *item.instancer;
+  const std::string instancer_path = item.abs_path.full_path_name();
+
+  std::vector<Path> prototypes;
+  if (instancer.prototypes) {
+    const Relationship &rel = instancer.prototypes.value();
+    if (rel.is_path()) {
+      prototypes.push_back(rel.targetPath);
+    } else if (rel.is_pathvector()) {
+      prototypes = rel.targetPathVector;
+    }
+  }
 
-      // Same color space.
+  if (prototypes.empty()) {
+    return;
+  }
 
-      if (assetImageBuffer.componentType == tydra::ComponentType::UInt8) {
+  std::vector<int32_t> proto_indices;
+  std::vector<value::point3f> positions;
+  std::vector<value::quath> orientations;
+  std::vector<value::float3> scales;
+  std::vector<int64_t> ids;
+  std::vector<int64_t> invisible_ids;
+
+  GetInstancerArray(instancer.protoIndices, &proto_indices);
+  GetInstancerArray(instancer.positions, &positions);
+  GetInstancerArray(instancer.orientations, &orientations);
+  GetInstancerArray(instancer.scales, &scales);
+  GetInstancerArray(instancer.ids, &ids);
+  GetInstancerArray(instancer.invisibleIds, &invisible_ids);
+
+  const size_t n = proto_indices.size();
+
+  if (positions.size() != n) {
+    if (warn) {
+      (*warn) += fmt::format(
+          "PointInstancer `{}` is ignored: The length of `positions`({}) must "
+          "be same with `protoIndices`({}).\n",
+          instancer_path, positions.size(), n);
+    }
+    return;
+  }
 
-        if (_material_config.preserve_texel_bitdepth) {
+  if (!orientations.empty() && (orientations.size() != n)) {
+    if (warn) {
+      (*warn) += fmt::format(
+          "PointInstancer `{}`: `orientations` is ignored since its length "
+          "differs from `protoIndices`.\n",
+          instancer_path);
+    }
+    orientations.clear();
+  }
 
-          // Do nothing.
-          imageBuffer = std::move(assetImageBuffer);
+  if (!scales.empty() && (scales.size() != n)) {
+    if (warn) {
+      (*warn) += fmt::format(
+          "PointInstancer `{}`: `scales` is ignored since its length differs "
+          "from `protoIndices`.\n",
+          instancer_path);
+    }
+    scales.clear();
+  }
 
-        } else {
+  if (ids.size() != n) {
+    ids.clear();
+  }
 
-          // u8 to f32
-          imageBuffer.componentType = tydra::ComponentType::Float;
+  std::sort(invisible_ids.begin(), invisible_ids.end());
 
-        }
+  // Visible instances of each prototype.
+  std::vector<std::vector<uint32_t>> proto_instances(prototypes.size());
+  size_t num_invalid = 0;
+  for (size_t i = 0; i < n; i++) {
+    const int64_t id = ids.empty() ? int64_t(i) : ids[i];
+    if (std::binary_search(invisible_ids.begin(), invisible_ids.end(), id)) {
+      continue;
+    }
 
-        texImage.colorSpace = texImage.usdColorSpace;
+    if ((proto_indices[i] < 0) ||
+        (size_t(proto_indices[i]) >= prototypes.size())) {
+      num_invalid++;
+      continue;
+    }
 
-      } else if (assetImageBuffer.componentType == tydra::ComponentType::Float) {
+    proto_instances[size_t(proto_indices[i])].push_back(uint32_t(i));
+  }
 
-        // ignore preserve_texel_bitdepth
+  if (num_invalid && warn) {
+    (*warn) += fmt::format(
+        "PointInstancer `{}`: {} instances with invalid `protoIndices` are "
+        "ignored.\n",
+        instancer_path, num_invalid);
+  }
 
-        // f32 to f32, so no op
-        imageBuffer = std::move(assetImageBuffer);
+  std::vector<mat4> instance_matrices(n);
+  BuildInstanceMatrices(
+      n, positions.data(), orientations.empty() ? nullptr : orientations.data(),
+      scales.empty() ? nullptr : scales.data(),
+      ToMat4(FindWorldMatrix(world_matrices, instancer_path)),
+      instance_matrices.data());
 
-      } else {
-        PUSH_ERROR(fmt::format("TODO: asset texture texel format {}", to_string(assetImageBuffer.componentType)));
+  for (size_t p = 0; p < prototypes.size(); p++) {
+    const Path &proto_path = prototypes[p];
+
+    const value::matrix4d inv_parent_world = inverse(FindWorldMatrix(
+        world_matrices, proto_path.get_parent_prim_path().full_path_name()));
+
+    for (size_t m = 0; m < mesh_items.size(); m++) {
+      if (!mesh_items[m].abs_path.has_prefix(proto_path)) {
+        continue;
+      }
+
+      const size_t mesh_id = mesh_ids[m];
+      prototype_meshes[mesh_id] = 1;
+
+      // Transform from the RenderMesh points to the space of the prototype
+      // root's parent.
+      const value::matrix4d pre =
+          baked ? inv_parent_world
+                : FindWorldMatrix(world_matrices,
+                                  mesh_items[m].abs_path.full_path_name()) *
+                      inv_parent_world;
+      const mat4 pre_f = ToMat4(pre);
+
+      MeshInstances mesh_instances;
+      mesh_instances.abs_path = instancer_path;
+      mesh_instances.mesh_id = int32_t(mesh_id);
+      mesh_instances.transforms.resize(proto_instances[p].size());
+      for (size_t k = 0; k < proto_instances[p].size(); k++) {
+        mesh_instances.transforms[k] =
+            pre_f * instance_matrices[proto_instances[p][k]];
       }
 
+      instances->emplace_back(std::move(mesh_instances));
     }
+  }
+}
 
-    // Assign buffer id
-    texImage.buffer_id = int64_t(buffers.size());
+//
+// Build MeshInstances of meshes shared by `instanceable` Prims. Meshes which
+// appear in only one instance are left as regular meshes.
+//
+void BuildPrototypeInstances(
+    const ConvertItems &items,
+    const std::unordered_map<std::string, value::matrix4d> &world_matrices,
+    const std::vector<size_t> &mesh_ids, const bool baked,
+    std::vector<MeshInstances> *instances,
+    std::vector<uint8_t> &prototype_meshes) {
+  // mesh item index -> instanced meshes
+  std::vector<std::vector<const InstancedMeshItem *>> mesh_instances(
+      items.meshes.size());
+  for (const auto &instanced : items.instanced_meshes) {
+    mesh_instances[instanced.mesh].push_back(&instanced);
+  }
 
-    // TODO: Share image data as much as possible.
-    // e.g. Texture A and B uses same image file, but texturing parameter is
-    // different.
-    buffers.emplace_back(imageBuffer);
+  for (size_t m = 0; m < mesh_instances.size(); m++) {
+    const auto &list = mesh_instances[m];
+    if (list.size() < 2) {
+      continue;
+    }
 
+    const size_t mesh_id = mesh_ids[m];
+    prototype_meshes[mesh_id] = 1;
+
+    const value::matrix4d pre =
+        baked ? inverse(FindWorldMatrix(world_matrices,
+                                        items.meshes[m].abs_path.full_path_name()))
+              : value::matrix4d::identity();
+
+    MeshInstances dst;
+    dst.abs_path = items.prototypes[list[0]->prototype].abs_path;
+    dst.mesh_id = int32_t(mesh_id);
+    dst.transforms.resize(list.size());
+    for (size_t k = 0; k < list.size(); k++) {
+      dst.transforms[k] = ToMat4(
+          pre * FindWorldMatrix(world_matrices,
+                                list[k]->abs_path.full_path_name()));
+    }
 
-    tex.texture_image_id = int64_t(images.size());
+    instances->emplace_back(std::move(dst));
+  }
+}
 
-    images.emplace_back(texImage);
+//
+// Build RenderScene nodes from XformNode hierarchy in depth-first order.
+// `node_prims` receives the Prim of each node(nullptr for the Stage root).
+//
+// Returns node index. -1 when neither the XformNode nor its descendants has
+// Xform.
+//
+int64_t BuildNodesRec(const XformNode &xnode,
+                      const std::unordered_map<std::string, size_t> &mesh_ids,
+                      std::vector<Node> &nodes,
+                      std::vector<const Prim *> &node_prims, uint32_t depth) {
+  if (depth > 1024 * 1024) {
+    return -1;
   }
 
-  //
-  // Convert other UVTexture parameters
-  //
+  const size_t idx = nodes.size();
+  {
+    Node node;
+    node.abs_path = xnode.absolute_path.full_path_name();
+    node.local_matrix = xnode.get_local_matrix();
+    node.global_matrix = xnode.get_world_matrix();
+
+    if (xnode.prim && xnode.prim->is<GeomMesh>()) {
+      const auto it = mesh_ids.find(node.abs_path);
+      if ((it != mesh_ids.end()) &&
+          (it->second < size_t((std::numeric_limits<int32_t>::max)()))) {
+        node.nodeType = NodeType::Mesh;
+        node.id = int32_t(it->second);
+      }
+    }
 
-  if (texture.bias.authored()) {
-    tex.bias = texture.bias.get_value();
+    nodes.emplace_back(std::move(node));
+    node_prims.push_back(xnode.prim);
   }
 
-  if (texture.scale.authored()) {
-    tex.scale = texture.scale.get_value();
+  std::vector<uint32_t> children;
+  for (const auto &child : xnode.children) {
+    const int64_t child_idx =
+        BuildNodesRec(child, mesh_ids, nodes, node_prims, depth + 1);
+    if (child_idx >= 0) {
+      children.push_back(uint32_t(child_idx));
+    }
   }
 
-  if (texture.st.authored()) {
-    if (texture.st.is_connection()) {
-      const auto &paths = texture.st.get_connections();
-      if (paths.size() != 1) {
-        PUSH_ERROR_AND_RETURN(
-            "UsdUVTexture inputs:st connection must be single Path.");
-      }
-      const Path &path = paths[0];
+  // Keep the Stage root.
+  if ((depth > 0) && !xnode.has_xform() && children.empty()) {
+    // No node was added after this node.
+    nodes.pop_back();
+    node_prims.pop_back();
+    return -1;
+  }
 
-      const Prim *readerPrim{nullptr};
-      if (!_stage->find_prim_at_path(Path(path.prim_part(), ""), readerPrim,
-                                     &err)) {
-        PUSH_ERROR_AND_RETURN(
-            "UsdUVTexture inputs:st connection targetPath not found in the "
-            "Stage: " +
-            err);
-      }
+  nodes[idx].children = std::move(children);
 
-      if (!readerPrim) {
-        PUSH_ERROR_AND_RETURN(
-            "[InternlError] Invalid Prim connected to inputs:st");
-      }
+  return int64_t(idx);
+}
 
-      const Shader *pshader = readerPrim->as<Shader>();
-      if (!pshader) {
-        PUSH_ERROR_AND_RETURN(
-            fmt::format("UsdUVTexture inputs:st connected Prim must be "
-                        "Shader Prim, but got {} Prim",
-                        readerPrim->prim_type_name()));
+//
+// Points of Mesh nodes are already in world space when
+// `MeshConverterConfig::bake_world_transform` is true. Set identity world
+// matrix to Mesh nodes and adjust local matrices so that the world matrix of
+// the other nodes is unchanged.
+//
+void ResetMeshNodeTransforms(std::vector<Node> &nodes) {
+  // Nodes are stored in depth-first order(parent comes first).
+  std::vector<int64_t> parents(nodes.size(), -1);
+  for (size_t i = 0; i < nodes.size(); i++) {
+    for (const uint32_t child : nodes[i].children) {
+      if (child < nodes.size()) {
+        parents[child] = int64_t(i);
       }
+    }
+  }
 
-      // currently UsdTranform2d or PrimvarReaer_float2 only for inputs:st
-      if (const UsdPrimvarReader_float2 *preader =
-              pshader->value.as<UsdPrimvarReader_float2>()) {
-        if (!preader) {
-          PUSH_ERROR_AND_RETURN(
-              fmt::format("Shader's info:id must be UsdPrimvarReader_float2, "
-                          "but got {}",
-                          pshader->info_id));
-        }
+  const value::matrix4d identity = value::matrix4d::identity();
+  std::vector<uint8_t> modified(nodes.size(), 0);
 
-        // Get value producing attribute(i.e, follow .connection and return
-        // terminal Attribute value)
-        value::token varname;
-        TerminalAttributeValue attr;
-        if (!tydra::EvaluateAttribute(*_stage, *readerPrim, "inputs:varname",
-                                      &attr, &err)) {
-          PUSH_ERROR_AND_RETURN(
-              fmt::format("Failed to evaluate UsdPrimvarReader_float2's "
-                          "inputs:varname.\n{}",
-                          err));
-        }
+  for (size_t i = 0; i < nodes.size(); i++) {
+    Node &node = nodes[i];
+    const int64_t parent = parents[i];
+    const bool parent_modified = (parent >= 0) && modified[size_t(parent)];
 
-        if (auto pv = attr.as<value::token>()) {
-          varname = *pv;
-        } else {
-          PUSH_ERROR_AND_RETURN(
-              "`inputs:varname` must be `token` type, but got " +
-              attr.type_name());
-        }
-        if (varname.str().empty()) {
-          PUSH_ERROR_AND_RETURN("`inputs:varname` is empty token.");
-        }
-        DCOUT("inputs:varname = " << varname);
+    if (node.nodeType == NodeType::Mesh) {
+      node.global_matrix = identity;
+      modified[i] = 1;
+    } else if (!parent_modified) {
+      continue;
+    }
 
-        tex.varname_uv = varname.str();
-      } else if (const UsdTransform2d *ptransform =
-                     pshader->value.as<UsdTransform2d>()) {
-        auto result = ConvertTexTransform2d(*_stage, path, *ptransform, &tex);
-        if (!result) {
-          PUSH_ERROR_AND_RETURN(result.error());
-        }
-      } else {
-        PUSH_ERROR_AND_RETURN(
-            "Unsupported Shader type for `inputs:st` connection: " +
-            pshader->info_id + "\n");
-      }
+    if (parent < 0) {
+      node.local_matrix = node.global_matrix;
+      continue;
+    }
 
-    } else {
-      Animatable<value::texcoord2f> fallbacks = texture.st.get_value();
-      value::texcoord2f uv;
-      if (fallbacks.get_scalar(&uv)) {
-        tex.fallback_uv[0] = uv[0];
-        tex.fallback_uv[1] = uv[1];
-      } else {
-        // TODO: report warning.
-        PUSH_WARN(
-            "Failed to get fallback `st` texcoord attribute. Maybe `st` is "
-            "timeSamples attribute?\n");
-      }
+    // world = local x parent_world
+    value::matrix4d inv_parent;
+    if (inverse(nodes[size_t(parent)].global_matrix, inv_parent)) {
+      node.local_matrix = node.global_matrix * inv_parent;
     }
   }
+}
 
-  if (texture.wrapS.authored()) {
-    tinyusdz::UsdUVTexture::Wrap wrap;
-
-    if (!texture.wrapS.get_value().get_scalar(&wrap)) {
-      PUSH_ERROR_AND_RETURN("Invalid UsdUVTexture inputs:wrapS value.");
+//
+// Decompose local matrix M(row-major. p' = p x M) into M = S x R x T.
+// Returns false when M has shear or is singular.
+//
+bool DecomposeTRS(const value::matrix4d &m, vec3 *translation, quat *rotation,
+                  vec3 *scale) {
+  double rows[3][3];
+  double s[3];
+  for (size_t i = 0; i < 3; i++) {
+    s[i] = std::sqrt(m.m[i][0] * m.m[i][0] + m.m[i][1] * m.m[i][1] +
+                     m.m[i][2] * m.m[i][2]);
+    if (s[i] < std::numeric_limits<double>::epsilon()) {
+      return false;
     }
-
-    if (wrap == UsdUVTexture::Wrap::Repeat) {
-      tex.wrapS = UVTexture::WrapMode::REPEAT;
-    } else if (wrap == UsdUVTexture::Wrap::Mirror) {
-      tex.wrapS = UVTexture::WrapMode::MIRROR;
-    } else if (wrap == UsdUVTexture::Wrap::Clamp) {
-      tex.wrapS = UVTexture::WrapMode::CLAMP_TO_EDGE;
-    } else if (wrap == UsdUVTexture::Wrap::Black) {
-      tex.wrapS = UVTexture::WrapMode::CLAMP_TO_BORDER;
-    } else {
-      tex.wrapS = UVTexture::WrapMode::CLAMP_TO_EDGE;
+    for (size_t j = 0; j < 3; j++) {
+      rows[i][j] = m.m[i][j] / s[i];
     }
   }
 
-  if (texture.wrapT.authored()) {
-    tinyusdz::UsdUVTexture::Wrap wrap;
+  const auto dot = [&rows](size_t a, size_t b) {
+    return rows[a][0] * rows[b][0] + rows[a][1] * rows[b][1] +
+           rows[a][2] * rows[b][2];
+  };
 
-    if (!texture.wrapT.get_value().get_scalar(&wrap)) {
-      PUSH_ERROR_AND_RETURN("Invalid UsdUVTexture inputs:wrapT value.");
-    }
+  constexpr double kShearEps = 1e-4;
+  if ((std::fabs(dot(0, 1)) > kShearEps) ||
+      (std::fabs(dot(0, 2)) > kShearEps) ||
+      (std::fabs(dot(1, 2)) > kShearEps)) {
+    return false;
+  }
 
-    if (wrap == UsdUVTexture::Wrap::Repeat) {
-      tex.wrapT = UVTexture::WrapMode::REPEAT;
-    } else if (wrap == UsdUVTexture::Wrap::Mirror) {
-      tex.wrapT = UVTexture::WrapMode::MIRROR;
-    } else if (wrap == UsdUVTexture::Wrap::Clamp) {
-      tex.wrapT = UVTexture::WrapMode::CLAMP_TO_EDGE;
-    } else if (wrap == UsdUVTexture::Wrap::Black) {
-      tex.wrapT = UVTexture::WrapMode::CLAMP_TO_BORDER;
-    } else {
-      tex.wrapT = UVTexture::WrapMode::CLAMP_TO_EDGE;
+  // Mirror: flip the X axis.
+  const double det =
+      rows[0][0] * (rows[1][1] * rows[2][2] - rows[1][2] * rows[2][1]) -
+      rows[0][1] * (rows[1][0] * rows[2][2] - rows[1][2] * rows[2][0]) +
+      rows[0][2] * (rows[1][0] * rows[2][1] - rows[1][1] * rows[2][0]);
+  if (det < 0.0) {
+    s[0] = -s[0];
+    for (size_t j = 0; j < 3; j++) {
+      rows[0][j] = -rows[0][j];
     }
   }
 
-  DCOUT("Converted UVTexture.");
+  // rows = transpose of the rotation matrix R(column vector convention).
+  const auto R = [&rows](size_t i, size_t j) { return rows[j][i]; };
+
+  double x, y, z, w;
+  const double trace = R(0, 0) + R(1, 1) + R(2, 2);
+  if (trace > 0.0) {
+    const double k = 2.0 * std::sqrt(trace + 1.0);
+    w = 0.25 * k;
+    x = (R(2, 1) - R(1, 2)) / k;
+    y = (R(0, 2) - R(2, 0)) / k;
+    z = (R(1, 0) - R(0, 1)) / k;
+  } else if ((R(0, 0) > R(1, 1)) && (R(0, 0) > R(2, 2))) {
+    const double k = 2.0 * std::sqrt(1.0 + R(0, 0) - R(1, 1) - R(2, 2));
+    w = (R(2, 1) - R(1, 2)) / k;
+    x = 0.25 * k;
+    y = (R(0, 1) + R(1, 0)) / k;
+    z = (R(0, 2) + R(2, 0)) / k;
+  } else if (R(1, 1) > R(2, 2)) {
+    const double k = 2.0 * std::sqrt(1.0 + R(1, 1) - R(0, 0) - R(2, 2));
+    w = (R(0, 2) - R(2, 0)) / k;
+    x = (R(0, 1) + R(1, 0)) / k;
+    y = 0.25 * k;
+    z = (R(1, 2) + R(2, 1)) / k;
+  } else {
+    const double k = 2.0 * std::sqrt(1.0 + R(2, 2) - R(0, 0) - R(1, 1));
+    w = (R(1, 0) - R(0, 1)) / k;
+    x = (R(0, 2) + R(2, 0)) / k;
+    y = (R(1, 2) + R(2, 1)) / k;
+    z = 0.25 * k;
+  }
+
+  const double len = std::sqrt(x * x + y * y + z * z + w * w);
+
+  (*translation) = {float(m.m[3][0]), float(m.m[3][1]), float(m.m[3][2])};
+  (*rotation) = {float(x / len), float(y / len), float(z / len),
+                 float(w / len)};
+  (*scale) = {float(s[0]), float(s[1]), float(s[2])};
 
-  (*tex_out) = tex;
   return true;
 }
 
-template <typename T, typename Dty>
-bool RenderSceneConverter::ConvertPreviewSurfaceShaderParam(
-    const Path &shader_abs_path,
-    const TypedAttributeWithFallback<Animatable<T>> &param,
-    const std::string &param_name, ShaderParam<Dty> &dst_param) {
-  if (!param.authored()) {
-    return true;
-  }
-
-  if (param.is_blocked()) {
-    PUSH_ERROR_AND_RETURN(fmt::format("{} attribute is blocked.", param_name));
-  } else if (param.is_connection()) {
-    DCOUT(fmt::format("{] is attribute connection.", param_name));
+//
+// Sample the local matrix of Xformable at its timeSamples and store
+// TRS(or matrix) samples to `channel`.
+//
+bool ConvertXformAnimation(const Xformable &xformable,
+                           const RenderSceneConverterConfig &config,
+                           const double time_codes_per_second,
+                           AnimationChannel *channel, std::string *err) {
+  std::vector<double> times;
+  for (const auto &op : xformable.xformOps) {
+    if (const auto ts = op.get_timesamples()) {
+      for (size_t i = 0; i < ts.value().size(); i++) {
+        if (const auto t = ts.value().get_time(i)) {
+          times.push_back(t.value());
+        }
+      }
+    }
+  }
 
-    const UsdUVTexture *ptex{nullptr};
-    const Shader *pshader{nullptr};
-    Path texPath;
-    auto result = GetConnectedUVTexture(*_stage, param, &texPath, &ptex, &pshader);
+  std::sort(times.begin(), times.end());
+  times.erase(std::unique(times.begin(), times.end()), times.end());
 
-    if (!result) {
-      PUSH_ERROR_AND_RETURN(result.error());
+  if (times.empty()) {
+    if (err) {
+      (*err) += "No timeSamples in xformOps.\n";
     }
+    return false;
+  }
 
-    if (!ptex) {
-      PUSH_ERROR_AND_RETURN("[InternalError] ptex is nullptr.");
+  const double interval = config.animation_sample_interval;
+  if ((interval > 0.0) && (times.size() > 1)) {
+    const double start = times.front();
+    const double end = times.back();
+
+    constexpr double kMaxSamples = 1024.0 * 1024.0;
+    if ((end - start) / interval > kMaxSamples) {
+      if (err) {
+        (*err) += fmt::format(
+            "Too many animation samples. Increase "
+            "`animation_sample_interval`(current {}).\n",
+            interval);
+      }
+      return false;
     }
-    DCOUT("ptex = " << ptex->name);
 
-    if (!pshader) {
-      PUSH_ERROR_AND_RETURN("[InternalError] pshader is nullptr.");
+    for (size_t k = 1; start + double(k) * interval < end; k++) {
+      times.push_back(start + double(k) * interval);
     }
 
-    DCOUT("Get connected UsdUVTexture Prim: " << texPath);
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+  }
 
-    UVTexture rtex;
-    const AssetInfo &assetInfo = pshader->metas().get_assetInfo();
-    if (!ConvertUVTexture(texPath, assetInfo, *ptex, &rtex)) {
-      PUSH_ERROR_AND_RETURN(fmt::format(
-          "Failed to convert UVTexture connected to {}", param_name));
+  std::vector<value::matrix4d> matrices(times.size());
+  for (size_t i = 0; i < times.size(); i++) {
+    bool reset_xform_stack{false};
+    std::string local_err;
+    if (!xformable.EvaluateXformOps(times[i], config.animation_interpolation,
+                                    &matrices[i], &reset_xform_stack,
+                                    &local_err)) {
+      if (err) {
+        (*err) += fmt::format("Failed to evaluate xformOps at time {}: {}\n",
+                              times[i], local_err);
+      }
+      return false;
     }
+  }
 
-    uint64_t texId = textures.size();
-    textures.push_back(rtex);
-
-    textureMap.add(texId, shader_abs_path.prim_part() + "." + param_name);
+  const bool held = (config.animation_interpolation ==
+                     value::TimeSampleInterpolationType::Held);
 
-    DCOUT(fmt::format("TexId {} = {}",
-                      shader_abs_path.prim_part() + ".diffuseColor", texId));
+  std::vector<AnimationSample<vec3>> translations(times.size());
+  std::vector<AnimationSample<quat>> rotations(times.size());
+  std::vector<AnimationSample<vec3>> scales(times.size());
 
-    dst_param.textureId = int32_t(texId);
+  bool decomposed = true;
+  for (size_t i = 0; i < times.size(); i++) {
+    const float t = float(times[i] / time_codes_per_second);
+    translations[i].t = rotations[i].t = scales[i].t = t;
 
-    return true;
-  } else {
-    T val;
-    if (!param.get_value().get_scalar(&val)) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("Failed to get {} at `default` timecode.", param_name));
+    if (!DecomposeTRS(matrices[i], &translations[i].value,
+                      &rotations[i].value, &scales[i].value)) {
+      decomposed = false;
+      break;
     }
 
-    dst_param.set_value(val);
-
-    return true;
+    // Take the shorter path from the previous rotation.
+    if (i > 0) {
+      const quat &prev = rotations[i - 1].value;
+      quat &q = rotations[i].value;
+      if (prev[0] * q[0] + prev[1] * q[1] + prev[2] * q[2] + prev[3] * q[3] <
+          0.0f) {
+        q = {-q[0], -q[1], -q[2], -q[3]};
+      }
+    }
   }
-}
 
-// TODO: timeSamples
-bool RenderSceneConverter::ConvertPreviewSurfaceShader(
-    const Path &shader_abs_path, const UsdPreviewSurface &shader,
-    PreviewSurfaceShader *rshader_out) {
-  if (!rshader_out) {
-    PUSH_ERROR_AND_RETURN("rshader_out arg is nullptr.");
+  if (decomposed) {
+    channel->translations.samples = std::move(translations);
+    channel->translations.interpolation =
+        held ? AnimationSampler<vec3>::Interpolation::Step
+             : AnimationSampler<vec3>::Interpolation::Linear;
+    channel->rotations.samples = std::move(rotations);
+    channel->rotations.interpolation =
+        held ? AnimationSampler<quat>::Interpolation::Step
+             : AnimationSampler<quat>::Interpolation::Linear;
+    channel->scales.samples = std::move(scales);
+    channel->scales.interpolation =
+        held ? AnimationSampler<vec3>::Interpolation::Step
+             : AnimationSampler<vec3>::Interpolation::Linear;
+  } else {
+    // Shear
+    channel->transforms.samples.resize(times.size());
+    for (size_t i = 0; i < times.size(); i++) {
+      AnimationSample<mat4> &sample = channel->transforms.samples[i];
+      sample.t = float(times[i] / time_codes_per_second);
+      sample.value = ToMat4(matrices[i]);
+    }
+    channel->transforms.interpolation =
+        held ? AnimationSampler<mat4>::Interpolation::Step
+             : AnimationSampler<mat4>::Interpolation::Linear;
   }
 
-  PreviewSurfaceShader rshader;
+  return true;
+}
 
-  if (shader.useSpecularWorkflow.authored()) {
-    if (shader.useSpecularWorkflow.is_blocked()) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("useSpecularWorkflow attribute is blocked."));
-    } else if (shader.useSpecularWorkflow.is_connection()) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("TODO: useSpecularWorkflow with connection."));
-    } else {
-      int val;
-      if (!shader.useSpecularWorkflow.get_value().get_scalar(&val)) {
-        PUSH_ERROR_AND_RETURN(fmt::format(
-            "Failed to get useSpcularWorkFlow value at `default` timecode."));
+//
+// Convert time-varying xformOps of node Prims to Animations(an Animation per
+// animated Prim, in the order of nodes).
+// `skip_mesh_nodes` skips Mesh nodes and their ancestors(used when the world
+// transform is baked into meshes. Animating an ancestor would move the baked
+// points again).
+//
+bool ConvertAnimations(const Stage &stage, const std::vector<Node> &nodes,
+                       const std::vector<const Prim *> &node_prims,
+                       const RenderSceneConverterConfig &config,
+                       bool skip_mesh_nodes,
+                       std::vector<Animation> *animations, std::string *warn,
+                       std::string *err) {
+  std::vector<uint8_t> skipped(nodes.size(), 0);
+  if (skip_mesh_nodes) {
+    std::vector<int64_t> parents(nodes.size(), -1);
+    for (size_t i = 0; i < nodes.size(); i++) {
+      for (const uint32_t child : nodes[i].children) {
+        if (child < nodes.size()) {
+          parents[child] = int64_t(i);
+        }
       }
+    }
 
-      rshader.useSpecularWorkFlow = val ? true : false;
+    for (size_t i = 0; i < nodes.size(); i++) {
+      if (nodes[i].nodeType != NodeType::Mesh) {
+        continue;
+      }
+      for (int64_t n = int64_t(i); (n >= 0) && !skipped[size_t(n)];
+           n = parents[size_t(n)]) {
+        skipped[size_t(n)] = 1;
+      }
     }
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.diffuseColor,
-                                        "diffuseColor", rshader.diffuseColor)) {
-    return false;
+  std::vector<size_t> animated_nodes;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const Xformable *xformable{nullptr};
+    if (node_prims[i] && IsXformablePrim(*node_prims[i]) &&
+        CastToXformable(*node_prims[i], &xformable) && xformable &&
+        xformable->has_timesamples()) {
+      if (skipped[i]) {
+        if (warn && (nodes[i].nodeType != NodeType::Mesh)) {
+          (*warn) += fmt::format(
+              "Animation of `{}` is not exported since the world transform "
+              "is baked into its descendant meshes.\n",
+              nodes[i].abs_path);
+        }
+        continue;
+      }
+      animated_nodes.push_back(i);
+    }
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.normal,
-                                        "normal", rshader.normal)) {
-    return false;
+  double time_codes_per_second = stage.metas().timeCodesPerSecond.get_value();
+  if (!(time_codes_per_second > 0.0)) {
+    time_codes_per_second = 24.0;
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.roughness,
-                                        "roughness", rshader.roughness)) {
-    return false;
-  }
+  const size_t num_anims = animated_nodes.size();
+  std::vector<Animation> anims(num_anims);
+  std::vector<uint8_t> results(num_anims, 0);
+  std::vector<std::string> errs(num_anims);
+
+  const auto convert = [&](size_t i) {
+    const size_t node_idx = animated_nodes[i];
+    const Xformable *xformable{nullptr};
+    CastToXformable(*node_prims[node_idx], &xformable);
+
+    Animation &anim = anims[i];
+    anim.path = nodes[node_idx].abs_path;
+
+    AnimationChannel channel;
+    channel.taget_node = int64_t(node_idx);
+    if (ConvertXformAnimation(*xformable, config, time_codes_per_second,
+                              &channel, &errs[i])) {
+      anim.channels.emplace_back(std::move(channel));
+      results[i] = 1;
+    }
+  };
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.metallic,
-                                        "metallic", rshader.metallic)) {
-    return false;
+  const uint32_t num_threads =
+      ThreadPool::resolve_num_threads(config.num_threads);
+  if ((num_threads <= 1) || (num_anims < 2)) {
+    for (size_t i = 0; i < num_anims; i++) {
+      convert(i);
+    }
+  } else {
+    ThreadPool pool(uint32_t((std::min)(size_t(num_threads), num_anims)));
+    for (size_t i = 0; i < num_anims; i++) {
+      pool.submit([&convert, i]() { convert(i); });
+    }
+    pool.wait();
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.clearcoat,
-                                        "clearcoat", rshader.clearcoat)) {
-    return false;
+  for (size_t i = 0; i < num_anims; i++) {
+    if (!results[i]) {
+      if (err) {
+        (*err) += fmt::format("Failed to convert animation of `{}`: {}",
+                              anims[i].path, errs[i]);
+      }
+      return false;
+    }
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(
-          shader_abs_path, shader.clearcoatRoughness, "clearcoatRoughness",
-          rshader.clearcoatRoughness)) {
-    return false;
+  (*animations) = std::move(anims);
+
+  return true;
+}
+
+bool BakeWorldTransform(const value::matrix4d &world_matrix, RenderMesh &mesh,
+                        std::string *err) {
+  const value::matrix4d identity = value::matrix4d::identity();
+  if (memcmp(world_matrix.m, identity.m, sizeof(double) * 16) == 0) {
+    return true;
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.opacity,
-                                        "opacity", rshader.opacity)) {
+  static_assert(sizeof(vec3) == sizeof(value::float3), "");
+
+  transform_points(world_matrix,
+                   reinterpret_cast<const value::float3 *>(mesh.points.data()),
+                   mesh.points.size(),
+                   reinterpret_cast<value::float3 *>(mesh.points.data()));
+
+  if (!transform_normals(
+          world_matrix,
+          reinterpret_cast<const value::float3 *>(
+              mesh.facevaryingNormals.data()),
+          mesh.facevaryingNormals.size(),
+          reinterpret_cast<value::float3 *>(mesh.facevaryingNormals.data()))) {
+    if (err) {
+      (*err) += fmt::format(
+          "Failed to transform normals(singular world matrix): {}\n",
+          mesh.abs_name);
+    }
     return false;
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(
-          shader_abs_path, shader.opacityThreshold, "opacityThreshold",
-          rshader.opacityThreshold)) {
+  if (!transform_normals(
+          world_matrix,
+          reinterpret_cast<const value::float3 *>(mesh.vertexNormals.data()),
+          mesh.vertexNormals.size(),
+          reinterpret_cast<value::float3 *>(mesh.vertexNormals.data()))) {
+    if (err) {
+      (*err) += fmt::format(
+          "Failed to transform normals(singular world matrix): {}\n",
+          mesh.abs_name);
+    }
     return false;
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.ior, "ior",
-                                        rshader.ior)) {
-    return false;
+  for (auto &meshlet : mesh.meshlets) {
+    ComputeMeshletBounds(mesh, meshlet);
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.occlusion,
-                                        "occlusion", rshader.occlusion)) {
-    return false;
+  // Mirroring transform flips front faces.
+  if (determinant(world_matrix) < 0.0) {
+    if (!FlipFaceWinding(mesh, err)) {
+      return false;
+    }
   }
 
-  if (!ConvertPreviewSurfaceShaderParam(shader_abs_path, shader.displacement,
-                                        "displacement", rshader.displacement)) {
-    return false;
+  if (mesh.vertexBuffer.data.size()) {
+    const std::vector<VertexElement> elements = mesh.vertexLayout.elements;
+    if (!BuildInterleavedVertexBuffer(mesh, elements, &mesh.vertexLayout,
+                                      &mesh.vertexBuffer, err)) {
+      return false;
+    }
   }
 
-  (*rshader_out) = rshader;
   return true;
 }
 
-bool RenderSceneConverter::ConvertMaterial(const Path &mat_abs_path,
-                                           const tinyusdz::Material &material,
-                                           RenderMaterial *rmat_out) {
-  if (!_stage) {
-    PUSH_ERROR_AND_RETURN("stage is nullptr.");
+}  // namespace
+
+void RenderSceneConverter::SetupWorker(RenderSceneConverter &worker) const {
+  worker._asset_resolver = _asset_resolver;
+  worker._scene_config = _scene_config;
+  worker._mesh_config = _mesh_config;
+  worker._material_config = _material_config;
+  worker._stage = _stage;
+}
+
+bool RenderSceneConverter::ConvertToRenderScene(const Stage &stage,
+                                                RenderScene *scene) {
+  return ConvertStage(stage, /* changed_paths */ nullptr, scene,
+                      /* update */ nullptr);
+}
+
+bool RenderSceneConverter::UpdateRenderScene(
+    const Stage &stage, const std::vector<Path> &changed_paths,
+    RenderScene *scene, RenderSceneUpdate *update) {
+  if (update) {
+    (*update) = RenderSceneUpdate();
   }
 
-  if (!rmat_out) {
-    PUSH_ERROR_AND_RETURN("rmat_out argument is nullptr.");
+  return ConvertStage(stage, &changed_paths, scene, update);
+}
+
+bool RenderSceneConverter::ConvertStage(const Stage &stage,
+                                        const std::vector<Path> *changed_paths,
+                                        RenderScene *scene,
+                                        RenderSceneUpdate *update) {
+  if (!scene) {
+    PUSH_ERROR_AND_RETURN("nullptr for RenderScene argument.");
   }
 
-  RenderMaterial rmat;
-  rmat.abs_path = mat_abs_path.prim_part();
-  rmat.name = mat_abs_path.element_name();
-  DCOUT("rmat.abs_path = " << rmat.abs_path);
-  DCOUT("rmat.name = " << rmat.name);
+  _stage = &stage;
+
+  // Build Xform at default time.
+  XformNode xform_node;
+  if (!BuildXformNodeFromStage(stage, &xform_node)) {
+    PUSH_ERROR_AND_RETURN("Failed to build Xform node hierarchy.\n");
+  }
+
+  // W.I.P.
+
+  RenderScene render_scene;
+
+  // Update: Continue from the previous result. Nodes, MeshInstances and
+  // Animations are rebuilt.
+  std::vector<Node> prev_nodes;
+  std::vector<MeshInstances> prev_instances;
+  std::vector<Animation> prev_animations;
+  if (changed_paths) {
+    prev_nodes = std::move(scene->nodes);
+    prev_instances = std::move(scene->instances);
+    prev_animations = std::move(scene->animations);
+    meshes = std::move(scene->meshes);
+    materials = std::move(scene->materials);
+    textures = std::move(scene->textures);
+    images = std::move(scene->images);
+    buffers = std::move(scene->buffers);
+    instances.clear();
+    animations.clear();
+  }
+  _mesh_material_ids.resize(meshes.size());
+
+  // 1. Visit GeomMesh and list up its bound Material(serial).
+  // 2. Convert Materials(parallel).
+  // 3. Convert Meshes(parallel).
 
   std::string err;
 
-  Path surfacePath;
+  const size_t num_prev_materials = materials.size();
 
-  //
-  // surface shader
-  {
-    if (material.surface.authored()) {
-      auto paths = material.surface.get_connections();
-      DCOUT("paths = " << paths);
-      // must have single targetPath.
-      if (paths.size() != 1) {
-        PUSH_ERROR_AND_RETURN(
-            fmt::format("{}'s outputs:surface must be connection with single "
-                        "target Path.\n",
-                        mat_abs_path.full_path_name()));
-      }
-      surfacePath = paths[0];
-    } else {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("{}'s outputs:surface isn't authored.\n",
-                      mat_abs_path.full_path_name()));
-    }
+  ConvertItems items;
+  items.converter = this;
+  items.build_instances = _scene_config.build_instances;
 
-    const Prim *shaderPrim{nullptr};
-    if (!_stage->find_prim_at_path(
-            Path(surfacePath.prim_part(), /* prop part */ ""), shaderPrim,
-            &err)) {
-      PUSH_ERROR_AND_RETURN(fmt::format(
-          "{}'s outputs:surface isn't connected to exising Prim path.\n",
-          mat_abs_path.full_path_name()));
-    }
+  bool ret = tydra::VisitPrims(stage, CollectMeshVisitor, &items, &err);
 
-    if (!shaderPrim) {
-      // this should not happen though.
-      PUSH_ERROR_AND_RETURN("[InternalError] invalid Shader Prim.\n");
-    }
+  if (!ret) {
+    _err += err;
 
-    const Shader *shader = shaderPrim->as<Shader>();
+    return false;
+  }
 
-    if (!shader) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("{}'s outputs:surface must be connected to Shader Prim, "
-                      "but connected to `{}` Prim.\n",
-                      shaderPrim->prim_type_name()));
-    }
+  const uint32_t num_threads =
+      ThreadPool::resolve_num_threads(_scene_config.num_threads);
 
-    // Currently must be UsdPreviewSurface
-    const UsdPreviewSurface *psurface = shader->value.as<UsdPreviewSurface>();
-    if (!psurface) {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("Shader's info:id must be UsdPreviewSurface, but got {}",
-                      shader->info_id));
-    }
+  //
+  // Materials
+  //
+  // Materials to be converted and their RenderMaterial index.
+  std::vector<MaterialItem> material_items;
+  std::vector<size_t> material_ids;
+  // 1 = previously converted Material is modified.
+  std::vector<uint8_t> modified_materials(num_prev_materials, 0);
+  if (changed_paths) {
+    // Modified Materials. Removed Materials are left as they are.
+    for (auto it = materialMap.i_begin(); it != materialMap.i_end(); it++) {
+      if (it->first >= num_prev_materials) {
+        break;
+      }
 
-    // prop part must be `outputs:surface` for now.
-    if (surfacePath.prop_part() != "outputs:surface") {
-      PUSH_ERROR_AND_RETURN(
-          fmt::format("{}'s outputs:surface connection must point to property "
-                      "`outputs:surface`, but got `{}`",
-                      mat_abs_path.full_path_name(), surfacePath.prop_part()));
-    }
+      const Path material_path(it->second, "");
+      if (FindPathChange(material_path, *changed_paths) != PathChange::Self) {
+        continue;
+      }
 
-    PreviewSurfaceShader pss;
-    if (!ConvertPreviewSurfaceShader(surfacePath, *psurface, &pss)) {
-      PUSH_ERROR_AND_RETURN(fmt::format(
-          "Failed to convert UsdPreviewSurface : {}", surfacePath.prim_part()));
+      const Prim *prim{nullptr};
+      if (!stage.find_prim_at_path(material_path, prim, &err) || !prim ||
+          !prim->as<Material>()) {
+        err.clear();
+        continue;
+      }
+
+      MaterialItem item;
+      item.abs_path = material_path;
+      item.material = prim->as<Material>();
+      material_items.emplace_back(std::move(item));
+      material_ids.push_back(size_t(it->first));
+      modified_materials[size_t(it->first)] = 1;
     }
+  }
 
-    rmat.surfaceShader = pss;
+  for (size_t i = 0; i < items.materials.size(); i++) {
+    material_items.push_back(items.materials[i]);
+    material_ids.push_back(num_prev_materials + i);
   }
 
-  DCOUT("Converted Material: " << mat_abs_path);
+  if (!changed_paths && (num_threads <= 1)) {
+    for (const auto &item : material_items) {
+      RenderMaterial rmat;
+      if (!ConvertMaterial(item.abs_path, *item.material, &rmat)) {
+        _err += fmt::format("Material conversion failed: {}",
+                            item.abs_path.full_path_name());
+        return false;
+      }
 
-  (*rmat_out) = rmat;
-  return true;
-}
+      DCOUT("Add material: " << rmat.abs_path << " ( " << rmat.name << " ) ");
+      materials.emplace_back(std::move(rmat));
+    }
+  } else if (material_items.size()) {
+    // Each Material is converted with its own worker, then textures, images
+    // and buffers are merged in the order of Materials(with index offsets),
+    // so the result is identical to the serial conversion.
+    const size_t num_mats = material_items.size();
+    std::vector<std::unique_ptr<RenderSceneConverter>> workers(num_mats);
+    std::vector<RenderMaterial> rmats(num_mats);
+    std::vector<uint8_t> results(num_mats, 0);
+
+    {
+      ThreadPool pool(
+          uint32_t((std::min)(size_t(num_threads), num_mats)));
+      for (size_t i = 0; i < num_mats; i++) {
+        pool.submit([this, &material_items, &workers, &rmats, &results, i]() {
+          workers[i].reset(new RenderSceneConverter());
+          RenderSceneConverter &worker = *workers[i];
+          SetupWorker(worker);
+
+          const MaterialItem &item = material_items[i];
+          if (worker.ConvertMaterial(item.abs_path, *item.material,
+                                     &rmats[i])) {
+            results[i] = 1;
+          }
+        });
+      }
+      pool.wait();
+    }
 
-namespace {
+    for (size_t i = 0; i < num_mats; i++) {
+      RenderSceneConverter &worker = *workers[i];
 
-bool MeshVisitor(const tinyusdz::Path &abs_path, const tinyusdz::Prim &prim,
-                 const int32_t level, void *userdata, std::string *err) {
-  if (!userdata) {
-    return false;
-  }
+      _warn += worker._warn;
 
-  RenderSceneConverter *converter =
-      reinterpret_cast<RenderSceneConverter *>(userdata);
+      if (!results[i]) {
+        _err += worker._err;
+        _err += fmt::format("Material conversion failed: {}",
+                            material_items[i].abs_path.full_path_name());
+        return false;
+      }
 
-  if (level > 1024 * 1024) {
-    if (err) {
-      (*err) += "Scene graph is too deep.\n";
+      StoreMaterial(worker, std::move(rmats[i]), material_ids[i], *this,
+                    update);
+
+      workers[i].reset();
     }
-    // Too deep
-    return false;
   }
 
-  if (const tinyusdz::GeomMesh *pmesh = prim.as<tinyusdz::GeomMesh>()) {
-    DCOUT("Material: " << abs_path);
-
-    //
-    // First convert Material
-    //
-
-    const std::string mesh_path_str = abs_path.full_path_name();
-
-    std::vector<RenderMaterial> &rmaterials = converter->materials;
+  //
+  // Meshes
+  //
+  // RenderScene mesh index of each mesh item.
+  std::vector<size_t> mesh_ids(items.meshes.size());
 
-    tinyusdz::Path bound_material_path;
-    const tinyusdz::Material *bound_material{nullptr};
-    bool ret = tinyusdz::tydra::FindBoundMaterial(
-        *converter->GetStagePtr(), /* GeomMesh prim path */ abs_path,
-        /* suffix */ "", &bound_material_path, &bound_material, err);
+  // Mesh items to be converted.
+  std::vector<size_t> targets;
 
-    int64_t rmaterial_id = -1;
+  if (!changed_paths) {
+    for (size_t i = 0; i < items.meshes.size(); i++) {
+      mesh_ids[i] = meshes.size() + i;
+      targets.push_back(i);
+    }
+  } else {
+    std::unordered_map<std::string, size_t> prev_mesh_ids;
+    for (size_t i = 0; i < meshes.size(); i++) {
+      if (!meshes[i].abs_name.empty()) {
+        prev_mesh_ids[meshes[i].abs_name] = i;
+      }
+    }
 
-    if (ret && bound_material) {
-      DCOUT("Bound material path: " << bound_material_path);
+    size_t num_meshes = meshes.size();
+    for (size_t i = 0; i < items.meshes.size(); i++) {
+      const MeshItem &item = items.meshes[i];
 
-      const auto matIt =
-          converter->materialMap.find(bound_material_path.full_path_name());
+      const auto it = prev_mesh_ids.find(item.abs_path.full_path_name());
+      if (it == prev_mesh_ids.end()) {
+        mesh_ids[i] = num_meshes++;
+        targets.push_back(i);
+        continue;
+      }
 
-      if (matIt != converter->materialMap.s_end()) {
-        // Got material in the cache.
-        uint64_t mat_id = matIt->second;
-        if (mat_id >=
-            converter->materials.size()) {  // this should not happen though
-          if (err) {
-            (*err) += "Material index out-of-range.\n";
-          }
-          return false;
+      mesh_ids[i] = it->second;
+
+      // Convert again when the GeomMesh, its GeomSubset or its ancestor Prim
+      // is modified, the world transform baked into points may be
+      // modified(property of an ancestor is modified), or bound
+      // Materials are changed or modified(a Material decides which primvars
+      // are converted as texcoords).
+      const PathChange change = FindPathChange(item.abs_path, *changed_paths);
+      const std::vector<int64_t> material_ids_of_mesh =
+          GetMeshMaterialIds(item);
+      bool material_modified = false;
+      for (const int64_t id : material_ids_of_mesh) {
+        if ((id >= 0) && (size_t(id) < num_prev_materials) &&
+            modified_materials[size_t(id)]) {
+          material_modified = true;
+          break;
         }
+      }
 
-        if (mat_id >= (std::numeric_limits<int64_t>::max)()) {
-          if (err) {
-            (*err) += "Material index too large.\n";
-          }
-          return false;
-        }
+      if ((change == PathChange::Self) ||
+          ((change == PathChange::AncestorProperty) &&
+           _mesh_config.bake_world_transform) ||
+          material_modified ||
+          (_mesh_material_ids[it->second] != material_ids_of_mesh)) {
+        targets.push_back(i);
+      }
 
-        rmaterial_id = int64_t(mat_id);
+      prev_mesh_ids.erase(it);
+    }
 
-      } else {
-        RenderMaterial rmat;
-        if (!converter->ConvertMaterial(bound_material_path, *bound_material,
-                                        &rmat)) {
-          if (err) {
-            (*err) += fmt::format("Material conversion failed: {}",
-                                  bound_material_path);
-          }
-          return false;
-        }
+    // Removed meshes(or meshes drawn as an instance of other mesh).
+    for (const auto &it : prev_mesh_ids) {
+      meshes[it.second] = RenderMesh();
+      _mesh_material_ids[it.second].clear();
+      PushUpdatedId(update ? &update->removed_meshes : nullptr,
+                    int64_t(it.second));
+    }
+  }
 
-        // Assign new material ID
-        uint64_t mat_id = rmaterials.size();
+  const size_t num_targets = targets.size();
+  std::vector<RenderMesh> rmeshes(num_targets);
 
-        if (mat_id >= (std::numeric_limits<int64_t>::max)()) {
-          if (err) {
-            (*err) += "Material index too large.\n";
-          }
-          return false;
-        }
-        rmaterial_id = int64_t(mat_id);
+  const auto finalize_mesh = [&items, &targets, &rmeshes](size_t i) {
+    const MeshItem &item = items.meshes[targets[i]];
+    RenderMesh &rmesh = rmeshes[i];
+
+    rmesh.element_name = item.element_name;
+    rmesh.abs_name = item.abs_path.full_path_name();
 
-        converter->materialMap.add(bound_material_path.full_path_name(),
-                                   uint64_t(rmaterial_id));
-        DCOUT("Add material: " << mat_id << " " << rmat.abs_path << " ( "
-                               << rmat.name << " ) ");
+    DCOUT("renderMaterialId = " << item.rmaterial_id);
+  };
 
-        rmaterials.push_back(rmat);
+  if ((num_threads <= 1) || (num_targets < 2)) {
+    for (size_t i = 0; i < num_targets; i++) {
+      const MeshItem &item = items.meshes[targets[i]];
+      if (!ConvertMesh(item.rmaterial_id, item.material_subsets, *item.mesh,
+                       &rmeshes[i])) {
+        _err += fmt::format("Mesh conversion failed: {}",
+                            item.abs_path.full_path_name());
+        return false;
       }
+      finalize_mesh(i);
+    }
+  } else {
+    std::vector<uint8_t> results(num_targets, 0);
+    std::vector<std::string> warns(num_targets);
+    std::vector<std::string> errs(num_targets);
+
+    ThreadPool pool(uint32_t((std::min)(size_t(num_threads), num_targets)));
+
+    // ConvertMesh only reads `materials` and `textures`, so one worker per
+    // thread is enough.
+    std::vector<std::unique_ptr<RenderSceneConverter>> workers(
+        pool.num_threads());
+    for (auto &worker : workers) {
+      worker.reset(new RenderSceneConverter());
+      SetupWorker(*worker);
+      worker->materials = materials;
+      worker->textures = textures;
     }
 
-    RenderMesh rmesh;
+    for (size_t i = 0; i < num_targets; i++) {
+      pool.submit([&, i]() {
+        RenderSceneConverter &worker = *workers[pool.thread_index()];
 
-    if (!converter->ConvertMesh(rmaterial_id, *pmesh, &rmesh)) {
-      if (err) {
-        (*err) += fmt::format("Mesh conversion failed: {}",
-                              abs_path.full_path_name());
-      }
-      return false;
+        const MeshItem &item = items.meshes[targets[i]];
+        if (worker.ConvertMesh(item.rmaterial_id, item.material_subsets,
+                               *item.mesh, &rmeshes[i])) {
+          finalize_mesh(i);
+          results[i] = 1;
+        }
+
+        warns[i] = std::move(worker._warn);
+        errs[i] = std::move(worker._err);
+        worker._warn.clear();
+        worker._err.clear();
+      });
     }
+    pool.wait();
 
-    DCOUT("renderMaterialId = " << rmaterial_id);
+    for (size_t i = 0; i < num_targets; i++) {
+      _warn += warns[i];
 
-    // Do not assign materialIds when no material bound to this Mesh.
-    // TODO: per-face material.
-    if ((rmaterial_id > -1) &&
-        (rmaterial_id < (std::numeric_limits<int32_t>::max)())) {
-      rmesh.materialIds.resize(rmesh.faceVertexCounts.size(),
-                               int32_t(rmaterial_id));
+      if (!results[i]) {
+        _err += errs[i];
+        _err += fmt::format("Mesh conversion failed: {}",
+                            items.meshes[targets[i]].abs_path.full_path_name());
+        return false;
+      }
     }
+  }
 
-    converter->meshes.emplace_back(std::move(rmesh));
+  std::unordered_map<std::string, value::matrix4d> world_matrices;
+  if (_mesh_config.bake_world_transform || !items.instancers.empty() ||
+      !items.instanced_meshes.empty()) {
+    CollectWorldMatricesRec(xform_node, world_matrices, 0);
   }
 
-  return true;  // continue traversal
-}
-}  // namespace
+  if (_mesh_config.bake_world_transform) {
+    for (auto &mesh : rmeshes) {
+      const auto it = world_matrices.find(mesh.abs_name);
+      if (it == world_matrices.end()) {
+        continue;
+      }
 
-bool RenderSceneConverter::ConvertToRenderScene(const Stage &stage,
-                                                RenderScene *scene) {
-  if (!scene) {
-    PUSH_ERROR_AND_RETURN("nullptr for RenderScene argument.");
+      if (!BakeWorldTransform(it->second, mesh, &err)) {
+        _err += err;
+        return false;
+      }
+    }
   }
 
-  _stage = &stage;
+  // New meshes are appended in the order of mesh items.
+  for (size_t i = 0; i < num_targets; i++) {
+    const size_t mesh_id = mesh_ids[targets[i]];
+    if (mesh_id < meshes.size()) {
+      rmeshes[i].handle = meshes[mesh_id].handle;
+      meshes[mesh_id] = std::move(rmeshes[i]);
+    } else if (mesh_id == meshes.size()) {
+      meshes.emplace_back(std::move(rmeshes[i]));
+      _mesh_material_ids.resize(meshes.size());
+    } else {
+      PUSH_ERROR_AND_RETURN("[InternalError] Invalid mesh index.");
+    }
 
-  // Build Xform at default time.
-  XformNode xform_node;
-  if (!BuildXformNodeFromStage(stage, &xform_node)) {
-    PUSH_ERROR_AND_RETURN("Failed to build Xform node hierarchy.\n");
+    _mesh_material_ids[mesh_id] = GetMeshMaterialIds(items.meshes[targets[i]]);
+    PushUpdatedId(update ? &update->meshes : nullptr, int64_t(mesh_id));
   }
 
-  // W.I.P.
+  //
+  // Instances
+  //
+  // Prototype meshes are drawn only through `instances`.
+  std::vector<uint8_t> prototype_meshes(meshes.size(), 0);
 
-  RenderScene render_scene;
+  for (const auto &instancer : items.instancers) {
+    ConvertPointInstancer(instancer, items.meshes, world_matrices, mesh_ids,
+                          _mesh_config.bake_world_transform, &instances,
+                          prototype_meshes, &_warn);
+  }
 
-  // 1. Visit GeomMesh
-  // 2. If the mesh has bound material
-  //   1. Create Material
+  BuildPrototypeInstances(items, world_matrices, mesh_ids,
+                          _mesh_config.bake_world_transform, &instances,
+                          prototype_meshes);
+
+  //
+  // Nodes and Animations
   //
-  // TODO: GeomSubset(per-face material)
+  std::vector<const Prim *> node_prims;
+  {
+    std::unordered_map<std::string, size_t> node_mesh_ids;
+    for (size_t i = 0; i < meshes.size(); i++) {
+      if (!prototype_meshes[i] && !meshes[i].abs_name.empty()) {
+        node_mesh_ids[meshes[i].abs_name] = i;
+      }
+    }
 
-  std::string err;
+    nodes.clear();
+    BuildNodesRec(xform_node, node_mesh_ids, nodes, node_prims, 0);
 
-  // Pass `this` through userdata ptr
-  bool ret = tydra::VisitPrims(stage, MeshVisitor, this, &err);
+    if (_mesh_config.bake_world_transform) {
+      ResetMeshNodeTransforms(nodes);
+    }
+  }
 
-  if (!ret) {
-    _err += err;
+  if (_scene_config.export_animations) {
+    if (!ConvertAnimations(stage, nodes, node_prims, _scene_config,
+                           _mesh_config.bake_world_transform, &animations,
+                           &_warn, &err)) {
+      _err += err;
+      return false;
+    }
+  }
 
-    return false;
+  if (changed_paths) {
+    std::unordered_map<std::string, uint64_t> node_handles;
+    for (const auto &node : prev_nodes) {
+      if (node.handle) {
+        node_handles[node.abs_path] = node.handle;
+      }
+    }
+
+    for (auto &node : nodes) {
+      const auto it = node_handles.find(node.abs_path);
+      if (it != node_handles.end()) {
+        node.handle = it->second;
+      }
+    }
+
+    if (update) {
+      SortUpdatedIds(update->meshes);
+      SortUpdatedIds(update->removed_meshes);
+      SortUpdatedIds(update->materials);
+      SortUpdatedIds(update->textures);
+      SortUpdatedIds(update->images);
+      SortUpdatedIds(update->buffers);
+
+      update->nodes = !IsSameNodes(prev_nodes, nodes);
+      update->instances = !IsSameInstances(prev_instances, instances);
+      update->animations = !IsSameAnimations(prev_animations, animations);
+    }
   }
 
   // render_scene.meshMap = std::move(meshMap);
@@ -1728,6 +5224,8 @@ bool RenderSceneConverter::ConvertToRenderScene(const Stage &stage,
 
   render_scene.nodes = std::move(nodes);
   render_scene.meshes = std::move(meshes);
+  render_scene.animations = std::move(animations);
+  render_scene.instances = std::move(instances);
   render_scene.textures = std::move(textures);
   render_scene.images = std::move(images);
   render_scene.buffers = std::move(buffers);
@@ -1884,6 +5382,134 @@ std::string to_string(ComponentType cty) {
   return s;
 }
 
+std::string to_string(VertexVariability v) {
+  std::string s;
+  switch (v) {
+    case VertexVariability::Constant: {
+      s = "constant";
+      break;
+    }
+    case VertexVariability::Uniform: {
+      s = "uniform";
+      break;
+    }
+    case VertexVariability::Varying: {
+      s = "varying";
+      break;
+    }
+    case VertexVariability::Vertex: {
+      s = "vertex";
+      break;
+    }
+    case VertexVariability::FaceVarying: {
+      s = "facevarying";
+      break;
+    }
+    case VertexVariability::Indexed: {
+      s = "indexed";
+      break;
+    }
+  }
+
+  return s;
+}
+
+std::string to_string(VertexAttributeFormat f) {
+  std::string s;
+  switch (f) {
+    case VertexAttributeFormat::Float: {
+      s = "float";
+      break;
+    }
+    case VertexAttributeFormat::Vec2: {
+      s = "float2";
+      break;
+    }
+    case VertexAttributeFormat::Vec3: {
+      s = "float3";
+      break;
+    }
+    case VertexAttributeFormat::Vec4: {
+      s = "float4";
+      break;
+    }
+    case VertexAttributeFormat::Ivec2: {
+      s = "int2";
+      break;
+    }
+    case VertexAttributeFormat::Uvec4: {
+      s = "uint4";
+      break;
+    }
+    case VertexAttributeFormat::Double: {
+      s = "double";
+      break;
+    }
+    case VertexAttributeFormat::Dvec2: {
+      s = "double2";
+      break;
+    }
+    case VertexAttributeFormat::Dvec3: {
+      s = "double3";
+      break;
+    }
+    case VertexAttributeFormat::Dvec4: {
+      s = "double4";
+      break;
+    }
+  }
+
+  return s;
+}
+
+std::string to_string(VertexElementSemantic semantic) {
+  std::string s;
+  switch (semantic) {
+    case VertexElementSemantic::Position: {
+      s = "position";
+      break;
+    }
+    case VertexElementSemantic::Normal: {
+      s = "normal";
+      break;
+    }
+    case VertexElementSemantic::Texcoord: {
+      s = "texcoord";
+      break;
+    }
+    case VertexElementSemantic::Primvar: {
+      s = "primvar";
+      break;
+    }
+  }
+
+  return s;
+}
+
+std::string to_string(VertexElementFormat format) {
+  std::string s;
+  switch (format) {
+    case VertexElementFormat::Float: {
+      s = "float";
+      break;
+    }
+    case VertexElementFormat::Half: {
+      s = "half";
+      break;
+    }
+    case VertexElementFormat::SNorm16: {
+      s = "snorm16";
+      break;
+    }
+    case VertexElementFormat::UNorm16: {
+      s = "unorm16";
+      break;
+    }
+  }
+
+  return s;
+}
+
 std::string to_string(UVTexture::WrapMode mode) {
   std::string s;
   switch (mode) {
@@ -1931,6 +5557,11 @@ std::string DumpMesh(const RenderMesh &mesh, uint32_t indent) {
      << std::to_string(mesh.materialIds.size()) << "\n";
   ss << pprint::Indent(indent + 1) << "materialIds \""
      << value::print_array_snipped(mesh.materialIds) << "\"\n";
+  for (const auto &submesh : mesh.submeshes) {
+    ss << pprint::Indent(indent + 1) << "submesh face_offset="
+       << submesh.face_offset << " face_count=" << submesh.face_count
+       << " material_id=" << submesh.material_id << "\n";
+  }
   ss << pprint::Indent(indent + 1) << "num_facevaryingNormals "
      << mesh.facevaryingNormals.size() << "\n";
   ss << pprint::Indent(indent + 1) << "facevaryingNormals \""
@@ -1943,6 +5574,39 @@ std::string DumpMesh(const RenderMesh &mesh, uint32_t indent) {
     ss << pprint::Indent(indent + 2) << "texcoords_" << uvs.first << " \""
        << value::print_array_snipped(uvs.second) << "\"\n";
   }
+  if (mesh.is_indexed) {
+    ss << pprint::Indent(indent + 1) << "is_indexed true\n";
+    ss << pprint::Indent(indent + 1) << "num_vertexNormals "
+       << mesh.vertexNormals.size() << "\n";
+    ss << pprint::Indent(indent + 1) << "vertexNormals \""
+       << value::print_array_snipped(mesh.vertexNormals) << "\"\n";
+    ss << pprint::Indent(indent + 1) << "num_vertexTexcoordSlots "
+       << std::to_string(mesh.vertexTexcoords.size()) << "\n";
+    for (const auto &uvs : mesh.vertexTexcoords) {
+      ss << pprint::Indent(indent + 1) << "num_vertexTexcoords_"
+         << std::to_string(uvs.first) << " " << uvs.second.size() << "\n";
+      ss << pprint::Indent(indent + 2) << "vertexTexcoords_" << uvs.first
+         << " \"" << value::print_array_snipped(uvs.second) << "\"\n";
+    }
+    ss << pprint::Indent(indent + 1) << "indices_componentType "
+       << to_string(mesh.indices.componentType) << "\n";
+  }
+  if (mesh.meshlets.size()) {
+    ss << pprint::Indent(indent + 1) << "num_meshlets " << mesh.meshlets.size()
+       << "\n";
+  }
+  if (mesh.vertexLayout.elements.size()) {
+    ss << pprint::Indent(indent + 1) << "vertexBuffer_stride "
+       << mesh.vertexLayout.stride << "\n";
+    ss << pprint::Indent(indent + 1) << "vertexBuffer_bytes "
+       << mesh.vertexBuffer.data.size() << "\n";
+    for (const auto &element : mesh.vertexLayout.elements) {
+      ss << pprint::Indent(indent + 2) << "vertexElement \""
+         << to_string(element.semantic) << "\" slot=" << element.slot
+         << " format=\"" << to_string(element.format)
+         << "\" offset=" << element.offset << "\n";
+    }
+  }
 
   // TODO: primvars
 
@@ -2150,6 +5814,73 @@ std::string DumpBuffer(const BufferData &buffer, uint32_t indent) {
   return ss.str();
 }
 
+std::string DumpNode(const Node &node, uint32_t indent) {
+  std::stringstream ss;
+
+  std::string type;
+  switch (node.nodeType) {
+    case NodeType::Xform:
+      type = "xform";
+      break;
+    case NodeType::Mesh:
+      type = "mesh";
+      break;
+    case NodeType::PointLight:
+      type = "pointLight";
+      break;
+    case NodeType::DomeLight:
+      type = "domeLight";
+      break;
+    case NodeType::Camera:
+      type = "camera";
+      break;
+  }
+
+  ss << "Node {\n";
+  ss << pprint::Indent(indent + 1) << "type \"" << type << "\"\n";
+  ss << pprint::Indent(indent + 1) << "id " << node.id << "\n";
+  ss << pprint::Indent(indent + 1) << "abs_path \"" << node.abs_path
+     << "\"\n";
+  ss << pprint::Indent(indent + 1) << "children \""
+     << value::print_array_snipped(node.children) << "\"\n";
+  ss << pprint::Indent(indent) << "}\n";
+
+  return ss.str();
+}
+
+std::string DumpMeshInstances(const MeshInstances &instances,
+                              uint32_t indent) {
+  std::stringstream ss;
+
+  ss << "MeshInstances {\n";
+  ss << pprint::Indent(indent + 1) << "abs_path \"" << instances.abs_path
+     << "\"\n";
+  ss << pprint::Indent(indent + 1) << "mesh_id " << instances.mesh_id << "\n";
+  ss << pprint::Indent(indent + 1) << "num_instances "
+     << instances.transforms.size() << "\n";
+  ss << pprint::Indent(indent) << "}\n";
+
+  return ss.str();
+}
+
+std::string DumpAnimation(const Animation &anim, uint32_t indent) {
+  std::stringstream ss;
+
+  ss << "Animation {\n";
+  ss << pprint::Indent(indent + 1) << "path \"" << anim.path << "\"\n";
+  for (const auto &channel : anim.channels) {
+    ss << pprint::Indent(indent + 1) << "channel target_node="
+       << channel.taget_node
+       << " transforms=" << channel.transforms.samples.size()
+       << " translations=" << channel.translations.samples.size()
+       << " rotations=" << channel.rotations.samples.size()
+       << " scales=" << channel.scales.samples.size() << "\n";
+  }
+  ss << pprint::Indent(indent) << "}\n";
+
+  return ss.str();
+}
+
 }  // namespace
 
 std::string DumpRenderScene(const RenderScene &scene,
@@ -2166,6 +5897,7 @@ std::string DumpRenderScene(const RenderScene &scene,
   ss << "title RenderScene\n";
   ss << "// # of Meshes : " << scene.meshes.size() << "\n";
   ss << "// # of Animations : " << scene.animations.size() << "\n";
+  ss << "// # of MeshInstances : " << scene.instances.size() << "\n";
   ss << "// # of Materials : " << scene.materials.size() << "\n";
   ss << "// # of UVTextures : " << scene.textures.size() << "\n";
   ss << "// # of TextureImages : " << scene.images.size() << "\n";
@@ -2173,6 +5905,13 @@ std::string DumpRenderScene(const RenderScene &scene,
 
   ss << "\n";
 
+  ss << "nodes {\n";
+  for (size_t i = 0; i < scene.nodes.size(); i++) {
+    ss << "[" << i << "] " << DumpNode(scene.nodes[i], 1);
+  }
+  ss << "}\n";
+
+  ss << "\n";
   ss << "meshes {\n";
   for (size_t i = 0; i < scene.meshes.size(); i++) {
     ss << "[" << i << "] " << DumpMesh(scene.meshes[i], 1);
@@ -2207,7 +5946,19 @@ std::string DumpRenderScene(const RenderScene &scene,
   }
   ss << "}\n";
 
-  // ss << "TODO: Animations, ...\n";
+  ss << "\n";
+  ss << "instances {\n";
+  for (size_t i = 0; i < scene.instances.size(); i++) {
+    ss << "[" << i << "] " << DumpMeshInstances(scene.instances[i], 1);
+  }
+  ss << "}\n";
+
+  ss << "\n";
+  ss << "animations {\n";
+  for (size_t i = 0; i < scene.animations.size(); i++) {
+    ss << "[" << i << "] " << DumpAnimation(scene.animations[i], 1);
+  }
+  ss << "}\n";
 
   return ss.str();
 }
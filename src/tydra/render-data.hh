@@ -105,7 +105,7 @@ struct StringAndIdMap {
 // TODO: AttributeBlock support
 template <typename T>
 struct AnimationSample {
-  float t{0.0};  // time is represented as float
+  float t{0.0};  // time in seconds(timeCode / timeCodesPerSecond)
   T value;
 };
 
@@ -248,6 +248,40 @@ struct VertexAttribute {
   }
 };
 
+// Element of interleaved vertex buffer.
+enum class VertexElementSemantic {
+  Position,  // RenderMesh::points
+  Normal,    // RenderMesh::facevaryingNormals or vertexNormals
+  Texcoord,  // RenderMesh::facevaryingTexcoords or vertexTexcoords
+  Primvar,   // RenderMesh::primvars(Float, Vec2, Vec3 or Vec4 format)
+};
+
+// Component format of the element.
+enum class VertexElementFormat {
+  Float,    // 32bit float
+  Half,     // 16bit float
+  SNorm16,  // [-1, 1] -> int16(e.g. normals). Values are clamped.
+  UNorm16,  // [0, 1] -> uint16(e.g. UVs in [0, 1]). Values are clamped.
+};
+
+std::string to_string(VertexElementSemantic semantic);
+std::string to_string(VertexElementFormat format);
+
+struct VertexElement {
+  VertexElementSemantic semantic{VertexElementSemantic::Position};
+  uint32_t slot{0};  // slot ID for Texcoord and Primvar.
+  VertexElementFormat format{VertexElementFormat::Float};
+
+  // Filled by BuildInterleavedVertexBuffer()
+  uint32_t num_components{0};
+  uint32_t offset{0};  // byte offset in a vertex(4 bytes aligned)
+};
+
+struct VertexBufferLayout {
+  std::vector<VertexElement> elements;
+  uint32_t stride{0};  // in bytes(multiple of 4)
+};
+
 enum class ColorSpace {
   sRGB,
   Linear,
@@ -316,10 +350,15 @@ struct Animation {
   std::vector<AnimationChannel> channels;
 };
 
+// nodes[0] is the Stage root("/"). Prims without Xform(e.g. Scope) are
+// included only when they have Xformable descendants.
 struct Node {
   NodeType nodeType{NodeType::Xform};
 
-  int32_t id;  // Index to node content(e.g. meshes[id] when nodeTypes == Mesh
+  int32_t id{-1};  // Index to node content(e.g. meshes[id] when nodeTypes ==
+                   // Mesh). -1 = no content
+
+  std::string abs_path;  // absolute Prim path in USD
 
   std::vector<uint32_t> children;
 
@@ -330,6 +369,50 @@ struct Node {
   uint64_t handle{0};  // Handle ID for Graphics API. 0 = invalid
 };
 
+///
+/// Cluster of triangles for mesh shader and GPU-driven(cluster) culling.
+///
+struct Meshlet {
+  uint32_t vertex_offset{0};    // index to RenderMesh::meshletVertices
+  uint32_t triangle_offset{0};  // index to RenderMesh::meshletTriangles
+  uint32_t vertex_count{0};
+  uint32_t triangle_count{0};
+
+  // Bounding sphere
+  vec3 center{0.0f, 0.0f, 0.0f};
+  float radius{0.0f};
+
+  // Cone of triangle normals. Every triangle normal `n` in the meshlet
+  // satisfies `dot(n, cone_axis) >= cone_cutoff`(cosine of the cone
+  // angle). cone_cutoff <= 0 means the cone is too wide to be used for
+  // backface culling.
+  vec3 cone_axis{0.0f, 0.0f, 1.0f};
+  float cone_cutoff{-1.0f};
+
+  // Material of the triangles(meshlet does not span multiple materials).
+  // -1 = no material assigned.
+  int32_t material_id{-1};
+};
+
+// Contiguous range of faces which share the same material. Apps can issue a
+// draw call per range.
+struct SubmeshRange {
+  uint32_t face_offset{0};   // index to RenderMesh::faceVertexCounts
+  uint32_t face_count{0};
+  uint32_t index_offset{0};  // index to RenderMesh::faceVertexIndices
+  uint32_t index_count{0};
+  int32_t material_id{-1};   // -1 = no material assigned
+};
+
+///
+/// Faces of GeomMesh bound to a material by GeomSubset(`familyName` =
+/// "materialBind").
+///
+struct MaterialSubset {
+  std::vector<uint32_t> faces;  // face indices of GeomMesh
+  int64_t material_id{-1};      // RenderMaterial index
+};
+
 // Currently normals and texcoords are converted as facevarying attribute.
 struct RenderMesh {
   std::string element_name;  // element(leaf) Prim name
@@ -353,11 +436,46 @@ struct RenderMesh {
   std::vector<int32_t>
       materialIds;  // per-face material. -1 = no material assigned
 
+  // Faces sorted by `materialIds`. See
+  // MeshConverterConfig::sort_faces_by_material.
+  std::vector<SubmeshRange> submeshes;
+
   std::map<uint32_t, VertexAttribute> primvars;  // Excludes texcoords
 
   // Index value = key to `primvars`
   StringAndIdMap primvarsMap;
 
+  // Indexed(vertex-welded) mesh. See MeshConverterConfig::build_indexed_mesh.
+  //
+  // When true, `points`, `vertexNormals`, `vertexTexcoords` and
+  // faceVarying/vertex `primvars` are per-vertex arrays referenced by
+  // `faceVertexIndices`, and `facevaryingNormals` and `facevaryingTexcoords`
+  // are empty.
+  bool is_indexed{false};
+  std::vector<vec3> vertexNormals;
+  std::unordered_map<uint32_t, std::vector<vec2>> vertexTexcoords;
+
+  // `faceVertexIndices` packed in UInt16(when the number of vertices <=
+  // 65536) or UInt32. Filled for indexed mesh.
+  BufferData indices;
+
+  // Interleaved vertex buffer. See
+  // MeshConverterConfig::build_interleaved_vertex_buffer.
+  // A vertex per `points` for indexed mesh(draw with `indices`), otherwise a
+  // vertex per face-corner(draw without index buffer).
+  BufferData vertexBuffer;
+  VertexBufferLayout vertexLayout;
+
+  // Meshlets. See MeshConverterConfig::build_meshlets.
+  //
+  // `meshletVertices` stores vertex indices(the same index space as
+  // `faceVertexIndices` for indexed mesh, face-corner index otherwise) of
+  // each meshlet, and `meshletTriangles` stores 3 local vertex
+  // indices(index to the meshlet's vertices) per triangle.
+  std::vector<Meshlet> meshlets;
+  std::vector<uint32_t> meshletVertices;
+  std::vector<uint8_t> meshletTriangles;
+
   uint64_t handle{0};  // Handle ID for Graphics API. 0 = invalid
 };
 
@@ -493,6 +611,21 @@ struct RenderMaterial {
   uint64_t handle{0};  // Handle ID for Graphics API. 0 = invalid
 };
 
+///
+/// Instances of a RenderMesh(PointInstancer prototype, or a mesh in
+/// `instanceable` Prims). The mesh is stored once in `RenderScene::meshes` and
+/// is not referenced from `RenderScene::nodes`.
+///
+struct MeshInstances {
+  std::string abs_path;  // PointInstancer path, or the instanceable Prim path
+                         // of the first instance.
+  int32_t mesh_id{-1};   // index to RenderScene::meshes
+
+  // Matrix of each instance which transforms RenderMesh points to the world
+  // space. Invisible instances(`invisibleIds`) are not included.
+  std::vector<mat4> transforms;
+};
+
 // Simple glTF-like Scene Graph
 class RenderScene {
  public:
@@ -502,6 +635,7 @@ class RenderScene {
   std::vector<UVTexture> textures;
   std::vector<RenderMesh> meshes;
   std::vector<Animation> animations;
+  std::vector<MeshInstances> instances;
   std::vector<BufferData>
       buffers;  // Various data storage(e.g. primvar texcoords)
 
@@ -571,6 +705,52 @@ std::vector<UsdPrimvarReader_float2> ExtractPrimvarReadersFromMaterialNode(const
 
 struct MeshConverterConfig {
   bool triangulate{true};
+
+  // Transform `points` and `facevaryingNormals` of RenderMesh to world space
+  // (Xform evaluated at default time). Useful for exporters which does not
+  // support node hierarchy.
+  // Mesh nodes get identity world matrix(their local matrix cancels the
+  // parent's world matrix). xformOp animations of Mesh nodes and their
+  // ancestors are not exported(with a warning for ancestors). The winding order
+  // of faces is reversed when the world matrix has negative determinant.
+  bool bake_world_transform{false};
+
+  // Weld face-corners which have identical point index, normal, texcoords
+  // and primvar values, and output indexed mesh(`RenderMesh::is_indexed`)
+  // with a compact vertex buffer and a 16/32bit index buffer, instead of
+  // expanding attributes to one vertex per face-corner.
+  bool build_indexed_mesh{false};
+
+  // The number of threads to process faces of a single mesh(currently
+  // triangulation of meshes with many faces). 0 = use hardware concurrency.
+  // Independent of RenderSceneConverterConfig::num_threads.
+  uint32_t num_threads{1};
+
+  // Pack vertex attributes into a single interleaved vertex
+  // buffer(`RenderMesh::vertexBuffer`) with `vertex_layout`, so that apps can
+  // upload it to GPU without repacking.
+  bool build_interleaved_vertex_buffer{false};
+
+  // Elements of the interleaved vertex buffer in this order. Empty = Position,
+  // Normal and Texcoord(slot 0) in Float.
+  std::vector<VertexElement> vertex_layout;
+
+  // Partition triangulated mesh into meshlets(RenderMesh::meshlets) with at
+  // most `meshlet_max_vertices` vertices and `meshlet_max_triangles`
+  // triangles each. Requires `triangulate`.
+  bool build_meshlets{false};
+  uint32_t meshlet_max_vertices{64};    // [3, 256]
+  uint32_t meshlet_max_triangles{124};  // [1, 512]
+
+  // Reorder triangles for post-transform vertex cache efficiency and
+  // vertices for vertex fetch locality(See OptimizeVertexCache). Requires
+  // `triangulate`. Applied before building meshlets and the vertex buffer.
+  bool optimize_vertex_cache{false};
+
+  // Sort faces by material(per-face material from GeomSubset) and fill
+  // `RenderMesh::submeshes`(See SortFacesByMaterial). Face order is not
+  // changed for a mesh with a single material.
+  bool sort_faces_by_material{true};
 };
 
 struct MaterialConverterConfig {
@@ -623,6 +803,66 @@ struct RenderSceneConverterConfig {
   // false: no actual texture file/asset access.
   // App/User must setup TextureImage manually after the conversion.
   bool load_texture_assets{true};
+
+  // The number of threads to convert Materials and Meshes.
+  // 0 = use hardware concurrency. 1 = convert on the calling thread.
+  // The output is identical regardless of the number of threads, but
+  // TextureImageLoaderFunction may be called concurrently when this value is
+  // not 1.
+  uint32_t num_threads{1};
+
+  // Bake time-varying xformOps(timeSamples) of each Prim into translation,
+  // rotation and scale channels of `RenderScene::animations`(a `transforms`
+  // channel when the local matrix has shear). Animated Prims are sampled in
+  // parallel with `num_threads`.
+  bool export_animations{true};
+
+  // Interpolation of timeSamples. Held is exported as Step.
+  value::TimeSampleInterpolationType animation_interpolation{
+      value::TimeSampleInterpolationType::Linear};
+
+  // Also sample at this interval(in timeCodes) between the first and the last
+  // timeSample, since a linear TRS channel does not reproduce the
+  // interpolation of xformOp values(e.g. rotation angles over 180 degrees)
+  // exactly. 0 = sample at authored timeSamples only.
+  double animation_sample_interval{0.0};
+
+  // Convert the prototype meshes of PointInstancer once and emit their
+  // instance transforms to `RenderScene::instances`. Meshes of `instanceable`
+  // Prims having the same content(geometry, normals, primvars and bound
+  // Materials) are also converted once per prototype. Off by default since
+  // prototype meshes are then drawn only through `instances`.
+  // false: PointInstancers are ignored and each instance of `instanceable`
+  // Prims is converted as a separate mesh.
+  bool build_instances{false};
+};
+
+///
+/// RenderScene elements modified by RenderSceneConverter::UpdateRenderScene.
+///
+/// Ids are indices to the arrays of RenderScene(sorted in ascending order).
+/// GPU resources of the listed ids need to be (re)uploaded; elements not
+/// listed keep their content, id and `handle`.
+///
+struct RenderSceneUpdate {
+  std::vector<int32_t> meshes;  // converted(new or modified) meshes
+  std::vector<int32_t> removed_meshes;  // emptied. The id is not reused.
+  std::vector<int32_t> materials;
+  std::vector<int32_t> textures;
+  std::vector<int32_t> images;
+  std::vector<int32_t> buffers;  // texel data of `images`
+
+  // Nodes, MeshInstances and Animations are rebuilt on each update. true
+  // when the content differs from the previous one.
+  bool nodes{false};
+  bool instances{false};
+  bool animations{false};
+
+  bool empty() const {
+    return meshes.empty() && removed_meshes.empty() && materials.empty() &&
+           textures.empty() && images.empty() && buffers.empty() && !nodes &&
+           !instances && !animations;
+  }
 };
 
 class RenderSceneConverter {
@@ -657,6 +897,45 @@ class RenderSceneConverter {
   ///
   bool ConvertToRenderScene(const Stage &stage, RenderScene *scene);
 
+  ///
+  /// Update RenderScene for the modification of Prims at `changed_paths`.
+  ///
+  /// A changed Prim path means the whole Prim subtree may be changed. Only
+  /// GeomMeshes at, under or above the changed Prims(and GeomMeshes whose
+  /// bound Material is changed or modified(texcoords depend on the UV
+  /// primvars read by the Material)) and Materials at, under or above the
+  /// changed Prims(with their textures) are converted again. Converted
+  /// elements are written to their previous slots, new elements are appended,
+  /// and removed GeomMeshes are left as empty RenderMesh, so ids of the other
+  /// elements are kept.
+  ///
+  /// Pass property paths(e.g. `/root.xformOp:translate`) when only properties
+  /// are changed. A changed property of an ancestor Prim does not convert the
+  /// GeomMeshes again, unless `MeshConverterConfig::bake_world_transform` is
+  /// true(nodes are always rebuilt).
+  ///
+  /// Root Prim names of IncrementalComposer::updated_prims() and
+  /// removed_prims() can be passed as `/name` paths.
+  ///
+  /// NOTE: Shaders outside of the Material Prim are not tracked. Pass the
+  /// Material path when such a Shader is modified.
+  ///
+  /// @param[in] stage Stage. It may be a different object from the Stage of
+  /// the previous conversion.
+  /// @param[in] changed_paths Absolute Prim paths of added, modified or
+  /// removed Prims, or absolute property paths of modified properties.
+  /// @param[inout] scene RenderScene built by ConvertToRenderScene(or
+  /// UpdateRenderScene) of this converter. The content is undefined when
+  /// this function fails.
+  /// @param[out] update Optional. Modified elements.
+  ///
+  /// @return true upon success.
+  ///
+  bool UpdateRenderScene(const Stage &stage,
+                         const std::vector<Path> &changed_paths,
+                         RenderScene *scene,
+                         RenderSceneUpdate *update = nullptr);
+
   const std::string &GetWarning() const { return _warn; }
 
   const std::string &GetError() const { return _err; }
@@ -669,6 +948,8 @@ class RenderSceneConverter {
   StringAndIdMap bufferMap;
   std::vector<Node> nodes;
   std::vector<RenderMesh> meshes;
+  std::vector<Animation> animations;
+  std::vector<MeshInstances> instances;
   std::vector<RenderMaterial> materials;
   std::vector<UVTexture> textures;
   std::vector<TextureImage> images;
@@ -683,11 +964,25 @@ class RenderSceneConverter {
   ///
   /// @return true when success.
   ///
-  /// TODO: per-face material(GeomSubset)
-  ///
   bool ConvertMesh(const int64_t rmaterial_d, const tinyusdz::GeomMesh &mesh,
                    RenderMesh *dst);
 
+  ///
+  /// ConvertMesh with per-face material.
+  ///
+  /// @param[in] rmaterial_id RenderMaterial index of faces not in
+  /// `material_subsets`. -1 if no material assigned.
+  /// @param[in] material_subsets Faces bound to other materials(GeomSubset).
+  /// Latter subset wins when a face is in multiple subsets.
+  /// @param[in] mesh Input GeomMesh
+  /// @param[out] dst RenderMesh output
+  ///
+  /// @return true when success.
+  ///
+  bool ConvertMesh(const int64_t rmaterial_id,
+                   const std::vector<MaterialSubset> &material_subsets,
+                   const tinyusdz::GeomMesh &mesh, RenderMesh *dst);
+
   ///
   /// Convert USD Material/Shader to renderer-friendly Material
   ///
@@ -713,6 +1008,19 @@ class RenderSceneConverter {
       const TypedAttributeWithFallback<Animatable<T>> &param,
       const std::string &param_name, ShaderParam<Dty> &dst_param);
 
+  // Setup `worker` to convert Materials/Meshes on a worker thread(configs,
+  // AssetResolutionResolver and Stage are copied).
+  void SetupWorker(RenderSceneConverter &worker) const;
+
+  // `changed_paths` = nullptr: Full conversion.
+  bool ConvertStage(const Stage &stage,
+                    const std::vector<Path> *changed_paths,
+                    RenderScene *scene, RenderSceneUpdate *update);
+
+  // Material ids(bound Material, then GeomSubset Materials) of each
+  // RenderMesh at the last conversion. Used to detect binding changes.
+  std::vector<std::vector<int64_t>> _mesh_material_ids;
+
   AssetResolutionResolver _asset_resolver;
 
   RenderSceneConverterConfig _scene_config;
@@ -729,6 +1037,99 @@ class RenderSceneConverter {
   std::string _warn;
 };
 
+///
+/// Weld face-corners of non-indexed RenderMesh which have identical point
+/// index, faceVarying normal, texcoords and faceVarying primvar values, and
+/// convert it to indexed mesh(`RenderMesh::is_indexed`).
+///
+/// `faceVertexCounts` and `materialIds` are not modified. Vertices are
+/// ordered by their first occurrence in `faceVertexIndices`, so the result
+/// is deterministic.
+///
+/// @param[inout] mesh RenderMesh.
+/// @param[out] err Error message.
+///
+/// @return true upon success.
+///
+bool WeldFaceVertices(RenderMesh &mesh, std::string *err = nullptr);
+
+///
+/// Pack vertex attributes of RenderMesh into a single interleaved vertex
+/// buffer.
+///
+/// For indexed mesh(`RenderMesh::is_indexed`) a vertex is emitted per
+/// `points` element, otherwise per face-corner(`faceVertexIndices`).
+/// Elements whose attribute does not exist in the mesh(e.g. no normals) are
+/// filled with zeros.
+///
+/// @param[in] mesh RenderMesh.
+/// @param[in] elements Elements of a vertex in this order.
+/// @param[out] layout Vertex layout(offsets and stride are computed).
+/// @param[out] dst Vertex buffer.
+/// @param[out] err Error message.
+///
+/// @return true upon success.
+///
+bool BuildInterleavedVertexBuffer(const RenderMesh &mesh,
+                                  const std::vector<VertexElement> &elements,
+                                  VertexBufferLayout *layout, BufferData *dst,
+                                  std::string *err = nullptr);
+
+///
+/// Reorder triangles of triangulated RenderMesh for post-transform vertex
+/// cache efficiency(Forsyth's linear-speed vertex cache optimization), then
+/// reorder vertices in the order of first use for vertex fetch locality.
+///
+/// faceVarying(per face-corner) attributes and `materialIds` follow the
+/// triangle order, and `points`, per-vertex attributes and vertex primvars
+/// follow the vertex order. Existing meshlets and interleaved vertex buffer
+/// are not updated, so call this before building them. `submeshes` are
+/// cleared(call SortFacesByMaterial afterwards).
+///
+/// @param[inout] mesh Triangulated RenderMesh.
+/// @param[out] err Error message.
+///
+/// @return true upon success.
+///
+bool OptimizeVertexCache(RenderMesh &mesh, std::string *err = nullptr);
+
+///
+/// Stable sort faces of RenderMesh by `materialIds`(ascending. -1 first)
+/// and fill `submeshes`, a range per material. A single range of material
+/// -1 is emitted when `materialIds` is empty.
+///
+/// faceVarying(per face-corner) and uniform attributes follow the face
+/// order.
+///
+/// @param[inout] mesh RenderMesh.
+/// @param[out] err Error message.
+///
+/// @return true upon success.
+///
+bool SortFacesByMaterial(RenderMesh &mesh, std::string *err = nullptr);
+
+///
+/// Partition triangulated RenderMesh into meshlets.
+///
+/// Triangles are greedily clustered: a meshlet grows with the adjacent
+/// triangle which adds the fewest new vertices, and the next meshlet starts
+/// from a neighbor of the previous one to keep spatial locality. Bounding
+/// sphere and normal cone of each meshlet are computed. A meshlet contains
+/// triangles of a single material(`materialIds`).
+///
+/// @param[inout] mesh Triangulated RenderMesh. `meshlets`, `meshletVertices`
+/// and `meshletTriangles` are filled.
+/// @param[in] max_vertices The maximum number of vertices per meshlet.
+/// [3, 256]
+/// @param[in] max_triangles The maximum number of triangles per meshlet.
+/// [1, 512]
+/// @param[out] err Error message.
+///
+/// @return true upon success.
+///
+bool BuildMeshlets(RenderMesh &mesh, uint32_t max_vertices = 64,
+                   uint32_t max_triangles = 124, std::string *err = nullptr);
+
 // For debug
 // Supported format: "kdl" (default. https://kdl.dev/), "json"
 //
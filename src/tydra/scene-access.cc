@@ -3,11 +3,19 @@
 //
 #include "scene-access.hh"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#if defined(TINYUSDZ_ENABLE_THREAD)
+#include <mutex>
+#endif
+
 #include "common-macros.inc"
 #include "pprinter.hh"
 #include "prim-pprint.hh"
 #include "prim-types.hh"
 #include "primvar.hh"
+#include "thread-pool.hh"
 #include "tiny-format.hh"
 #include "tydra/prim-apply.hh"
 #include "usdGeom.hh"
@@ -1860,6 +1868,218 @@ bool VisitPrims(const tinyusdz::Stage &stage, VisitPrimFunction visitor_fun,
   return true;
 }
 
+namespace {
+
+struct ParallelVisitContext {
+  ThreadPool *pool{nullptr};
+  ParallelVisitPrimFunction visitor_fun{nullptr};
+  void *userdata{nullptr};
+  uint32_t max_task_depth{64};
+
+  std::atomic<bool> terminated{false};
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  std::mutex err_mutex;
+#endif
+  std::string err;
+
+  void push_error(const std::string &msg) {
+#if defined(TINYUSDZ_ENABLE_THREAD)
+    std::lock_guard<std::mutex> lock(err_mutex);
+#endif
+    err += msg;
+  }
+};
+
+//
+// Get child Prims in traversal order.
+// Use `primChildren` if available, as done in VisitPrimsRec.
+//
+bool GetTraversalChildren(const Prim &prim,
+                          std::vector<const Prim *> *children,
+                          std::string *err) {
+  children->clear();
+
+  if (prim.metas().primChildren.size() == prim.children().size()) {
+    std::map<std::string, const Prim *> primNameTable;
+    for (size_t i = 0; i < prim.children().size(); i++) {
+      primNameTable.emplace(prim.children()[i].element_name(),
+                            &prim.children()[i]);
+    }
+
+    for (size_t i = 0; i < prim.metas().primChildren.size(); i++) {
+      value::token nameTok = prim.metas().primChildren[i];
+      const auto it = primNameTable.find(nameTok.str());
+      if (it != primNameTable.end()) {
+        children->push_back(it->second);
+      } else {
+        if (err) {
+          (*err) += fmt::format(
+              "Prim name `{}` in `primChildren` metadatum not found in this "
+              "Prim's children",
+              nameTok.str());
+        }
+        return false;
+      }
+    }
+
+  } else {
+    for (const auto &child : prim.children()) {
+      children->push_back(&child);
+    }
+  }
+
+  return true;
+}
+
+void ParallelVisitPrimsRec(ParallelVisitContext *ctx,
+                           const tinyusdz::Path &abs_path,
+                           const tinyusdz::Prim &prim, int32_t level) {
+  if (ctx->terminated.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  std::string fun_error;
+  bool prune_children{false};
+  bool ret = ctx->visitor_fun(abs_path, prim, level, ctx->pool->thread_index(),
+                              ctx->userdata, &prune_children, &fun_error);
+  if (!ret) {
+    if (fun_error.empty()) {
+      // early termination request.
+    } else {
+      ctx->push_error(
+          fmt::format("Visit function returned an error for Prim {} (id {})",
+                      abs_path.full_path_name(), prim.prim_id()));
+    }
+    ctx->terminated = true;
+    return;
+  }
+
+  if (prune_children) {
+    return;
+  }
+
+  std::vector<const Prim *> children;
+  std::string err;
+  if (!GetTraversalChildren(prim, &children, &err)) {
+    ctx->push_error(err);
+    ctx->terminated = true;
+    return;
+  }
+
+  for (const Prim *child : children) {
+    Path child_abs_path = abs_path.AppendPrim(child->element_name());
+    if (child->children().empty() ||
+        (uint32_t(level + 1) > ctx->max_task_depth)) {
+      // Leaf Prim or deep subtree. Visit in this task.
+      ParallelVisitPrimsRec(ctx, child_abs_path, *child, level + 1);
+    } else {
+      ctx->pool->submit([ctx, child_abs_path, child, level]() {
+        ParallelVisitPrimsRec(ctx, child_abs_path, *child, level + 1);
+      });
+    }
+  }
+}
+
+}  // namespace
+
+uint32_t GetParallelVisitThreadCount(const ParallelVisitOptions &options) {
+  return ThreadPool::resolve_num_threads(options.num_threads);
+}
+
+bool ParallelVisitPrims(const tinyusdz::Stage &stage,
+                        ParallelVisitPrimFunction visitor_fun, void *userdata,
+                        ParallelVisitOptions *options, std::string *err) {
+  if (!visitor_fun) {
+    PUSH_ERROR_AND_RETURN("`visitor_fun` is nullptr.");
+  }
+
+  ParallelVisitOptions default_options;
+  if (!options) {
+    options = &default_options;
+  }
+
+  ThreadPool pool(options->num_threads);
+  options->num_threads = pool.num_threads();
+
+  ParallelVisitContext ctx;
+  ctx.pool = &pool;
+  ctx.visitor_fun = visitor_fun;
+  ctx.userdata = userdata;
+  ctx.max_task_depth = options->max_task_depth;
+
+  std::vector<const Prim *> roots;
+
+  // if `primChildren` is available, use it
+  if (stage.metas().primChildren.size() == stage.root_prims().size()) {
+    std::map<std::string, const Prim *> primNameTable;
+    for (size_t i = 0; i < stage.root_prims().size(); i++) {
+      primNameTable.emplace(stage.root_prims()[i].element_name(),
+                            &stage.root_prims()[i]);
+    }
+
+    for (size_t i = 0; i < stage.metas().primChildren.size(); i++) {
+      value::token nameTok = stage.metas().primChildren[i];
+      const auto it = primNameTable.find(nameTok.str());
+      if (it != primNameTable.end()) {
+        roots.push_back(it->second);
+      } else {
+        PUSH_ERROR_AND_RETURN(fmt::format(
+            "Prim name `{}` in root Layer's `primChildren` metadatum not "
+            "found in Layer root.",
+            nameTok.str()));
+      }
+    }
+  } else {
+    for (const auto &root : stage.root_prims()) {
+      roots.push_back(&root);
+    }
+  }
+
+  for (const Prim *root : roots) {
+    Path root_abs_path("/" + root->element_name(), /* prop part */ "");
+    ParallelVisitContext *pctx = &ctx;
+    pool.submit([pctx, root_abs_path, root]() {
+      ParallelVisitPrimsRec(pctx, root_abs_path, *root, /* root level */ 0);
+    });
+  }
+
+  pool.wait();
+
+  if (!ctx.err.empty()) {
+    PUSH_ERROR_AND_RETURN(ctx.err);
+  }
+
+  return !ctx.terminated.load();
+}
+
+bool VisitPrims(const tinyusdz::FrozenStage &stage,
+                VisitPrimFunction visitor_fun, void *userdata,
+                std::string *err) {
+  for (size_t i = 0; i < stage.size(); i++) {
+    const Prim &prim = stage.prim(i);
+    const FrozenPrimNode &node = stage.node(i);
+
+    std::string fun_error;
+    bool ret = visitor_fun(prim.absolute_path(), prim, int32_t(node.depth),
+                           userdata, &fun_error);
+    if (!ret) {
+      if (fun_error.empty()) {
+        // early termination request.
+      } else {
+        if (err) {
+          (*err) += fmt::format(
+              "Visit function returned an error for Prim {} (id {})",
+              prim.absolute_path().full_path_name(), prim.prim_id());
+        }
+      }
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool GetProperty(const tinyusdz::Prim &prim, const std::string &attr_name,
                  Property *out_prop, std::string *err) {
 #define GET_PRIM_PROPERTY(__ty)                                         \
@@ -2043,9 +2263,6 @@ bool BuildXformNodeFromStageRec(
   XformNode *nodeOut, /* out */
   value::matrix4d rootMat,
   const double t, const tinyusdz::value::TimeSampleInterpolationType tinterp) {
-  // TODO: time
-  (void)t;
-  (void)tinterp;
   (void)stage;
 
   if (!nodeOut) {
@@ -2068,8 +2285,8 @@ bool BuildXformNodeFromStageRec(
   if (IsXformablePrim(*prim)) {
     bool resetXformStack{false};
 
-    // TODO: t, tinterp
-    value::matrix4d localMat = GetLocalTransform(*prim, &resetXformStack);
+    value::matrix4d localMat =
+        GetLocalTransform(*prim, &resetXformStack, t, tinterp);
     DCOUT("local mat = " << localMat);
 
     value::matrix4d worldMat = rootMat;
@@ -2181,6 +2398,257 @@ std::string DumpXformNode(
 
 }
 
+namespace {
+
+constexpr uint32_t kMaxXformCacheDepth = 1024 * 128;
+
+// Note on time code comparison: TimeCode::Default() is NaN.
+bool IsSameTimeCode(const double a, const double b) {
+  if (std::isnan(a) || std::isnan(b)) {
+    return std::isnan(a) && std::isnan(b);
+  }
+  return a == b;
+}
+
+}  // namespace
+
+bool XformCache::build(const tinyusdz::Stage &stage, const double t,
+                       const tinyusdz::value::TimeSampleInterpolationType tinterp,
+                       std::string *err) {
+  _items.clear();
+  _varying_items.clear();
+  _local_matrices.clear();
+  _world_matrices.clear();
+  _time_varying.clear();
+  _valid = false;
+
+  // Collect Prims in depth-first order, so that parent Prim is always
+  // evaluated before its children.
+  struct StackItem {
+    const Prim *prim;
+    int64_t parent_prim_id;
+    bool parent_varying;
+    uint32_t depth;
+  };
+
+  std::vector<StackItem> stack;
+  for (auto it = stage.root_prims().rbegin(); it != stage.root_prims().rend();
+       ++it) {
+    stack.push_back({&(*it), -1, false, 0});
+  }
+
+  int64_t max_prim_id{0};
+
+  while (!stack.empty()) {
+    StackItem si = stack.back();
+    stack.pop_back();
+
+    if (si.depth > kMaxXformCacheDepth) {
+      PUSH_ERROR_AND_RETURN("Prim hierarchy too deep.");
+    }
+
+    const Prim *prim = si.prim;
+    if (prim->prim_id() < 1) {
+      PUSH_ERROR_AND_RETURN(fmt::format(
+          "Prim `{}` does not have valid prim_id. Call Stage::commit() before "
+          "building XformCache.",
+          prim->element_name()));
+    }
+
+    Item item;
+    item.prim = prim;
+    item.prim_id = prim->prim_id();
+    item.parent_prim_id = si.parent_prim_id;
+
+    const Xformable *xformable{nullptr};
+    if (IsXformablePrim(*prim) && CastToXformable(*prim, &xformable) &&
+        xformable) {
+      item.xformable = true;
+      item.local_varying = xformable->has_timesamples();
+    }
+    item.world_varying = item.local_varying || si.parent_varying;
+
+    max_prim_id = (std::max)(max_prim_id, item.prim_id);
+
+    if (item.world_varying) {
+      _varying_items.push_back(_items.size());
+    }
+    _items.push_back(item);
+
+    const auto &children = prim->children();
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      stack.push_back(
+          {&(*it), item.prim_id, item.world_varying, si.depth + 1});
+    }
+  }
+
+  const size_t n = size_t(max_prim_id) + 1;
+  _local_matrices.assign(n, value::matrix4d::identity());
+  _world_matrices.assign(n, value::matrix4d::identity());
+  _time_varying.assign(n, 0);
+
+  for (const auto &item : _items) {
+    _time_varying[size_t(item.prim_id)] = item.world_varying ? 1 : 0;
+  }
+
+  for (const auto &item : _items) {
+    if (!evaluate_item(item, t, tinterp, _local_matrices, _world_matrices,
+                       err)) {
+      return false;
+    }
+  }
+
+  _t = t;
+  _tinterp = tinterp;
+  _valid = true;
+
+  return true;
+}
+
+bool XformCache::evaluate_item(
+    const Item &item, const double t,
+    const tinyusdz::value::TimeSampleInterpolationType tinterp,
+    std::vector<value::matrix4d> &local_matrices,
+    std::vector<value::matrix4d> &world_matrices, std::string *err) const {
+  const value::matrix4d &parent_world =
+      (item.parent_prim_id > 0) ? world_matrices[size_t(item.parent_prim_id)]
+                                : value::matrix4d::identity();
+
+  if (!item.xformable) {
+    world_matrices[size_t(item.prim_id)] = parent_world;
+    return true;
+  }
+
+  // Evaluate xformOps directly(Xformable::GetLocalMatrix caches the matrix).
+  const Xformable *xformable{nullptr};
+  if (!CastToXformable(*item.prim, &xformable) || !xformable) {
+    PUSH_ERROR_AND_RETURN("[InternalError] Prim is not Xformable.");
+  }
+
+  value::matrix4d local;
+  bool reset_xform_stack{false};
+  std::string local_err;
+  if (!xformable->EvaluateXformOps(t, tinterp, &local, &reset_xform_stack,
+                                   &local_err)) {
+    PUSH_ERROR_AND_RETURN(fmt::format("Failed to evaluate xformOps of `{}`: {}",
+                                      item.prim->element_name(), local_err));
+  }
+
+  local_matrices[size_t(item.prim_id)] = local;
+  // matrix is row-major, so local first
+  world_matrices[size_t(item.prim_id)] =
+      reset_xform_stack ? local : local * parent_world;
+
+  return true;
+}
+
+bool XformCache::update(const double t,
+                        const tinyusdz::value::TimeSampleInterpolationType tinterp,
+                        std::string *err) {
+  if (!_valid) {
+    PUSH_ERROR_AND_RETURN("XformCache is not built.");
+  }
+
+  if (IsSameTimeCode(t, _t) && (tinterp == _tinterp)) {
+    return true;
+  }
+
+  // `_varying_items` is in depth-first order, and the parent of a varying item
+  // is either static(already evaluated) or varying(evaluated before).
+  for (size_t idx : _varying_items) {
+    if (!evaluate_item(_items[idx], t, tinterp, _local_matrices,
+                       _world_matrices, err)) {
+      // State is partially updated.
+      _valid = false;
+      return false;
+    }
+  }
+
+  _t = t;
+  _tinterp = tinterp;
+
+  return true;
+}
+
+bool XformCache::evaluate_batch(
+    const std::vector<double> &times,
+    const tinyusdz::value::TimeSampleInterpolationType tinterp,
+    std::vector<std::vector<value::matrix4d>> *world_matrices,
+    std::string *err, const uint32_t num_threads) const {
+  if (!_valid) {
+    PUSH_ERROR_AND_RETURN("XformCache is not built.");
+  }
+
+  if (!world_matrices) {
+    PUSH_ERROR_AND_RETURN("`world_matrices` argument is nullptr.");
+  }
+
+  world_matrices->clear();
+  world_matrices->resize(times.size());
+
+  std::vector<uint8_t> results(times.size(), 0);
+  std::vector<std::string> errs(times.size());
+
+  const auto evaluate_at = [&](size_t i) {
+    // Static Prims are shared with the current state. Only time-varying
+    // Prims are evaluated.
+    std::vector<value::matrix4d> locals = _local_matrices;
+    std::vector<value::matrix4d> &worlds = (*world_matrices)[i];
+    worlds = _world_matrices;
+
+    for (size_t idx : _varying_items) {
+      if (!evaluate_item(_items[idx], times[i], tinterp, locals, worlds,
+                         &errs[i])) {
+        return;
+      }
+    }
+    results[i] = 1;
+  };
+
+  {
+    ThreadPool pool(
+        uint32_t((std::min)(size_t(ThreadPool::resolve_num_threads(num_threads)),
+                            (std::max)(size_t(1), times.size()))));
+    for (size_t i = 0; i < times.size(); i++) {
+      pool.submit([&evaluate_at, i]() { evaluate_at(i); });
+    }
+    pool.wait();
+  }
+
+  for (size_t i = 0; i < times.size(); i++) {
+    if (!results[i]) {
+      PUSH_ERROR_AND_RETURN(
+          fmt::format("Failed to evaluate Xforms at time {}: {}", times[i],
+                      errs[i]));
+    }
+  }
+
+  return true;
+}
+
+bool XformCache::get_world_matrix(int64_t prim_id, value::matrix4d *m) const {
+  if (!m || (prim_id < 1) || (size_t(prim_id) >= _world_matrices.size())) {
+    return false;
+  }
+  (*m) = _world_matrices[size_t(prim_id)];
+  return true;
+}
+
+bool XformCache::get_local_matrix(int64_t prim_id, value::matrix4d *m) const {
+  if (!m || (prim_id < 1) || (size_t(prim_id) >= _local_matrices.size())) {
+    return false;
+  }
+  (*m) = _local_matrices[size_t(prim_id)];
+  return true;
+}
+
+bool XformCache::is_time_varying(int64_t prim_id) const {
+  if ((prim_id < 1) || (size_t(prim_id) >= _time_varying.size())) {
+    return false;
+  }
+  return _time_varying[size_t(prim_id)];
+}
+
 template<typename T>
 bool PrimToPrimSpecImpl(const T &p, PrimSpec &ps, std::string *err);
 
@@ -10,6 +10,7 @@
 
 #include <map>
 
+#include "frozen-stage.hh"
 #include "prim-types.hh"
 #include "stage.hh"
 #include "usdGeom.hh"
@@ -92,6 +93,83 @@ typedef bool (*VisitPrimFunction)(const Path &abs_path, const Prim &prim,
 bool VisitPrims(const tinyusdz::Stage &stage, VisitPrimFunction visitor_fun,
                 void *userdata = nullptr, std::string *err = nullptr);
 
+///
+/// Visit Prims in FrozenStage.
+/// Prims are visited in the same order as `VisitPrims(Stage)`, but with a
+/// linear scan over the flattened Prim array(no recursion).
+///
+/// @param[out] err Error message.
+///
+bool VisitPrims(const tinyusdz::FrozenStage &stage,
+                VisitPrimFunction visitor_fun, void *userdata = nullptr,
+                std::string *err = nullptr);
+
+///
+/// Callback function for ParallelVisitPrims.
+///
+/// @param[in] abs_path Prim's absolute path(e.g. "/xform/mesh0")
+/// @param[in] prim Prim
+/// @param[in] tree_depth Tree depth of this Prim. 0 = root prim.
+/// @param[in] thread_id Index of the thread which invokes this callback. [0,
+/// ParallelVisitOptions::num_threads). Use it to index per-thread
+/// accumulators in `userdata`.
+/// @param[inout] userdata User data. Shared among threads.
+/// @param[out] prune_children Set true to skip visiting descendant Prims of
+/// this Prim(default false).
+/// @param[out] err Error message.
+///
+/// @return Usually true. return false + no error message to notify early
+/// termination of visiting Prims.
+///
+typedef bool (*ParallelVisitPrimFunction)(const Path &abs_path,
+                                          const Prim &prim,
+                                          const int32_t tree_depth,
+                                          const uint32_t thread_id,
+                                          void *userdata, bool *prune_children,
+                                          std::string *err);
+
+struct ParallelVisitOptions {
+  // The number of threads to use. 0 = use hardware concurrency.
+  // Updated to the actual number of threads used after
+  // ParallelVisitPrims(always 1 when TinyUSDZ is built without
+  // TINYUSDZ_ENABLE_THREAD).
+  uint32_t num_threads{0};
+
+  // Subtrees whose depth is larger than this value are visited in the task of
+  // their ancestor(no further task split), to reduce scheduling overhead.
+  uint32_t max_task_depth{64};
+};
+
+///
+/// Visit Prims in Stage in parallel.
+///
+/// Prim subtrees are scheduled onto a work-stealing thread pool.
+///
+/// - Visitor invocation for a Prim happens after the invocations of all its
+/// ancestors.
+/// - Invocation order among siblings/subtrees is not defined. Use `thread_id`
+/// to accumulate results per thread without locking.
+/// - `primChildren` metadatum is used to determine child Prims as done in
+/// `VisitPrims`.
+/// - The visitor may call Stage lookup APIs(e.g. `Stage::find_prim_at_path`),
+/// also on an uncommitted Stage. Do not modify the Stage during the visit.
+///
+/// @param[inout] options Parallel traversal options. `num_threads` is updated
+/// to the number of threads actually used.
+/// @param[out] err Error message.
+///
+bool ParallelVisitPrims(const tinyusdz::Stage &stage,
+                        ParallelVisitPrimFunction visitor_fun,
+                        void *userdata, ParallelVisitOptions *options,
+                        std::string *err = nullptr);
+
+///
+/// Returns the number of threads used in ParallelVisitPrims for
+/// `options.num_threads`(Use it to allocate per-thread accumulators before
+/// calling ParallelVisitPrims).
+///
+uint32_t GetParallelVisitThreadCount(const ParallelVisitOptions &options);
+
 ///
 /// Get Property(Attribute or Relationship) of given Prim by name.
 /// Similar to UsdPrim::GetProperty() in pxrUSD.
@@ -384,7 +462,8 @@ struct XformNode {
 /// Set a time, and compute xform of each Prim and store its cache(i.e. read
 /// only).
 ///
-/// TODO: Support timeSamples.
+/// For evaluating Xforms at many time codes(e.g. animation playback), use
+/// XformCache.
 ///
 bool BuildXformNodeFromStage(
     const tinyusdz::Stage &stage, XformNode *root, /* out */
@@ -394,6 +473,114 @@ bool BuildXformNodeFromStage(
 
 std::string DumpXformNode(const XformNode &root);
 
+///
+/// Time-varying Xform cache.
+///
+/// Records which Prims have time-varying xformOps(timeSamples) at `build`,
+/// then `update` re-evaluates only those Prims and their descendants for a
+/// new time code. Matrices are stored in contiguous arrays indexed by
+/// prim_id.
+///
+/// Prim ids must be assigned to Prims(i.e. `Stage::commit()`) before `build`.
+/// XformCache keeps pointers to Prims, so rebuild XformCache when the Stage is
+/// modified.
+///
+class XformCache {
+ public:
+  ///
+  /// Build cache from Stage. World matrices are evaluated at `t`.
+  ///
+  bool build(const tinyusdz::Stage &stage,
+             const double t = tinyusdz::value::TimeCode::Default(),
+             const tinyusdz::value::TimeSampleInterpolationType tinterp =
+                 tinyusdz::value::TimeSampleInterpolationType::Linear,
+             std::string *err = nullptr);
+
+  ///
+  /// Re-evaluate matrices of time-varying Prims(and their descendants) at
+  /// time `t`. No-op when `t` and `tinterp` is same as the current state.
+  ///
+  bool update(const double t,
+              const tinyusdz::value::TimeSampleInterpolationType tinterp =
+                  tinyusdz::value::TimeSampleInterpolationType::Linear,
+              std::string *err = nullptr);
+
+  ///
+  /// Evaluate world matrices at multiple time codes. Each time code is
+  /// evaluated in parallel(when built with TINYUSDZ_ENABLE_THREAD).
+  /// The cache state(`time()`, `world_matrices()`) is not modified.
+  ///
+  /// @param[in] times Time codes.
+  /// @param[out] world_matrices world_matrices[i] = world matrices at
+  /// times[i](indexed by prim_id).
+  /// @param[in] num_threads The number of threads. 0 = hardware concurrency.
+  ///
+  bool evaluate_batch(
+      const std::vector<double> &times,
+      const tinyusdz::value::TimeSampleInterpolationType tinterp,
+      std::vector<std::vector<value::matrix4d>> *world_matrices,
+      std::string *err = nullptr, const uint32_t num_threads = 0) const;
+
+  ///
+  /// World matrices indexed by prim_id. Identity for non-Xformable Prims and
+  /// invalid prim_id.
+  ///
+  const std::vector<value::matrix4d> &world_matrices() const {
+    return _world_matrices;
+  }
+
+  ///
+  /// Local matrices indexed by prim_id.
+  ///
+  const std::vector<value::matrix4d> &local_matrices() const {
+    return _local_matrices;
+  }
+
+  bool get_world_matrix(int64_t prim_id, value::matrix4d *m) const;
+  bool get_local_matrix(int64_t prim_id, value::matrix4d *m) const;
+
+  ///
+  /// True when the Prim's xformOps(or any of its ancestor's xformOps) has
+  /// timeSamples.
+  ///
+  bool is_time_varying(int64_t prim_id) const;
+
+  ///
+  /// The number of Prims re-evaluated in `update`.
+  ///
+  size_t num_time_varying_prims() const { return _varying_items.size(); }
+
+  double time() const { return _t; }
+
+ private:
+  struct Item {
+    const Prim *prim{nullptr};
+    int64_t prim_id{-1};
+    int64_t parent_prim_id{-1};  // -1 = no parent(root Prim)
+    bool xformable{false};
+    bool local_varying{false};  // xformOps has timeSamples.
+    bool world_varying{false};  // local_varying or ancestor is varying.
+  };
+
+  bool evaluate_item(const Item &item, double t,
+                     tinyusdz::value::TimeSampleInterpolationType tinterp,
+                     std::vector<value::matrix4d> &local_matrices,
+                     std::vector<value::matrix4d> &world_matrices,
+                     std::string *err) const;
+
+  std::vector<Item> _items;  // depth-first order(parent first)
+  std::vector<size_t> _varying_items;  // indices to `_items`.
+
+  std::vector<value::matrix4d> _local_matrices;
+  std::vector<value::matrix4d> _world_matrices;
+  std::vector<uint8_t> _time_varying;  // indexed by prim_id
+
+  double _t{tinyusdz::value::TimeCode::Default()};
+  tinyusdz::value::TimeSampleInterpolationType _tinterp{
+      tinyusdz::value::TimeSampleInterpolationType::Linear};
+  bool _valid{false};
+};
+
 ///
 /// For composition. Convert Concrete Prim(Xform, GeomMesh, ...) to PrimSpec, generic Prim container.
 /// TODO: Move to *core* module?
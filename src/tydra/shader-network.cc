@@ -173,6 +173,26 @@ bool GetBoundMaterial(
 
   (void)err;
 
+  // GeomSubset is not a GPrim. Only `material:binding` is supported.
+  if (const GeomSubset *subset = prim.as<GeomSubset>()) {
+    if (suffix.empty() && subset->materialBinding.has_value()) {
+      if (GetSinglePath(subset->materialBinding.value(), materialPath)) {
+        const Prim *p{nullptr};
+        if (_stage.find_prim_at_path(*materialPath, p, err)) {
+          if (p->is<Material>() && (material != nullptr)) {
+            (*material) = p->as<Material>();
+          } else if (material != nullptr) {
+            (*material) = nullptr;
+          }
+        }
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
   auto apply_fun = [&](const Stage &stage, const GPrim *gprim) -> bool {
     if (suffix.empty()) {
       if (gprim->materialBinding.has_value()) {
@@ -319,9 +339,10 @@ bool FindBoundMaterial(
   }
 
   // Search parent Prim
+  Path path = abs_path;
   int depth = 0;
   while (depth < 1024*1024*128) { // to avoid infinite loop.
-    Path parentPath = abs_path.get_parent_prim_path();
+    Path parentPath = path.get_parent_prim_path();
     DCOUT("search parent: " << parentPath.full_path_name());
 
     if (parentPath.is_valid() && (!parentPath.is_root_path())) {
@@ -343,6 +364,7 @@ bool FindBoundMaterial(
       // no further parent Prim.
       return false;
     }
+    path = parentPath;
     depth++;
   }
 
@@ -71,6 +71,7 @@ extern template bool EvaluateShaderAttribute(const Stage &stage, const Shader &s
 ///
 /// Get material:binding target Path of given Prim.
 /// Do not seek `material:binding` of parent Path.
+/// For GeomSubset Prim, only `material:binding`(empty `suffix`) is supported.
 ///
 /// @param[in] stage Prim
 /// @param[in] prim Prim
@@ -432,6 +432,8 @@ struct GeomSubset {
 
   std::vector<uint32_t> indices;
 
+  nonstd::optional<Relationship> materialBinding;  // material:binding
+
   std::map<std::string, Property> props;  // custom Properties
   PrimMeta meta;
 };
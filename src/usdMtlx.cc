@@ -675,6 +675,13 @@ static bool ConvertTiledImage(const pugi::xml_node &node, UsdUVTexture &tex, std
 bool ReadMaterialXFromString(const std::string &str,
                              const std::string &asset_path, MtlxModel *mtlx,
                              std::string *warn, std::string *err) {
+  return ReadMaterialXFromMemory(reinterpret_cast<const uint8_t *>(str.data()),
+                                 str.size(), asset_path, mtlx, warn, err);
+}
+
+bool ReadMaterialXFromMemory(const uint8_t *addr, const size_t nbytes,
+                             const std::string &asset_path, MtlxModel *mtlx,
+                             std::string *warn, std::string *err) {
 #define GET_ATTR_VALUE(__xml, __name, __ty, __var)                        \
   do {                                                                    \
     pugi::xml_attribute attr = __xml.attribute(__name);                   \
@@ -704,8 +711,12 @@ bool ReadMaterialXFromString(const std::string &str,
     __attr.set_value(v);                                                 \
   } else
 
+  if (!addr) {
+    PUSH_ERROR_AND_RETURN("`addr` is nullptr.");
+  }
+
   pugi::xml_document doc;
-  pugi::xml_parse_result result = doc.load_string(str.c_str());
+  pugi::xml_parse_result result = doc.load_buffer(addr, nbytes);
   if (!result) {
     std::string msg(result.description());
     PUSH_ERROR_AND_RETURN("Failed to parse XML: " + msg);
@@ -922,8 +933,8 @@ bool ReadMaterialXFromFile(const AssetResolutionResolver &resolver,
     PUSH_ERROR_AND_RETURN("Read file failed.");
   }
 
-  std::string str(reinterpret_cast<const char *>(&data[0]), data.size());
-  return ReadMaterialXFromString(str, asset_path, mtlx, warn, err);
+  return ReadMaterialXFromMemory(data.data(), data.size(), asset_path, mtlx,
+                                 warn, err);
 }
 
 bool WriteMaterialXToString(const MtlxModel &mtlx, std::string &xml_str,
@@ -1004,10 +1015,10 @@ bool LoadMaterialXFromAsset(const Asset &asset, const std::string &asset_path,
     return false;
   }
 
-  std::string str(reinterpret_cast<const char *>(asset.data()), asset.size());
-
+  // Parse the content in place(no intermediate std::string).
   MtlxModel mtlx;
-  if (!ReadMaterialXFromString(str, asset_path, &mtlx, warn, err)) {
+  if (!ReadMaterialXFromMemory(asset.data(), asset.size(), asset_path, &mtlx,
+                               warn, err)) {
     PUSH_ERROR_AND_RETURN("Failed to read MaterialX.");
   }
 
@@ -1039,6 +1050,21 @@ bool ReadMaterialXFromFile(const AssetResolutionResolver &resolver,
   return false;
 }
 
+bool ReadMaterialXFromMemory(const uint8_t *addr, const size_t nbytes,
+                             const std::string &asset_path, MtlxModel *mtlx,
+                             std::string *warn, std::string *err) {
+  (void)addr;
+  (void)nbytes;
+  (void)asset_path;
+  (void)mtlx;
+  (void)warn;
+
+  if (err) {
+    (*err) += "MaterialX support is disabled in this build.\n";
+  }
+  return false;
+}
+
 bool WriteMaterialXToString(const MtlxModel &mtlx, std::string &xml_str,
                             std::string *warn, std::string *err) {
   (void)mtlx;
@@ -116,6 +116,21 @@ struct MtlxAutodeskStandardSurface : ShaderNode {
 bool ReadMaterialXFromString(const std::string &str, const std::string &asset_name, MtlxModel *mtlx,
                              std::string *warn, std::string *err);
 
+///
+/// Load MaterialX XML from memory(no intermediate copy to std::string).
+///
+/// @param[in] addr XML data.
+/// @param[in] nbytes Byte length of XML data.
+/// @param[in] asset_name Corresponding asset name. Can be empty.
+/// @param[out] mtlx Output
+/// @param[out] warn Warning message
+/// @param[out] err Error message
+///
+/// @return true upon success.
+bool ReadMaterialXFromMemory(const uint8_t *addr, const size_t nbytes,
+                             const std::string &asset_name, MtlxModel *mtlx,
+                             std::string *warn, std::string *err);
+
 ///
 /// Load MaterialX XML from a file.
 ///
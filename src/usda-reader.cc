@@ -1738,6 +1738,7 @@ bool USDAReader::Impl::RegisterReconstructCallback<GeomSubset>() {
                   "`material:binding` property as Attribute is not "
                   "supported.");
             }
+            subset.materialBinding = item.second.get_relationship();
           } else if (item.first == "familyName") {
             if (item.second.is_relationship()) {
               PUSH_ERROR_AND_RETURN(
@@ -1885,6 +1886,7 @@ bool USDAReader::Impl::Read(const uint32_t state_flags, bool as_primspec) {
   RegisterReconstructCallback<GeomBasisCurves>();
   RegisterReconstructCallback<GeomNurbsCurves>();
   RegisterReconstructCallback<GeomCamera>();
+  RegisterReconstructCallback<PointInstancer>();
 
   RegisterReconstructCallback<Material>();
   RegisterReconstructCallback<Shader>();
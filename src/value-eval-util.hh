@@ -619,6 +619,26 @@ inline value::float4 lerp(const value::float4 &a, const value::float4 &b, const
   return float(1.0 - t) * a + float(t) * b;
 }
 
+template <>
+inline double lerp(const double &a, const double &b, const double t) {
+  return (1.0 - t) * a + t * b;
+}
+
+template <>
+inline value::double2 lerp(const value::double2 &a, const value::double2 &b, const double t) {
+  return (1.0 - t) * a + t * b;
+}
+
+template <>
+inline value::double3 lerp(const value::double3 &a, const value::double3 &b, const double t) {
+  return (1.0 - t) * a + t * b;
+}
+
+template <>
+inline value::double4 lerp(const value::double4 &a, const value::double4 &b, const double t) {
+  return (1.0 - t) * a + t * b;
+}
+
 template <typename T>
 inline std::vector<T> lerp(const std::vector<T> &a, const std::vector<T> &b,
                            const double t) {
@@ -221,9 +221,9 @@ class TimeCode {
     return time_;
   }
 
-  bool is_default() {
+  bool is_default() const {
     // TODO: Bitwise comparison
-    return !std::isnan(time_);
+    return std::isnan(time_);
   }
 
  private:
@@ -1239,7 +1239,19 @@ inline matrix4d operator-(const matrix4d &a, const matrix4d &b) {
 }
 
 inline matrix4d operator*(const matrix4d &a, const matrix4d &b) {
-  matrix4d ret = Mult<matrix4d, double, 4>(a, b);
+  // Unrolled version of Mult<matrix4d, double, 4>(same summation order).
+  // ret.row[j] = sum_k a[j][k] * b.row[k], which compilers can vectorize.
+  matrix4d ret;
+  for (size_t j = 0; j < 4; j++) {
+    const double a0 = a.m[j][0];
+    const double a1 = a.m[j][1];
+    const double a2 = a.m[j][2];
+    const double a3 = a.m[j][3];
+    for (size_t i = 0; i < 4; i++) {
+      ret.m[j][i] =
+          a0 * b.m[0][i] + a1 * b.m[1][i] + a2 * b.m[2][i] + a3 * b.m[3][i];
+    }
+  }
   return ret;
 }
 
@@ -1885,8 +1897,14 @@ class Value {
   template <class T>
   Value(const T &v) : v_(v) {}
 
-  // template <class T>
-  // Value(T &&v) : v_(v) {}
+  // Move the value into Value(e.g. to avoid copying large Prim data).
+  // Lvalues and Value itself use the constructors above.
+  template <class T,
+            typename std::enable_if<
+                !std::is_lvalue_reference<T>::value &&
+                    !std::is_same<typename std::decay<T>::type, Value>::value,
+                std::nullptr_t>::type = nullptr>
+  Value(T &&v) : v_(std::move(v)) {}
 
   const std::string type_name() const { return v_.type_name(); }
   const std::string underlying_type_name() const {
@@ -2208,12 +2226,16 @@ struct TimeSamples {
         (*dst) = std::move(p);
         return true;
       } else {
-        if (it == _samples.end()) {
-          // ???
-          return false;
-        }
-
-        (*dst) = it->value;
+        // Held: Use the sample at or before `t`.
+        // Use the first sample when `t` is before the first sample.
+        auto uit = std::upper_bound(
+            _samples.begin(), _samples.end(), t,
+            [](double tval, const Sample &a) { return tval < a.t; });
+        size_t idx = (uit == _samples.begin())
+                         ? 0
+                         : size_t(std::distance(_samples.begin(), uit) - 1);
+
+        (*dst) = _samples[idx].value;
         return true;
       }
     }
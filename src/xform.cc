@@ -678,19 +678,35 @@ bool Xformable::EvaluateXformOps(double t,
   Identity(&cm);
 
   for (size_t i = 0; i < xformOps.size(); i++) {
-    const auto x = xformOps[i];
+    // Evaluate timeSamples at `t` and use it as a scalar xformOp.
+    XformOp sampled;
+    const XformOp *px = &xformOps[i];
+
+    if (px->is_timesamples()) {
+      value::Value v;
+      if (!px->get_var().get_interpolated_value(t, tinterp, &v)) {
+        if (err) {
+          (*err) += fmt::format(
+              "Failed to evaluate timeSamples of `{}` at time {}.\n",
+              to_string(px->op_type), t);
+        }
+        return false;
+      }
+
+      sampled.op_type = px->op_type;
+      sampled.inverted = px->inverted;
+      sampled.suffix = px->suffix;
+      sampled.var().value_raw() = std::move(v);
+      px = &sampled;
+    }
+
+    const XformOp &x = *px;
 
     value::matrix4d m;  // local matrix
     Identity(&m);
 
-    if (x.is_timesamples()) {
-      (void)t;
-      (void)tinterp;
-      if (err) {
-        (*err) += "TODO: xformOp property with timeSamples.\n";
-      }
-      return false;
-    }
+    // false when the op is directly applied to `cm`.
+    bool concat{true};
 
     switch (x.op_type) {
       case XformOp::OpType::ResetXformStack: {
@@ -782,9 +798,13 @@ bool Xformable::EvaluateXformOps(double t,
           sz = 1.0 / sz;
         }
 
-        m.m[0][0] = sx;
-        m.m[1][1] = sy;
-        m.m[2][2] = sz;
+        // Fast path: Scale rows of `cm`(equivalent to `m * cm`).
+        for (size_t j = 0; j < 4; j++) {
+          cm.m[0][j] *= sx;
+          cm.m[1][j] *= sy;
+          cm.m[2][j] *= sz;
+        }
+        concat = false;
 
         break;
       }
@@ -816,9 +836,12 @@ bool Xformable::EvaluateXformOps(double t,
           tz = -tz;
         }
 
-        m.m[3][0] = tx;
-        m.m[3][1] = ty;
-        m.m[3][2] = tz;
+        // Fast path: Add translation to `cm`(equivalent to `m * cm`).
+        for (size_t j = 0; j < 4; j++) {
+          cm.m[3][j] = tx * cm.m[0][j] + ty * cm.m[1][j] + tz * cm.m[2][j] +
+                       cm.m[3][j];
+        }
+        concat = false;
 
         break;
       }
@@ -1009,7 +1032,9 @@ bool Xformable::EvaluateXformOps(double t,
       }
     }
 
-    cm = m * cm;  // `m` fist for pre-multiply system.
+    if (concat) {
+      cm = m * cm;  // `m` fist for pre-multiply system.
+    }
   }
 
   (*out_matrix) = cm;
@@ -1125,6 +1150,178 @@ value::point3d transform_dir(const value::matrix4d &m,
   return value::MultV<value::matrix4d, value::point3d, double, double, 3>(m, p);
 }
 
+namespace {
+
+//
+// Batch transform kernels. `src`, `dst` are flattened xyz arrays.
+// Matrix elements are loaded once, and each output element only depends on
+// the input element, so that the loop can be auto-vectorized.
+// Summation order is same as `value::MultV`.
+//
+template <typename T>
+void TransformPointsImpl(const value::matrix4d &m, const T *src, size_t n,
+                         T *dst, const bool translate) {
+  const T m00 = T(m.m[0][0]), m01 = T(m.m[0][1]), m02 = T(m.m[0][2]);
+  const T m10 = T(m.m[1][0]), m11 = T(m.m[1][1]), m12 = T(m.m[1][2]);
+  const T m20 = T(m.m[2][0]), m21 = T(m.m[2][1]), m22 = T(m.m[2][2]);
+  const T tx = translate ? T(m.m[3][0]) : T(0);
+  const T ty = translate ? T(m.m[3][1]) : T(0);
+  const T tz = translate ? T(m.m[3][2]) : T(0);
+
+  for (size_t i = 0; i < n; i++) {
+    const T x = src[3 * i + 0];
+    const T y = src[3 * i + 1];
+    const T z = src[3 * i + 2];
+
+    dst[3 * i + 0] = (m00 * x + m10 * y + m20 * z) + tx;
+    dst[3 * i + 1] = (m01 * x + m11 * y + m21 * z) + ty;
+    dst[3 * i + 2] = (m02 * x + m12 * y + m22 * z) + tz;
+  }
+}
+
+template <typename T>
+bool TransformNormalsImpl(const value::matrix4d &m, const T *src, size_t n,
+                          T *dst) {
+  value::matrix3d m33 = to_matrix3x3(m);
+
+  value::matrix3d inv_m33;
+  if (!inverse(m33, inv_m33)) {
+    return false;
+  }
+
+  // normal matrix = transpose(inverse(M))
+  value::matrix3d nm = transpose(inv_m33);
+
+  value::matrix4d nm44 = to_matrix(nm, {0.0, 0.0, 0.0});
+  TransformPointsImpl(nm44, src, n, dst, /* translate */ false);
+
+  for (size_t i = 0; i < n; i++) {
+    const T x = dst[3 * i + 0];
+    const T y = dst[3 * i + 1];
+    const T z = dst[3 * i + 2];
+    const T len2 = x * x + y * y + z * z;
+    if (len2 > T(0)) {
+      const T inv_len = T(1) / std::sqrt(len2);
+      dst[3 * i + 0] = x * inv_len;
+      dst[3 * i + 1] = y * inv_len;
+      dst[3 * i + 2] = z * inv_len;
+    }
+  }
+
+  return true;
+}
+
+static_assert(sizeof(value::float3) == sizeof(float) * 3, "");
+static_assert(sizeof(value::point3f) == sizeof(float) * 3, "");
+static_assert(sizeof(value::normal3f) == sizeof(float) * 3, "");
+static_assert(sizeof(value::vector3f) == sizeof(float) * 3, "");
+static_assert(sizeof(value::double3) == sizeof(double) * 3, "");
+static_assert(sizeof(value::point3d) == sizeof(double) * 3, "");
+static_assert(sizeof(value::normal3d) == sizeof(double) * 3, "");
+static_assert(sizeof(value::vector3d) == sizeof(double) * 3, "");
+
+}  // namespace
+
+void transform_points(const value::matrix4d &m, const value::float3 *src,
+                      size_t n, value::float3 *dst) {
+  TransformPointsImpl(m, reinterpret_cast<const float *>(src), n,
+                      reinterpret_cast<float *>(dst), /* translate */ true);
+}
+
+void transform_points(const value::matrix4d &m, const value::double3 *src,
+                      size_t n, value::double3 *dst) {
+  TransformPointsImpl(m, reinterpret_cast<const double *>(src), n,
+                      reinterpret_cast<double *>(dst), /* translate */ true);
+}
+
+void transform_dirs(const value::matrix4d &m, const value::float3 *src,
+                    size_t n, value::float3 *dst) {
+  TransformPointsImpl(m, reinterpret_cast<const float *>(src), n,
+                      reinterpret_cast<float *>(dst), /* translate */ false);
+}
+
+void transform_dirs(const value::matrix4d &m, const value::double3 *src,
+                    size_t n, value::double3 *dst) {
+  TransformPointsImpl(m, reinterpret_cast<const double *>(src), n,
+                      reinterpret_cast<double *>(dst), /* translate */ false);
+}
+
+bool transform_normals(const value::matrix4d &m, const value::float3 *src,
+                       size_t n, value::float3 *dst) {
+  return TransformNormalsImpl(m, reinterpret_cast<const float *>(src), n,
+                              reinterpret_cast<float *>(dst));
+}
+
+bool transform_normals(const value::matrix4d &m, const value::double3 *src,
+                       size_t n, value::double3 *dst) {
+  return TransformNormalsImpl(m, reinterpret_cast<const double *>(src), n,
+                              reinterpret_cast<double *>(dst));
+}
+
+void transform_points(const value::matrix4d &m,
+                      std::vector<value::point3f> &points) {
+  float *p = reinterpret_cast<float *>(points.data());
+  TransformPointsImpl(m, p, points.size(), p, /* translate */ true);
+}
+
+void transform_points(const value::matrix4d &m,
+                      std::vector<value::point3d> &points) {
+  double *p = reinterpret_cast<double *>(points.data());
+  TransformPointsImpl(m, p, points.size(), p, /* translate */ true);
+}
+
+void transform_dirs(const value::matrix4d &m,
+                    std::vector<value::vector3f> &vectors) {
+  float *p = reinterpret_cast<float *>(vectors.data());
+  TransformPointsImpl(m, p, vectors.size(), p, /* translate */ false);
+}
+
+void transform_dirs(const value::matrix4d &m,
+                    std::vector<value::vector3d> &vectors) {
+  double *p = reinterpret_cast<double *>(vectors.data());
+  TransformPointsImpl(m, p, vectors.size(), p, /* translate */ false);
+}
+
+bool transform_normals(const value::matrix4d &m,
+                       std::vector<value::normal3f> &normals) {
+  float *p = reinterpret_cast<float *>(normals.data());
+  return TransformNormalsImpl(m, p, normals.size(), p);
+}
+
+bool transform_normals(const value::matrix4d &m,
+                       std::vector<value::normal3d> &normals) {
+  double *p = reinterpret_cast<double *>(normals.data());
+  return TransformNormalsImpl(m, p, normals.size(), p);
+}
+
+bool is_affine(const value::matrix4d &m) {
+  return (m.m[0][3] == 0.0) && (m.m[1][3] == 0.0) && (m.m[2][3] == 0.0) &&
+         (m.m[3][3] == 1.0);
+}
+
+bool inverse_affine(const value::matrix4d &m, value::matrix4d &inv_m,
+                    double eps) {
+  if (!is_affine(m)) {
+    return false;
+  }
+
+  value::double3 tx;
+  value::matrix3d m33 = to_matrix3x3(m, &tx);
+
+  value::matrix3d inv_m33;
+  if (!inverse(m33, inv_m33, eps)) {
+    return false;
+  }
+
+  // p' = p x A + t
+  // p = (p' - t) x inv(A) = p' x inv(A) - t x inv(A)
+  value::double3 inv_tx = transform_dir(to_matrix(inv_m33, {0.0, 0.0, 0.0}), tx);
+
+  inv_m = to_matrix(inv_m33, {-inv_tx[0], -inv_tx[1], -inv_tx[2]});
+
+  return true;
+}
+
 value::matrix4d upper_left_3x3_only(const value::matrix4d &m) {
   value::matrix4d dst;
 
@@ -100,6 +100,60 @@ value::vector3d transform_dir(const value::matrix4d &m, const value::vector3d &p
 value::normal3d transform_dir(const value::matrix4d &m, const value::normal3d &p);
 value::point3d transform_dir(const value::matrix4d &m, const value::point3d &p);
 
+//
+// Batch transform of 3d vector arrays using 4x4 matrix.
+// Transform `n` elements of `src` and write results to `dst`. `src` and `dst`
+// may point to the same array(in-place transform).
+//
+// Inner loops are written so that compilers can vectorize them.
+// float version computes in float precision(matrix elements are converted to
+// float), so the result may slightly differ from `transform()`.
+//
+// transform_points: p' = p x M ([3][3] is not used, same as `transform()`)
+// transform_dirs: v' = v x upper-left 3x3 of M(same as `transform_dir()`)
+// transform_normals: n' = normalize(n x transpose(inverse(upper-left 3x3 of
+// M))). Returns false when the upper-left 3x3 matrix is singular.
+//
+void transform_points(const value::matrix4d &m, const value::float3 *src,
+                      size_t n, value::float3 *dst);
+void transform_points(const value::matrix4d &m, const value::double3 *src,
+                      size_t n, value::double3 *dst);
+
+void transform_dirs(const value::matrix4d &m, const value::float3 *src,
+                    size_t n, value::float3 *dst);
+void transform_dirs(const value::matrix4d &m, const value::double3 *src,
+                    size_t n, value::double3 *dst);
+
+bool transform_normals(const value::matrix4d &m, const value::float3 *src,
+                       size_t n, value::float3 *dst);
+bool transform_normals(const value::matrix4d &m, const value::double3 *src,
+                       size_t n, value::double3 *dst);
+
+// In-place std::vector versions.
+void transform_points(const value::matrix4d &m,
+                      std::vector<value::point3f> &points);
+void transform_points(const value::matrix4d &m,
+                      std::vector<value::point3d> &points);
+void transform_dirs(const value::matrix4d &m,
+                    std::vector<value::vector3f> &vectors);
+void transform_dirs(const value::matrix4d &m,
+                    std::vector<value::vector3d> &vectors);
+bool transform_normals(const value::matrix4d &m,
+                       std::vector<value::normal3f> &normals);
+bool transform_normals(const value::matrix4d &m,
+                       std::vector<value::normal3d> &normals);
+
+//
+// Inverse of affine matrix(the last column is (0, 0, 0, 1)).
+// Faster than generic `inverse()`.
+// Return false when the matrix is not affine or singular.
+//
+bool inverse_affine(const value::matrix4d &m, value::matrix4d &inv_m,
+                    double eps = 0.0);
+
+// Check if the last column of the matrix is (0, 0, 0, 1)
+bool is_affine(const value::matrix4d &m);
+
 // tx, ty, tz = [inout]
 // default eps is grabbed from pxrUSD. 
 bool orthonormalize_basis(value::double3 &tx, value::double3 &ty, value::double3 &tz, const bool normalize, const double eps = 1e-6);
@@ -175,23 +229,51 @@ struct Xformable {
   ///
   /// @param[out] resetTransformStack Is xformOpOrder contains !resetTransformStack!? 
   ///
+  /// The evaluated matrix is cached only when xformOps does not contain
+  /// timeSamples.
+  ///
   nonstd::expected<value::matrix4d, std::string> GetLocalMatrix(double t = value::TimeCode::Default(), value::TimeSampleInterpolationType tinterp = value::TimeSampleInterpolationType::Held, bool *resetTransformStack = nullptr) const {
-    if (_dirty) {
-      value::matrix4d m;
-      std::string err;
-      if (EvaluateXformOps(t, tinterp, &m, resetTransformStack, &err)) {
-        _matrix = m;
-        _dirty = false;
-      } else {
-        return nonstd::make_unexpected(err);
+    if (!_dirty) {
+      if (resetTransformStack) {
+        (*resetTransformStack) = _reset_xform_stack;
       }
+      return _matrix;
     }
 
-    return _matrix;
+    value::matrix4d m;
+    bool rxs{false};
+    std::string err;
+    if (!EvaluateXformOps(t, tinterp, &m, &rxs, &err)) {
+      return nonstd::make_unexpected(err);
+    }
+
+    if (resetTransformStack) {
+      (*resetTransformStack) = rxs;
+    }
+
+    if (!has_timesamples()) {
+      _matrix = m;
+      _reset_xform_stack = rxs;
+      _dirty = false;
+    }
+
+    return m;
   }
 
   void set_dirty(bool onoff) { _dirty = onoff; }
 
+  ///
+  /// Returns true when any of xformOps has timeSamples(i.e. time-varying).
+  ///
+  bool has_timesamples() const {
+    for (const auto &op : xformOps) {
+      if (op.is_timesamples()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   // Return `token[]` representation of `xformOps`
   std::vector<value::token> xformOpOrder() const;
 
@@ -199,6 +281,7 @@ struct Xformable {
 
   mutable bool _dirty{true};
   mutable value::matrix4d _matrix;  // Matrix of this Xform(local matrix)
+  mutable bool _reset_xform_stack{false};
 };
 
 
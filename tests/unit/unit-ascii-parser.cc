@@ -0,0 +1,52 @@
+#ifdef _MSC_VER
+#define NOMINMAX
+#endif
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "unit-ascii-parser.h"
+#include "ascii-parser.hh"
+#include "stream-reader.hh"
+
+using namespace tinyusdz;
+
+namespace {
+
+template <typename T>
+bool ParseInteger(const std::string &s, T *value) {
+  StreamReader sr(reinterpret_cast<const uint8_t *>(s.data()), s.size(),
+                  /* swap endian */ false);
+  ascii::AsciiParser parser(&sr);
+  return parser.ReadBasicType(value);
+}
+
+}  // namespace
+
+void ascii_parser_integer_test(void) {
+  {
+    uint32_t v{0};
+    TEST_CHECK(ParseInteger("4000000000", &v));
+    TEST_CHECK(v == 4000000000u);
+  }
+
+  {
+    int64_t v{0};
+    TEST_CHECK(ParseInteger("1234567890123", &v));
+    TEST_CHECK(v == int64_t(1234567890123ll));
+
+    TEST_CHECK(ParseInteger("-1234567890123", &v));
+    TEST_CHECK(v == int64_t(-1234567890123ll));
+
+    TEST_CHECK(ParseInteger("+42", &v));
+    TEST_CHECK(v == 42);
+  }
+
+  {
+    uint64_t v{0};
+    TEST_CHECK(ParseInteger("18446744073709551615", &v));
+    TEST_CHECK(v == 18446744073709551615ull);
+
+    TEST_CHECK(!ParseInteger("-1", &v));
+  }
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void ascii_parser_integer_test(void);
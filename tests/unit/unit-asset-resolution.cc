@@ -0,0 +1,193 @@
+#ifdef _MSC_VER
+#define NOMINMAX
+#endif
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "unit-asset-resolution.h"
+#include "asset-resolution.hh"
+#include "io-util.hh"
+
+using namespace tinyusdz;
+
+void asset_resolution_cache_test(void) {
+  const std::string filename = "unit-asset-resolution-test.usda";
+
+  {
+    std::ofstream ofs(filename);
+    ofs << "#usda 1.0\n";
+  }
+
+  AssetResolutionResolver resolver;
+
+  // Duplicated search paths are removed.
+  resolver.set_search_paths({"nonexistent-dir", ".", "nonexistent-dir"});
+  TEST_CHECK(resolver.search_paths().size() == 2);
+  resolver.add_seartch_path(".");
+  TEST_CHECK(resolver.search_paths().size() == 2);
+
+  std::string resolved = resolver.resolve(filename);
+  TEST_CHECK(!resolved.empty());
+
+  AssetResolutionStats stats = resolver.stats();
+  TEST_CHECK(stats.resolve_calls == 1);
+  TEST_CHECK(stats.cache_hits == 0);
+  TEST_CHECK(stats.probes == 2);
+
+  // Cached
+  TEST_CHECK(resolver.resolve(filename) == resolved);
+  TEST_CHECK(resolver.find(filename));
+  stats = resolver.stats();
+  TEST_CHECK(stats.resolve_calls == 3);
+  TEST_CHECK(stats.cache_hits == 2);
+  TEST_CHECK(stats.probes == 2);
+
+  // Negative cache
+  TEST_CHECK(resolver.resolve("nonexistent.usda").empty());
+  TEST_CHECK(resolver.resolve("nonexistent.usda").empty());
+  stats = resolver.stats();
+  TEST_CHECK(stats.negative_cache_hits == 1);
+  TEST_CHECK(stats.probes == 4);
+
+  // Appending a search path only invalidates negative results.
+  resolver.reset_stats();
+  resolver.add_seartch_path("nonexistent-dir2");
+  TEST_CHECK(resolver.resolve(filename) == resolved);
+  TEST_CHECK(resolver.resolve("nonexistent.usda").empty());
+  stats = resolver.stats();
+  TEST_CHECK(stats.cache_hits == 1);
+  TEST_CHECK(stats.probes == 3);
+
+  // Removed file is still resolved until the cache is invalidated.
+  std::remove(filename.c_str());
+  TEST_CHECK(resolver.resolve(filename) == resolved);
+  resolver.invalidate_resolve_cache(filename);
+  TEST_CHECK(resolver.resolve(filename).empty());
+
+  // Without the cache.
+  resolver.set_resolve_cache_enabled(false);
+  resolver.reset_stats();
+  TEST_CHECK(resolver.resolve(filename).empty());
+  TEST_CHECK(resolver.resolve(filename).empty());
+  stats = resolver.stats();
+  TEST_CHECK(stats.cache_hits == 0);
+  TEST_CHECK(stats.probes == 6);
+}
+
+void asset_storage_test(void) {
+  const uint8_t bytes[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+  // Owned
+  {
+    std::vector<uint8_t> buf(bytes, bytes + 8);
+    const uint8_t *addr = buf.data();
+
+    Asset asset;
+    asset.set_data(std::move(buf));
+    TEST_CHECK(asset.is_owned());
+    TEST_CHECK(asset.size() == 8);
+    // Moved, not copied.
+    TEST_CHECK(static_cast<const Asset &>(asset).data() == addr);
+
+    // Slice of Owned storage is copied.
+    Asset s = asset.slice(2, 4);
+    TEST_CHECK(s.is_owned());
+    TEST_CHECK(s.size() == 4);
+    TEST_CHECK(static_cast<const Asset &>(s).data()[0] == 2);
+
+    // Share without copy.
+    asset.share();
+    TEST_CHECK(asset.is_shared());
+    TEST_CHECK(static_cast<const Asset &>(asset).data() == addr);
+
+    Asset s2 = asset.slice(6, 100);  // clamped
+    TEST_CHECK(s2.is_shared());
+    TEST_CHECK(s2.size() == 2);
+    TEST_CHECK(static_cast<const Asset &>(s2).data() == addr + 6);
+  }
+
+  // View + copy-on-write
+  {
+    Asset asset;
+    asset.set_view(bytes, 8);
+    TEST_CHECK(asset.is_view());
+
+    const Asset &casset = asset;
+    TEST_CHECK(casset.data() == bytes);
+
+    Asset copied = asset;
+    TEST_CHECK(static_cast<const Asset &>(copied).data() == bytes);
+
+    // Non-const access makes the content owned.
+    uint8_t *p = asset.data();
+    TEST_CHECK(p != bytes);
+    TEST_CHECK(asset.is_owned());
+    p[0] = 100;
+    TEST_CHECK(bytes[0] == 0);
+    TEST_CHECK(asset.size() == 8);
+  }
+
+  // Shared storage outlives the original owner.
+  {
+    Asset slice;
+    {
+      auto buf = std::make_shared<const std::vector<uint8_t>>(bytes, bytes + 8);
+      Asset asset;
+      asset.set_shared(buf);
+      slice = asset.slice(4, 4);
+    }
+    TEST_CHECK(slice.size() == 4);
+    TEST_CHECK(static_cast<const Asset &>(slice).data()[3] == 7);
+  }
+
+  // mmap
+  {
+    const std::string filename = "unit-asset-storage-test.usda";
+    const std::string content = "#usda 1.0\n";
+    {
+      std::ofstream ofs(filename, std::ios::binary);
+      ofs << content;
+    }
+
+    AssetResolutionResolver resolver;
+    TEST_CHECK(resolver.use_mmap());
+    resolver.set_search_paths({"."});
+    std::string resolved = resolver.resolve(filename);
+    TEST_CHECK(!resolved.empty());
+
+    std::string warn, err;
+
+    // Small file is read even though mmap is enabled.
+    Asset small_asset;
+    TEST_CHECK(
+        resolver.open_asset(resolved, filename, &small_asset, &warn, &err));
+    TEST_CHECK(small_asset.is_owned());
+    TEST_CHECK(small_asset.size() == content.size());
+
+    resolver.set_mmap_threshold(0);
+    Asset asset;
+    TEST_CHECK(resolver.open_asset(resolved, filename, &asset, &warn, &err));
+    TEST_CHECK(asset.size() == content.size());
+    if (io::MMapFile::supported()) {
+      TEST_CHECK(asset.is_shared());
+    }
+    TEST_CHECK(memcmp(static_cast<const Asset &>(asset).data(),
+                      content.data(), content.size()) == 0);
+
+    resolver.set_use_mmap(false);
+    Asset asset2;
+    TEST_CHECK(resolver.open_asset(resolved, filename, &asset2, &warn, &err));
+    TEST_CHECK(asset2.is_owned());
+    TEST_CHECK(asset2.size() == content.size());
+
+    // Release the mapping before removing the file(required on Windows).
+    asset = Asset();
+    std::remove(filename.c_str());
+  }
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+void asset_resolution_cache_test(void);
+void asset_storage_test(void);
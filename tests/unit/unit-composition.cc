@@ -0,0 +1,1392 @@
+#ifdef _MSC_VER
+#define NOMINMAX
+#endif
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#if defined(TINYUSDZ_ENABLE_THREAD)
+#include <thread>
+#endif
+
+#include "unit-composition.h"
+#include "asset-resolution.hh"
+#include "composition.hh"
+#include "incremental-composition.hh"
+#include "prim-types.hh"
+#include "stage.hh"
+#include "tinyusdz.hh"
+#include "usdGeom.hh"
+
+using namespace tinyusdz;
+
+namespace {
+
+// In-memory assets. key = asset name.
+using MemoryAssets = std::map<std::string, std::string>;
+
+int MemResolve(const char *asset_name,
+               const std::vector<std::string> &search_paths,
+               std::string *resolved_asset_name, std::string *err,
+               void *userdata) {
+  (void)search_paths;
+  (void)err;
+  const MemoryAssets *assets = reinterpret_cast<const MemoryAssets *>(userdata);
+  if (!assets->count(asset_name)) {
+    return -1;
+  }
+  (*resolved_asset_name) = asset_name;
+  return 0;
+}
+
+int MemSize(const char *resolved_asset_name, uint64_t *nbytes,
+            std::string *err, void *userdata) {
+  (void)err;
+  const MemoryAssets *assets = reinterpret_cast<const MemoryAssets *>(userdata);
+  if (!assets->count(resolved_asset_name)) {
+    return -1;
+  }
+  (*nbytes) = assets->at(resolved_asset_name).size();
+  return 0;
+}
+
+int MemRead(const char *resolved_asset_name, uint64_t req_nbytes,
+            uint8_t *out_buf, uint64_t *nbytes, std::string *err,
+            void *userdata) {
+  (void)err;
+  const MemoryAssets *assets = reinterpret_cast<const MemoryAssets *>(userdata);
+  if (!assets->count(resolved_asset_name)) {
+    return -1;
+  }
+  const std::string &s = assets->at(resolved_asset_name);
+  if (req_nbytes < s.size()) {
+    return -1;
+  }
+  memcpy(out_buf, s.data(), s.size());
+  (*nbytes) = s.size();
+  return 0;
+}
+
+Asset MakeAsset(const std::string &s) {
+  Asset asset;
+  asset.resize(s.size());
+  memcpy(asset.data(), s.data(), s.size());
+  return asset;
+}
+
+}  // namespace
+
+void layer_cache_test(void) {
+  // LayerCache API
+  {
+    LayerCache cache;
+    TEST_CHECK(cache.validate_content() == true);
+
+    Asset asset = MakeAsset("#usda 1.0\n");
+    TEST_CHECK(cache.find("a.usda", &asset) == nullptr);
+
+    std::shared_ptr<const Layer> layer = std::make_shared<const Layer>();
+    cache.insert("a.usda", asset, layer);
+    TEST_CHECK(cache.size() == 1);
+    TEST_CHECK(cache.find("a.usda", &asset) == layer);
+
+    // Content changed.
+    Asset modified = MakeAsset("#usda 1.0\n\n");
+    TEST_CHECK(cache.find("a.usda", &modified) == nullptr);
+    TEST_CHECK(cache.size() == 0);
+
+    LayerCacheStats stats = cache.stats();
+    TEST_CHECK(stats.hits == 1);
+    TEST_CHECK(stats.misses == 2);
+    TEST_CHECK(stats.invalidations == 1);
+
+    cache.insert("a.usda", asset, layer);
+    TEST_CHECK(cache.erase("a.usda"));
+    TEST_CHECK(!cache.erase("a.usda"));
+
+    cache.reset_stats();
+    TEST_CHECK(cache.stats().hits == 0);
+  }
+
+  // Without content validation, the asset is not required.
+  {
+    LayerCache cache(/* validate_content */ false);
+
+    Asset asset = MakeAsset("#usda 1.0\n");
+    std::shared_ptr<const Layer> layer = std::make_shared<const Layer>();
+    cache.insert("a.usda", asset, layer);
+    TEST_CHECK(cache.find("a.usda") == layer);
+
+    cache.clear();
+    TEST_CHECK(cache.size() == 0);
+  }
+
+  // Share the cache among references.
+  {
+    MemoryAssets assets;
+    assets["child.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "child"
+)
+
+def Xform "child"
+{
+}
+)";
+
+    AssetResolutionResolver resolver;
+    AssetResolutionHandler handler;
+    handler.resolve_fun = MemResolve;
+    handler.size_fun = MemSize;
+    handler.read_fun = MemRead;
+    handler.userdata = &assets;
+    resolver.register_asset_resolution_handler("usda", handler);
+
+    const std::string root_usda = R"(#usda 1.0
+
+def "a" (
+  references = @child.usda@
+)
+{
+}
+
+def "b" (
+  references = @child.usda@
+)
+{
+}
+)";
+
+    Layer root_layer;
+    std::string warn, err;
+    bool ret = LoadLayerFromMemory(
+        reinterpret_cast<const uint8_t *>(root_usda.data()), root_usda.size(),
+        "root.usda", &root_layer, &warn, &err);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+
+    LayerCache cache;
+    ReferencesCompositionOptions options;
+    options.layer_cache = &cache;
+
+    Layer dst;
+    ret = CompositeReferences(resolver, root_layer, &dst, &warn, &err,
+                              options);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+
+    LayerCacheStats stats = cache.stats();
+    TEST_CHECK(stats.misses == 1);
+    TEST_CHECK(stats.hits == 1);
+
+    const PrimSpec *ps{nullptr};
+    TEST_CHECK(dst.find_primspec_at(Path("/b", ""), &ps, &err));
+    TEST_CHECK(ps != nullptr);
+    if (ps) {
+      TEST_CHECK(ps->typeName() == "Xform");
+    }
+
+    // Modify the asset. The cached Layer must not be used.
+    assets["child.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "child"
+)
+
+def Scope "child"
+{
+}
+)";
+
+    Layer dst2;
+    ret = CompositeReferences(resolver, root_layer, &dst2, &warn, &err,
+                              options);
+    TEST_CHECK(ret == true);
+
+    stats = cache.stats();
+    TEST_CHECK(stats.invalidations == 1);
+
+    ps = nullptr;
+    TEST_CHECK(dst2.find_primspec_at(Path("/a", ""), &ps, &err));
+    TEST_CHECK(ps != nullptr);
+    if (ps) {
+      TEST_CHECK(ps->typeName() == "Scope");
+    }
+  }
+}
+
+void composition_concurrent_load_test(void) {
+  MemoryAssets assets;
+
+  std::string root_usda = "#usda 1.0\n";
+  std::string sublayer_root_usda = "#usda 1.0\n(\n  subLayers = [\n";
+
+  const size_t kNumAssets = 16;
+  for (size_t i = 0; i < kNumAssets; i++) {
+    std::string name = "child" + std::to_string(i);
+    assets[name + ".usda"] = "#usda 1.0\n(\n  defaultPrim = \"" + name +
+                             "\"\n)\n\ndef Xform \"" + name +
+                             "\"\n{\n  double radius = " + std::to_string(i) +
+                             "\n}\n";
+
+    // Reference the same asset twice.
+    for (size_t k = 0; k < 2; k++) {
+      root_usda += "def \"ref" + std::to_string(i) + "_" + std::to_string(k) +
+                   "\" (\n  references = @" + name + ".usda@\n)\n{\n}\n";
+    }
+
+    sublayer_root_usda += "    @" + name + ".usda@,\n";
+  }
+  sublayer_root_usda += "  ]\n)\n";
+
+  AssetResolutionResolver resolver;
+  AssetResolutionHandler handler;
+  handler.resolve_fun = MemResolve;
+  handler.size_fun = MemSize;
+  handler.read_fun = MemRead;
+  handler.userdata = &assets;
+  resolver.register_asset_resolution_handler("usda", handler);
+
+  // references
+  {
+    Layer root_layer;
+    std::string warn, err;
+    bool ret = LoadLayerFromMemory(
+        reinterpret_cast<const uint8_t *>(root_usda.data()), root_usda.size(),
+        "root.usda", &root_layer, &warn, &err);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+
+    ReferencesCompositionOptions serial_options;
+    serial_options.num_threads = 1;
+
+    Layer serial_dst;
+    ret = CompositeReferences(resolver, root_layer, &serial_dst, &warn, &err,
+                              serial_options);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+
+    LayerCache cache;
+    ReferencesCompositionOptions options;
+    options.layer_cache = &cache;
+    options.num_threads = 4;
+
+    Layer dst;
+    ret = CompositeReferences(resolver, root_layer, &dst, &warn, &err,
+                              options);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+
+    LayerCacheStats stats = cache.stats();
+    TEST_CHECK(cache.size() == kNumAssets);
+#if defined(TINYUSDZ_ENABLE_THREAD)
+    // All assets are prefetched, so every LoadAsset hits the cache.
+    TEST_CHECK(stats.hits == 2 * kNumAssets);
+    TEST_CHECK(stats.misses == 0);
+#else
+    TEST_CHECK(stats.hits == kNumAssets);
+    TEST_CHECK(stats.misses == kNumAssets);
+#endif
+
+    TEST_CHECK(dst.primspecs().size() == serial_dst.primspecs().size());
+    for (const auto &item : serial_dst.primspecs()) {
+      const PrimSpec *ps{nullptr};
+      TEST_CHECK(dst.find_primspec_at(Path("/" + item.first, ""), &ps, &err));
+      TEST_CHECK(ps != nullptr);
+      if (ps) {
+        TEST_CHECK(ps->typeName() == item.second.typeName());
+        TEST_CHECK(ps->props().size() == item.second.props().size());
+      }
+    }
+  }
+
+  // subLayers
+  {
+    Layer root_layer;
+    std::string warn, err;
+    bool ret = LoadLayerFromMemory(
+        reinterpret_cast<const uint8_t *>(sublayer_root_usda.data()),
+        sublayer_root_usda.size(), "root.usda", &root_layer, &warn, &err);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+
+    SublayersCompositionOptions options;
+    options.num_threads = 4;
+
+    Layer dst;
+    ret = CompositeSublayers(resolver, root_layer, &dst, &warn, &err, options);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+
+    TEST_CHECK(dst.primspecs().size() == kNumAssets);
+  }
+
+  // Search paths(base dirs of resolved assets) are appended in the same
+  // order as the single-threaded composition.
+  {
+    MemoryAssets dir_assets;
+    dir_assets["d0/a.usda"] =
+        "#usda 1.0\n(\n  subLayers = [@d2/c.usda@]\n)\ndef \"a\"\n{\n}\n";
+    dir_assets["d1/b.usda"] = "#usda 1.0\ndef \"b\"\n{\n}\n";
+    dir_assets["d2/c.usda"] = "#usda 1.0\ndef \"c\"\n{\n}\n";
+
+    const std::string dir_root_usda =
+        "#usda 1.0\n(\n  subLayers = [@d0/a.usda@, @d1/b.usda@]\n)\n";
+
+    Layer root_layer;
+    std::string warn, err;
+    TEST_CHECK(LoadLayerFromMemory(
+        reinterpret_cast<const uint8_t *>(dir_root_usda.data()),
+        dir_root_usda.size(), "root.usda", &root_layer, &warn, &err));
+    TEST_MSG("%s", err.c_str());
+
+    std::vector<std::string> search_paths[2];
+    for (size_t n = 0; n < 2; n++) {
+      AssetResolutionResolver dir_resolver;
+      AssetResolutionHandler dir_handler = handler;
+      dir_handler.userdata = &dir_assets;
+      dir_resolver.register_asset_resolution_handler("usda", dir_handler);
+
+      LayerCache cache;
+      SublayersCompositionOptions options;
+      options.layer_cache = &cache;
+      options.num_threads = (n == 0) ? 1 : 4;
+
+      Layer dst;
+      TEST_CHECK(CompositeSublayers(dir_resolver, root_layer, &dst, &warn,
+                                    &err, options));
+      TEST_MSG("%s", err.c_str());
+      TEST_CHECK(dst.primspecs().size() == 3);
+
+      search_paths[n] = dir_resolver.search_paths();
+    }
+
+    const std::vector<std::string> expected = {"d0", "d2", "d1"};
+    TEST_CHECK(search_paths[0] == expected);
+    TEST_CHECK(search_paths[1] == expected);
+  }
+
+  // Warnings of prefetched assets are reported in the same order as the
+  // single-threaded composition.
+  {
+    MemoryAssets warn_assets;
+    warn_assets["w0.usda"] =
+        "#usda 1.0\n(\n  upAxis = \"W0\"\n)\ndef \"w0\"\n{\n}\n";
+    warn_assets["w1.usda"] =
+        "#usda 1.0\n(\n  upAxis = \"W1\"\n)\ndef \"w1\"\n{\n}\n";
+
+    // missing.usda is reported by the composition pass.
+    const std::string warn_root_usda =
+        "#usda 1.0\n"
+        "def \"a\" (\n  references = @w0.usda@\n)\n{\n}\n"
+        "def \"b\" (\n  references = @missing.usda@\n)\n{\n}\n"
+        "def \"c\" (\n  references = @w1.usda@\n)\n{\n}\n";
+
+    Layer root_layer;
+    std::string warn, err;
+    TEST_CHECK(LoadLayerFromMemory(
+        reinterpret_cast<const uint8_t *>(warn_root_usda.data()),
+        warn_root_usda.size(), "root.usda", &root_layer, &warn, &err));
+    TEST_MSG("%s", err.c_str());
+
+    std::string warns[2];
+    for (size_t n = 0; n < 2; n++) {
+      AssetResolutionResolver warn_resolver;
+      AssetResolutionHandler warn_handler = handler;
+      warn_handler.userdata = &warn_assets;
+      warn_resolver.register_asset_resolution_handler("usda", warn_handler);
+
+      LayerCache cache;
+      ReferencesCompositionOptions options;
+      options.layer_cache = &cache;
+      options.num_threads = (n == 0) ? 1 : 4;
+
+      Layer dst;
+      TEST_CHECK(CompositeReferences(warn_resolver, root_layer, &dst,
+                                     &warns[n], &err, options));
+      TEST_MSG("%s", err.c_str());
+    }
+
+    const size_t w0_pos = warns[0].find("W0");
+    const size_t missing_pos = warns[0].find("missing.usda");
+    const size_t w1_pos = warns[0].find("W1");
+    TEST_CHECK(w0_pos != std::string::npos);
+    TEST_CHECK(missing_pos != std::string::npos);
+    TEST_CHECK(w1_pos != std::string::npos);
+    // Prims are not necessarily composed in the authored order.
+    TEST_CHECK(((w0_pos < missing_pos) && (missing_pos < w1_pos)) ||
+               ((w1_pos < missing_pos) && (missing_pos < w0_pos)));
+    TEST_MSG("%s", warns[0].c_str());
+
+    TEST_CHECK(warns[1] == warns[0]);
+    TEST_MSG("%s", warns[1].c_str());
+  }
+}
+
+void incremental_composition_test(void) {
+  MemoryAssets assets;
+  assets["a.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "a"
+)
+
+def Xform "a"
+{
+}
+)";
+  assets["b.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "b"
+)
+
+def Xform "b"
+{
+}
+)";
+
+  AssetResolutionResolver resolver;
+  AssetResolutionHandler handler;
+  handler.resolve_fun = MemResolve;
+  handler.size_fun = MemSize;
+  handler.read_fun = MemRead;
+  handler.userdata = &assets;
+  resolver.register_asset_resolution_handler("usda", handler);
+
+  const std::string root_usda = R"(#usda 1.0
+
+def "x" (
+  references = @a.usda@
+)
+{
+}
+
+def "y" (
+  references = @b.usda@
+)
+{
+}
+
+class "_base"
+{
+  double radius = 1.0
+}
+
+def Xform "z" (
+  inherits = </_base>
+)
+{
+}
+
+def Xform "v" (
+  variants = {
+    string shape = "cube"
+  }
+  prepend variantSets = "shape"
+)
+{
+  variantSet "shape" = {
+    "cube" {
+      def Cube "geom"
+      {
+      }
+    }
+    "sphere" {
+      def Sphere "geom"
+      {
+      }
+    }
+  }
+}
+)";
+
+  Layer root_layer;
+  std::string warn, err;
+  bool ret = LoadLayerFromMemory(
+      reinterpret_cast<const uint8_t *>(root_usda.data()), root_usda.size(),
+      "root.usda", &root_layer, &warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  IncrementalComposer composer;
+  ret = composer.open(resolver, root_layer, &warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(composer.composed_layer().primspecs().size() == 5);
+  TEST_CHECK(composer.updated_prims().size() == 5);
+  TEST_CHECK(!composer.is_dirty());
+
+  const std::set<std::string> *deps = composer.asset_dependencies("x");
+  TEST_CHECK(deps != nullptr);
+  if (deps) {
+    TEST_CHECK(deps->size() == 1);
+    TEST_CHECK(deps->count("a.usda") == 1);
+  }
+
+  auto find_primspec = [&composer](const std::string &path) {
+    const PrimSpec *ps{nullptr};
+    composer.composed_layer().find_primspec_at(Path(path, ""), &ps, nullptr);
+    return ps;
+  };
+
+  {
+    const PrimSpec *ps = find_primspec("/z");
+    TEST_CHECK(ps != nullptr);
+    if (ps) {
+      TEST_CHECK(ps->props().count("radius") == 1);
+    }
+
+    ps = find_primspec("/v/geom");
+    TEST_CHECK(ps != nullptr);
+    if (ps) {
+      TEST_CHECK(ps->typeName() == "Cube");
+    }
+  }
+
+  // Modify the referenced asset. Only `x` is recomposed.
+  assets["a.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "a"
+)
+
+def Scope "a"
+{
+}
+)";
+  TEST_CHECK(composer.mark_asset_dirty("a.usda") == true);
+  TEST_CHECK(composer.mark_asset_dirty("unused.usda") == false);
+  TEST_CHECK(composer.is_dirty());
+
+  ret = composer.update(&warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(composer.updated_prims().size() == 1);
+  TEST_CHECK(composer.updated_prims()[0] == "x");
+  {
+    const PrimSpec *ps = find_primspec("/x");
+    TEST_CHECK(ps != nullptr);
+    if (ps) {
+      TEST_CHECK(ps->typeName() == "Scope");
+    }
+  }
+
+  // Edit the inherited PrimSpec. Inheriting Prims are also recomposed.
+  {
+    PrimSpec base = root_layer.primspecs().at("_base");
+    TEST_CHECK(base.props().count("radius") == 1);
+    base.props().emplace("height", base.props().at("radius"));
+    TEST_CHECK(composer.set_primspec(base, &err));
+
+    ret = composer.update(&warn, &err);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(composer.updated_prims().size() == 2);
+
+    const PrimSpec *ps = find_primspec("/z");
+    TEST_CHECK(ps != nullptr);
+    if (ps) {
+      TEST_CHECK(ps->props().count("height") == 1);
+    }
+  }
+
+  // Change the variant selection.
+  {
+    TEST_CHECK(composer.set_variant_selection(Path("/v", ""), "shape",
+                                              "sphere", &err));
+    ret = composer.update(&warn, &err);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(composer.updated_prims().size() == 1);
+
+    const PrimSpec *ps = find_primspec("/v/geom");
+    TEST_CHECK(ps != nullptr);
+    if (ps) {
+      TEST_CHECK(ps->typeName() == "Sphere");
+    }
+  }
+
+  // Remove a root Prim.
+  {
+    TEST_CHECK(composer.remove_primspec("y"));
+    ret = composer.update(&warn, &err);
+    TEST_CHECK(ret == true);
+    TEST_CHECK(composer.removed_prims().size() == 1);
+    TEST_CHECK(composer.composed_layer().primspecs().size() == 4);
+  }
+
+  // No modification.
+  {
+    ret = composer.update(&warn, &err);
+    TEST_CHECK(ret == true);
+    TEST_CHECK(composer.updated_prims().empty());
+  }
+
+  const IncrementalCompositionStats &stats = composer.stats();
+  TEST_CHECK(stats.num_recomposed_prims == 9);
+
+  // Variant selection of a Prim(and variantSet) which only exists in a
+  // referenced asset.
+  {
+    assets["variant.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "rv"
+)
+
+def Xform "rv"
+{
+  def Xform "inner" (
+    variants = {
+      string shape = "cube"
+    }
+    prepend variantSets = "shape"
+  )
+  {
+    variantSet "shape" = {
+      "cube" {
+        def Cube "geom"
+        {
+        }
+      }
+      "sphere" {
+        def Sphere "geom"
+        {
+        }
+      }
+    }
+  }
+}
+)";
+
+    const std::string ref_usda = R"(#usda 1.0
+
+def "r" (
+  references = @variant.usda@
+)
+{
+}
+)";
+
+    Layer ref_layer;
+    TEST_CHECK(LoadLayerFromMemory(
+        reinterpret_cast<const uint8_t *>(ref_usda.data()), ref_usda.size(),
+        "root.usda", &ref_layer, &warn, &err));
+    TEST_MSG("%s", err.c_str());
+
+    IncrementalComposer ref_composer;
+    TEST_CHECK(ref_composer.open(resolver, ref_layer, &warn, &err));
+    TEST_MSG("%s", err.c_str());
+
+    auto geom_type = [&ref_composer]() {
+      const PrimSpec *ps{nullptr};
+      ref_composer.composed_layer().find_primspec_at(Path("/r/inner/geom", ""), &ps,
+                                                     nullptr);
+      return ps ? ps->typeName() : std::string();
+    };
+    TEST_CHECK(geom_type() == "Cube");
+
+    TEST_CHECK(ref_composer.set_variant_selection(Path("/r/inner", ""),
+                                                  "shape", "sphere", &err));
+    std::string ref_warn;
+    TEST_CHECK(ref_composer.update(&ref_warn, &err));
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(geom_type() == "Sphere");
+    TEST_CHECK(ref_warn.find("Variant selection") == std::string::npos);
+
+    // No Prim at the path.
+    TEST_CHECK(ref_composer.set_variant_selection(Path("/r/none", ""), "shape",
+                                                  "cube", &err));
+    ref_warn.clear();
+    TEST_CHECK(ref_composer.update(&ref_warn, &err));
+    TEST_CHECK(ref_warn.find("`/r/none`") != std::string::npos);
+    TEST_MSG("%s", ref_warn.c_str());
+    TEST_CHECK(geom_type() == "Sphere");
+  }
+}
+
+void payload_load_rules_test(void) {
+  {
+    PayloadLoadRules rules;
+    TEST_CHECK(rules.is_loaded(Path("/World/tileA", "")) == true);
+
+    rules.unload(Path("/World", ""));
+    rules.load(Path("/World/tileA", ""));
+    TEST_CHECK(rules.is_loaded(Path("/World", "")) == false);
+    TEST_CHECK(rules.is_loaded(Path("/World/tileA", "")) == true);
+    TEST_CHECK(rules.is_loaded(Path("/World/tileA/x", "")) == true);
+    TEST_CHECK(rules.is_loaded(Path("/World/tileAB", "")) == false);
+    TEST_CHECK(rules.is_loaded(Path("/World/tileB", "")) == false);
+    TEST_CHECK(rules.is_loaded(Path("/Other", "")) == true);
+
+    // Descendant rules are removed.
+    rules.load(Path("/World", ""));
+    TEST_CHECK(rules.rules().empty());
+
+    rules.unload_all();
+    TEST_CHECK(rules.is_loaded(Path("/Other", "")) == false);
+  }
+
+  MemoryAssets assets;
+  assets["p1.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "p1"
+)
+
+def Xform "p1"
+{
+  def Cube "detail"
+  {
+  }
+}
+)";
+  assets["p2.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "p2"
+)
+
+def Xform "p2"
+{
+  def Sphere "detail"
+  {
+  }
+}
+)";
+
+  AssetResolutionResolver resolver;
+  AssetResolutionHandler handler;
+  handler.resolve_fun = MemResolve;
+  handler.size_fun = MemSize;
+  handler.read_fun = MemRead;
+  handler.userdata = &assets;
+  resolver.register_asset_resolution_handler("usda", handler);
+
+  const std::string root_usda = R"(#usda 1.0
+
+def Xform "World"
+{
+  def "tileA" (
+    payload = @p1.usda@
+  )
+  {
+  }
+
+  def "tileB" (
+    payload = @p2.usda@
+  )
+  {
+  }
+}
+)";
+
+  Layer root_layer;
+  std::string warn, err;
+  bool ret = LoadLayerFromMemory(
+      reinterpret_cast<const uint8_t *>(root_usda.data()), root_usda.size(),
+      "root.usda", &root_layer, &warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  // CompositePayload with rules.
+  {
+    PayloadLoadRules rules(/* load_all */ false);
+    rules.load(Path("/World/tileB", ""));
+
+    PayloadCompositionOptions options;
+    options.load_rules = &rules;
+    TEST_CHECK(HasPayload(root_layer, true, options) == true);
+
+    Layer dst;
+    ret = CompositePayload(resolver, root_layer, &dst, &warn, &err, options);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(HasPayload(dst, true, options) == false);
+
+    const PrimSpec *ps{nullptr};
+    TEST_CHECK(dst.find_primspec_at(Path("/World/tileB/detail", ""), &ps,
+                                    &err) == true);
+    ps = nullptr;
+    TEST_CHECK(dst.find_primspec_at(Path("/World/tileA/detail", ""), &ps,
+                                    &err) == false);
+    TEST_CHECK(dst.find_primspec_at(Path("/World/tileA", ""), &ps, &err) ==
+               true);
+    if (ps) {
+      // Payload is kept for later loading.
+      TEST_CHECK(ps->metas().payload.has_value());
+    }
+  }
+
+  IncrementalCompositionOptions options;
+  options.load_payloads = false;
+
+  IncrementalComposer composer;
+  ret = composer.open(resolver, root_layer, &warn, &err, options);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  auto has_primspec = [&composer](const std::string &path) {
+    const PrimSpec *ps{nullptr};
+    std::string e;
+    return composer.composed_layer().find_primspec_at(Path(path, ""), &ps,
+                                                      &e) &&
+           ps;
+  };
+
+  TEST_CHECK(has_primspec("/World/tileA"));
+  TEST_CHECK(!has_primspec("/World/tileA/detail"));
+  TEST_CHECK(!has_primspec("/World/tileB/detail"));
+  TEST_CHECK(composer.asset_dependencies("World")->empty());
+
+  // Load payload of `tileA`.
+  TEST_CHECK(composer.load_payload(Path("/World/tileA", ""), &err));
+  TEST_CHECK(composer.is_payload_loaded(Path("/World/tileA", "")));
+  TEST_CHECK(!composer.is_payload_loaded(Path("/World/tileB", "")));
+
+  ret = composer.update(&warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(composer.updated_prims().size() == 1);
+  TEST_CHECK(composer.stats().num_payload_updates == 1);
+  TEST_CHECK(has_primspec("/World/tileA/detail"));
+  TEST_CHECK(!has_primspec("/World/tileB/detail"));
+  TEST_CHECK(composer.asset_dependencies("World")->count("p1.usda") == 1);
+
+  // Unload
+  TEST_CHECK(composer.unload_payload(Path("/World/tileA", ""), &err));
+  ret = composer.update(&warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(!has_primspec("/World/tileA/detail"));
+  TEST_CHECK(composer.asset_dependencies("World")->empty());
+
+  // Stage-level API.
+  {
+    Stage stage;
+    TEST_CHECK(LayerToStage(composer.composed_layer(), &stage, &warn, &err));
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(stage.GetPrimAtPath(Path("/World/tileB", "")).has_value());
+    TEST_CHECK(
+        !stage.GetPrimAtPath(Path("/World/tileB/detail", "")).has_value());
+
+    TEST_CHECK(
+        LoadPayload(composer, Path("/World/tileB", ""), &stage, &warn, &err));
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(composer.is_payload_loaded(Path("/World/tileB", "")));
+    auto detail = stage.GetPrimAtPath(Path("/World/tileB/detail", ""));
+    TEST_CHECK(detail.has_value());
+    if (detail) {
+      TEST_CHECK(detail.value()->is<GeomSphere>());
+    }
+
+    TEST_CHECK(UnloadPayload(composer, Path("/World/tileB", ""), &stage,
+                             &warn, &err));
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(stage.GetPrimAtPath(Path("/World/tileB", "")).has_value());
+    TEST_CHECK(
+        !stage.GetPrimAtPath(Path("/World/tileB/detail", "")).has_value());
+  }
+}
+
+namespace {
+
+void CollectPrimsRec(const Prim &prim, const std::string &parent_path,
+                     std::vector<std::pair<std::string, int64_t>> *prims) {
+  const std::string path = parent_path + "/" + prim.element_name();
+  prims->emplace_back(path + ":" + prim.prim_type_name(), prim.prim_id());
+  for (const auto &child : prim.children()) {
+    CollectPrimsRec(child, path, prims);
+  }
+}
+
+std::vector<std::pair<std::string, int64_t>> CollectPrims(const Stage &stage) {
+  std::vector<std::pair<std::string, int64_t>> prims;
+  for (const auto &root : stage.root_prims()) {
+    CollectPrimsRec(root, "", &prims);
+  }
+  return prims;
+}
+
+}  // namespace
+
+void layer_to_stage_test(void) {
+  std::string usda = "#usda 1.0\n";
+  for (size_t i = 0; i < 8; i++) {
+    usda += "def Xform \"root" + std::to_string(i) + "\"\n{\n";
+    usda += "  def Mesh \"mesh\"\n  {\n";
+    usda += "    point3f[] points = [(0, 0, 0), (1, 0, 0), (" +
+            std::to_string(i) + ", 1, 0)]\n";
+    usda += "    int[] faceVertexCounts = [3]\n";
+    usda += "    int[] faceVertexIndices = [0, 1, 2]\n";
+    usda += "  }\n";
+    usda += "  def Scope \"child\"\n  {\n    def Sphere \"sphere\"\n    {\n"
+            "    }\n  }\n";
+    usda += "}\n";
+  }
+
+  Layer layer;
+  std::string warn, err;
+  bool ret = LoadLayerFromMemory(
+      reinterpret_cast<const uint8_t *>(usda.data()), usda.size(), "root.usda",
+      &layer, &warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  // Single-threaded by default.
+  LayerToStageOptions serial_options;
+  TEST_CHECK(serial_options.num_threads == 1);
+
+  Stage serial_stage;
+  ret = LayerToStage(layer, &serial_stage, &warn, &err, serial_options);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  const auto serial_prims = CollectPrims(serial_stage);
+  TEST_CHECK(serial_prims.size() == 8 * 4);
+  if (!serial_prims.empty()) {
+    TEST_CHECK(serial_prims[0].first == "/root0:Xform");
+    TEST_CHECK(serial_prims[0].second == 1);
+  }
+
+  const Prim *prim{nullptr};
+  TEST_CHECK(serial_stage.find_prim_at_path(Path("/root3/mesh", ""), prim,
+                                            &err));
+  if (prim) {
+    const GeomMesh *mesh = prim->as<GeomMesh>();
+    TEST_CHECK(mesh != nullptr);
+    if (mesh) {
+      std::vector<value::point3f> points = mesh->get_points();
+      TEST_CHECK(points.size() == 3);
+      if (points.size() == 3) {
+        TEST_CHECK(points[2][0] == 3.0f);
+      }
+    }
+  }
+
+  LayerToStageOptions options;
+  options.num_threads = 4;
+
+  Stage stage;
+  ret = LayerToStage(layer, &stage, &warn, &err, options);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(CollectPrims(stage) == serial_prims);
+
+  // Move PrimSpecs
+  Stage moved_stage;
+  ret = LayerToStage(std::move(layer), &moved_stage, &warn, &err, options);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(CollectPrims(moved_stage) == serial_prims);
+
+  prim = nullptr;
+  TEST_CHECK(moved_stage.find_prim_at_path(Path("/root3/mesh", ""), prim,
+                                           &err));
+  if (prim) {
+    const GeomMesh *mesh = prim->as<GeomMesh>();
+    TEST_CHECK(mesh != nullptr);
+    if (mesh) {
+      TEST_CHECK(mesh->get_points().size() == 3);
+    }
+  }
+}
+
+void variant_index_test(void) {
+  const std::string usda = R"(#usda 1.0
+
+def Xform "a" (
+  variants = {
+    string shape = "cube"
+  }
+  prepend variantSets = "shape"
+)
+{
+  variantSet "shape" = {
+    "cube" {
+      def Cube "geom" (
+        variants = {
+          string size = "small"
+        }
+        prepend variantSets = "size"
+      )
+      {
+        variantSet "size" = {
+          "small" {
+            double size = 1.0
+          }
+          "large" {
+            double size = 10.0
+          }
+        }
+      }
+    }
+    "sphere" {
+      def Sphere "geom"
+      {
+      }
+    }
+  }
+}
+
+def Xform "b" (
+  variants = {
+    string color = "red"
+  }
+  prepend variantSets = "color"
+)
+{
+  variantSet "color" = {
+    "red" {
+      def Scope "red"
+      {
+      }
+    }
+    "blue" {
+      def Scope "blue"
+      {
+      }
+    }
+  }
+}
+)";
+
+  Layer layer;
+  std::string warn, err;
+  bool ret = LoadLayerFromMemory(
+      reinterpret_cast<const uint8_t *>(usda.data()), usda.size(), "root.usda",
+      &layer, &warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  VariantIndex index;
+  ret = index.build(layer, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(index.entries().size() == 3);
+
+  const VariantIndex::PrimEntry *entry = index.find(Path("/a/geom", ""));
+  TEST_CHECK(entry != nullptr);
+  if (entry) {
+    TEST_CHECK(entry->in_variant == true);
+    TEST_CHECK(entry->update_root.prim_part() == "/a");
+    TEST_CHECK(entry->variants.at("size").size() == 2);
+    TEST_CHECK(entry->selection.at("size") == "small");
+  }
+
+  entry = index.find(Path("/b", ""));
+  TEST_CHECK(entry != nullptr);
+  if (entry) {
+    TEST_CHECK(entry->in_variant == false);
+    TEST_CHECK(entry->variant_sets.size() == 1);
+    TEST_CHECK(entry->variants.at("color").size() == 2);
+  }
+
+  Layer composed;
+  ret = index.compose(&composed, &warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(composed.primspecs().size() == 2);
+
+  const PrimSpec &b = composed.primspecs().at("b");
+  TEST_CHECK(b.children().size() == 1);
+  if (b.children().size() == 1) {
+    TEST_CHECK(b.children()[0].name() == "red");
+  }
+
+  const PrimSpec &a = composed.primspecs().at("a");
+  TEST_CHECK(a.children().size() == 1);
+  if (a.children().size() == 1) {
+    TEST_CHECK(a.children()[0].typeName() == "Cube");
+    TEST_CHECK(a.children()[0].props().count("size") == 1);
+  }
+
+  // Same selection does not mark the index dirty.
+  ret = index.set_selection(Path("/b", ""), "color", "red", &err);
+  TEST_CHECK(ret == true);
+  TEST_CHECK(!index.is_dirty());
+
+  // Invalid selection
+  TEST_CHECK(!index.set_selection(Path("/b", ""), "color", "green", &err));
+  TEST_CHECK(!index.set_selection(Path("/b", ""), "shape", "cube", &err));
+  TEST_CHECK(!index.set_selection(Path("/c", ""), "color", "red", &err));
+
+  ret = index.set_selection(Path("/b", ""), "color", "blue", &err);
+  TEST_CHECK(ret == true);
+  TEST_CHECK(index.is_dirty());
+
+  std::vector<Path> updated_paths;
+  ret = index.update(&composed, &warn, &err, &updated_paths);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(!index.is_dirty());
+  TEST_CHECK(updated_paths.size() == 1);
+  if (updated_paths.size() == 1) {
+    TEST_CHECK(updated_paths[0].prim_part() == "/b");
+  }
+
+  const PrimSpec &b2 = composed.primspecs().at("b");
+  TEST_CHECK(b2.children().size() == 1);
+  if (b2.children().size() == 1) {
+    TEST_CHECK(b2.children()[0].name() == "blue");
+  }
+
+  // Nested variant: re-resolve the subtree of the top-most variant Prim.
+  ret = index.set_selection(Path("/a/geom", ""), "size", "large", &err);
+  TEST_CHECK(ret == true);
+  ret = index.set_selection(Path("/a", ""), "shape", "cube", &err);
+  TEST_CHECK(ret == true);
+
+  updated_paths.clear();
+  ret = index.update(&composed, &warn, &err, &updated_paths);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(updated_paths.size() == 1);
+  if (updated_paths.size() == 1) {
+    TEST_CHECK(updated_paths[0].prim_part() == "/a");
+  }
+
+  const PrimSpec &a2 = composed.primspecs().at("a");
+  TEST_CHECK(a2.children().size() == 1);
+  if (a2.children().size() == 1) {
+    const auto it = a2.children()[0].props().find("size");
+    TEST_CHECK(it != a2.children()[0].props().end());
+    if (it != a2.children()[0].props().end()) {
+      const auto pv = it->second.get_attribute().get_value<double>();
+      TEST_CHECK(pv && (pv.value() == 10.0));
+    }
+  }
+
+  // Untouched subtree is kept.
+  const PrimSpec &b3 = composed.primspecs().at("b");
+  TEST_CHECK(b3.children().size() == 1);
+  if (b3.children().size() == 1) {
+    TEST_CHECK(b3.children()[0].name() == "blue");
+  }
+
+  Dictionary dict;
+  index.to_dictionary(&dict);
+  TEST_CHECK(dict.size() == 3);
+  TEST_CHECK(dict.count("/b") == 1);
+
+  // Free functions
+  VariantSelectorMap vsmap;
+  ret = ListVariantSelectionMaps(layer, vsmap);
+  TEST_CHECK(ret == true);
+  TEST_CHECK(vsmap.size() == 3);
+
+  vsmap[Path("/b", "")].vsmap["color"] = "blue";
+  Layer dst;
+  ret = ApplyVariantSelector(layer, vsmap, &dst, &warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+  if (ret) {
+    const PrimSpec &b4 = dst.primspecs().at("b");
+    TEST_CHECK(b4.children().size() == 1);
+    if (b4.children().size() == 1) {
+      TEST_CHECK(b4.children()[0].name() == "blue");
+    }
+  }
+}
+
+void sublayers_cycle_test(void) {
+  MemoryAssets assets;
+  // Diamond: root -> (b, c), b -> d, c -> d
+  assets["b.usda"] = "#usda 1.0\n(\n  subLayers = [@d.usda@]\n)\n"
+                     "def \"b\"\n{\n}\n";
+  assets["c.usda"] = "#usda 1.0\n(\n  subLayers = [@d.usda@]\n)\n"
+                     "def \"c\"\n{\n}\n";
+  assets["d.usda"] = "#usda 1.0\ndef \"d\"\n{\n}\n";
+
+  // Cycle: e -> f -> e
+  assets["e.usda"] = "#usda 1.0\n(\n  subLayers = [@f.usda@]\n)\n"
+                     "def \"e\"\n{\n}\n";
+  assets["f.usda"] = "#usda 1.0\n(\n  subLayers = [@e.usda@]\n)\n"
+                     "def \"f\"\n{\n}\n";
+
+  AssetResolutionResolver resolver;
+  AssetResolutionHandler handler;
+  handler.resolve_fun = MemResolve;
+  handler.size_fun = MemSize;
+  handler.read_fun = MemRead;
+  handler.userdata = &assets;
+  resolver.register_asset_resolution_handler("usda", handler);
+
+  {
+    Layer root;
+    root.metas().subLayers.resize(2);
+    root.metas().subLayers[0].assetPath = value::AssetPath("b.usda");
+    root.metas().subLayers[1].assetPath = value::AssetPath("c.usda");
+
+    Layer dst;
+    std::string warn, err;
+    bool ret = CompositeSublayers(resolver, root, &dst, &warn, &err);
+    TEST_CHECK(ret == true);
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(dst.primspecs().size() == 3);
+  }
+
+  {
+    Layer root;
+    root.metas().subLayers.resize(1);
+    root.metas().subLayers[0].assetPath = value::AssetPath("e.usda");
+
+    Layer dst;
+    std::string warn, err;
+    bool ret = CompositeSublayers(resolver, root, &dst, &warn, &err);
+    TEST_CHECK(ret == false);
+    TEST_CHECK(err.find("Circular") != std::string::npos);
+  }
+}
+
+void composition_stats_test(void) {
+  MemoryAssets assets;
+  assets["sub.usda"] = R"(#usda 1.0
+def Xform "sub"
+{
+}
+)";
+  assets["ref.usda"] = R"(#usda 1.0
+(
+  defaultPrim = "ref"
+)
+
+def Xform "ref"
+{
+  double radius = 2.0
+}
+)";
+
+  AssetResolutionResolver resolver;
+  AssetResolutionHandler handler;
+  handler.resolve_fun = MemResolve;
+  handler.size_fun = MemSize;
+  handler.read_fun = MemRead;
+  handler.userdata = &assets;
+  resolver.register_asset_resolution_handler("usda", handler);
+
+  const std::string root_usda = R"(#usda 1.0
+(
+  subLayers = [@sub.usda@]
+)
+
+def "a" (
+  references = @ref.usda@
+)
+{
+}
+
+def "b" (
+  prepend references = @ref.usda@
+)
+{
+}
+
+class "_base"
+{
+}
+
+def "c" (
+  inherits = </_base>
+)
+{
+}
+)";
+
+  Layer root_layer;
+  std::string warn, err;
+  bool ret = LoadLayerFromMemory(
+      reinterpret_cast<const uint8_t *>(root_usda.data()), root_usda.size(),
+      "root.usda", &root_layer, &warn, &err);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  CompositionStats stats;
+  LayerCache cache;
+
+  SublayersCompositionOptions sublayers_options;
+  sublayers_options.layer_cache = &cache;
+  sublayers_options.stats = &stats;
+
+  Layer sublayered;
+  ret = CompositeSublayers(resolver, root_layer, &sublayered, &warn, &err,
+                           sublayers_options);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  ReferencesCompositionOptions references_options;
+  references_options.layer_cache = &cache;
+  references_options.stats = &stats;
+
+  Layer referenced;
+  ret = CompositeReferences(resolver, sublayered, &referenced, &warn, &err,
+                            references_options);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  Layer inherited;
+  ret = CompositeInherits(referenced, &inherited, &warn, &err, &stats);
+  TEST_CHECK(ret == true);
+  TEST_MSG("%s", err.c_str());
+
+  const CompositionCounters c = stats.counters();
+  TEST_CHECK(c.sublayer_arcs == 1);
+  TEST_CHECK(c.reference_arcs == 2);
+  TEST_CHECK(c.inherit_arcs == 1);
+  TEST_CHECK(c.assets_loaded == 2);
+  TEST_CHECK(c.asset_cache_hits == 1);
+  // LayerCache validates the content, so the asset is read on cache hit.
+  TEST_CHECK(c.bytes_read ==
+             (assets["sub.usda"].size() + 2 * assets["ref.usda"].size()));
+  // Merges of `references` are not counted.
+  TEST_CHECK(c.inherit_merges == 1);
+  TEST_CHECK(c.parse_time_ms >= 0.0);
+
+  // 3 passes + 4 arcs + 3 reads + 2 parses
+  const std::vector<CompositionTraceEvent> events = stats.events();
+  TEST_CHECK(events.size() == 12);
+  TEST_MSG("%d", int(events.size()));
+  size_t num_parse_events = 0;
+  for (const auto &ev : events) {
+    if (ev.name == "parse") {
+      num_parse_events++;
+    }
+  }
+  TEST_CHECK(num_parse_events == 2);
+
+  const std::string json = stats.to_chrome_trace_json();
+  TEST_CHECK(json.compare(0, 15, "{\"traceEvents\":") == 0);
+  TEST_CHECK(json.find("\"name\":\"references\"") != std::string::npos);
+  TEST_CHECK(json.find("\"asset\":\"ref.usda\"") != std::string::npos);
+  TEST_CHECK(json.find("\"reference_arcs\":2") != std::string::npos);
+
+  // Counters only
+  CompositionStats counter_stats(/* record_events */ false);
+  ret = CompositeInherits(referenced, &inherited, &warn, &err, &counter_stats);
+  TEST_CHECK(ret == true);
+  TEST_CHECK(counter_stats.counters().inherit_arcs == 1);
+  TEST_CHECK(counter_stats.events().empty());
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  // thread_id 0 is the thread which created CompositionStats, even when
+  // another thread adds the first event.
+  {
+    CompositionStats thread_stats;
+    std::thread worker([&thread_stats]() {
+      CompositionTraceEvent ev;
+      ev.name = "worker";
+      thread_stats.add_event(std::move(ev));
+    });
+    worker.join();
+
+    CompositionTraceEvent ev;
+    ev.name = "main";
+    thread_stats.add_event(std::move(ev));
+
+    const std::vector<CompositionTraceEvent> thread_events =
+        thread_stats.events();
+    TEST_CHECK(thread_events.size() == 2);
+    if (thread_events.size() == 2) {
+      TEST_CHECK(thread_events[0].thread_id == 1);
+      TEST_CHECK(thread_events[1].thread_id == 0);
+    }
+  }
+#endif
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+void layer_cache_test(void);
+void composition_concurrent_load_test(void);
+void incremental_composition_test(void);
+void payload_load_rules_test(void);
+void layer_to_stage_test(void);
+void variant_index_test(void);
+void sublayers_cycle_test(void);
+void composition_stats_test(void);
@@ -12,6 +12,11 @@
 #include "unit-customdata.h"
 #include "unit-handle-allocator.h"
 #include "unit-math.h"
+#include "unit-stage.h"
+#include "unit-tydra.h"
+#include "unit-composition.h"
+#include "unit-asset-resolution.h"
+#include "unit-ascii-parser.h"
 
 #if defined(TINYUSDZ_WITH_PXR_COMPAT_API)
 #include "unit-pxr-compat-api.h"
@@ -22,15 +27,44 @@
 TEST_LIST = {
   { "prim_type_test", prim_type_test },
   { "prim_add_test", prim_add_test },
+  { "prim_timesamples_held_test", prim_timesamples_held_test },
   { "primvar_test", primvar_test },
   { "value_types_test", value_types_test },
   { "xformOp_test", xformOp_test },
+  { "xform_batch_transform_test", xform_batch_transform_test },
   { "customdata_test", customdata_test },
   { "handle_allocator_test", handle_allocator_test },
   { "math_cos_pi_test", math_cos_pi_test },
   { "math_sin_pi_test", math_sin_pi_test },
   { "math_sin_cos_pi_test", math_sin_cos_pi_test },
   { "pathutil_test", pathutil_test },
+  { "stage_prim_lookup_test", stage_prim_lookup_test },
+  { "frozen_stage_test", frozen_stage_test },
+  { "tydra_parallel_visit_test", tydra_parallel_visit_test },
+  { "tydra_xform_cache_test", tydra_xform_cache_test },
+  { "tydra_render_scene_parallel_test", tydra_render_scene_parallel_test },
+  { "tydra_weld_face_vertices_test", tydra_weld_face_vertices_test },
+  { "tydra_triangulation_test", tydra_triangulation_test },
+  { "tydra_interleaved_vertex_buffer_test", tydra_interleaved_vertex_buffer_test },
+  { "tydra_meshlet_test", tydra_meshlet_test },
+  { "tydra_vertex_cache_test", tydra_vertex_cache_test },
+  { "tydra_geom_subset_material_test", tydra_geom_subset_material_test },
+  { "tydra_animation_test", tydra_animation_test },
+  { "tydra_bake_world_transform_test", tydra_bake_world_transform_test },
+  { "tydra_bound_material_test", tydra_bound_material_test },
+  { "tydra_instancing_test", tydra_instancing_test },
+  { "tydra_update_render_scene_test", tydra_update_render_scene_test },
+  { "layer_cache_test", layer_cache_test },
+  { "composition_concurrent_load_test", composition_concurrent_load_test },
+  { "incremental_composition_test", incremental_composition_test },
+  { "payload_load_rules_test", payload_load_rules_test },
+  { "layer_to_stage_test", layer_to_stage_test },
+  { "variant_index_test", variant_index_test },
+  { "sublayers_cycle_test", sublayers_cycle_test },
+  { "composition_stats_test", composition_stats_test },
+  { "asset_resolution_cache_test", asset_resolution_cache_test },
+  { "asset_storage_test", asset_storage_test },
+  { "ascii_parser_integer_test", ascii_parser_integer_test },
 #if defined(TINYUSDZ_WITH_PXR_COMPAT_API)
   { "pxr_compat_api_test", pxr_compat_api_test },
 #endif
@@ -140,3 +140,28 @@ void prim_add_test(void) {
   TEST_CHECK(root.add_child(std::move(dprim), /* rename_if_required */true)); 
   
 }
+
+void prim_timesamples_held_test(void) {
+  // Held interpolation uses the sample at or before the time, and the last
+  // sample after the end.
+  {
+    Animatable<float> anim;
+    anim.add_sample(10.0, 2.0f);
+    anim.add_sample(0.0, 1.0f);
+    anim.add_sample(20.0, 3.0f);
+
+    float v{0.0f};
+    TEST_CHECK(anim.get(-1.0, &v));
+    TEST_CHECK(v == 1.0f);
+    TEST_CHECK(anim.get(0.0, &v));
+    TEST_CHECK(v == 1.0f);
+    TEST_CHECK(anim.get(5.0, &v));
+    TEST_CHECK(v == 1.0f);
+    TEST_CHECK(anim.get(10.0, &v));
+    TEST_CHECK(v == 2.0f);
+    TEST_CHECK(anim.get(19.5, &v));
+    TEST_CHECK(v == 2.0f);
+    TEST_CHECK(anim.get(25.0, &v));
+    TEST_CHECK(v == 3.0f);
+  }
+}
@@ -0,0 +1,231 @@
+#ifdef _MSC_VER
+#define NOMINMAX
+#endif
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+#include <atomic>
+#include <thread>
+#endif
+
+#include "unit-stage.h"
+#include "prim-types.hh"
+#include "stage.hh"
+#include "frozen-stage.hh"
+
+using namespace tinyusdz;
+
+void stage_prim_lookup_test(void) {
+  Stage stage;
+
+  {
+    Model rootmodel;
+    Model amodel;
+    Model bmodel;
+
+    Prim root("root", rootmodel);
+    Prim aprim("a", amodel);
+    Prim bprim("b", bmodel);
+
+    TEST_CHECK(aprim.add_child(std::move(bprim)));
+    TEST_CHECK(root.add_child(std::move(aprim)));
+    TEST_CHECK(stage.add_root_prim(std::move(root)));
+  }
+
+  // Lookup before commit(fallback to traversal)
+  {
+    const Prim *prim{nullptr};
+    TEST_CHECK(stage.find_prim_at_path(Path("/root/a", ""), prim));
+    TEST_CHECK(prim != nullptr);
+  }
+
+  TEST_CHECK(stage.commit());
+
+  {
+    const Prim *prim{nullptr};
+    TEST_CHECK(stage.find_prim_at_path(Path("/root/a/b", ""), prim));
+    TEST_CHECK(prim != nullptr);
+    TEST_CHECK(prim->element_name() == "b");
+
+    int64_t prim_id{-1};
+    TEST_CHECK(stage.find_prim_at_path(Path("/root/a/b", ""), &prim_id));
+    TEST_CHECK(prim_id > 0);
+
+    const Prim *iprim{nullptr};
+    TEST_CHECK(stage.find_prim_by_prim_id(uint64_t(prim_id), iprim));
+    TEST_CHECK(iprim == prim);
+
+    TEST_CHECK(!stage.find_prim_at_path(Path("/root/c", ""), prim));
+  }
+
+  // Add more root Prims(may reallocate root Prim array)
+  for (size_t i = 0; i < 16; i++) {
+    Model model;
+    Prim prim("node" + std::to_string(i), model);
+    TEST_CHECK(stage.add_root_prim(std::move(prim)));
+  }
+
+  {
+    // Existing entries are still reachable.
+    const Prim *prim{nullptr};
+    TEST_CHECK(stage.find_prim_at_path(Path("/root/a/b", ""), prim));
+    TEST_CHECK(prim && (prim->element_name() == "b"));
+
+    // Newly added Prim is found without commit()
+    TEST_CHECK(stage.find_prim_at_path(Path("/node3", ""), prim));
+    TEST_CHECK(prim && (prim->element_name() == "node3"));
+  }
+
+  // Replace root Prim
+  {
+    Model model;
+    Prim prim("c", model);
+    TEST_CHECK(stage.replace_root_prim("root", std::move(prim)));
+
+    const Prim *p{nullptr};
+    TEST_CHECK(!stage.find_prim_at_path(Path("/root/a/b", ""), p));
+  }
+
+  TEST_CHECK(stage.commit());
+
+  {
+    const Prim *prim{nullptr};
+    TEST_CHECK(stage.find_prim_at_path(Path("/root", ""), prim));
+    TEST_CHECK(prim && (prim->element_name() == "root"));
+    TEST_CHECK(stage.find_prim_at_path(Path("/node15", ""), prim));
+
+    // Copied Stage must not refer Prims in the source Stage.
+    Stage copied = stage;
+    const Prim *cprim{nullptr};
+    TEST_CHECK(copied.find_prim_at_path(Path("/node15", ""), cprim));
+    TEST_CHECK(cprim && (cprim != prim));
+  }
+
+  // Prim with a stale(duplicated) prim_id added without commit() must not
+  // take over the index slot of the Prim owning the prim_id.
+  {
+    int64_t prim_id{-1};
+    TEST_CHECK(stage.find_prim_at_path(Path("/node15", ""), &prim_id));
+
+    Model model;
+    Prim dup("dup", model);
+    dup.prim_id() = prim_id;
+    dup.absolute_path() = Path("/dup", "");
+    stage.root_prims().emplace_back(std::move(dup));
+
+    const Prim *prim{nullptr};
+    TEST_CHECK(stage.find_prim_at_path(Path("/dup", ""), prim));
+    TEST_CHECK(prim && (prim->element_name() == "dup"));
+
+    TEST_CHECK(stage.find_prim_by_prim_id(uint64_t(prim_id), prim));
+    TEST_CHECK(prim && (prim->element_name() == "node15"));
+
+    TEST_CHECK(stage.find_prim_at_path(Path("/node15", ""), prim));
+    TEST_CHECK(prim && (prim->element_name() == "node15"));
+  }
+
+#if defined(TINYUSDZ_ENABLE_THREAD)
+  // Concurrent lookups on committed and uncommitted Stage.
+  for (size_t n = 0; n < 2; n++) {
+    TEST_CHECK(stage.commit());
+    if (n == 1) {
+      Model model;
+      Prim prim("extra", model);
+      TEST_CHECK(stage.add_root_prim(std::move(prim)));
+    }
+
+    std::atomic<uint32_t> num_failures{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++) {
+      threads.emplace_back([&stage, &num_failures]() {
+        for (size_t i = 0; i < 16; i++) {
+          const std::string name = "node" + std::to_string(i);
+          const Prim *prim{nullptr};
+          if (!stage.find_prim_at_path(Path("/" + name, ""), prim) || !prim ||
+              (prim->element_name() != name)) {
+            num_failures++;
+            continue;
+          }
+
+          const Prim *iprim{nullptr};
+          if (!stage.find_prim_by_prim_id(uint64_t(prim->prim_id()), iprim) ||
+              (iprim != prim)) {
+            num_failures++;
+          }
+        }
+      });
+    }
+    for (auto &th : threads) {
+      th.join();
+    }
+    TEST_CHECK(num_failures.load() == 0);
+  }
+#endif
+}
+
+void frozen_stage_test(void) {
+  Stage stage;
+
+  {
+    Model rootmodel;
+    Model amodel;
+    Model bmodel;
+    Model cmodel;
+
+    Prim root("root", rootmodel);
+    Prim aprim("a", amodel);
+    Prim bprim("b", bmodel);
+    Prim cprim("c", cmodel);
+
+    TEST_CHECK(aprim.add_child(std::move(bprim)));
+    TEST_CHECK(root.add_child(std::move(aprim)));
+    TEST_CHECK(root.add_child(std::move(cprim)));
+    TEST_CHECK(stage.add_root_prim(std::move(root)));
+
+    Model model;
+    Prim root2("root2", model);
+    TEST_CHECK(stage.add_root_prim(std::move(root2)));
+  }
+
+  TEST_CHECK(stage.commit());
+
+  FrozenStage frozen;
+  std::string err;
+  TEST_CHECK(FreezeStage(stage, &frozen, &err));
+  TEST_CHECK(frozen.size() == 5);
+  TEST_CHECK(frozen.root_indices().size() == 2);
+
+  // Depth-first order
+  TEST_CHECK(std::string(frozen.element_name(0)) == "root");
+  TEST_CHECK(std::string(frozen.element_name(1)) == "a");
+  TEST_CHECK(std::string(frozen.element_name(2)) == "b");
+  TEST_CHECK(std::string(frozen.element_name(3)) == "c");
+  TEST_CHECK(std::string(frozen.element_name(4)) == "root2");
+
+  TEST_CHECK(frozen.node(0).first_child == 1);
+  TEST_CHECK(frozen.node(0).num_children == 2);
+  TEST_CHECK(frozen.node(0).subtree_end == 4);
+  TEST_CHECK(frozen.node(0).next_sibling == 4);
+  TEST_CHECK(frozen.node(1).next_sibling == 3);
+  TEST_CHECK(frozen.node(2).parent == 1);
+  TEST_CHECK(frozen.node(2).depth == 2);
+
+  TEST_CHECK(frozen.find_prim_index(Path("/root/a/b", "")) == 2);
+  TEST_CHECK(frozen.find_prim_index(Path("/root2", "")) == 4);
+  TEST_CHECK(frozen.find_prim_index(Path("/root/d", "")) == -1);
+  TEST_CHECK(frozen.prim(2).absolute_path().full_path_name() == "/root/a/b");
+
+  int64_t prim_id{-1};
+  TEST_CHECK(stage.find_prim_at_path(Path("/root/c", ""), &prim_id));
+  TEST_CHECK(frozen.find_prim_index_by_prim_id(prim_id) == 3);
+
+  // Move version gives the same result.
+  FrozenStage moved;
+  TEST_CHECK(FreezeStage(std::move(stage), &moved, &err));
+  TEST_CHECK(moved.size() == 5);
+  TEST_CHECK(moved.find_prim_index(Path("/root/a/b", "")) == 2);
+  TEST_CHECK(moved.prim(2).element_name() == "b");
+  TEST_CHECK(moved.prim(2).children().empty());
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+void stage_prim_lookup_test(void);
+void frozen_stage_test(void);
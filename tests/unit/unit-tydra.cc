@@ -0,0 +1,2189 @@
+#ifdef _MSC_VER
+#define NOMINMAX
+#endif
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#include "unit-tydra.h"
+#include "prim-types.hh"
+#include "usdGeom.hh"
+#include "stage.hh"
+#include "tinyusdz.hh"
+#include "tydra/render-data.hh"
+#include "tydra/scene-access.hh"
+#include "tydra/shader-network.hh"
+
+using namespace tinyusdz;
+
+namespace {
+
+// Build Stage with `n` root Prims, each having `m` children with `k`
+// grandchildren.
+void BuildTestStage(Stage &stage, size_t n, size_t m, size_t k) {
+  for (size_t i = 0; i < n; i++) {
+    Model model;
+    Prim root("root" + std::to_string(i), model);
+    for (size_t j = 0; j < m; j++) {
+      Prim child("child" + std::to_string(j), model);
+      for (size_t l = 0; l < k; l++) {
+        Prim gchild("leaf" + std::to_string(l), model);
+        child.add_child(std::move(gchild));
+      }
+      root.add_child(std::move(child));
+    }
+    stage.add_root_prim(std::move(root));
+  }
+  stage.commit();
+}
+
+struct VisitData {
+  std::vector<size_t> counts;  // per-thread
+  std::vector<int> ordered;    // per prim_id. 1 = parent visited before.
+  const Stage *stage{nullptr};
+};
+
+bool ParallelVisitFun(const Path &abs_path, const Prim &prim,
+                      const int32_t tree_depth, const uint32_t thread_id,
+                      void *userdata, bool *prune_children, std::string *err) {
+  (void)tree_depth;
+  (void)err;
+  VisitData *data = reinterpret_cast<VisitData *>(userdata);
+  data->counts[thread_id]++;
+
+  // Parent must be visited before.
+  Path parent = abs_path.get_parent_prim_path();
+  int ok = 1;
+  if (!parent.is_root_path() && parent.is_valid() &&
+      (parent.prim_part() != abs_path.prim_part())) {
+    int64_t parent_id{-1};
+    if (data->stage->find_prim_at_path(parent, &parent_id)) {
+      ok = (data->ordered[size_t(parent_id)] == 1) ? 1 : -1;
+    }
+  }
+  data->ordered[size_t(prim.prim_id())] = ok;
+
+  // Prune children of "child1"
+  if (prim.element_name() == "child1") {
+    (*prune_children) = true;
+  }
+
+  return true;
+}
+
+// `num_materials` Materials(even-numbered ones have a diffuseColor texture)
+// and `num_meshes` Meshes bound to them.
+std::string BuildRenderSceneUSDA(size_t num_materials, size_t num_meshes) {
+  std::string s = "#usda 1.0\n";
+
+  s += "def Scope \"mtl\"\n{\n";
+  for (size_t i = 0; i < num_materials; i++) {
+    const std::string name = "mat" + std::to_string(i);
+    const std::string base = "/mtl/" + name;
+    s += "def Material \"" + name + "\"\n{\n";
+    s += "  token outputs:surface.connect = <" + base +
+         "/pbr.outputs:surface>\n";
+    s += "  def Shader \"pbr\"\n  {\n";
+    s += "    uniform token info:id = \"UsdPreviewSurface\"\n";
+    if ((i % 2) == 0) {
+      s += "    color3f inputs:diffuseColor.connect = <" + base +
+           "/tex.outputs:rgb>\n";
+    } else {
+      s += "    color3f inputs:diffuseColor = (0.5, 0.5, 0.5)\n";
+    }
+    s += "    float inputs:roughness = 0." + std::to_string(i % 10) + "\n";
+    s += "    token outputs:surface\n  }\n";
+    if ((i % 2) == 0) {
+      s += "  def Shader \"tex\"\n  {\n";
+      s += "    uniform token info:id = \"UsdUVTexture\"\n";
+      s += "    asset inputs:file = @tex" + std::to_string(i) + ".png@\n";
+      s += "    float2 inputs:st.connect = <" + base +
+           "/uv.outputs:result>\n";
+      s += "    color3f outputs:rgb\n  }\n";
+      s += "  def Shader \"uv\"\n  {\n";
+      s += "    uniform token info:id = \"UsdPrimvarReader_float2\"\n";
+      s += "    token inputs:varname = \"st\"\n";
+      s += "    float2 outputs:result\n  }\n";
+    }
+    s += "}\n";
+  }
+  s += "}\n";
+
+  for (size_t i = 0; i < num_meshes; i++) {
+    const float x = float(i);
+    s += "def Mesh \"mesh" + std::to_string(i) + "\"\n{\n";
+    s += "  int[] faceVertexCounts = [4]\n";
+    s += "  int[] faceVertexIndices = [0, 1, 2, 3]\n";
+    s += "  point3f[] points = [(" + std::to_string(x) + ", 0, 0), (" +
+         std::to_string(x + 1.0f) + ", 0, 0), (" + std::to_string(x + 1.0f) +
+         ", 1, 0), (" + std::to_string(x) + ", 1, 0)]\n";
+    s += "  texCoord2f[] primvars:st = [(0, 0), (1, 0), (1, 1), (0, 1)] (\n";
+    s += "    interpolation = \"faceVarying\"\n  )\n";
+    if (num_materials && ((i % 3) != 2)) {
+      // Bind Materials in reverse order to test material id assignment.
+      s += "  rel material:binding = </mtl/mat" +
+           std::to_string(num_materials - 1 - (i % num_materials)) + ">\n";
+    }
+    s += "}\n";
+  }
+
+  return s;
+}
+
+}  // namespace
+
+void tydra_parallel_visit_test(void) {
+  Stage stage;
+  BuildTestStage(stage, 4, 8, 16);
+
+  // The visitor looks up the parent Prim from worker threads.
+  // 0: committed Stage. 1: copied and uncommitted Stage, whose Prim lookup
+  // index is updated lazily during the visit.
+  for (size_t n = 0; n < 2; n++) {
+    Stage copied;
+    if (n == 1) {
+      copied = stage;
+      (void)copied.root_prims();  // mark the Stage dirty.
+    }
+    const Stage &target = (n == 0) ? stage : copied;
+
+    tydra::ParallelVisitOptions options;
+    options.num_threads = 4;
+
+    VisitData data;
+    data.stage = &target;
+    data.counts.resize(tydra::GetParallelVisitThreadCount(options), 0);
+    data.ordered.resize(4 + 4 * 8 + 4 * 8 * 16 + 1, 0);
+
+    std::string err;
+    TEST_CHECK(tydra::ParallelVisitPrims(target, ParallelVisitFun, &data,
+                                         &options, &err));
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(options.num_threads == data.counts.size());
+
+    size_t total = 0;
+    for (size_t c : data.counts) {
+      total += c;
+    }
+
+    // "child1" subtree(16 leaves) is pruned for each root.
+    TEST_CHECK(total == (4 + 4 * 8 + 4 * 7 * 16));
+
+    for (size_t i = 1; i < data.ordered.size(); i++) {
+      TEST_CHECK(data.ordered[i] != -1);
+    }
+  }
+}
+
+void tydra_xform_cache_test(void) {
+  // /anim(translate timeSamples)/child(static translate)
+  // /static(static translate)
+  Stage stage;
+  {
+    Xform anim;
+    anim.name = "anim";
+    XformOp op;
+    op.op_type = XformOp::OpType::Translate;
+    op.set_timesample(0.0, value::double3({0.0, 0.0, 0.0}));
+    op.set_timesample(10.0, value::double3({10.0, 0.0, 0.0}));
+    anim.xformOps.push_back(op);
+
+    Xform child;
+    child.name = "child";
+    XformOp cop;
+    cop.op_type = XformOp::OpType::Translate;
+    cop.set_value(value::double3({0.0, 1.0, 0.0}));
+    child.xformOps.push_back(cop);
+
+    Prim animPrim(anim);
+    animPrim.add_child(Prim(child));
+    stage.add_root_prim(std::move(animPrim));
+
+    Xform st;
+    st.name = "static";
+    XformOp sop;
+    sop.op_type = XformOp::OpType::Translate;
+    sop.set_value(value::double3({0.0, 0.0, 2.0}));
+    st.xformOps.push_back(sop);
+    stage.add_root_prim(Prim(st));
+  }
+  stage.commit();
+
+  int64_t anim_id{-1}, child_id{-1}, static_id{-1};
+  TEST_CHECK(stage.find_prim_at_path(Path("/anim", ""), &anim_id));
+  TEST_CHECK(stage.find_prim_at_path(Path("/anim/child", ""), &child_id));
+  TEST_CHECK(stage.find_prim_at_path(Path("/static", ""), &static_id));
+
+  tydra::XformCache cache;
+  std::string err;
+  TEST_CHECK(cache.build(stage, 0.0, value::TimeSampleInterpolationType::Linear,
+                         &err));
+  TEST_MSG("%s", err.c_str());
+
+  TEST_CHECK(cache.num_time_varying_prims() == 2);
+  TEST_CHECK(cache.is_time_varying(anim_id));
+  TEST_CHECK(cache.is_time_varying(child_id));
+  TEST_CHECK(!cache.is_time_varying(static_id));
+
+  value::matrix4d m;
+  TEST_CHECK(cache.get_world_matrix(static_id, &m));
+  TEST_CHECK(m.m[3][2] == 2.0);
+
+  TEST_CHECK(cache.update(5.0, value::TimeSampleInterpolationType::Linear,
+                          &err));
+  TEST_CHECK(cache.get_world_matrix(child_id, &m));
+  TEST_CHECK(std::fabs(m.m[3][0] - 5.0) < 1e-9);
+  TEST_CHECK(std::fabs(m.m[3][1] - 1.0) < 1e-9);
+
+  TEST_CHECK(cache.get_local_matrix(child_id, &m));
+  TEST_CHECK(std::fabs(m.m[3][0]) < 1e-9);
+
+  // Held interpolation
+  TEST_CHECK(cache.update(5.0, value::TimeSampleInterpolationType::Held,
+                          &err));
+  TEST_CHECK(cache.get_world_matrix(anim_id, &m));
+  TEST_CHECK(std::fabs(m.m[3][0]) < 1e-9);
+
+  std::vector<double> times = {0.0, 2.5, 10.0, 20.0};
+  std::vector<std::vector<value::matrix4d>> batch;
+  TEST_CHECK(cache.evaluate_batch(
+      times, value::TimeSampleInterpolationType::Linear, &batch, &err, 2));
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(batch.size() == times.size());
+  if (batch.size() == times.size()) {
+    TEST_CHECK(std::fabs(batch[1][size_t(child_id)].m[3][0] - 2.5) < 1e-9);
+    TEST_CHECK(std::fabs(batch[2][size_t(child_id)].m[3][0] - 10.0) < 1e-9);
+    TEST_CHECK(std::fabs(batch[3][size_t(child_id)].m[3][0] - 10.0) < 1e-9);
+    TEST_CHECK(batch[3][size_t(static_id)].m[3][2] == 2.0);
+  }
+
+  // State is not modified by evaluate_batch.
+  TEST_CHECK(cache.time() == 5.0);
+
+  // XformNode also honors time code.
+  tydra::XformNode root;
+  TEST_CHECK(tydra::BuildXformNodeFromStage(
+      stage, &root, 2.5, value::TimeSampleInterpolationType::Linear));
+  TEST_CHECK(root.children.size() == 2);
+  if (root.children.size() == 2) {
+    TEST_CHECK(std::fabs(root.children[0].get_world_matrix().m[3][0] - 2.5) <
+               1e-9);
+  }
+}
+
+void tydra_render_scene_parallel_test(void) {
+  const std::string usda = BuildRenderSceneUSDA(5, 24);
+
+  Stage stage;
+  std::string warn, err;
+  TEST_CHECK(LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                                usda.size(), "", &stage, &warn, &err));
+  TEST_MSG("%s", err.c_str());
+
+  tydra::RenderScene scenes[2];
+  for (size_t n = 0; n < 2; n++) {
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+    config.num_threads = (n == 0) ? 1 : 4;
+
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    TEST_CHECK(converter.ConvertToRenderScene(stage, &scenes[n]));
+    TEST_MSG("%s", converter.GetError().c_str());
+  }
+
+  const tydra::RenderScene &serial = scenes[0];
+  const tydra::RenderScene &parallel = scenes[1];
+
+  TEST_CHECK(serial.meshes.size() == 24);
+  TEST_CHECK(serial.materials.size() == 5);
+  TEST_CHECK(serial.textures.size() == 3);
+
+  TEST_CHECK(serial.meshes.size() == parallel.meshes.size());
+  TEST_CHECK(serial.materials.size() == parallel.materials.size());
+  TEST_CHECK(serial.textures.size() == parallel.textures.size());
+  TEST_CHECK(serial.images.size() == parallel.images.size());
+  TEST_CHECK(serial.buffers.size() == parallel.buffers.size());
+
+  if (serial.meshes.size() == parallel.meshes.size()) {
+    for (size_t i = 0; i < serial.meshes.size(); i++) {
+      const tydra::RenderMesh &a = serial.meshes[i];
+      const tydra::RenderMesh &b = parallel.meshes[i];
+      TEST_CHECK(a.abs_name == b.abs_name);
+      TEST_CHECK(a.abs_name == "/mesh" + std::to_string(i));
+      TEST_CHECK(a.materialIds == b.materialIds);
+      TEST_CHECK(a.faceVertexIndices == b.faceVertexIndices);
+      TEST_CHECK(a.points.size() == b.points.size());
+      for (size_t k = 0; (k < a.points.size()) && (k < b.points.size());
+           k++) {
+        TEST_CHECK(a.points[k][0] == b.points[k][0]);
+        TEST_CHECK(a.points[k][1] == b.points[k][1]);
+      }
+    }
+
+  }
+
+  if (serial.meshes.size() == 24) {
+    // mesh0 binds the last Material, which gets RenderMaterial id 0.
+    // (quad is triangulated)
+    TEST_CHECK(serial.meshes[0].materialIds.size() == 2);
+    for (const int32_t id : serial.meshes[0].materialIds) {
+      TEST_CHECK(id == 0);
+    }
+    TEST_CHECK(serial.meshes[2].materialIds.empty());
+  }
+
+  if (serial.materials.size() == parallel.materials.size()) {
+    for (size_t i = 0; i < serial.materials.size(); i++) {
+      const tydra::RenderMaterial &a = serial.materials[i];
+      const tydra::RenderMaterial &b = parallel.materials[i];
+      TEST_CHECK(a.abs_path == b.abs_path);
+      TEST_CHECK(a.surfaceShader.diffuseColor.textureId ==
+                 b.surfaceShader.diffuseColor.textureId);
+      TEST_CHECK(a.surfaceShader.roughness.value ==
+                 b.surfaceShader.roughness.value);
+    }
+  }
+
+  if (serial.textures.size() == parallel.textures.size()) {
+    for (size_t i = 0; i < serial.textures.size(); i++) {
+      TEST_CHECK(serial.textures[i].texture_image_id ==
+                 parallel.textures[i].texture_image_id);
+      TEST_CHECK(serial.textures[i].texture_image_id == int64_t(i));
+    }
+  }
+
+  if (serial.images.size() == parallel.images.size()) {
+    for (size_t i = 0; i < serial.images.size(); i++) {
+      TEST_CHECK(serial.images[i].asset_identifier ==
+                 parallel.images[i].asset_identifier);
+      TEST_CHECK(serial.images[i].buffer_id == parallel.images[i].buffer_id);
+    }
+  }
+
+  // Uncommitted Stage: Prim lookup index is updated lazily by the workers.
+  {
+    Stage copied = stage;
+    (void)copied.root_prims();  // mark the Stage dirty.
+
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+    config.num_threads = 4;
+
+    tydra::RenderScene scene;
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    TEST_CHECK(converter.ConvertToRenderScene(copied, &scene));
+    TEST_MSG("%s", converter.GetError().c_str());
+
+    TEST_CHECK(scene.meshes.size() == serial.meshes.size());
+    TEST_CHECK(scene.materials.size() == serial.materials.size());
+    for (size_t i = 0;
+         (i < scene.meshes.size()) && (i < serial.meshes.size()); i++) {
+      TEST_CHECK(scene.meshes[i].abs_name == serial.meshes[i].abs_name);
+      TEST_CHECK(scene.meshes[i].materialIds == serial.meshes[i].materialIds);
+    }
+  }
+}
+
+void tydra_weld_face_vertices_test(void) {
+  // Two quads sharing an edge(points 1 and 4).
+  //
+  // 3 - 4 - 5
+  // |   |   |
+  // 0 - 1 - 2
+  //
+  tydra::RenderMesh mesh;
+  mesh.points = {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {2.0f, 0.0f, 0.0f},
+                 {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {2.0f, 1.0f, 0.0f}};
+  mesh.faceVertexCounts = {4, 4};
+  mesh.faceVertexIndices = {0, 1, 4, 3, 1, 2, 5, 4};
+  mesh.facevaryingNormals.assign(8, {0.0f, 0.0f, 1.0f});
+  // Continuous UV.
+  mesh.facevaryingTexcoords[0] = {{0.0f, 0.0f}, {0.5f, 0.0f}, {0.5f, 1.0f},
+                                  {0.0f, 1.0f}, {0.5f, 0.0f}, {1.0f, 0.0f},
+                                  {1.0f, 1.0f}, {0.5f, 1.0f}};
+
+  tydra::RenderMesh seam = mesh;
+  // UV seam at the shared edge.
+  seam.facevaryingTexcoords[0][4] = {0.0f, 0.0f};
+  seam.facevaryingTexcoords[0][7] = {0.0f, 1.0f};
+
+  std::string err;
+  TEST_CHECK(tydra::WeldFaceVertices(mesh, &err));
+  TEST_MSG("%s", err.c_str());
+
+  TEST_CHECK(mesh.is_indexed);
+  TEST_CHECK(mesh.points.size() == 6);
+  TEST_CHECK(mesh.vertexNormals.size() == 6);
+  TEST_CHECK(mesh.vertexTexcoords.count(0) == 1);
+  TEST_CHECK(mesh.vertexTexcoords[0].size() == 6);
+  TEST_CHECK(mesh.facevaryingNormals.empty());
+  TEST_CHECK(mesh.facevaryingTexcoords.empty());
+  TEST_CHECK(mesh.faceVertexCounts.size() == 2);
+  // Vertices are ordered by first occurrence.
+  std::vector<uint32_t> expected = {0, 1, 2, 3, 1, 4, 5, 2};
+  TEST_CHECK(mesh.faceVertexIndices == expected);
+  TEST_CHECK(mesh.points[5][0] == 2.0f);
+  TEST_CHECK(mesh.points[5][1] == 1.0f);
+  TEST_CHECK(mesh.vertexTexcoords[0][5][0] == 1.0f);
+
+  TEST_CHECK(mesh.indices.componentType == tydra::ComponentType::UInt16);
+  TEST_CHECK(mesh.indices.data.size() == 8 * sizeof(uint16_t));
+
+  // Welding twice is an error.
+  TEST_CHECK(!tydra::WeldFaceVertices(mesh, &err));
+
+  err.clear();
+  TEST_CHECK(tydra::WeldFaceVertices(seam, &err));
+  TEST_MSG("%s", err.c_str());
+  TEST_CHECK(seam.points.size() == 8);
+
+  // Through RenderSceneConverter(with triangulation).
+  const std::string usda = BuildRenderSceneUSDA(2, 4);
+
+  Stage stage;
+  std::string warn;
+  TEST_CHECK(LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                                usda.size(), "", &stage, &warn, &err));
+  TEST_MSG("%s", err.c_str());
+
+  tydra::RenderSceneConverterConfig config;
+  config.load_texture_assets = false;
+
+  tydra::MeshConverterConfig mesh_config;
+  mesh_config.build_indexed_mesh = true;
+
+  tydra::RenderSceneConverter converter;
+  converter.set_scene_config(config);
+  converter.set_mesh_config(mesh_config);
+
+  tydra::RenderScene scene;
+  TEST_CHECK(converter.ConvertToRenderScene(stage, &scene));
+  TEST_MSG("%s", converter.GetError().c_str());
+
+  TEST_CHECK(scene.meshes.size() == 4);
+  for (const auto &rmesh : scene.meshes) {
+    TEST_CHECK(rmesh.is_indexed);
+    TEST_CHECK(rmesh.points.size() == 4);
+    TEST_CHECK(rmesh.faceVertexCounts.size() == 2);
+    TEST_CHECK(rmesh.faceVertexIndices.size() == 6);
+    TEST_CHECK(rmesh.indices.data.size() == 6 * sizeof(uint16_t));
+    for (const auto &it : rmesh.vertexTexcoords) {
+      TEST_CHECK(it.second.size() == 4);
+    }
+  }
+}
+
+namespace {
+
+// L-shaped hexagon(concave), dart-shaped quad(concave at point 3. The
+// shorter diagonal is outside of the quad) and
+// `n` pentagons. Texcoords = xy of the points.
+std::string BuildPolygonMeshUSDA(size_t n) {
+  std::vector<std::array<float, 2>> points = {
+      {0.0f, 0.0f}, {2.0f, 0.0f}, {2.0f, 1.0f}, {1.0f, 1.0f},
+      {1.0f, 2.0f}, {0.0f, 2.0f},                              // L
+      {3.0f, 0.0f}, {6.0f, 1.0f}, {3.0f, 2.0f}, {3.5f, 1.0f}};  // dart
+  std::vector<int> counts = {6, 4};
+  std::vector<int> indices = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+  for (size_t i = 0; i < n; i++) {
+    const float x = 10.0f + float(i % 100) * 3.0f;
+    const float y = float(i / 100) * 3.0f;
+    const int base = int(points.size());
+    points.push_back({x, y});
+    points.push_back({x + 2.0f, y});
+    points.push_back({x + 2.0f, y + 1.0f});
+    points.push_back({x + 1.0f, y + 2.0f});
+    points.push_back({x, y + 1.0f});
+    counts.push_back(5);
+    for (int k = 0; k < 5; k++) {
+      indices.push_back(base + k);
+    }
+  }
+
+  std::string s = "#usda 1.0\n";
+  s += "def Mesh \"poly\"\n{\n";
+  s += "  int[] faceVertexCounts = [";
+  for (size_t i = 0; i < counts.size(); i++) {
+    s += (i ? ", " : "") + std::to_string(counts[i]);
+  }
+  s += "]\n  int[] faceVertexIndices = [";
+  for (size_t i = 0; i < indices.size(); i++) {
+    s += (i ? ", " : "") + std::to_string(indices[i]);
+  }
+  s += "]\n  point3f[] points = [";
+  for (size_t i = 0; i < points.size(); i++) {
+    s += (i ? ", (" : "(") + std::to_string(points[i][0]) + ", " +
+         std::to_string(points[i][1]) + ", 0)";
+  }
+  s += "]\n  texCoord2f[] primvars:st = [";
+  for (size_t i = 0; i < indices.size(); i++) {
+    const auto &p = points[size_t(indices[i])];
+    s += (i ? ", (" : "(") + std::to_string(p[0]) + ", " +
+         std::to_string(p[1]) + ")";
+  }
+  s += "] (\n    interpolation = \"faceVarying\"\n  )\n";
+  s += "  rel material:binding = </mtl/mat0>\n";
+  s += "}\n";
+
+  // Textured material, so that `st` is converted.
+  const std::string mtl = BuildRenderSceneUSDA(1, 0);
+  s += mtl.substr(mtl.find('\n') + 1);
+
+  return s;
+}
+
+}  // namespace
+
+void tydra_triangulation_test(void) {
+  const size_t num_pentagons = 10000;
+  const std::string usda = BuildPolygonMeshUSDA(num_pentagons);
+
+  Stage stage;
+  std::string warn, err;
+  TEST_CHECK(LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                                usda.size(), "", &stage, &warn, &err));
+  TEST_MSG("%s", err.c_str());
+
+  tydra::RenderScene scenes[2];
+  for (size_t n = 0; n < 2; n++) {
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+
+    tydra::MeshConverterConfig mesh_config;
+    mesh_config.num_threads = (n == 0) ? 1 : 4;
+
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    converter.set_mesh_config(mesh_config);
+    TEST_CHECK(converter.ConvertToRenderScene(stage, &scenes[n]));
+    TEST_MSG("%s", converter.GetError().c_str());
+  }
+
+  TEST_CHECK(scenes[0].meshes.size() == 1);
+  TEST_CHECK(scenes[1].meshes.size() == 1);
+  if ((scenes[0].meshes.size() != 1) || (scenes[1].meshes.size() != 1)) {
+    return;
+  }
+
+  const tydra::RenderMesh &mesh = scenes[0].meshes[0];
+  const size_t num_tris = 4 + 2 + 3 * num_pentagons;
+
+  TEST_CHECK(mesh.faceVertexCounts.size() == num_tris);
+  TEST_CHECK(mesh.faceVertexIndices.size() == 3 * num_tris);
+  TEST_CHECK(mesh.faceVertexIndices == scenes[1].meshes[0].faceVertexIndices);
+  TEST_CHECK(mesh.facevaryingTexcoords.size() == 1);
+
+  if (mesh.faceVertexIndices.size() != 3 * num_tris) {
+    return;
+  }
+
+  // Triangles must cover the polygon(sum of areas) with the same winding as
+  // the input(counter-clockwise).
+  float area_l = 0.0f, area_dart = 0.0f;
+  bool ccw = true;
+  for (size_t t = 0; t < num_tris; t++) {
+    const auto &p0 = mesh.points[mesh.faceVertexIndices[3 * t + 0]];
+    const auto &p1 = mesh.points[mesh.faceVertexIndices[3 * t + 1]];
+    const auto &p2 = mesh.points[mesh.faceVertexIndices[3 * t + 2]];
+    const float a = 0.5f * ((p1[0] - p0[0]) * (p2[1] - p0[1]) -
+                            (p2[0] - p0[0]) * (p1[1] - p0[1]));
+    if (a <= 0.0f) {
+      ccw = false;
+    }
+    if (t < 4) {
+      area_l += a;
+    } else if (t < 6) {
+      area_dart += a;
+    }
+  }
+  TEST_CHECK(ccw);
+  TEST_CHECK(std::fabs(area_l - 3.0f) < 1e-5f);
+  TEST_CHECK(std::fabs(area_dart - 2.5f) < 1e-5f);
+
+  // faceVarying texcoords follow the triangulated face-corners.
+  for (const auto &it : mesh.facevaryingTexcoords) {
+    TEST_CHECK(it.second.size() == 3 * num_tris);
+    if (it.second.size() != 3 * num_tris) {
+      continue;
+    }
+    bool match = true;
+    for (size_t k = 0; k < it.second.size(); k++) {
+      const auto &p = mesh.points[mesh.faceVertexIndices[k]];
+      if ((std::fabs(it.second[k][0] - p[0]) > 1e-5f) ||
+          (std::fabs(it.second[k][1] - p[1]) > 1e-5f)) {
+        match = false;
+      }
+    }
+    TEST_CHECK(match);
+  }
+}
+
+void tydra_interleaved_vertex_buffer_test(void) {
+  tydra::RenderMesh mesh;
+  mesh.points = {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}};
+  mesh.faceVertexCounts = {3};
+  mesh.faceVertexIndices = {0, 1, 2};
+  mesh.facevaryingNormals.assign(3, {0.0f, 0.0f, 1.0f});
+  mesh.facevaryingTexcoords[0] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}};
+
+  std::string err;
+
+  // Default layout(float)
+  {
+    std::vector<tydra::VertexElement> elements(3);
+    elements[0].semantic = tydra::VertexElementSemantic::Position;
+    elements[1].semantic = tydra::VertexElementSemantic::Normal;
+    elements[2].semantic = tydra::VertexElementSemantic::Texcoord;
+
+    tydra::VertexBufferLayout layout;
+    tydra::BufferData buffer;
+    TEST_CHECK(tydra::BuildInterleavedVertexBuffer(mesh, elements, &layout,
+                                                   &buffer, &err));
+    TEST_MSG("%s", err.c_str());
+    TEST_CHECK(layout.stride == 32);
+    TEST_CHECK(layout.elements.size() == 3);
+    TEST_CHECK(buffer.data.size() == 3 * 32);
+    if (buffer.data.size() == 3 * 32) {
+      float v[8];
+      memcpy(v, buffer.data.data() + 2 * 32, sizeof(float) * 8);
+      TEST_CHECK(v[0] == 1.0f);  // position
+      TEST_CHECK(v[1] == 1.0f);
+      TEST_CHECK(v[5] == 1.0f);  // normal.z
+      TEST_CHECK(v[6] == 1.0f);  // uv
+      TEST_CHECK(v[7] == 1.0f);
+    }
+  }
+
+  // Compact layout
+  {
+    std::vector<tydra::VertexElement> elements(4);
+    elements[0].semantic = tydra::VertexElementSemantic::Position;
+    elements[0].format = tydra::VertexElementFormat::Half;
+    elements[1].semantic = tydra::VertexElementSemantic::Normal;
+    elements[1].format = tydra::VertexElementFormat::SNorm16;
+    elements[2].semantic = tydra::VertexElementSemantic::Texcoord;
+    elements[2].format = tydra::VertexElementFormat::UNorm16;
+    // Texcoord slot which does not exist is filled with zeros.
+    elements[3].semantic = tydra::VertexElementSemantic::Texcoord;
+    elements[3].slot = 1;
+
+    TEST_CHECK(tydra::WeldFaceVertices(mesh, &err));
+
+    tydra::VertexBufferLayout layout;
+    tydra::BufferData buffer;
+    TEST_CHECK(tydra::BuildInterleavedVertexBuffer(mesh, elements, &layout,
+                                                   &buffer, &err));
+    TEST_MSG("%s", err.c_str());
+
+    // half3(6 -> 8) + snorm16x3(6 -> 8) + unorm16x2(4) + float2(8)
+    TEST_CHECK(layout.stride == 28);
+    TEST_CHECK(layout.elements.size() == 4);
+    if (layout.elements.size() == 4) {
+      TEST_CHECK(layout.elements[0].offset == 0);
+      TEST_CHECK(layout.elements[1].offset == 8);
+      TEST_CHECK(layout.elements[2].offset == 16);
+      TEST_CHECK(layout.elements[3].offset == 20);
+      TEST_CHECK(layout.elements[1].num_components == 3);
+    }
+    TEST_CHECK(buffer.data.size() == 3 * 28);
+
+    if (buffer.data.size() == 3 * 28) {
+      const uint8_t *vertex = buffer.data.data() + 1 * 28;
+      value::half hx;
+      memcpy(&hx.value, vertex, sizeof(uint16_t));
+      TEST_CHECK(value::half_to_float(hx) == 1.0f);
+
+      int16_t nz;
+      memcpy(&nz, vertex + 8 + 2 * sizeof(int16_t), sizeof(int16_t));
+      TEST_CHECK(nz == 32767);
+
+      uint16_t u;
+      memcpy(&u, vertex + 16, sizeof(uint16_t));
+      TEST_CHECK(u == 65535);
+
+      float uv1[2];
+      memcpy(uv1, vertex + 20, sizeof(float) * 2);
+      TEST_CHECK(uv1[0] == 0.0f);
+      TEST_CHECK(uv1[1] == 0.0f);
+    }
+  }
+
+  // Primvar slot which does not exist is an error.
+  {
+    std::vector<tydra::VertexElement> elements(1);
+    elements[0].semantic = tydra::VertexElementSemantic::Primvar;
+    elements[0].slot = 3;
+
+    tydra::VertexBufferLayout layout;
+    tydra::BufferData buffer;
+    TEST_CHECK(!tydra::BuildInterleavedVertexBuffer(mesh, elements, &layout,
+                                                    &buffer, &err));
+  }
+
+  // Through RenderSceneConverter(non-indexed, triangulated quads).
+  {
+    const std::string usda = BuildRenderSceneUSDA(1, 2);
+
+    Stage stage;
+    std::string warn;
+    TEST_CHECK(LoadUSDAFromMemory(
+        reinterpret_cast<const uint8_t *>(usda.data()), usda.size(), "",
+        &stage, &warn, &err));
+
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+
+    tydra::MeshConverterConfig mesh_config;
+    mesh_config.build_interleaved_vertex_buffer = true;
+
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    converter.set_mesh_config(mesh_config);
+
+    tydra::RenderScene scene;
+    TEST_CHECK(converter.ConvertToRenderScene(stage, &scene));
+    TEST_MSG("%s", converter.GetError().c_str());
+
+    TEST_CHECK(scene.meshes.size() == 2);
+    for (const auto &rmesh : scene.meshes) {
+      TEST_CHECK(rmesh.vertexLayout.stride == 32);
+      TEST_CHECK(rmesh.vertexBuffer.data.size() == 6 * 32);
+    }
+  }
+}
+
+namespace {
+
+// Indexed, triangulated grid of `n` x `n` quads on the XY plane.
+tydra::RenderMesh BuildGridRenderMesh(uint32_t n) {
+  tydra::RenderMesh mesh;
+  for (uint32_t y = 0; y <= n; y++) {
+    for (uint32_t x = 0; x <= n; x++) {
+      mesh.points.push_back({float(x), float(y), 0.0f});
+    }
+  }
+  for (uint32_t y = 0; y < n; y++) {
+    for (uint32_t x = 0; x < n; x++) {
+      const uint32_t i0 = y * (n + 1) + x;
+      const uint32_t i1 = i0 + 1;
+      const uint32_t i2 = i0 + n + 2;
+      const uint32_t i3 = i0 + n + 1;
+      const uint32_t tris[6] = {i0, i1, i2, i0, i2, i3};
+      for (uint32_t k = 0; k < 6; k++) {
+        mesh.faceVertexIndices.push_back(tris[k]);
+      }
+      mesh.faceVertexCounts.push_back(3);
+      mesh.faceVertexCounts.push_back(3);
+    }
+  }
+  mesh.is_indexed = true;
+  return mesh;
+}
+
+}  // namespace
+
+void tydra_meshlet_test(void) {
+  tydra::RenderMesh mesh = BuildGridRenderMesh(16);
+  const size_t num_tris = mesh.faceVertexCounts.size();
+
+  std::string err;
+  TEST_CHECK(tydra::BuildMeshlets(mesh, 64, 124, &err));
+  TEST_MSG("%s", err.c_str());
+
+  TEST_CHECK(mesh.meshlets.size() > 1);
+
+  // Every triangle is emitted exactly once.
+  std::vector<std::array<uint32_t, 3>> src_tris, dst_tris;
+  for (size_t t = 0; t < num_tris; t++) {
+    std::array<uint32_t, 3> tri = {mesh.faceVertexIndices[3 * t + 0],
+                                   mesh.faceVertexIndices[3 * t + 1],
+                                   mesh.faceVertexIndices[3 * t + 2]};
+    // Rotate so that the smallest index comes first(keep winding).
+    std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()),
+                tri.end());
+    src_tris.push_back(tri);
+  }
+
+  size_t total_tris = 0;
+  for (const auto &m : mesh.meshlets) {
+    TEST_CHECK(m.vertex_count <= 64);
+    TEST_CHECK(m.triangle_count <= 124);
+    TEST_CHECK(m.triangle_count > 0);
+    total_tris += m.triangle_count;
+
+    for (uint32_t t = 0; t < m.triangle_count; t++) {
+      std::array<uint32_t, 3> tri;
+      for (uint32_t k = 0; k < 3; k++) {
+        const uint8_t local = mesh.meshletTriangles[m.triangle_offset + 3 * t + k];
+        TEST_CHECK(local < m.vertex_count);
+        tri[k] = mesh.meshletVertices[m.vertex_offset + local];
+
+        // Inside the bounding sphere.
+        const auto &p = mesh.points[tri[k]];
+        const float dx = p[0] - m.center[0];
+        const float dy = p[1] - m.center[1];
+        const float dz = p[2] - m.center[2];
+        TEST_CHECK(std::sqrt(dx * dx + dy * dy + dz * dz) <=
+                   m.radius + 1e-4f);
+      }
+      std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()),
+                  tri.end());
+      dst_tris.push_back(tri);
+    }
+
+    // Flat, counter-clockwise grid.
+    TEST_CHECK(std::fabs(m.cone_axis[2] - 1.0f) < 1e-5f);
+    TEST_CHECK(m.cone_cutoff > 0.9999f);
+  }
+  TEST_CHECK(total_tris == num_tris);
+
+  std::sort(src_tris.begin(), src_tris.end());
+  std::sort(dst_tris.begin(), dst_tris.end());
+  TEST_CHECK(src_tris == dst_tris);
+
+  // Meshlets are well filled for a regular grid.
+  TEST_CHECK(mesh.meshlets.size() <= 2 * (num_tris / 124 + 1));
+
+  // Polygon mesh is an error.
+  tydra::RenderMesh quad;
+  quad.points = {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f},
+                 {0.0f, 1.0f, 0.0f}};
+  quad.faceVertexCounts = {4};
+  quad.faceVertexIndices = {0, 1, 2, 3};
+  TEST_CHECK(!tydra::BuildMeshlets(quad, 64, 124, &err));
+
+  // Invalid limits.
+  TEST_CHECK(!tydra::BuildMeshlets(mesh, 257, 124, &err));
+
+  // Non-indexed mesh does not share vertices between triangles, but
+  // meshlets are still filled up to the vertex limit.
+  tydra::RenderMesh flat = BuildGridRenderMesh(16);
+  flat.is_indexed = false;
+  TEST_CHECK(tydra::BuildMeshlets(flat, 64, 124, &err));
+  TEST_CHECK(flat.meshlets.size() == (num_tris + 20) / 21);
+  for (const auto &m : flat.meshlets) {
+    TEST_CHECK(m.vertex_count <= 64);
+    TEST_CHECK(m.vertex_count == 3 * m.triangle_count);
+  }
+}
+
+namespace {
+
+// Average cache miss ratio(misses per triangle) with a FIFO cache.
+float ComputeACMR(const std::vector<uint32_t> &indices, size_t cache_size) {
+  std::vector<uint32_t> cache;
+  size_t misses = 0;
+  for (uint32_t v : indices) {
+    if (std::find(cache.begin(), cache.end(), v) == cache.end()) {
+      misses++;
+      cache.push_back(v);
+      if (cache.size() > cache_size) {
+        cache.erase(cache.begin());
+      }
+    }
+  }
+  return float(misses) / float(indices.size() / 3);
+}
+
+// Triangles as point positions(winding kept), sorted.
+std::vector<std::array<float, 9>> SortedTriangles(
+    const tydra::RenderMesh &mesh) {
+  std::vector<std::array<float, 9>> tris;
+  for (size_t t = 0; t < mesh.faceVertexIndices.size() / 3; t++) {
+    std::array<uint32_t, 3> tri = {mesh.faceVertexIndices[3 * t + 0],
+                                   mesh.faceVertexIndices[3 * t + 1],
+                                   mesh.faceVertexIndices[3 * t + 2]};
+    size_t first = 0;
+    for (size_t k = 1; k < 3; k++) {
+      if (mesh.points[tri[k]] < mesh.points[tri[first]]) {
+        first = k;
+      }
+    }
+    std::array<float, 9> p;
+    for (size_t k = 0; k < 3; k++) {
+      const auto &v = mesh.points[tri[(first + k) % 3]];
+      p[3 * k + 0] = v[0];
+      p[3 * k + 1] = v[1];
+      p[3 * k + 2] = v[2];
+    }
+    tris.push_back(p);
+  }
+  std::sort(tris.begin(), tris.end());
+  return tris;
+}
+
+}  // namespace
+
+void tydra_vertex_cache_test(void) {
+  tydra::RenderMesh mesh = BuildGridRenderMesh(32);
+  const size_t num_tris = mesh.faceVertexCounts.size();
+
+  // Shuffle triangles(deterministic LCG).
+  uint32_t state = 12345;
+  for (size_t t = num_tris - 1; t > 0; t--) {
+    state = state * 1664525u + 1013904223u;
+    const size_t r = state % (t + 1);
+    for (size_t k = 0; k < 3; k++) {
+      std::swap(mesh.faceVertexIndices[3 * t + k],
+                mesh.faceVertexIndices[3 * r + k]);
+    }
+  }
+
+  const auto src_tris = SortedTriangles(mesh);
+  const float src_acmr = ComputeACMR(mesh.faceVertexIndices, 16);
+
+  std::string err;
+  TEST_CHECK(tydra::OptimizeVertexCache(mesh, &err));
+  TEST_MSG("%s", err.c_str());
+
+  const float dst_acmr = ComputeACMR(mesh.faceVertexIndices, 16);
+  TEST_CHECK(dst_acmr < src_acmr);
+  TEST_CHECK(dst_acmr < 0.8f);
+  TEST_MSG("ACMR %f -> %f", double(src_acmr), double(dst_acmr));
+
+  TEST_CHECK(mesh.faceVertexCounts.size() == num_tris);
+  TEST_CHECK(mesh.points.size() == 33 * 33);
+  TEST_CHECK(SortedTriangles(mesh) == src_tris);
+
+  // Vertices are in first-use order.
+  uint32_t next = 0;
+  for (uint32_t v : mesh.faceVertexIndices) {
+    TEST_CHECK(v <= next);
+    if (v == next) {
+      next++;
+    }
+  }
+
+  // Indices buffer is repacked.
+  TEST_CHECK(mesh.indices.data.size() > 0);
+
+  // Per-face, per-corner and per-vertex attributes follow the reordering.
+  // Each attribute encodes the point(or triangle) it belongs to.
+  tydra::RenderMesh attr_mesh = BuildGridRenderMesh(4);
+  attr_mesh.is_indexed = false;
+  const size_t num_attr_tris = attr_mesh.faceVertexCounts.size();
+  for (size_t t = 0; t < num_attr_tris; t++) {
+    attr_mesh.materialIds.push_back(int32_t(t));
+  }
+  for (uint32_t v : attr_mesh.faceVertexIndices) {
+    const auto &p = attr_mesh.points[v];
+    attr_mesh.facevaryingNormals.push_back({p[0], p[1], 1.0f});
+  }
+  for (const auto &p : attr_mesh.points) {
+    attr_mesh.vertexNormals.push_back({p[0], p[1], 2.0f});
+  }
+  // Indexed primvars: indices refer to a value table.
+  {
+    tydra::VertexAttribute uniform_attr;
+    uniform_attr.format = tydra::VertexAttributeFormat::Float;
+    uniform_attr.variability = tydra::VertexVariability::Uniform;
+    uniform_attr.data.resize(sizeof(float));
+    for (size_t t = 0; t < num_attr_tris; t++) {
+      uniform_attr.indices.push_back(uint32_t(t));
+    }
+    attr_mesh.primvars[0] = uniform_attr;
+
+    tydra::VertexAttribute fv_attr;
+    fv_attr.format = tydra::VertexAttributeFormat::Float;
+    fv_attr.variability = tydra::VertexVariability::FaceVarying;
+    fv_attr.data.resize(sizeof(float));
+    for (size_t i = 0; i < attr_mesh.faceVertexIndices.size(); i++) {
+      fv_attr.indices.push_back(uint32_t(i));
+    }
+    attr_mesh.primvars[1] = fv_attr;
+  }
+  const std::vector<uint32_t> src_indices = attr_mesh.faceVertexIndices;
+  const std::vector<tydra::vec3> src_points = attr_mesh.points;
+
+  TEST_CHECK(tydra::OptimizeVertexCache(attr_mesh, &err));
+  TEST_MSG("%s", err.c_str());
+
+  TEST_CHECK(attr_mesh.materialIds.size() == num_attr_tris);
+  TEST_CHECK(attr_mesh.facevaryingNormals.size() ==
+             attr_mesh.faceVertexIndices.size());
+  TEST_CHECK(attr_mesh.vertexNormals.size() == attr_mesh.points.size());
+
+  const std::vector<uint32_t> &uniform_indices = attr_mesh.primvars[0].indices;
+  const std::vector<uint32_t> &fv_indices = attr_mesh.primvars[1].indices;
+  TEST_CHECK(uniform_indices.size() == num_attr_tris);
+  TEST_CHECK(fv_indices.size() == attr_mesh.faceVertexIndices.size());
+  if ((uniform_indices.size() != num_attr_tris) ||
+      (fv_indices.size() != attr_mesh.faceVertexIndices.size())) {
+    return;
+  }
+
+  for (size_t i = 0; i < attr_mesh.faceVertexIndices.size(); i++) {
+    const auto &p = attr_mesh.points[attr_mesh.faceVertexIndices[i]];
+    const auto &n = attr_mesh.facevaryingNormals[i];
+    TEST_CHECK((n[0] == p[0]) && (n[1] == p[1]));
+
+    // materialId is the source triangle index.
+    const size_t src_t = size_t(attr_mesh.materialIds[i / 3]);
+    const auto &sp = src_points[src_indices[3 * src_t + (i % 3)]];
+    TEST_CHECK((sp[0] == p[0]) && (sp[1] == p[1]));
+
+    TEST_CHECK(uniform_indices[i / 3] == src_t);
+    TEST_CHECK(fv_indices[i] == 3 * src_t + (i % 3));
+  }
+  for (size_t v = 0; v < attr_mesh.points.size(); v++) {
+    TEST_CHECK((attr_mesh.vertexNormals[v][0] == attr_mesh.points[v][0]) &&
+               (attr_mesh.vertexNormals[v][1] == attr_mesh.points[v][1]));
+  }
+
+  // Polygon mesh is an error.
+  tydra::RenderMesh quad;
+  quad.points = {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f},
+                 {0.0f, 1.0f, 0.0f}};
+  quad.faceVertexCounts = {4};
+  quad.faceVertexIndices = {0, 1, 2, 3};
+  TEST_CHECK(!tydra::OptimizeVertexCache(quad, &err));
+}
+
+void tydra_geom_subset_material_test(void) {
+  // 4 quads along X. face 0 = mesh material, face 1, 3 = mat1, face 2 = mat2.
+  std::string usda = BuildRenderSceneUSDA(3, 0);
+  usda += R"(
+def Mesh "mesh"
+{
+  int[] faceVertexCounts = [4, 4, 4, 4]
+  int[] faceVertexIndices = [0, 1, 6, 5, 1, 2, 7, 6, 2, 3, 8, 7, 3, 4, 9, 8]
+  point3f[] points = [(0, 0, 0), (1, 0, 0), (2, 0, 0), (3, 0, 0), (4, 0, 0), (0, 1, 0), (1, 1, 0), (2, 1, 0), (3, 1, 0), (4, 1, 0)]
+  texCoord2f[] primvars:st = [(0, 0), (1, 0), (1, 1), (0, 1), (1, 0), (2, 0), (2, 1), (1, 1), (2, 0), (3, 0), (3, 1), (2, 1), (3, 0), (4, 0), (4, 1), (3, 1)] (
+    interpolation = "faceVarying"
+  )
+  rel material:binding = </mtl/mat0>
+  uniform token subsetFamily:materialBind:familyType = "partition"
+
+  def GeomSubset "odd"
+  {
+    uniform token elementType = "face"
+    uniform token familyName = "materialBind"
+    int[] indices = [1, 3]
+    rel material:binding = </mtl/mat1>
+  }
+
+  def GeomSubset "two"
+  {
+    uniform token elementType = "face"
+    uniform token familyName = "materialBind"
+    int[] indices = [2]
+    rel material:binding = </mtl/mat2>
+  }
+
+  def GeomSubset "other"
+  {
+    uniform token elementType = "face"
+    uniform token familyName = "other"
+    int[] indices = [0]
+    rel material:binding = </mtl/mat2>
+  }
+}
+)";
+
+  Stage stage;
+  std::string warn, err;
+  TEST_CHECK(LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                                usda.size(), "", &stage, &warn, &err));
+  TEST_MSG("%s", err.c_str());
+
+  tydra::RenderSceneConverterConfig config;
+  config.load_texture_assets = false;
+
+  tydra::MeshConverterConfig mesh_config;
+  mesh_config.build_meshlets = true;
+
+  tydra::RenderScene scene;
+  tydra::RenderSceneConverter converter;
+  converter.set_scene_config(config);
+  converter.set_mesh_config(mesh_config);
+  TEST_CHECK(converter.ConvertToRenderScene(stage, &scene));
+  TEST_MSG("%s", converter.GetError().c_str());
+
+  TEST_CHECK(scene.meshes.size() == 1);
+  TEST_CHECK(scene.materials.size() == 3);
+  if (scene.meshes.size() != 1) {
+    return;
+  }
+
+  const tydra::RenderMesh &mesh = scene.meshes[0];
+  TEST_CHECK(mesh.faceVertexCounts.size() == 8);
+
+  // Triangles are sorted by material.
+  const std::vector<int32_t> expected_ids = {0, 0, 1, 1, 1, 1, 2, 2};
+  TEST_CHECK(mesh.materialIds == expected_ids);
+
+  TEST_CHECK(mesh.submeshes.size() == 3);
+  if (mesh.submeshes.size() == 3) {
+    const uint32_t offsets[3] = {0, 2, 6};
+    const uint32_t counts[3] = {2, 4, 2};
+    for (size_t i = 0; i < 3; i++) {
+      TEST_CHECK(mesh.submeshes[i].face_offset == offsets[i]);
+      TEST_CHECK(mesh.submeshes[i].face_count == counts[i]);
+      TEST_CHECK(mesh.submeshes[i].index_offset == 3 * offsets[i]);
+      TEST_CHECK(mesh.submeshes[i].index_count == 3 * counts[i]);
+      TEST_CHECK(mesh.submeshes[i].material_id == int32_t(i));
+    }
+  }
+
+  // Triangles are in the source face of its material, and texcoords follow
+  // the face order(st = xy of the point).
+  TEST_CHECK(mesh.facevaryingTexcoords.count(0) == 1);
+  if (mesh.facevaryingTexcoords.count(0)) {
+    const std::vector<tydra::vec2> &uvs = mesh.facevaryingTexcoords.at(0);
+    TEST_CHECK(uvs.size() == mesh.faceVertexIndices.size());
+    for (size_t i = 0; (i < uvs.size()) && (i < mesh.faceVertexIndices.size());
+         i++) {
+      const tydra::vec3 &p = mesh.points[mesh.faceVertexIndices[i]];
+      TEST_CHECK((uvs[i][0] == p[0]) && (uvs[i][1] == p[1]));
+    }
+  }
+
+  for (size_t t = 0; t < mesh.faceVertexCounts.size(); t++) {
+    float cx = 0.0f;
+    for (size_t k = 0; k < 3; k++) {
+      cx += mesh.points[mesh.faceVertexIndices[3 * t + k]][0] / 3.0f;
+    }
+    const int face = int(cx);
+    const int32_t mat_id = (face == 0) ? 0 : ((face == 2) ? 2 : 1);
+    TEST_CHECK(mesh.materialIds[t] == mat_id);
+  }
+
+  // A meshlet per material.
+  TEST_CHECK(mesh.meshlets.size() == 3);
+  for (size_t i = 0; i < mesh.meshlets.size(); i++) {
+    TEST_CHECK(mesh.meshlets[i].material_id == int32_t(i));
+  }
+
+  // No material: a single range.
+  tydra::RenderMesh quad;
+  quad.points = {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f},
+                 {0.0f, 1.0f, 0.0f}};
+  quad.faceVertexCounts = {4};
+  quad.faceVertexIndices = {0, 1, 2, 3};
+  TEST_CHECK(tydra::SortFacesByMaterial(quad, &err));
+  TEST_CHECK(quad.submeshes.size() == 1);
+  if (quad.submeshes.size() == 1) {
+    TEST_CHECK(quad.submeshes[0].face_count == 1);
+    TEST_CHECK(quad.submeshes[0].index_count == 4);
+    TEST_CHECK(quad.submeshes[0].material_id == -1);
+  }
+
+  // Invalid materialIds.
+  quad.materialIds = {0, 1};
+  TEST_CHECK(!tydra::SortFacesByMaterial(quad, &err));
+}
+
+void tydra_animation_test(void) {
+  std::string usda = R"(#usda 1.0
+(
+  timeCodesPerSecond = 10
+)
+
+def Xform "root"
+{
+  float3 xformOp:translate.timeSamples = {
+    0: (0, 0, 0),
+    10: (2, 4, 6),
+  }
+  float xformOp:rotateY.timeSamples = {
+    0: 0,
+    10: 90,
+  }
+  uniform token[] xformOpOrder = ["xformOp:translate", "xformOp:rotateY"]
+
+  def Mesh "mesh"
+  {
+    int[] faceVertexCounts = [3]
+    int[] faceVertexIndices = [0, 1, 2]
+    point3f[] points = [(0, 0, 0), (1, 0, 0), (0, 1, 0)]
+  }
+}
+
+def Scope "empty"
+{
+}
+)";
+
+  Stage stage;
+  std::string warn, err;
+  TEST_CHECK(LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                                usda.size(), "", &stage, &warn, &err));
+  TEST_MSG("%s", err.c_str());
+
+  tydra::RenderSceneConverterConfig config;
+  config.load_texture_assets = false;
+  config.animation_sample_interval = 5.0;
+
+  tydra::RenderScene scene;
+  tydra::RenderSceneConverter converter;
+  converter.set_scene_config(config);
+  TEST_CHECK(converter.ConvertToRenderScene(stage, &scene));
+  TEST_MSG("%s", converter.GetError().c_str());
+
+  // Stage root, /root and /root/mesh. /empty has no Xformable descendant.
+  TEST_CHECK(scene.nodes.size() == 3);
+  if (scene.nodes.size() != 3) {
+    return;
+  }
+  TEST_CHECK(scene.nodes[0].abs_path == "/");
+  TEST_CHECK(scene.nodes[0].children.size() == 1);
+  TEST_CHECK(scene.nodes[1].abs_path == "/root");
+  TEST_CHECK(scene.nodes[1].nodeType == tydra::NodeType::Xform);
+  TEST_CHECK(scene.nodes[2].abs_path == "/root/mesh");
+  TEST_CHECK(scene.nodes[2].nodeType == tydra::NodeType::Mesh);
+  TEST_CHECK(scene.nodes[2].id == 0);
+
+  TEST_CHECK(scene.animations.size() == 1);
+  if (scene.animations.size() != 1) {
+    return;
+  }
+
+  const tydra::Animation &anim = scene.animations[0];
+  TEST_CHECK(anim.path == "/root");
+  TEST_CHECK(anim.channels.size() == 1);
+  if (anim.channels.size() != 1) {
+    return;
+  }
+
+  const tydra::AnimationChannel &channel = anim.channels[0];
+  TEST_CHECK(channel.taget_node == 1);
+  TEST_CHECK(channel.transforms.samples.empty());
+
+  // timeCodes 0, 5(resampled), 10 -> 0, 0.5, 1.0 seconds
+  TEST_CHECK(channel.translations.samples.size() == 3);
+  TEST_CHECK(channel.rotations.samples.size() == 3);
+  TEST_CHECK(channel.scales.samples.size() == 3);
+  if ((channel.translations.samples.size() != 3) ||
+      (channel.rotations.samples.size() != 3) ||
+      (channel.scales.samples.size() != 3)) {
+    return;
+  }
+
+  const auto near = [](float a, float b) { return std::fabs(a - b) < 1e-4f; };
+
+  TEST_CHECK(near(channel.translations.samples[0].t, 0.0f));
+  TEST_CHECK(near(channel.translations.samples[1].t, 0.5f));
+  TEST_CHECK(near(channel.translations.samples[2].t, 1.0f));
+
+  const tydra::vec3 &t1 = channel.translations.samples[1].value;
+  TEST_CHECK(near(t1[0], 1.0f) && near(t1[1], 2.0f) && near(t1[2], 3.0f));
+  const tydra::vec3 &t2 = channel.translations.samples[2].value;
+  TEST_CHECK(near(t2[0], 2.0f) && near(t2[1], 4.0f) && near(t2[2], 6.0f));
+
+  // quaternion(x, y, z, w)
+  const float s45 = float(std::sin(3.14159265358979 / 4.0));
+  const float s225 = float(std::sin(3.14159265358979 / 8.0));
+  const float c225 = float(std::cos(3.14159265358979 / 8.0));
+
+  const tydra::quat &r0 = channel.rotations.samples[0].value;
+  TEST_CHECK(near(r0[0], 0.0f) && near(r0[1], 0.0f) && near(r0[2], 0.0f) &&
+             near(r0[3], 1.0f));
+  const tydra::quat &r1 = channel.rotations.samples[1].value;
+  TEST_CHECK(near(r1[0], 0.0f) && near(r1[1], s225) && near(r1[2], 0.0f) &&
+             near(r1[3], c225));
+  TEST_MSG("r1 = (%f, %f, %f, %f)", double(r1[0]), double(r1[1]),
+           double(r1[2]), double(r1[3]));
+  const tydra::quat &r2 = channel.rotations.samples[2].value;
+  TEST_CHECK(near(r2[0], 0.0f) && near(r2[1], s45) && near(r2[2], 0.0f) &&
+             near(r2[3], s45));
+
+  for (const auto &sample : channel.scales.samples) {
+    TEST_CHECK(near(sample.value[0], 1.0f) && near(sample.value[1], 1.0f) &&
+               near(sample.value[2], 1.0f));
+  }
+
+  // export_animations = false
+  config.export_animations = false;
+  tydra::RenderScene static_scene;
+  tydra::RenderSceneConverter static_converter;
+  static_converter.set_scene_config(config);
+  TEST_CHECK(static_converter.ConvertToRenderScene(stage, &static_scene));
+  TEST_CHECK(static_scene.animations.empty());
+  TEST_CHECK(static_scene.nodes.size() == 3);
+}
+
+void tydra_bake_world_transform_test(void) {
+  std::string usda = R"(#usda 1.0
+(
+  timeCodesPerSecond = 10
+)
+
+def Xform "root"
+{
+  float3 xformOp:translate = (1, 2, 3)
+  float3 xformOp:translate.timeSamples = {
+    0: (1, 2, 3),
+    10: (1, 2, 4),
+  }
+  uniform token[] xformOpOrder = ["xformOp:translate"]
+
+  def Mesh "mesh"
+  {
+    float3 xformOp:scale = (-1, 1, 1)
+    float xformOp:rotateY.timeSamples = {
+      0: 0,
+      10: 90,
+    }
+    uniform token[] xformOpOrder = ["xformOp:scale", "xformOp:rotateY"]
+
+    int[] faceVertexCounts = [3]
+    int[] faceVertexIndices = [0, 1, 2]
+    point3f[] points = [(0, 0, 0), (1, 0, 0), (0, 1, 0)]
+
+    def Xform "child"
+    {
+      float3 xformOp:translate = (0, 0, 5)
+      uniform token[] xformOpOrder = ["xformOp:translate"]
+    }
+  }
+}
+
+def Xform "anim"
+{
+  float xformOp:rotateZ.timeSamples = {
+    0: 0,
+    10: 90,
+  }
+  uniform token[] xformOpOrder = ["xformOp:rotateZ"]
+}
+)";
+
+  Stage stage;
+  std::string warn, err;
+  TEST_CHECK(LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                                usda.size(), "", &stage, &warn, &err));
+  TEST_MSG("%s", err.c_str());
+
+  tydra::RenderScene scenes[2];
+  std::string warns[2];
+  for (const bool bake : {false, true}) {
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+
+    tydra::MeshConverterConfig mesh_config;
+    mesh_config.bake_world_transform = bake;
+
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    converter.set_mesh_config(mesh_config);
+    TEST_CHECK(converter.ConvertToRenderScene(stage, &scenes[bake ? 1 : 0]));
+    TEST_MSG("%s", converter.GetError().c_str());
+    warns[bake ? 1 : 0] = converter.GetWarning();
+  }
+
+  const tydra::RenderScene &scene = scenes[0];
+  const tydra::RenderScene &baked = scenes[1];
+
+  // Stage root, /root, /root/mesh, /root/mesh/child and /anim
+  TEST_CHECK(scene.nodes.size() == 5);
+  TEST_CHECK(baked.nodes.size() == 5);
+  TEST_CHECK(scene.meshes.size() == 1);
+  TEST_CHECK(baked.meshes.size() == 1);
+  if ((scene.nodes.size() != 5) || (baked.nodes.size() != 5) ||
+      (scene.meshes.size() != 1) || (baked.meshes.size() != 1)) {
+    return;
+  }
+  TEST_CHECK(baked.nodes[2].abs_path == "/root/mesh");
+  TEST_CHECK(baked.nodes[2].nodeType == tydra::NodeType::Mesh);
+  TEST_CHECK(baked.nodes[3].abs_path == "/root/mesh/child");
+
+  const auto near_matrix = [](const value::matrix4d &a,
+                              const value::matrix4d &b) {
+    for (size_t i = 0; i < 4; i++) {
+      for (size_t j = 0; j < 4; j++) {
+        if (std::fabs(a.m[i][j] - b.m[i][j]) > 1e-6) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  const value::matrix4d identity = value::matrix4d::identity();
+
+  // Mesh node has identity world matrix, and its local matrix cancels the
+  // world matrix of /root.
+  TEST_CHECK(near_matrix(baked.nodes[2].global_matrix, identity));
+  TEST_CHECK(near_matrix(
+      baked.nodes[2].local_matrix * baked.nodes[1].global_matrix, identity));
+
+  // World matrix of the other nodes is unchanged.
+  TEST_CHECK(near_matrix(baked.nodes[1].global_matrix,
+                         scene.nodes[1].global_matrix));
+  TEST_CHECK(near_matrix(baked.nodes[3].global_matrix,
+                         scene.nodes[3].global_matrix));
+  TEST_CHECK(near_matrix(
+      baked.nodes[3].local_matrix * baked.nodes[2].global_matrix,
+      baked.nodes[3].global_matrix));
+
+  // xformOp animations of the Mesh node and its ancestor(/root) are not
+  // exported. /anim has no Mesh below it and is still animated.
+  TEST_CHECK(scene.animations.size() == 3);
+  TEST_CHECK(baked.animations.size() == 1);
+  if (baked.animations.size() == 1) {
+    TEST_CHECK(baked.animations[0].path == "/anim");
+  }
+  TEST_CHECK(warns[0].find("`/root`") == std::string::npos);
+  TEST_CHECK(warns[1].find("`/root`") != std::string::npos);
+  TEST_MSG("%s", warns[1].c_str());
+
+  // Points are in world space and the winding order is flipped(mirrored by
+  // scale -1).
+  const tydra::RenderMesh &mesh = scene.meshes[0];
+  const tydra::RenderMesh &bmesh = baked.meshes[0];
+  TEST_CHECK(bmesh.points.size() == mesh.points.size());
+  TEST_CHECK(mesh.faceVertexIndices == std::vector<uint32_t>({0, 1, 2}));
+  TEST_CHECK(bmesh.faceVertexIndices == std::vector<uint32_t>({0, 2, 1}));
+  if (bmesh.points.size() == 3) {
+    const auto near = [](float a, float b) { return std::fabs(a - b) < 1e-4f; };
+    const tydra::vec3 &p1 = bmesh.points[1];
+    TEST_CHECK(near(p1[0], 0.0f) && near(p1[1], 2.0f) && near(p1[2], 3.0f));
+    TEST_MSG("p1 = (%f, %f, %f)", double(p1[0]), double(p1[1]),
+             double(p1[2]));
+  }
+}
+
+void tydra_bound_material_test(void) {
+  std::string usda = BuildRenderSceneUSDA(1, 0);
+  usda += R"(
+def Xform "a"
+{
+  rel material:binding = </mtl/mat0>
+
+  def Xform "b"
+  {
+    def Xform "c"
+    {
+      def Mesh "mesh"
+      {
+      }
+    }
+  }
+}
+
+def Xform "x"
+{
+  def Xform "y"
+  {
+    def Xform "z"
+    {
+      def Mesh "mesh"
+      {
+      }
+    }
+  }
+}
+)";
+
+  Stage stage;
+  std::string warn, err;
+  TEST_CHECK(LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                                usda.size(), "", &stage, &warn, &err));
+  TEST_MSG("%s", err.c_str());
+
+  // Binding of the grand-grandparent Prim.
+  Path material_path;
+  const Material *material{nullptr};
+  TEST_CHECK(tydra::FindBoundMaterial(stage, Path("/a/b/c/mesh", ""),
+                                      /* suffix */ "", &material_path,
+                                      &material, &err));
+  TEST_CHECK(material_path.prim_part() == "/mtl/mat0");
+  TEST_CHECK(material != nullptr);
+
+  // No binding in any ancestor.
+  TEST_CHECK(!tydra::FindBoundMaterial(stage, Path("/x/y/z/mesh", ""),
+                                       /* suffix */ "", &material_path,
+                                       &material, &err));
+}
+
+void tydra_instancing_test(void) {
+  std::string usda = R"(#usda 1.0
+
+def PointInstancer "instancer"
+{
+  double3 xformOp:translate = (0, 0, 10)
+  uniform token[] xformOpOrder = ["xformOp:translate"]
+
+  rel prototypes = [</instancer/protos/a>, </instancer/protos/b>]
+  int[] protoIndices = [0, 1, 0, 0, 5]
+  point3f[] positions = [(1, 0, 0), (2, 0, 0), (3, 0, 0), (4, 0, 0), (5, 0, 0)]
+  quath[] orientations = [(1, 0, 0, 0), (0.70710677, 0, 0.70710677, 0), (1, 0, 0, 0), (1, 0, 0, 0), (1, 0, 0, 0)]
+  float3[] scales = [(1, 1, 1), (1, 1, 1), (2, 2, 2), (1, 1, 1), (1, 1, 1)]
+  int64[] ids = [10, 11, 12, 13, 14]
+  int64[] invisibleIds = [13]
+
+  def Scope "protos"
+  {
+    def Xform "a"
+    {
+      double3 xformOp:translate = (0, 1, 0)
+      uniform token[] xformOpOrder = ["xformOp:translate"]
+
+      def Mesh "m"
+      {
+        int[] faceVertexCounts = [3]
+        int[] faceVertexIndices = [0, 1, 2]
+        point3f[] points = [(0, 0, 0), (1, 0, 0), (0, 1, 0)]
+      }
+    }
+
+    def Mesh "b"
+    {
+      int[] faceVertexCounts = [3]
+      int[] faceVertexIndices = [0, 1, 2]
+      point3f[] points = [(1, 0, 0), (0, 0, 1), (0, 1, 0)]
+    }
+  }
+}
+
+def Xform "tree1" (
+  instanceable = true
+)
+{
+  double3 xformOp:translate = (100, 0, 0)
+  uniform token[] xformOpOrder = ["xformOp:translate"]
+
+  def Mesh "leaf"
+  {
+    int[] faceVertexCounts = [3]
+    int[] faceVertexIndices = [0, 1, 2]
+    point3f[] points = [(0, 0, 0), (1, 0, 0), (0, 1, 0)]
+  }
+}
+
+def Xform "tree2" (
+  instanceable = true
+)
+{
+  double3 xformOp:translate = (200, 0, 0)
+  uniform token[] xformOpOrder = ["xformOp:translate"]
+
+  def Mesh "leaf"
+  {
+    int[] faceVertexCounts = [3]
+    int[] faceVertexIndices = [0, 1, 2]
+    point3f[] points = [(0, 0, 0), (1, 0, 0), (0, 1, 0)]
+  }
+}
+
+def Xform "rock" (
+  instanceable = true
+)
+{
+  def Mesh "leaf"
+  {
+    int[] faceVertexCounts = [3]
+    int[] faceVertexIndices = [0, 1, 2]
+    point3f[] points = [(0, 0, 0), (2, 0, 0), (0, 2, 0)]
+  }
+}
+)";
+
+  Stage stage;
+  std::string warn, err;
+  TEST_CHECK(LoadUSDAFromMemory(reinterpret_cast<const uint8_t *>(usda.data()),
+                                usda.size(), "", &stage, &warn, &err));
+  TEST_MSG("%s", err.c_str());
+
+  const auto near = [](float a, float b) { return std::fabs(a - b) < 1e-3f; };
+  const auto transform = [](const tydra::mat4 &m, const tydra::vec3 &p) {
+    tydra::vec3 r;
+    for (size_t j = 0; j < 3; j++) {
+      r[j] = p[0] * m.m[0][j] + p[1] * m.m[1][j] + p[2] * m.m[2][j] +
+             m.m[3][j];
+    }
+    return r;
+  };
+  const auto check_point = [&](const tydra::mat4 &m, const tydra::vec3 &p,
+                               float x, float y, float z) {
+    const tydra::vec3 r = transform(m, p);
+    TEST_CHECK(near(r[0], x) && near(r[1], y) && near(r[2], z));
+    TEST_MSG("got (%f, %f, %f), expected (%f, %f, %f)", double(r[0]),
+             double(r[1]), double(r[2]), double(x), double(y), double(z));
+  };
+
+  for (const bool bake : {false, true}) {
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+    config.build_instances = true;
+
+    tydra::MeshConverterConfig mesh_config;
+    mesh_config.bake_world_transform = bake;
+
+    tydra::RenderScene scene;
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    converter.set_mesh_config(mesh_config);
+    TEST_CHECK(converter.ConvertToRenderScene(stage, &scene));
+    TEST_MSG("%s", converter.GetError().c_str());
+    // protoIndices 5 is out-of-range.
+    TEST_CHECK(converter.GetWarning().find("invalid `protoIndices`") !=
+               std::string::npos);
+
+    // /tree2/leaf shares the mesh of /tree1/leaf.
+    TEST_CHECK(scene.meshes.size() == 4);
+    if (scene.meshes.size() != 4) {
+      return;
+    }
+    TEST_CHECK(scene.meshes[0].abs_name == "/instancer/protos/a/m");
+    TEST_CHECK(scene.meshes[1].abs_name == "/instancer/protos/b");
+    TEST_CHECK(scene.meshes[2].abs_name == "/tree1/leaf");
+    TEST_CHECK(scene.meshes[3].abs_name == "/rock/leaf");
+
+    TEST_CHECK(scene.instances.size() == 3);
+    if (scene.instances.size() != 3) {
+      return;
+    }
+
+    // Prototype meshes are not referenced from nodes.
+    for (const auto &node : scene.nodes) {
+      if (node.nodeType == tydra::NodeType::Mesh) {
+        TEST_CHECK(node.id == 3);
+        TEST_CHECK(node.abs_path == "/rock/leaf");
+      }
+    }
+
+    // Points in the RenderMesh space.
+    const auto mesh_point = [&](size_t mesh_id, size_t i) {
+      return scene.meshes[mesh_id].points[i];
+    };
+
+    // protos/a: instance 0(id 10) and 2(id 12). id 13 is invisible.
+    const tydra::MeshInstances &a = scene.instances[0];
+    TEST_CHECK(a.abs_path == "/instancer");
+    TEST_CHECK(a.mesh_id == 0);
+    TEST_CHECK(a.transforms.size() == 2);
+    if (a.transforms.size() == 2) {
+      // (0, 0, 0) in protos/a/m
+      check_point(a.transforms[0], mesh_point(0, 0), 1.0f, 1.0f, 10.0f);
+      check_point(a.transforms[1], mesh_point(0, 0), 3.0f, 2.0f, 10.0f);
+    }
+
+    // protos/b: instance 1(90 degrees around Y)
+    const tydra::MeshInstances &b = scene.instances[1];
+    TEST_CHECK(b.mesh_id == 1);
+    TEST_CHECK(b.transforms.size() == 1);
+    if (b.transforms.size() == 1) {
+      // (1, 0, 0) -> (0, 0, -1)
+      check_point(b.transforms[0], mesh_point(1, 0), 2.0f, 0.0f, 9.0f);
+    }
+
+    const tydra::MeshInstances &tree = scene.instances[2];
+    TEST_CHECK(tree.abs_path == "/tree1");
+    TEST_CHECK(tree.mesh_id == 2);
+    TEST_CHECK(tree.transforms.size() == 2);
+    if (tree.transforms.size() == 2) {
+      // (1, 0, 0) in leaf
+      check_point(tree.transforms[0], mesh_point(2, 1), 101.0f, 0.0f, 0.0f);
+      check_point(tree.transforms[1], mesh_point(2, 1), 201.0f, 0.0f, 0.0f);
+    }
+  }
+
+  // build_instances = false(default)
+  {
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+    TEST_CHECK(!config.build_instances);
+
+    tydra::RenderScene scene;
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    TEST_CHECK(converter.ConvertToRenderScene(stage, &scene));
+    TEST_CHECK(scene.instances.empty());
+    TEST_CHECK(scene.meshes.size() == 5);
+  }
+
+  // Instances overriding primvars or normals must not share the mesh.
+  {
+    std::string inst_usda = R"(#usda 1.0
+)";
+    const char *overrides[] = {
+        "",
+        "",
+        "texCoord2f[] primvars:st = [(0, 0), (1, 0), (0, 1)] (\n"
+        "  interpolation = \"vertex\"\n)",
+        "texCoord2f[] primvars:st = [(0, 0), (2, 0), (0, 2)] (\n"
+        "  interpolation = \"vertex\"\n)",
+        "normal3f[] normals = [(0, 0, 1), (0, 0, 1), (0, 0, 1)] (\n"
+        "  interpolation = \"vertex\"\n)",
+        // timeSamples only
+        "float[] primvars:weight.timeSamples = {\n  0: [1, 2, 3],\n}",
+        "float[] primvars:weight.timeSamples = {\n  0: [4, 5, 6],\n}",
+    };
+    for (size_t i = 0; i < 7; i++) {
+      inst_usda += "def Xform \"inst" + std::to_string(i) +
+                   "\" (\n  instanceable = true\n)\n{\n"
+                   "  def Mesh \"leaf\"\n  {\n"
+                   "    int[] faceVertexCounts = [3]\n"
+                   "    int[] faceVertexIndices = [0, 1, 2]\n"
+                   "    point3f[] points = [(0, 0, 0), (1, 0, 0), (0, 1, 0)]\n"
+                   "    " + std::string(overrides[i]) + "\n  }\n}\n";
+    }
+
+    Stage inst_stage;
+    TEST_CHECK(LoadUSDAFromMemory(
+        reinterpret_cast<const uint8_t *>(inst_usda.data()), inst_usda.size(),
+        "", &inst_stage, &warn, &err));
+    TEST_MSG("%s", err.c_str());
+
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+    config.build_instances = true;
+
+    tydra::RenderScene scene;
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    TEST_CHECK(converter.ConvertToRenderScene(inst_stage, &scene));
+    TEST_MSG("%s", converter.GetError().c_str());
+
+    // inst0 and inst1 share the mesh.
+    TEST_CHECK(scene.meshes.size() == 6);
+    TEST_MSG("%d meshes", int(scene.meshes.size()));
+  }
+
+  // Malformed PointInstancer is skipped with a warning.
+  {
+    std::string bad_usda = R"(#usda 1.0
+
+def PointInstancer "bad"
+{
+  rel prototypes = [</bad/protos/a>]
+  int[] protoIndices = [0, 0]
+  point3f[] positions = [(1, 0, 0)]
+
+  def Scope "protos"
+  {
+    def Mesh "a"
+    {
+      int[] faceVertexCounts = [3]
+      int[] faceVertexIndices = [0, 1, 2]
+      point3f[] points = [(0, 0, 0), (1, 0, 0), (0, 1, 0)]
+    }
+  }
+}
+)";
+
+    Stage bad_stage;
+    TEST_CHECK(LoadUSDAFromMemory(
+        reinterpret_cast<const uint8_t *>(bad_usda.data()), bad_usda.size(),
+        "", &bad_stage, &warn, &err));
+    TEST_MSG("%s", err.c_str());
+
+    tydra::RenderSceneConverterConfig config;
+    config.load_texture_assets = false;
+    config.build_instances = true;
+
+    tydra::RenderScene scene;
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    TEST_CHECK(converter.ConvertToRenderScene(bad_stage, &scene));
+    TEST_MSG("%s", converter.GetError().c_str());
+    TEST_CHECK(converter.GetWarning().find("PointInstancer `/bad` is ignored") !=
+               std::string::npos);
+    TEST_CHECK(scene.instances.empty());
+    TEST_CHECK(scene.meshes.size() == 1);
+  }
+}
+
+void tydra_update_render_scene_test(void) {
+  struct Edit {
+    float a_x{0.0f};                 // points of /root/a
+    std::string tex{"red.png"};      // texture of /Looks/red
+    std::string uv_name{"st"};       // UV primvar of /Looks/red
+    float red_roughness{0.5f};
+    double root_tx{0.0};             // translate of /root
+    std::string b_material{"red"};
+    bool has_c{true};
+    bool has_d{false};
+  };
+
+  const auto build_usda = [](const Edit &edit) {
+    const auto mesh = [](const std::string &name, float x,
+                         const std::string &material) {
+      std::string s = "  def Mesh \"" + name + "\"\n  {\n";
+      s += "    int[] faceVertexCounts = [3]\n";
+      s += "    int[] faceVertexIndices = [0, 1, 2]\n";
+      s += "    point3f[] points = [(" + std::to_string(x) + ", 0, 0), (" +
+           std::to_string(x + 1.0f) + ", 0, 0), (" + std::to_string(x) +
+           ", 1, 0)]\n";
+      s += "    texCoord2f[] primvars:st = [(0, 0), (1, 0), (0, 1)] (\n";
+      s += "      interpolation = \"faceVarying\"\n    )\n";
+      s += "    texCoord2f[] primvars:st1 = [(0, 0), (2, 0), (0, 2)] (\n";
+      s += "      interpolation = \"faceVarying\"\n    )\n";
+      if (!material.empty()) {
+        s += "    rel material:binding = </Looks/" + material + ">\n";
+      }
+      s += "  }\n";
+      return s;
+    };
+
+    std::string s = "#usda 1.0\n";
+    s += "def Xform \"root\"\n{\n";
+    s += "  double3 xformOp:translate = (" + std::to_string(edit.root_tx) +
+         ", 0, 0)\n";
+    s += "  uniform token[] xformOpOrder = [\"xformOp:translate\"]\n";
+    s += mesh("a", edit.a_x, "red");
+    s += mesh("b", 0.0f, edit.b_material);
+    if (edit.has_d) {
+      s += mesh("d", 5.0f, "");
+    }
+    s += "}\n";
+
+    if (edit.has_c) {
+      s += "def Xform \"other\"\n{\n";
+      s += mesh("c", 2.0f, "");
+      s += "}\n";
+    }
+
+    s += R"(def Scope "Looks"
+{
+  def Material "red"
+  {
+    token outputs:surface.connect = </Looks/red/pbr.outputs:surface>
+    def Shader "pbr"
+    {
+      uniform token info:id = "UsdPreviewSurface"
+      color3f inputs:diffuseColor.connect = </Looks/red/tex.outputs:rgb>
+      float inputs:roughness = )" +
+         std::to_string(edit.red_roughness) + R"(
+      token outputs:surface
+    }
+    def Shader "tex"
+    {
+      uniform token info:id = "UsdUVTexture"
+      asset inputs:file = @)" +
+         edit.tex + R"(@
+      float2 inputs:st.connect = </Looks/red/uv.outputs:result>
+      color3f outputs:rgb
+    }
+    def Shader "uv"
+    {
+      uniform token info:id = "UsdPrimvarReader_float2"
+      token inputs:varname = ")" +
+         edit.uv_name + R"("
+      float2 outputs:result
+    }
+  }
+
+  def Material "blue"
+  {
+    token outputs:surface.connect = </Looks/blue/pbr.outputs:surface>
+    def Shader "pbr"
+    {
+      uniform token info:id = "UsdPreviewSurface"
+      color3f inputs:diffuseColor = (0, 0, 1)
+      token outputs:surface
+    }
+  }
+}
+)";
+    return s;
+  };
+
+  const auto load = [&](const Edit &edit, Stage *stage) {
+    const std::string usda = build_usda(edit);
+    std::string warn, err;
+    const bool ret = LoadUSDAFromMemory(
+        reinterpret_cast<const uint8_t *>(usda.data()), usda.size(), "", stage,
+        &warn, &err);
+    TEST_CHECK(ret);
+    TEST_MSG("%s", err.c_str());
+    return ret;
+  };
+
+  const auto find_mesh = [](const tydra::RenderScene &scene,
+                            const std::string &abs_name) {
+    for (size_t i = 0; i < scene.meshes.size(); i++) {
+      if (scene.meshes[i].abs_name == abs_name) {
+        return int32_t(i);
+      }
+    }
+    return int32_t(-1);
+  };
+
+  // 1x1 image. Texel value depends on the asset path.
+  const tydra::TextureImageLoaderFunction loader =
+      [](const value::AssetPath &asset_path, const AssetInfo &,
+         AssetResolutionResolver &, tydra::TextureImage *image,
+         std::vector<uint8_t> *data, void *, std::string *, std::string *) {
+        image->asset_identifier = asset_path.GetAssetPath();
+        image->width = 1;
+        image->height = 1;
+        image->channels = 3;
+        data->assign(3, uint8_t(asset_path.GetAssetPath().size()));
+        return true;
+      };
+
+  for (const bool bake : {false, true}) {
+    tydra::RenderSceneConverterConfig config;
+
+    tydra::MeshConverterConfig mesh_config;
+    mesh_config.bake_world_transform = bake;
+
+    tydra::MaterialConverterConfig material_config;
+    material_config.texture_image_loader_function = loader;
+    material_config.preserve_texel_bitdepth = true;
+
+    tydra::RenderSceneConverter converter;
+    converter.set_scene_config(config);
+    converter.set_mesh_config(mesh_config);
+    converter.set_material_config(material_config);
+
+    Edit edit;
+    Stage stage;
+    if (!load(edit, &stage)) {
+      return;
+    }
+
+    tydra::RenderScene scene;
+    TEST_CHECK(converter.ConvertToRenderScene(stage, &scene));
+    TEST_MSG("%s", converter.GetError().c_str());
+
+    TEST_CHECK(scene.meshes.size() == 3);
+    TEST_CHECK(scene.materials.size() == 1);
+    TEST_CHECK(scene.textures.size() == 1);
+    TEST_CHECK(scene.images.size() == 1);
+    if ((scene.meshes.size() != 3) || (scene.materials.size() != 1) ||
+        (scene.images.size() != 1)) {
+      return;
+    }
+
+    const int32_t a_id = find_mesh(scene, "/root/a");
+    const int32_t b_id = find_mesh(scene, "/root/b");
+    const int32_t c_id = find_mesh(scene, "/other/c");
+    TEST_CHECK((a_id >= 0) && (b_id >= 0) && (c_id >= 0));
+
+    // GPU handles set by the app are kept.
+    for (size_t i = 0; i < scene.meshes.size(); i++) {
+      scene.meshes[i].handle = 100 + i;
+    }
+    scene.materials[0].handle = 200;
+    scene.images[0].handle = 300;
+
+    tydra::RenderSceneUpdate update;
+
+    // No change.
+    TEST_CHECK(converter.UpdateRenderScene(stage, {}, &scene, &update));
+    TEST_MSG("%s", converter.GetError().c_str());
+    TEST_CHECK(update.empty());
+
+    // Modify points.
+    {
+      edit.a_x = 10.0f;
+      Stage edited;
+      if (!load(edit, &edited)) {
+        return;
+      }
+      stage = std::move(edited);
+
+      TEST_CHECK(converter.UpdateRenderScene(stage, {Path("/root/a", "")},
+                                             &scene, &update));
+      TEST_CHECK(update.meshes == std::vector<int32_t>{a_id});
+      TEST_CHECK(update.materials.empty());
+      TEST_CHECK(update.removed_meshes.empty());
+      TEST_CHECK(!update.nodes);
+      TEST_CHECK(find_mesh(scene, "/root/a") == a_id);
+      TEST_CHECK(std::fabs(scene.meshes[size_t(a_id)].points[0][0] - 10.0f) <
+                 1e-5f);
+      TEST_CHECK(scene.meshes[size_t(a_id)].handle == 100 + uint64_t(a_id));
+    }
+
+    // Meshes bound to a modified Material are converted again.
+    std::vector<int32_t> red_meshes{a_id, b_id};
+    std::sort(red_meshes.begin(), red_meshes.end());
+
+    // Modify Shader parameter. The texture is not changed.
+    {
+      edit.red_roughness = 0.25f;
+      Stage edited;
+      if (!load(edit, &edited)) {
+        return;
+      }
+      stage = std::move(edited);
+
+      TEST_CHECK(converter.UpdateRenderScene(
+          stage, {Path("/Looks/red/pbr", "")}, &scene, &update));
+      TEST_CHECK(update.materials == std::vector<int32_t>{0});
+      TEST_CHECK(update.meshes == red_meshes);
+      TEST_CHECK(update.textures == std::vector<int32_t>{0});
+      TEST_CHECK(update.images.empty());
+      TEST_CHECK(update.buffers.empty());
+      TEST_CHECK(scene.textures.size() == 1);
+      TEST_CHECK(std::fabs(scene.materials[0].surfaceShader.roughness.value -
+                           0.25f) < 1e-5f);
+      TEST_CHECK(scene.materials[0].surfaceShader.diffuseColor.textureId == 0);
+      TEST_CHECK(scene.materials[0].handle == 200);
+    }
+
+    // Modify texture asset. TextureImage is updated in place.
+    {
+      edit.tex = "red2.png";
+      Stage edited;
+      if (!load(edit, &edited)) {
+        return;
+      }
+      stage = std::move(edited);
+
+      TEST_CHECK(converter.UpdateRenderScene(
+          stage, {Path("/Looks/red/tex", "")}, &scene, &update));
+      TEST_CHECK(update.materials == std::vector<int32_t>{0});
+      TEST_CHECK(update.images == std::vector<int32_t>{0});
+      TEST_CHECK(update.buffers.size() == 1);
+      TEST_CHECK(scene.textures.size() == 1);
+      TEST_CHECK(scene.images.size() == 1);
+      TEST_CHECK(scene.images[0].asset_identifier.find("red2.png") !=
+                 std::string::npos);
+      TEST_CHECK(scene.images[0].handle == 300);
+    }
+
+    // Change the UV primvar read by the Material. Texcoords of the meshes
+    // bound to it are updated.
+    {
+      edit.uv_name = "st1";
+      Stage edited;
+      if (!load(edit, &edited)) {
+        return;
+      }
+      stage = std::move(edited);
+
+      TEST_CHECK(converter.UpdateRenderScene(
+          stage, {Path("/Looks/red/uv", "")}, &scene, &update));
+      TEST_CHECK(update.materials == std::vector<int32_t>{0});
+      TEST_CHECK(update.meshes == red_meshes);
+
+      const tydra::RenderMesh &a = scene.meshes[size_t(a_id)];
+      TEST_CHECK(a.facevaryingTexcoords.size() == 1);
+      if (a.facevaryingTexcoords.size() == 1) {
+        const std::vector<tydra::vec2> &uvs =
+            a.facevaryingTexcoords.begin()->second;
+        TEST_CHECK(uvs.size() == 3);
+        TEST_CHECK((uvs.size() == 3) && (std::fabs(uvs[1][0] - 2.0f) < 1e-5f));
+      }
+      TEST_CHECK(scene.meshes[size_t(a_id)].handle == 100 + uint64_t(a_id));
+    }
+
+    // Move the parent Xform(property path). Meshes are converted again only
+    // when the world transform is baked.
+    {
+      edit.root_tx = 3.0;
+      Stage edited;
+      if (!load(edit, &edited)) {
+        return;
+      }
+      stage = std::move(edited);
+
+      TEST_CHECK(converter.UpdateRenderScene(
+          stage, {Path("/root", "xformOp:translate")}, &scene, &update));
+      TEST_CHECK(update.nodes);
+      TEST_CHECK(update.materials.empty());
+      if (bake) {
+        TEST_CHECK(update.meshes == red_meshes);
+        TEST_CHECK(std::fabs(scene.meshes[size_t(a_id)].points[0][0] -
+                             13.0f) < 1e-5f);
+      } else {
+        TEST_CHECK(update.meshes.empty());
+      }
+    }
+
+    // Modify points of /root/a, but pass only the root Prim path(e.g. from
+    // IncrementalComposer::updated_prims()). Meshes in the subtree are
+    // converted again.
+    {
+      edit.a_x = 20.0f;
+      Stage edited;
+      if (!load(edit, &edited)) {
+        return;
+      }
+      stage = std::move(edited);
+
+      TEST_CHECK(converter.UpdateRenderScene(stage, {Path("/root", "")},
+                                             &scene, &update));
+      TEST_CHECK(update.meshes == red_meshes);
+      TEST_CHECK(update.materials.empty());
+      const float expected_x = bake ? 23.0f : 20.0f;
+      TEST_CHECK(std::fabs(scene.meshes[size_t(a_id)].points[0][0] -
+                           expected_x) < 1e-5f);
+      TEST_CHECK(scene.meshes[size_t(a_id)].handle == 100 + uint64_t(a_id));
+    }
+
+    // Rebind Material. `blue` is a new RenderMaterial.
+    {
+      edit.b_material = "blue";
+      Stage edited;
+      if (!load(edit, &edited)) {
+        return;
+      }
+      stage = std::move(edited);
+
+      TEST_CHECK(converter.UpdateRenderScene(stage, {Path("/root/b", "")},
+                                             &scene, &update));
+      TEST_CHECK(update.meshes == std::vector<int32_t>{b_id});
+      TEST_CHECK(update.materials == std::vector<int32_t>{1});
+      TEST_CHECK(scene.materials.size() == 2);
+      TEST_CHECK(!scene.meshes[size_t(b_id)].materialIds.empty() &&
+                 (scene.meshes[size_t(b_id)].materialIds[0] == 1));
+    }
+
+    // Remove /other(and /other/c), add /root/d.
+    {
+      edit.has_c = false;
+      edit.has_d = true;
+      Stage edited;
+      if (!load(edit, &edited)) {
+        return;
+      }
+      stage = std::move(edited);
+
+      TEST_CHECK(converter.UpdateRenderScene(
+          stage, {Path("/other", ""), Path("/root/d", "")}, &scene, &update));
+      TEST_CHECK(update.removed_meshes == std::vector<int32_t>{c_id});
+      TEST_CHECK(update.meshes == std::vector<int32_t>{3});
+      TEST_CHECK(scene.meshes.size() == 4);
+      TEST_CHECK(scene.meshes[size_t(c_id)].abs_name.empty());
+      TEST_CHECK(find_mesh(scene, "/root/d") == 3);
+      TEST_CHECK(find_mesh(scene, "/root/a") == a_id);
+      TEST_CHECK(find_mesh(scene, "/root/b") == b_id);
+      TEST_CHECK(update.nodes);
+
+      for (const auto &node : scene.nodes) {
+        if (node.nodeType == tydra::NodeType::Mesh) {
+          TEST_CHECK(node.id != c_id);
+        }
+      }
+    }
+
+    // The result matches the full conversion of the edited Stage.
+    {
+      tydra::RenderSceneConverter full_converter;
+      full_converter.set_scene_config(config);
+      full_converter.set_mesh_config(mesh_config);
+      full_converter.set_material_config(material_config);
+
+      tydra::RenderScene full;
+      TEST_CHECK(full_converter.ConvertToRenderScene(stage, &full));
+
+      for (const auto &mesh : full.meshes) {
+        const int32_t id = find_mesh(scene, mesh.abs_name);
+        TEST_CHECK(id >= 0);
+        if (id < 0) {
+          continue;
+        }
+        TEST_CHECK(scene.meshes[size_t(id)].points.size() ==
+                   mesh.points.size());
+        for (size_t i = 0; i < mesh.points.size(); i++) {
+          TEST_CHECK(std::fabs(scene.meshes[size_t(id)].points[i][0] -
+                               mesh.points[i][0]) < 1e-5f);
+        }
+      }
+      TEST_CHECK(full.nodes.size() == scene.nodes.size());
+    }
+  }
+}
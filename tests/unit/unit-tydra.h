@@ -0,0 +1,16 @@
+#pragma once
+
+void tydra_parallel_visit_test(void);
+void tydra_xform_cache_test(void);
+void tydra_render_scene_parallel_test(void);
+void tydra_weld_face_vertices_test(void);
+void tydra_triangulation_test(void);
+void tydra_interleaved_vertex_buffer_test(void);
+void tydra_meshlet_test(void);
+void tydra_vertex_cache_test(void);
+void tydra_geom_subset_material_test(void);
+void tydra_animation_test(void);
+void tydra_bake_world_transform_test(void);
+void tydra_bound_material_test(void);
+void tydra_instancing_test(void);
+void tydra_update_render_scene_test(void);
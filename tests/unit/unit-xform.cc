@@ -356,3 +356,101 @@ void xformOp_test(void) {
 
 
 }
+
+void xform_batch_transform_test(void) {
+  value::matrix4d m = trs_angle_xyz({1.0, 2.0, 3.0}, {30.0, 45.0, 60.0},
+                                    {2.0, 0.5, 1.5});
+
+  std::vector<value::double3> dsrc;
+  std::vector<value::float3> fsrc;
+  for (size_t i = 0; i < 37; i++) {
+    double x = double(i) * 0.25 - 3.0;
+    dsrc.push_back({x, -x * 0.5, 1.0 + x});
+    fsrc.push_back({float(x), float(-x * 0.5), float(1.0 + x)});
+  }
+
+  // points(double) must match scalar `transform()`
+  {
+    std::vector<value::double3> dst(dsrc.size());
+    transform_points(m, dsrc.data(), dsrc.size(), dst.data());
+    for (size_t i = 0; i < dsrc.size(); i++) {
+      value::double3 ref = transform(m, dsrc[i]);
+      TEST_CHECK(std::fabs(dst[i][0] - ref[0]) < 1e-12);
+      TEST_CHECK(std::fabs(dst[i][1] - ref[1]) < 1e-12);
+      TEST_CHECK(std::fabs(dst[i][2] - ref[2]) < 1e-12);
+    }
+  }
+
+  // points(float, in-place)
+  {
+    std::vector<value::float3> dst = fsrc;
+    transform_points(m, dst.data(), dst.size(), dst.data());
+    for (size_t i = 0; i < fsrc.size(); i++) {
+      value::float3 ref = transform(m, fsrc[i]);
+      TEST_CHECK(float_equals(dst[i][0], ref[0], 1e-4f));
+      TEST_CHECK(float_equals(dst[i][1], ref[1], 1e-4f));
+      TEST_CHECK(float_equals(dst[i][2], ref[2], 1e-4f));
+    }
+  }
+
+  // dirs
+  {
+    std::vector<value::double3> dst(dsrc.size());
+    transform_dirs(m, dsrc.data(), dsrc.size(), dst.data());
+    for (size_t i = 0; i < dsrc.size(); i++) {
+      value::double3 ref = transform_dir(m, dsrc[i]);
+      TEST_CHECK(std::fabs(dst[i][0] - ref[0]) < 1e-12);
+      TEST_CHECK(std::fabs(dst[i][1] - ref[1]) < 1e-12);
+      TEST_CHECK(std::fabs(dst[i][2] - ref[2]) < 1e-12);
+    }
+  }
+
+  // normals stay perpendicular to transformed tangents.
+  {
+    std::vector<value::normal3d> normals = {{0.0, 0.0, 1.0}, {0.0, 1.0, 0.0}};
+    std::vector<value::vector3d> tangents = {{1.0, 0.0, 0.0}, {0.0, 0.0, 1.0}};
+    TEST_CHECK(transform_normals(m, normals));
+    transform_dirs(m, tangents);
+    for (size_t i = 0; i < normals.size(); i++) {
+      double d = normals[i].x * tangents[i].x + normals[i].y * tangents[i].y +
+                 normals[i].z * tangents[i].z;
+      TEST_CHECK(std::fabs(d) < 1e-9);
+      double len = std::sqrt(normals[i].x * normals[i].x +
+                             normals[i].y * normals[i].y +
+                             normals[i].z * normals[i].z);
+      TEST_CHECK(std::fabs(len - 1.0) < 1e-9);
+    }
+  }
+
+  // inverse_affine
+  {
+    value::matrix4d inv_m;
+    TEST_CHECK(is_affine(m));
+    TEST_CHECK(inverse_affine(m, inv_m));
+    value::matrix4d ref = inverse(m);
+    for (size_t j = 0; j < 4; j++) {
+      for (size_t i = 0; i < 4; i++) {
+        TEST_CHECK(std::fabs(inv_m.m[j][i] - ref.m[j][i]) < 1e-9);
+      }
+    }
+
+    value::matrix4d proj = m;
+    proj.m[2][3] = -1.0;
+    TEST_CHECK(!inverse_affine(proj, inv_m));
+  }
+
+  // matrix4d multiplication
+  {
+    value::matrix4d a = m;
+    a.m[0][3] = 0.5;
+    value::matrix4d b = trs_angle_xyz({-1.0, 0.5, 2.0}, {10.0, 0.0, -20.0},
+                                      {1.0, 3.0, 1.0});
+    value::matrix4d ab = a * b;
+    value::matrix4d ref = value::Mult<value::matrix4d, double, 4>(a, b);
+    for (size_t j = 0; j < 4; j++) {
+      for (size_t i = 0; i < 4; i++) {
+        TEST_CHECK(std::fabs(ab.m[j][i] - ref.m[j][i]) < 1e-12);
+      }
+    }
+  }
+}
@@ -1,3 +1,4 @@
 #pragma once
 
 void xformOp_test(void);
+void xform_batch_transform_test(void);